@@ -14,8 +14,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 +(NSString*)stringWithWchar:(wchar_t*)input;
 +(NSString*)stringWithWstring:(const std::wstring &)input;
++(NSString*)stringWithU16string:(const std::u16string &)input;
++(NSString*)stringWithU16chars:(const char16_t *)input length:(NSUInteger)length;
 
 -(std::wstring)cStringWstring;
+-(std::u16string)cStringU16string;
 
 @end
 
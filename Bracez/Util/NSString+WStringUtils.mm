@@ -21,6 +21,15 @@
                                   encoding:NSUTF32LittleEndianStringEncoding];
 }
 
++(NSString*)stringWithU16string:(const std::u16string &)input {
+    return [NSString stringWithU16chars:input.c_str() length:input.length()];
+}
+
++(NSString*)stringWithU16chars:(const char16_t *)input length:(NSUInteger)length {
+    // unichar is UTF-16 as well, no transcoding required
+    return [[NSString alloc] initWithCharacters:(const unichar*)input length:length];
+}
+
 -(std::wstring)cStringWstring {
     NSUInteger len = self.length;
     std::wstring ret(len, 0);
@@ -38,4 +47,11 @@
     //return (wchar_t*)[self cStringUsingEncoding:NSUTF32LittleEndianStringEncoding];
 }
 
+-(std::u16string)cStringU16string {
+    std::u16string ret(self.length, 0);
+    [self getCharacters:(unichar*)&ret[0] range:NSMakeRange(0, self.length)];
+    
+    return ret;
+}
+
 @end
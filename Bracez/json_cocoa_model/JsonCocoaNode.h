@@ -12,7 +12,8 @@
 
 @interface JsonCocoaNode : NSObject {
 
-   json::Node *proxiedElement;
+   // Dropped by the file once the element leaves the DOM
+   json::PinnedNodes proxiedElement;
    NSString *name;
    NSMutableArray *children;
    int childCount;
@@ -24,6 +25,8 @@
 
 -(int)nodeType;
 -(id) nodeValue;
+// As nodeValue, for any element, e.g one parsed from a snapshot in the background
++(NSString*) valueOfElement:(json::Node*)aElement;
 -(NSString*) longNodeValue;
 -(NSString*) nodeName;
 
@@ -32,6 +35,7 @@
 
 -(BOOL) isContainer;
 
+// NULL once the element was replaced or removed from the DOM
 -(json::Node*)proxiedElement;
 
 -(void)setNodeValue:(NSValue*)aValue;
@@ -48,6 +52,7 @@
 
 -(json::TextRange)textRange;
 
+-(json::Node*)_liveElement;
 -(void)_prepChildren;
 -(void)_updateNameFromIndex:(int)aIdx;
 -(void)_internalRemoveChildAtIndex:(int)aIdx;
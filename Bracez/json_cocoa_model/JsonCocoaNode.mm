@@ -50,18 +50,36 @@ static int computeChildCount(json::Node *element) {
    if(self)
    {
       name = aName;
-      proxiedElement = aProxiedElement;
-      childCount = computeChildCount(proxiedElement);
+      proxiedElement.assign(aProxiedElement);
+      childCount = computeChildCount(proxiedElement.get());
    }
    
    return self;
 }
 
+-(json::Node*)_liveElement
+{
+   json::Node *lElement = proxiedElement.get();
+   if(!lElement && !proxiedElement.empty())
+   {
+      // Gone from the DOM; nothing left to hold on to
+      proxiedElement.clear();
+   }
+   
+   return lElement;
+}
+
 -(void)setNodeValue:(NSValue*)aValue
 {
+   Node *lElement = [self _liveElement];
+   if(!lElement)
+   {
+      return;
+   }
+   
    NSString *lValString = [aValue description];
    
-   int lIdx = proxiedElement->getParent()->getIndexOfChild(proxiedElement);
+   int lIdx = lElement->getParent()->getIndexOfChild(lElement);
    
    Node *lNewNode;
    if([lValString isEqualToString:@"true"])
@@ -99,21 +117,27 @@ static int computeChildCount(json::Node *element) {
       }
    }
    
-   proxiedElement->getParent()->setChildAt(lIdx, lNewNode);
+   lElement->getParent()->setChildAt(lIdx, lNewNode);
 }
 
 -(id) nodeValue
 {
-   if(!proxiedElement)
+   return [JsonCocoaNode valueOfElement:[self _liveElement]];
+}
+
++(NSString*) valueOfElement:(json::Node*)aElement
+{
+   Node *lElement = aElement;
+   if(!lElement)
       return nil;
       
-   switch(proxiedElement->getNodeTypeId())
+   switch(lElement->getNodeTypeId())
    {
       case ntNull:
          return @"null";
 
       case ntBoolean:
-         return ((BooleanNode*)proxiedElement)->getValue()?@"true":@"false";
+         return ((BooleanNode*)lElement)->getValue()?@"true":@"false";
 
       case ntObject:
          return @"[object]";
@@ -124,7 +148,7 @@ static int computeChildCount(json::Node *element) {
       default:
          {
             std::wstring lTxt;
-            proxiedElement->calculateJsonTextRepresentation(lTxt);
+            lElement->calculateJsonTextRepresentation(lTxt);
              return [NSString stringWithWstring:lTxt];
          }
    }
@@ -132,19 +156,25 @@ static int computeChildCount(json::Node *element) {
 
 -(NSString*) longNodeValue
 {
+    Node *lElement = [self _liveElement];
+    if(!lElement) {
+        return @"";
+    }
+    
     std::wstring lTxt;
-    proxiedElement->calculateJsonTextRepresentation(lTxt, 255);
+    lElement->calculateJsonTextRepresentation(lTxt, 255);
     return [NSString stringWithWstring:lTxt];
 }
 
 -(int)nodeType
 {
-   return proxiedElement->getNodeTypeId();
+   Node *lElement = [self _liveElement];
+   return lElement ? lElement->getNodeTypeId() : ntNull;
 }
 
 -(json::Node*)proxiedElement
 {
-   return proxiedElement;
+   return [self _liveElement];
 }
 
 
@@ -155,21 +185,23 @@ static int computeChildCount(json::Node *element) {
 
 -(void) setName:(NSString*)nodeName
 {
-    json::ObjectNode *objContainer = dynamic_cast<json::ObjectNode *>(proxiedElement->getParent());
+    Node *lElement = [self _liveElement];
+    json::ObjectNode *objContainer = lElement ? dynamic_cast<json::ObjectNode *>(lElement->getParent()) : NULL;
     if(objContainer) {
-        int indexInParent = objContainer->getIndexOfChild(proxiedElement);
+        int indexInParent = objContainer->getIndexOfChild(lElement);
         objContainer->renameMemberAt(indexInParent, wide_utf8_converter.from_bytes(nodeName.UTF8String));
         name = nodeName;
     }
 }
 
 -(BOOL) nameEditable {
-    return dynamic_cast<json::ObjectNode *>(proxiedElement->getParent()) != NULL;
+    Node *lElement = [self _liveElement];
+    return lElement && dynamic_cast<json::ObjectNode *>(lElement->getParent()) != NULL;
 }
 
 -(int)countOfChildren
 {
-    return childCount;
+    return [self _liveElement] ? childCount : 0;
 }
 
 -(JsonCocoaNode*)objectInChildrenAtIndex:(int)aIdx
@@ -180,7 +212,7 @@ static int computeChildCount(json::Node *element) {
 
 -(void)removeObjectFromChildrenAtIndex:(int)aIdx
 {
-   json::ContainerNode *lContainerNode = dynamic_cast<json::ContainerNode*>(proxiedElement);
+   json::ContainerNode *lContainerNode = dynamic_cast<json::ContainerNode*>([self _liveElement]);
    if(lContainerNode)
    {
       lContainerNode->removeChildAt(aIdx);
@@ -192,16 +224,22 @@ static int computeChildCount(json::Node *element) {
           atIndex:(int)aIndex
        fromParent:(JsonCocoaNode*)aParent;
 {
-   ContainerNode *lParentNode = proxiedElement->getParent();
-   int lIdxInParent = lParentNode->getIndexOfChild(proxiedElement);
+   Node *lElement = [self _liveElement];
+   Node *lNewParent = [aNewContainer proxiedElement];
+   if(!lElement || !lNewParent)
+   {
+      return;
+   }
+   
+   ContainerNode *lParentNode = lElement->getParent();
+   int lIdxInParent = lParentNode->getIndexOfChild(lElement);
    
    // Adjust underlying document: (a) detach child from current position
-   wstring lTxt = proxiedElement->getDocumentText();
+   TextString lTxt = lElement->getDocumentText();
    Node *lThis;
    lParentNode->detachChildAt(lIdxInParent, &lThis);
    
    // (b) Import to new position:
-   Node *lNewParent = [aNewContainer proxiedElement];
    
    // Fixup index if we're sliding an entry of the same object.
    if(lNewParent == lParentNode && aIndex > lIdxInParent)
@@ -227,11 +265,11 @@ static int computeChildCount(json::Node *element) {
 {
    [self willChangeValueForKey:@"children"];
    
-   json::ContainerNode *lContainerNode = dynamic_cast<json::ContainerNode*>(proxiedElement);
+   json::ContainerNode *lContainerNode = dynamic_cast<json::ContainerNode*>([self _liveElement]);
    
    [children insertObject:aChild atIndex:aIdx];
    
-   if(lContainerNode->getNodeTypeId() == ntArray)
+   if(lContainerNode && lContainerNode->getNodeTypeId() == ntArray)
    {
       for(int lIdx=aIdx; lIdx<[self countOfChildren]; lIdx++)
       {
@@ -247,11 +285,11 @@ static int computeChildCount(json::Node *element) {
 {
    [self willChangeValueForKey:@"children"];
 
-   json::ContainerNode *lContainerNode = dynamic_cast<json::ContainerNode*>(proxiedElement);
+   json::ContainerNode *lContainerNode = dynamic_cast<json::ContainerNode*>([self _liveElement]);
 
    [children removeObjectAtIndex:aIdx];
 
-   if(lContainerNode->getNodeTypeId() == ntArray)
+   if(lContainerNode && lContainerNode->getNodeTypeId() == ntArray)
    {
       for(int lIdx=aIdx; lIdx<[self countOfChildren]; lIdx++)
       {
@@ -273,7 +311,7 @@ static int computeChildCount(json::Node *element) {
 
 -(BOOL) isContainer
 {
-   return dynamic_cast<ContainerNode*>(proxiedElement)!=NULL;
+   return dynamic_cast<ContainerNode*>([self _liveElement])!=NULL;
 }
 
 -(void)_updateNameFromIndex:(int)aIdx
@@ -292,13 +330,14 @@ static int computeChildCount(json::Node *element) {
    
    NSMutableArray *lArray = [NSMutableArray array]; 
    
-   if(proxiedElement)
+   Node *lElement = [self _liveElement];
+   if(lElement)
    {
-      switch(proxiedElement->getNodeTypeId())
+      switch(lElement->getNodeTypeId())
       {
          case ntObject:
          {
-            ObjectNode *lObject = (ObjectNode *)proxiedElement;
+            ObjectNode *lObject = (ObjectNode *)lElement;
             for(ObjectNode::iterator lIter = lObject->begin();
                lIter != lObject->end();
                lIter++)
@@ -313,7 +352,7 @@ static int computeChildCount(json::Node *element) {
            
          case ntArray:
          {
-            ArrayNode *lJsonArray = (ArrayNode*)proxiedElement;
+            ArrayNode *lJsonArray = (ArrayNode*)lElement;
             int lIdx = 0;
             for(ArrayNode::iterator lIter = lJsonArray->begin();
                lIter != lJsonArray->end();
@@ -333,7 +372,8 @@ static int computeChildCount(json::Node *element) {
 
 -(json::TextRange)textRange
 {
-   return proxiedElement->getAbsTextRange();
+   Node *lElement = [self _liveElement];
+   return lElement ? lElement->getAbsTextRange() : json::TextRange();
 }
 
 -(int)indexOfChildWithName:(NSString*)aName
@@ -370,9 +410,9 @@ static int computeChildCount(json::Node *element) {
     [self willChangeValueForKey:@"nodeType"];
     [self willChangeValueForKey:@"nodeValue"];
     
-    proxiedElement = aProxiedElement;
+    proxiedElement.assign(aProxiedElement);
     children = nil;
-    childCount = computeChildCount(proxiedElement);
+    childCount = computeChildCount(proxiedElement.get());
     
     [self didChangeValueForKey:@"nodeValue"];
     [self didChangeValueForKey:@"nodeType"];
@@ -13,6 +13,8 @@
 #include "BookmarksList.h"
 #include "JsonFileListenerObjCBridge.h"
 
+@class JsonMarker;
+
 using namespace json;
 
 extern NSString *JsonDocumentBookmarkChangeNotification;
@@ -22,6 +24,7 @@ extern NSString *JsonDocumentSemanticModelUpdatedNotificationReasonNodeInvalidat
 extern NSString *JsonDocumentSemanticModelUpdatedNotificationReasonReparse;
 
 class BookmarksListenerBridge;
+class JsonPathResultCache;
 
 @interface JsonDocument : NSDocument<ObjCJsonFileChangeListener, NSTextStorageDelegate> {
 }
@@ -46,19 +49,23 @@ class BookmarksListenerBridge;
 -(const MarkerList<ParseErrorMarker>*)errors;
 
 -(NSArray*)problems; // This is errors + schema errors, cocoa'ed
+-(NSUInteger)indexOfProblem:(JsonMarker*)aProblem near:(NSUInteger)aHint;
 -(NSArray*)bookmarkMarkers; // This is boomarks, cocoa'ed
 
 -(JsonFile*)jsonFile;
+// Results of queries over the document, e.g searches and projections, kept across unrelated edits
+-(JsonPathResultCache*)jsonPathResultCache;
 -(NSIndexPath*)pathFromJsonPathString:(NSString*)jsonPathString;
 
 -(void)reindentStartingAt:(TextCoordinate)aOffsetStart
                       len:(TextLength)aLen
     suggestNewEndLocation:(TextCoordinate*)newEndLocation;
+-(void)applyEdits:(const std::vector<json::Splice>&)aEdits;
 
 -(int)suggestIdentForNewLineAt:(TextCoordinate)where;
 -(int)suggestCloserIndentAt:(TextCoordinate)where getLineStart:(TextCoordinate*)lineStart;
 
--(void)notifyErrorsChanged:(json::JsonFile*)aSender;
+-(void)notifyErrorsChanged:(json::JsonFile*)aSender delta:(const MarkerListDelta&)aDelta;
 -(void)notifyNodeInvalidated:(json::JsonFile*)aSender nodePath:(const json::JsonPath&)nodePath;
 -(void)notifyBookmarksUpdated;
 
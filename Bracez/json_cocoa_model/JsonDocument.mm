@@ -8,18 +8,26 @@
 
 #import "JsonDocument.h"
 #import "JsonMarker.h"
-#import "SyntaxHilightJsonVisitor.h"
+#import "NodeTypeToColorTransformer.h"
 #import "NSString+WStringUtils.h"
 #include "BracezPreferences.h"
 #include "marker_list.h"
 #include "JsonIndentFormatter.hpp"
 #include "stopwatch.h"
 #include "JsonDocumentEditingRecorder.hpp"
+#include "JsonPathResultCache.hpp"
 
 //#define USE_JSON_TEXT_STORAGE 1
 
 #define MAX_LOCAL_EDIT_LEN 1024
 
+// Number of characters parsed synchronously when opening a document; should
+// comfortably cover the initially visible part of the document.
+#define SPECULATIVE_PARSE_LEN (64*1024)
+
+// Ranges at least this long are colored from a snapshot lexed in the background
+#define BACKGROUND_HIGHLIGHT_MIN_LEN (256*1024)
+
 NSString *JsonDocumentBookmarkChangeNotification =
 @"com.zigsterz.braces.jsondocument.bookmarkchange";
 
@@ -35,6 +43,16 @@ NSString *JsonDocumentSemanticModelUpdatedNotificationReasonNodeInvalidation =
 NSString *JsonDocumentSemanticModelUpdatedNotificationReasonReparse =
 @"reparse";
 
+// Color for a token class, or nil for the default one
+static NSColor *colorForTokenClass(NodeTypeToColorTransformer *aColors, LexicalTokenClass aTokenClass) {
+    switch(aTokenClass) {
+        case ltcString: return [aColors colorForNodeType:ntString];
+        case ltcKey: return [aColors keyColor];
+        case ltcNumber: return [aColors colorForNodeType:ntNumber];
+        case ltcLiteral: return [aColors colorForNodeType:ntBoolean];
+        default: return nil;
+    }
+}
 
 @interface JsonTextStorage : NSTextStorage {
     JsonFile *_file;
@@ -59,8 +77,8 @@ NSString *JsonDocumentSemanticModelUpdatedNotificationReasonReparse =
     [self beginEditing];
     _file = file;
     _colors = (NodeTypeToColorTransformer*)[NSValueTransformer valueTransformerForName:@"NodeTypeToColorTransformer"];
-    _string = [[NSMutableString stringWithWstring:file->getText()] mutableCopy];
-    [self replaceCharactersInRange:NSMakeRange(0, _string.length) withString:[NSString stringWithWstring:_file->getText()]];
+    _string = [[NSMutableString stringWithU16string:file->getText()] mutableCopy];
+    [self replaceCharactersInRange:NSMakeRange(0, _string.length) withString:[NSString stringWithU16string:_file->getText()]];
     [self endEditing];
 }
 
@@ -81,81 +99,27 @@ NSString *JsonDocumentSemanticModelUpdatedNotificationReasonReparse =
 }
 
 -(NSDictionary<NSAttributedStringKey,id> *)attributesAtIndex:(NSUInteger)location effectiveRange:(NSRangePointer)range {
+    NSColor *color = nil;
     if(_file) {
-        const Node *n = _file->findNodeContaining(TextCoordinate(location), NULL);
-        if(n) {
-            switch(n->getNodeTypeId()) {
-                case json::ntNumber:
-                case json::ntString:
-                case json::ntBoolean:
-                case json::ntNull:
-                    {
-                        NSColor *color = [_colors colorForNodeType:n->getNodeTypeId()];
-                        if(range) {
-                            json::TextRange textRange = n->getAbsTextRange();
-                            range->location = textRange.start;
-                            range->length = textRange.length();
-                        }
-                        return @{ NSForegroundColorAttributeName: color,
-                                  NSFontAttributeName: _font
-                        };
-                    }
-                                        
-                case json::ntObject:
-                {
-                    const ContainerNode *obj = (const ContainerNode*)n;
-                    
-                    int childIdx = obj->findChildEndingAfter(TextCoordinate(location).relativeTo(obj->getAbsTextRange().start));
-                    const Node *nextChild = childIdx >= 0 ? obj->getChildAt(childIdx) : NULL;
-                    const Node *prevChild = childIdx > 0 ? obj->getChildAt(childIdx-1) : NULL;
-                    
-                    if(range) {
-                        if(prevChild) {
-                            range->location = prevChild->getAbsTextRange().end;
-                        } else {
-                            range->location = n->getAbsTextRange().start;
-                        }
-                                                
-                        if(nextChild) {
-                            range->length = nextChild->getAbsTextRange().start - range->location;
-                        } else {
-                            range->length = n->getAbsTextRange().end - range->location;
-                        }
-                    }
-                    return @{
-                              NSFontAttributeName: _font};
-                }
-                    
-                case json::ntArray:
-                {
-                    const ContainerNode *obj = (const ContainerNode*)n;
-                    int childIdx = obj->findChildEndingAfter(TextCoordinate(location).relativeTo(obj->getAbsTextRange().start));
-                    const Node *child = childIdx >= 0 ? obj->getChildAt(childIdx) : NULL;
-
-                    if(range) {
-                        range->location = location;
-                        if(child && location < child->getAbsTextRange().start) {
-                            range->length = child->getAbsTextRange().start - location;
-                        } else
-                        {
-                            range->length = n->getAbsTextRange().end - location;
-                        }
-                    }
-                    return @{
-                              NSFontAttributeName: _font};
-                }
-            }
+        TextCoordinate runStart, runEnd;
+        const SyntaxRun *run = _file->getSyntaxRuns().findRun(TextCoordinate(location), TextCoordinate(_string.length),
+                                                              runStart, runEnd);
+        if(run) {
+            color = colorForTokenClass(_colors, run->getTokenClass());
         }
+        
+        if(range) {
+            range->location = runStart.getAddress();
+            range->length = runEnd - runStart;
+        }
+    } else if(range) {
+        range->location = location;
+        range->length = _string.length - location;
     }
     
-    if(range) {
-        json::TextRange docTr = _file->getDom()->getTextRange();
-        range->location = location;
-        if(location < docTr.start) {
-            range->length = docTr.start - location;
-        } else {
-            range->length = _string.length - location;
-        }
+    if(color) {
+        return @{ NSForegroundColorAttributeName: color,
+                  NSFontAttributeName: _font };
     }
     
     return @{ NSFontAttributeName: _font };
@@ -166,6 +130,7 @@ NSString *JsonDocumentSemanticModelUpdatedNotificationReasonReparse =
 
 @interface JsonDocument () {
     BOOL _isSemanticModelTextChangeInProgress;
+    int _textSpliceBatchDepth;
     BOOL _isSemanticModelDirty;
     BOOL _isSemanticModelUpdateInProgress;
     std::shared_ptr<JsonFileSemanticModelReconciliationTask> currentReconciliationTask;
@@ -177,11 +142,12 @@ NSString *JsonDocumentSemanticModelUpdatedNotificationReasonReparse =
     JsonFileListenerObjCBridge *jsonSemanticListenerBridge;
     BookmarksListenerBridge *bookmarksListenerBridge;
     
-    NSArray *problemWrappers;
+    NSMutableArray *problemWrappers;
     NSArray *bookmarkWrappers;
         
     JsonCocoaNode *_cocoaNode;
     JsonDocumentEditingRecorder *_jsonEditingRecorder;
+    JsonPathResultCache *_jsonPathResultCache;
 }
 
 @end
@@ -257,6 +223,11 @@ private:
         delete _jsonEditingRecorder;
     }
     
+    if(_jsonPathResultCache) {
+        delete _jsonPathResultCache;
+        _jsonPathResultCache = NULL;
+    }
+    
     if(file) {
         delete file;
         file = NULL;
@@ -278,7 +249,30 @@ private:
 {
     NSString *dataAsString = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
     
-    [self.textStorage.mutableString setString:dataAsString];
+    // Text is shown right away with the beginning of the document already parsed;
+    // the rest of the semantic model is built in the background.
+    _isSemanticModelDirty = YES;
+
+    [self willChangeValueForKey:@"documentBusy"];
+    [self cancelCurrentReconciliationTask];
+    
+    // This keeps the reconciliation task alive for as long as it's running
+    std::shared_ptr<JsonFileSemanticModelReconciliationTask> reconcile =
+        file->setTextWithSpeculativeParse(dataAsString.cStringU16string, SPECULATIVE_PARSE_LEN);
+    currentReconciliationTask = reconcile;
+    [self didChangeValueForKey:@"documentBusy"];
+
+    [self willChangeValueForKey:@"rootNode"];
+    _cocoaNode = nil;
+    [self didChangeValueForKey:@"rootNode"];
+
+    if(reconcile) {
+        [self updateSyntaxInRange:NSMakeRange(0, MIN(self.textStorage.length, SPECULATIVE_PARSE_LEN))];
+        [self executeReconciliationTask:reconcile];
+    } else {
+        _isSemanticModelDirty = NO;
+        [self updateSyntaxInRange:NSMakeRange(0, self.textStorage.length)];
+    }
     
     [self updateChangeCount:NSChangeCleared];
     return YES;
@@ -332,11 +326,7 @@ private:
             lIter != lParseErrors.end();
             lIter++)
         {
-            [lProbArray addObject:[[JsonMarker alloc] initWithDescription:[NSString stringWithUTF8String:lIter->getErrorText().c_str()]
-                                                               markerType:JsonMarkerTypeError
-                                                                     code:0
-                                                               coordinate:(TextCoordinate)*lIter
-                                                                parentDoc:self]];
+            [lProbArray addObject:[JsonMarker markerForError:*lIter atIndex:lProbArray.count withParentDoc:self]];
         }
         
         problemWrappers = lProbArray;
@@ -344,11 +334,38 @@ private:
     return problemWrappers;
 }
 
+-(NSUInteger)indexOfProblem:(JsonMarker*)aProblem near:(NSUInteger)aHint
+{
+    // Wrappers only move by the errors added or removed before them, so look outwards from where it was
+    NSUInteger lCount = problemWrappers.count;
+    for(NSUInteger lDist = 0; lDist <= aHint || aHint + lDist < lCount; lDist++)
+    {
+        if(aHint + lDist < lCount && problemWrappers[aHint + lDist] == aProblem)
+        {
+            return aHint + lDist;
+        }
+        if(lDist && lDist <= aHint && aHint - lDist < lCount && problemWrappers[aHint - lDist] == aProblem)
+        {
+            return aHint - lDist;
+        }
+    }
+    return NSNotFound;
+}
+
 -(JsonFile*)jsonFile
 {
     return file;
 }
 
+-(JsonPathResultCache*)jsonPathResultCache
+{
+    if(!_jsonPathResultCache) {
+        _jsonPathResultCache = new JsonPathResultCache(file);
+    }
+    
+    return _jsonPathResultCache;
+}
+
 -(BookmarksList&)bookmarks
 {
     return bookmarks;
@@ -406,7 +423,7 @@ private:
 {
     int lRow;
     int lCol;
-    file->getCoordinateRowCol(aCoord, lRow, lCol);
+    file->getCoordinateRowCharacterCol(aCoord, lRow, lCol);
     
     *aRow = lRow;
     *aCol = lCol;
@@ -431,23 +448,73 @@ private:
                numAddedLines:(TextLength)aNewLineLength
 {
     if(!_isSemanticModelUpdateInProgress) {
-        _isSemanticModelTextChangeInProgress = YES;
+        [self beginTextSpliceBatch];
         
-        NSString *lNewText = [NSString stringWithWstring:aSender->getText().substr(aOldOffset.getAddress(), aNewLength)];
+        NSString *lNewText = [NSString stringWithU16chars:aSender->getText().data() + aOldOffset.getAddress()
+                                                   length:aNewLength];
         [self.textStorage replaceCharactersInRange:NSMakeRange(aOldOffset.getAddress(), aOldLength)
                                         withString:lNewText];
         
-        _isSemanticModelTextChangeInProgress = NO;
+        [self endTextSpliceBatch];
     }
     
     self.bookmarks.updateBookmarksByLineSplice(aOldLineStart+1, aOldLineLength, aNewLineLength);
 }
 
--(void)notifyErrorsChanged:(json::JsonFile*)aSender
+// Text the model splices is applied to the text storage as a single edit, so it's processed --
+// the document marked changed and the edited range colored -- once for all the splices
+-(void)beginTextSpliceBatch
+{
+    if(!_textSpliceBatchDepth++)
+    {
+        _isSemanticModelTextChangeInProgress = YES;
+        [self.textStorage beginEditing];
+    }
+}
+
+-(void)endTextSpliceBatch
 {
-    [self willChangeValueForKey:@"problems"];
-    problemWrappers = nil;
-    [self didChangeValueForKey:@"problems"];
+    if(_textSpliceBatchDepth == 1)
+    {
+        [self.textStorage endEditing];
+        _isSemanticModelTextChangeInProgress = NO;
+    }
+    _textSpliceBatchDepth--;
+}
+
+-(void)notifyErrorsChanged:(json::JsonFile*)aSender delta:(const MarkerListDelta&)aDelta
+{
+    if(!problemWrappers)
+    {
+        [self willChangeValueForKey:@"problems"];
+        [self didChangeValueForKey:@"problems"];
+        return;
+    }
+    
+    // Patch only the wrappers in the changed range; shifted errors read their new
+    // coordinate from the file when they're next looked at
+    if(aDelta.numRemoved)
+    {
+        NSIndexSet *lRemoved = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(aDelta.index, aDelta.numRemoved)];
+        [self willChange:NSKeyValueChangeRemoval valuesAtIndexes:lRemoved forKey:@"problems"];
+        [problemWrappers removeObjectsAtIndexes:lRemoved];
+        [self didChange:NSKeyValueChangeRemoval valuesAtIndexes:lRemoved forKey:@"problems"];
+    }
+    
+    if(aDelta.numInserted)
+    {
+        NSIndexSet *lInserted = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(aDelta.index, aDelta.numInserted)];
+        NSMutableArray *lNewProblems = [NSMutableArray arrayWithCapacity:aDelta.numInserted];
+        const MarkerList<ParseErrorMarker> &lParseErrors = file->getErrors();
+        for(size_t lIdx = aDelta.index; lIdx < aDelta.index + aDelta.numInserted; lIdx++)
+        {
+            [lNewProblems addObject:[JsonMarker markerForError:lParseErrors[(int)lIdx] atIndex:lIdx withParentDoc:self]];
+        }
+        
+        [self willChange:NSKeyValueChangeInsertion valuesAtIndexes:lInserted forKey:@"problems"];
+        [problemWrappers insertObjects:lNewProblems atIndexes:lInserted];
+        [self didChange:NSKeyValueChangeInsertion valuesAtIndexes:lInserted forKey:@"problems"];
+    }
 }
 
 -(void)notifyBookmarksUpdated
@@ -460,9 +527,17 @@ private:
                                                       userInfo:nil];
 }
 
+-(BOOL)canAsynchronouslyWriteToURL:(NSURL *)url ofType:(NSString *)typeName forSaveOperation:(NSSaveOperationType)saveOperation {
+    return [typeName isEqualToString:@"JsonFile"];
+}
+
 -(NSData *)dataOfType:(NSString *)typeName error:(NSError * _Nullable __autoreleasing *)outError {
     if([typeName isEqualToString:@"JsonFile"]) {
-        return [self.textStorage.string dataUsingEncoding:NSUTF8StringEncoding];
+        // Saves run on a background thread while the main thread waits; it's let go as soon
+        // as the text is snapshotted, and editing goes on while the snapshot is encoded
+        std::shared_ptr<const JsonFileSnapshot> snapshot = file->getSnapshot();
+        [self unblockUserInteraction];
+        return [[NSString stringWithU16string:snapshot->getText()] dataUsingEncoding:NSUTF8StringEncoding];
     } else {
         NSLog(@"Invalid typename for dataOfType:%@", typeName);
         return nil;
@@ -491,13 +566,13 @@ private:
                 bool fastSpliceSuccess =
                     file->fastSpliceTextWithWorkLimit(TextCoordinate(editedRange.location),
                                                        editedRange.length-delta,
-                                                       updatedRegion.cStringWstring,
+                                                       updatedRegion.cStringU16string,
                                                        MAX_LOCAL_EDIT_LEN);
                 
                 if(fastSpliceSuccess && _jsonEditingRecorder) {
                     _jsonEditingRecorder->recordFastSplice(file, TextCoordinate(editedRange.location),
                                                       editedRange.length-delta,
-                                                      updatedRegion.cStringWstring);
+                                                      updatedRegion.cStringU16string);
                 }
                 
                 shouldSlowSplice = !fastSpliceSuccess;
@@ -508,13 +583,16 @@ private:
                 _isSemanticModelDirty = YES;
                 [self slowSpliceFileContentAt:TextCoordinate(editedRange.location)
                                        length:editedRange.length-delta
-                                      newText:updatedRegion.cStringWstring];
+                                      newText:updatedRegion.cStringU16string];
             }
         }
 
 
         if(!_isSemanticModelDirty) {
             [self updateSyntaxInRange:editedRange];
+        } else {
+            // No DOM to go by till the model is reconciled; color the edited lines by tokens
+            [self updateLexicalSyntaxInRange:[textStorage.string lineRangeForRange:editedRange]];
         }
     }
 }
@@ -523,22 +601,30 @@ private:
 -(void)reindentStartingAt:(TextCoordinate)aOffsetStart
                       len:(TextLength)aLen
     suggestNewEndLocation:(TextCoordinate*)newEndLocation {
-    std::wstring jsonText = _textStorage.string.cStringWstring;
-    
     // Get line start
     int row, col;
     file->getCoordinateRowCol(aOffsetStart, row, col);
     aOffsetStart = aOffsetStart - (col - 1);
     aLen += (col - 1);
     
-    JsonIndentFormatter fixer(jsonText, *file, aOffsetStart, aLen,
+    // Copy the splices: applying them changes the file text the formatter reads
+    JsonIndentFormatter fixer(*file, aOffsetStart, aLen,
                               [BracezPreferences sharedPreferences].indentSize);
-    const std::wstring &indent = fixer.getIndented();
-    aLen = fixer.getIndentedLength();
+    std::vector<json::Splice> splices = fixer.getIndentSplices();
+    TextCoordinate newEnd = aOffsetStart + fixer.getIndentedLength();
+    
+    // Apply last to first so that offsets remain valid; the text storage reports
+    // them to the model as a single edit when editing ends.
+    [_textStorage beginEditing];
+    for(auto splice = splices.rbegin(); splice != splices.rend(); splice++) {
+        [_textStorage replaceCharactersInRange:NSMakeRange(splice->start.getAddress(), splice->len)
+                                    withString:[NSString stringWithU16string:splice->newText]];
+        newEnd += (long)splice->newText.length() - (long)splice->len;
+    }
+    [_textStorage endEditing];
     
-    [_textStorage replaceCharactersInRange:NSMakeRange(aOffsetStart, aLen) withString:[NSString stringWithWstring:indent]];
     if(newEndLocation) {
-        *newEndLocation = aOffsetStart + indent.length();
+        *newEndLocation = newEnd;
     }
 }
 
@@ -591,6 +677,11 @@ private:
 
 -(void)updateSyntaxInRange:(NSRange)editedRange {
 #ifndef USE_JSON_TEXT_STORAGE
+    if(editedRange.length >= BACKGROUND_HIGHLIGHT_MIN_LEN) {
+        [self updateSyntaxInBackgroundInRange:editedRange];
+        return;
+    }
+    
     NSFont *lFont = [[BracezPreferences sharedPreferences] editorFont];
     NSColor *lDefaultColor = [[BracezPreferences sharedPreferences] editorColorDefault];
     stopwatch lStopWatch("Update syntax coloring");
@@ -607,14 +698,101 @@ private:
         NSForegroundColorAttributeName: lDefaultColor
     } range:editedRange];
     
-    SyntaxHighlightJsonVisitor visitor(self.textStorage, editedRange);
-    json::TextRange editedRangeTR(TextCoordinate(editedRange.location), TextCoordinate(editedRange.location+editedRange.length));
-    file->getDom()->acceptInRange(&visitor, editedRangeTR);
+    NodeTypeToColorTransformer *lColors = (NodeTypeToColorTransformer*)[NSValueTransformer valueTransformerForName:@"NodeTypeToColorTransformer"];
+    auto lRuns = file->getSyntaxRuns().runsIntersecting(TextCoordinate(editedRange.location),
+                                                        TextCoordinate(editedRange.location+editedRange.length));
+    for(auto lIter = lRuns.first; lIter != lRuns.second; lIter++) {
+        NSColor *lColor = colorForTokenClass(lColors, lIter->getTokenClass());
+        NSRange lRange = NSIntersectionRange(NSMakeRange(lIter->getCoordinate().getAddress(), lIter->getLength()), editedRange);
+        if(lColor && lRange.length) {
+            [self.textStorage addAttribute:NSForegroundColorAttributeName value:lColor range:lRange];
+        }
+    }
 
     [self.textStorage endEditing];
 #endif
 }
 
+-(void)updateLexicalSyntaxInRange:(NSRange)editedRange {
+#ifndef USE_JSON_TEXT_STORAGE
+    stopwatch lStopWatch("Update lexical syntax coloring");
+    
+    std::vector<LexicalSpan> lSpans;
+    file->getLexicalSpans(TextCoordinate(editedRange.location), TextCoordinate(editedRange.location+editedRange.length), lSpans);
+    [self applyLexicalSpans:lSpans inRange:editedRange];
+#endif
+}
+
+#ifndef USE_JSON_TEXT_STORAGE
+// Large ranges (e.g the rest of the document once it's reconciled) are lexed on a background
+// queue, from a snapshot, and colored by tokens once the spans are in; these match the semantic
+// model's colors for all but text that doesn't parse. Spans of text that was edited since are
+// dropped, and what's left of the range is lexed again.
+-(void)updateSyntaxInBackgroundInRange:(NSRange)aRange {
+    // Lexed from the start of the token the range starts in, so it starts outside of any string
+    TextCoordinate lStart(aRange.location);
+    TextCoordinate lEnd(aRange.location + aRange.length);
+    TextCoordinate lRunStart, lRunEnd;
+    if(file->getSyntaxRuns().findRun(lStart, TextCoordinate(self.textStorage.length), lRunStart, lRunEnd) &&
+       lRunStart < lStart) {
+        lStart = lRunStart;
+    }
+    
+    std::shared_ptr<const JsonFileSnapshot> lSnapshot = file->getSnapshot();
+    __weak JsonDocument *weakSelf = self;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        auto lSpans = std::make_shared<std::vector<LexicalSpan>>();
+        lSnapshot->getTokenSpans(lStart, lEnd, *lSpans);
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakSelf syntaxSpans:lSpans lexedFrom:lSnapshot inRange:aRange];
+        });
+    });
+}
+
+-(void)syntaxSpans:(std::shared_ptr<std::vector<LexicalSpan>>)aSpans
+         lexedFrom:(std::shared_ptr<const JsonFileSnapshot>)aSnapshot
+           inRange:(NSRange)aRange {
+    if(!file->getSnapshot()->hasSameText(*aSnapshot)) {
+        NSRange lRange = NSIntersectionRange(aRange, NSMakeRange(0, self.textStorage.length));
+        if(lRange.length) {
+            [self updateSyntaxInRange:lRange];
+        }
+        return;
+    }
+    
+    [self applyLexicalSpans:*aSpans inRange:aRange];
+}
+
+-(void)applyLexicalSpans:(const std::vector<LexicalSpan>&)aSpans inRange:(NSRange)editedRange {
+    NSFont *lFont = [[BracezPreferences sharedPreferences] editorFont];
+    NSColor *lDefaultColor = [[BracezPreferences sharedPreferences] editorColorDefault];
+    NodeTypeToColorTransformer *lColors = (NodeTypeToColorTransformer*)[NSValueTransformer valueTransformerForName:@"NodeTypeToColorTransformer"];
+
+    [self.textStorage beginEditing];
+    
+    if(editedRange.location == 0 &&
+       editedRange.length == self.textStorage.length) {
+        self.textStorage.font = lFont;
+    }
+    
+    [self.textStorage setAttributes:@{
+        NSFontAttributeName: lFont,
+        NSForegroundColorAttributeName: lDefaultColor
+    } range:editedRange];
+    
+    for(const LexicalSpan &lSpan: aSpans) {
+        NSColor *lColor = colorForTokenClass(lColors, lSpan.tokenClass);
+        NSRange lRange = NSIntersectionRange(NSMakeRange(lSpan.start.getAddress(), lSpan.length), editedRange);
+        if(lColor && lRange.length) {
+            [self.textStorage addAttribute:NSForegroundColorAttributeName value:lColor range:lRange];
+        }
+    }
+
+    [self.textStorage endEditing];
+}
+#endif
+
 -(void)cancelCurrentReconciliationTask {
     if(currentReconciliationTask.get()) {
         currentReconciliationTask->cancelExecution();
@@ -622,7 +800,7 @@ private:
     }
 }
 
--(void)slowSpliceFileContentAt:(TextCoordinate)aOffsetStart length:(TextLength)aLen newText:(const std::wstring &)aNewText {
+-(void)slowSpliceFileContentAt:(TextCoordinate)aOffsetStart length:(TextLength)aLen newText:(const TextString &)aNewText {
     _isSemanticModelUpdateInProgress = true;
 
     [self willChangeValueForKey:@"documentBusy"];
@@ -639,6 +817,33 @@ private:
 
     _isSemanticModelUpdateInProgress = false;
 
+    [self executeReconciliationTask:reconcile];
+}
+
+-(void)applyEdits:(const std::vector<json::Splice>&)aEdits {
+    // Text storage is updated through notifyJsonTextSpliced once the model is thru, in a single
+    // text storage edit
+    [self beginTextSpliceBatch];
+    std::shared_ptr<JsonFileSemanticModelReconciliationTask> reconcile = file->applyEdits(aEdits, MAX_LOCAL_EDIT_LEN);
+    if(reconcile) {
+        // Colored by tokens when the batch is processed
+        _isSemanticModelDirty = YES;
+    }
+    [self endTextSpliceBatch];
+    if(!reconcile) {
+        return;
+    }
+    
+    // Edits couldn't be reparsed locally; finish the model in the background
+    [self willChangeValueForKey:@"documentBusy"];
+    [self cancelCurrentReconciliationTask];
+    currentReconciliationTask = reconcile;
+    [self didChangeValueForKey:@"documentBusy"];
+    
+    [self executeReconciliationTask:reconcile];
+}
+
+-(void)executeReconciliationTask:(std::shared_ptr<JsonFileSemanticModelReconciliationTask>)reconcile {
     dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
         bool taskCancelled = false;
         try {
@@ -651,20 +856,13 @@ private:
         dispatch_async(dispatch_get_main_queue(), ^{
             if(self->currentReconciliationTask == reconcile) {
                 if(!taskCancelled) {
-                    self->file->applyReconciliationTask(reconcile);
+                    // Nodes that changed are refreshed through notifyNodeInvalidated, errors
+                    // through notifyErrorsChanged and coloring through notifySyntaxRunsChanged
                     self->_isSemanticModelUpdateInProgress = true;
-                    [self willChangeValueForKey:@"rootNode"];
-                    [self willChangeValueForKey:@"problems"];
-
-                    self->_cocoaNode = nil;
-                    self->problemWrappers = nil;
-                    
-                    [self didChangeValueForKey:@"problems"];
-                    [self didChangeValueForKey:@"rootNode"];
+                    self->file->applyReconciliationTask(reconcile);
                     self->_isSemanticModelUpdateInProgress = false;
                     self->_isSemanticModelDirty = NO;
 
-                    [self updateSyntaxInRange:NSMakeRange(0, self.textStorage.string.length)];
                     [self notifySemanticModelUpdatedWithReason:JsonDocumentSemanticModelUpdatedNotificationReasonReparse];
                 }
                 
@@ -693,17 +891,73 @@ private:
 }
 
 
+-(void)notifySyntaxRunsChanged:(json::JsonFile*)aSender delta:(const MarkerListDelta&)aDelta {
+    // Text loaded with setText is colored by readFromData; reparses recolor what they changed
+    if(!_isSemanticModelUpdateInProgress) {
+        return;
+    }
+    
+    TextCoordinate lStart, lEnd;
+    aSender->getSyntaxRuns().getChangedRange(aDelta, TextCoordinate(self.textStorage.length), lStart, lEnd);
+    if(lEnd > lStart) {
+        [self updateSyntaxInRange:NSMakeRange(lStart.getAddress(), lEnd.getAddress() - lStart.getAddress())];
+    }
+}
+
+-(void)notifyJsonFileChanged:(json::JsonFile*)aSender changeSet:(const json::JsonFileChangeSet&)aChangeSet {
+    // Splices make a single text storage edit
+    [self beginTextSpliceBatch];
+    for(const JsonFileChangeSet::TextSplice &lSplice: aChangeSet.splices) {
+        [self notifyJsonTextSpliced:aSender
+                               from:lSplice.offsetStart
+                             length:lSplice.len
+                          newLength:lSplice.newLen
+                  affectedLineStart:lSplice.lineOffsetStart
+                    numDeletedLines:lSplice.lineLen
+                      numAddedLines:lSplice.lineNewLen];
+    }
+    [self endTextSpliceBatch];
+    
+    // Observers hear of the refreshed nodes, the errors and the coloring once per batch
+    for(const JsonPath &lPath: aChangeSet.refreshedNodes) {
+        [self reloadNodeAtPath:lPath];
+    }
+    if(!aChangeSet.refreshedNodes.empty()) {
+        [self notifySemanticModelUpdatedWithReason:JsonDocumentSemanticModelUpdatedNotificationReasonNodeInvalidation];
+    }
+    
+    if(aChangeSet.errorsChanged) {
+        [self notifyErrorsChanged:aSender delta:aChangeSet.errorsDelta];
+    }
+    
+    if(aChangeSet.syntaxRunsChanged) {
+        [self notifySyntaxRunsChanged:aSender delta:aChangeSet.syntaxRunsDelta];
+    }
+}
+
 -(void)notifyNodeInvalidated:(json::JsonFile*)aSender nodePath:(const json::JsonPath&)nodePath {
+    [self reloadNodeAtPath:nodePath];
+    [self notifySemanticModelUpdatedWithReason:JsonDocumentSemanticModelUpdatedNotificationReasonNodeInvalidation];
+}
+
+-(void)reloadNodeAtPath:(const json::JsonPath&)nodePath {
+    if(nodePath.empty()) {
+        [self willChangeValueForKey:@"rootNode"];
+        _cocoaNode = nil;
+        [self didChangeValueForKey:@"rootNode"];
+        return;
+    }
     
+    // The node's element may have been replaced, so its new element is looked up from the parent's
+    JsonCocoaNode *parent = nil;
     JsonCocoaNode *node = self.rootNode;
     
     for(auto iter = nodePath.begin(); iter != nodePath.end(); iter++) {
+        parent = node;
         node = [node objectInChildrenAtIndex:*iter];
     }
     
-    [node reloadFromElement: ((json::ContainerNode*)node.proxiedElement->getParent())->getChildAt(nodePath.back())];
-    
-    [self notifySemanticModelUpdatedWithReason:JsonDocumentSemanticModelUpdatedNotificationReasonNodeInvalidation];
+    [node reloadFromElement: ((json::ContainerNode*)parent.proxiedElement)->getChildAt(nodePath.back())];
 }
 
 -(void)notifySemanticModelUpdatedWithReason:(NSString*)reason {
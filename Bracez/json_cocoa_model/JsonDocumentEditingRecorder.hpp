@@ -15,8 +15,8 @@ public:
     virtual ~JsonDocumentEditingRecorder() {}
     
     virtual void prepareToRecordSpliceOnFile(json::JsonFile *file) = 0;
-    virtual void recordFastSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const std::wstring &newText) = 0;
-    virtual void recordSlowSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const std::wstring &newText) = 0;
+    virtual void recordFastSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const TextString &newText) = 0;
+    virtual void recordSlowSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const TextString &newText) = 0;
 
 public:
     static  JsonDocumentEditingRecorder *createForFile(json::JsonFile *file);
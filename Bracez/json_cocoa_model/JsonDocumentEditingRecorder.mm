@@ -25,7 +25,7 @@ public:
         if(needToEmitFileContent) {
             json::ObjectNode commandNode;
             commandNode.domAddMemberNode(L"action", new json::StringNode(L"file_content"));
-            commandNode.domAddMemberNode(L"content", new json::StringNode(file->getText()));
+            commandNode.domAddMemberNode(L"content", new json::StringNode(wstringFromText(file->getText())));
 
             std::wstring command;
             commandNode.calculateJsonTextRepresentation(command);
@@ -36,12 +36,12 @@ public:
         }
     }
     
-    virtual void recordFastSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const std::wstring &newText) {
+    virtual void recordFastSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const TextString &newText) {
         json::ObjectNode commandNode;
         commandNode.domAddMemberNode(L"action", new json::StringNode(L"splice"));
         commandNode.domAddMemberNode(L"start", new json::NumberNode(start.getAddress()));
         commandNode.domAddMemberNode(L"len", new json::NumberNode(len));
-        commandNode.domAddMemberNode(L"new_text", new json::StringNode(newText));
+        commandNode.domAddMemberNode(L"new_text", new json::StringNode(wstringFromText(newText)));
 
         std::wstring command;
         commandNode.calculateJsonTextRepresentation(command);
@@ -49,7 +49,7 @@ public:
         outputCommand(command);
     }
 
-    virtual void recordSlowSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const std::wstring &newText) {
+    virtual void recordSlowSplice(json::JsonFile *file, TextCoordinate start, TextLength len, const TextString &newText) {
         needToEmitFileContent = true;
     }
     
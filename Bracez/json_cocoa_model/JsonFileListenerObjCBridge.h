@@ -21,9 +21,15 @@
              numDeletedLines:(TextLength)aOldLineLength
                numAddedLines:(TextLength)aNewLineLength;
 
--(void)notifyErrorsChanged:(json::JsonFile*)aSender;
+-(void)notifyErrorsChanged:(json::JsonFile*)aSender delta:(const MarkerListDelta&)aDelta;
 -(void)notifyNodeInvalidated:(json::JsonFile*)aSender nodePath:(const json::JsonPath&)nodePath;
 
+@optional
+-(void)notifySyntaxRunsChanged:(json::JsonFile*)aSender delta:(const MarkerListDelta&)aDelta;
+
+// A batch of changes at once; when implemented, it gets them instead of the methods above
+-(void)notifyJsonFileChanged:(json::JsonFile*)aSender changeSet:(const json::JsonFileChangeSet&)aChangeSet;
+
 @end
 
 class JsonFileListenerObjCBridge : public json::JsonFileChangeListener
@@ -35,8 +41,10 @@ public:
                           TextLength aNewLength,
                           TextCoordinate aOldLineStart, TextLength aOldLineLength,
                           TextLength aNewLineLength);
-   void notifyErrorsChanged(json::JsonFile *aSender);
+   void notifyErrorsChanged(json::JsonFile *aSender, const MarkerListDelta &aDelta);
    void notifyNodeChanged(json::JsonFile *aSender, const json::JsonPath &nodePath);
+   void notifySyntaxRunsChanged(json::JsonFile *aSender, const MarkerListDelta &aDelta);
+   void notifyChangeSet(json::JsonFile *aSender, const json::JsonFileChangeSet &aChangeSet);
 
 private:
    __weak id<ObjCJsonFileChangeListener> targetListener;
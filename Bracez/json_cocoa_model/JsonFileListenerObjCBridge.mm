@@ -33,7 +33,26 @@ void JsonFileListenerObjCBridge::notifyNodeChanged(JsonFile *aSender, const Json
     [targetListener notifyNodeInvalidated:aSender nodePath:nodePath];
 }
 
-void JsonFileListenerObjCBridge::notifyErrorsChanged(json::JsonFile *aSender)
+void JsonFileListenerObjCBridge::notifyErrorsChanged(json::JsonFile *aSender, const MarkerListDelta &aDelta)
 {
-   [targetListener notifyErrorsChanged:aSender];
+   [targetListener notifyErrorsChanged:aSender delta:aDelta];
+}
+
+void JsonFileListenerObjCBridge::notifySyntaxRunsChanged(json::JsonFile *aSender, const MarkerListDelta &aDelta)
+{
+   if([targetListener respondsToSelector:@selector(notifySyntaxRunsChanged:delta:)])
+   {
+      [targetListener notifySyntaxRunsChanged:aSender delta:aDelta];
+   }
+}
+
+void JsonFileListenerObjCBridge::notifyChangeSet(json::JsonFile *aSender, const json::JsonFileChangeSet &aChangeSet)
+{
+   if([targetListener respondsToSelector:@selector(notifyJsonFileChanged:changeSet:)])
+   {
+      [targetListener notifyJsonFileChanged:aSender changeSet:aChangeSet];
+   } else
+   {
+      JsonFileChangeListener::notifyChangeSet(aSender, aChangeSet);
+   }
 }
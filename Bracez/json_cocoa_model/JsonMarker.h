@@ -25,6 +25,7 @@ enum JsonMarkerType {
    int whatCode;
    int line;
    JsonMarkerType markerType;
+   NSUInteger errorIndex; // Where an error was last found in the document's problems
     
    NSString *cachedLocationText;
 }
@@ -41,6 +42,7 @@ enum JsonMarkerType {
         parentDoc:(JsonDocument*)aDoc;
 
 +(JsonMarker*)markerForNode:(JsonCocoaNode*)node withParentDoc:(JsonDocument*)parentDoc;
++(JsonMarker*)markerForError:(const ParseErrorMarker&)anError atIndex:(NSUInteger)anIndex withParentDoc:(JsonDocument*)parentDoc;
 
 -(NSString*)message;
 -(NSString*)locationAsText;
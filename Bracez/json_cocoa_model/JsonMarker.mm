@@ -60,7 +60,18 @@
                                          parentDoc:parentDoc];
 }
 
++(JsonMarker*)markerForError:(const ParseErrorMarker&)anError atIndex:(NSUInteger)anIndex withParentDoc:(JsonDocument*)parentDoc {
+    JsonMarker *lRet = [[JsonMarker alloc] initWithDescription:[NSString stringWithUTF8String:parentDoc.jsonFile->getErrorText(anError).c_str()]
+                                                    markerType:JsonMarkerTypeError
+                                                          code:0
+                                                    coordinate:anError.getCoordinate()
+                                                     parentDoc:parentDoc];
+    lRet->errorIndex = anIndex;
+    return lRet;
+}
+
 -(NSString*)locationAsText {
+    [self resolveErrorCoordinate];
     if(!cachedLocationText) {
         if(line != -1) {
             cachedLocationText = [NSString stringWithFormat:@"Line %d in %@", line, doc.displayName];
@@ -85,6 +96,7 @@
 
 -(int)line
 {
+   [self resolveErrorCoordinate];
    if(line == -1)
    {
       int lRow;
@@ -100,9 +112,36 @@
 
 -(TextCoordinate)coordinate
 {
+   [self resolveErrorCoordinate];
    return where;
 }
 
+// Edits shift errors in the file's error list without touching their wrappers, so
+// an error picks up where it moved to when it's looked at
+-(void)resolveErrorCoordinate
+{
+   if(markerType != JsonMarkerTypeError)
+   {
+      return;
+   }
+
+   JsonDocument *lDoc = doc;
+   NSUInteger lIndex = [lDoc indexOfProblem:self near:errorIndex];
+   if(lIndex == NSNotFound)
+   {
+      return; // Error's gone, keep where it was last seen
+   }
+   errorIndex = lIndex;
+
+   TextCoordinate lWhere = lDoc.jsonFile->getErrors()[(int)lIndex].getCoordinate();
+   if(lWhere != where)
+   {
+      where = lWhere;
+      line = -1;
+      cachedLocationText = nil;
+   }
+}
+
 -(int)code {
     return whatCode;
 }
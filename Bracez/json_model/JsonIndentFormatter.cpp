@@ -8,7 +8,7 @@
 #include "JsonIndentFormatter.hpp"
 #include "reader.h"
 
-static TokenStreamAndUnderlying tokenStreamAtBeginningOfLine(const std::wstring &text,
+static TokenStreamAndUnderlying tokenStreamAtBeginningOfLine(const TextString &text,
                                                              const json::JsonFile &file,
                                                              TextCoordinate aOffset) {
     
@@ -24,15 +24,16 @@ static TokenStreamAndUnderlying tokenStreamAtBeginningOfLine(const std::wstring
  * JsonIndentFormatter
  */
 
-JsonIndentFormatter::JsonIndentFormatter(const std::wstring &text,
-                                         const json::JsonFile &jsonFile,
+JsonIndentFormatter::JsonIndentFormatter(const json::JsonFile &jsonFile,
                                          TextCoordinate aOffsetStart,
                                          TextLength aLen,
                                          int indentSize)
-: tokStreamAndCo(tokenStreamAtBeginningOfLine(text, jsonFile, aOffsetStart)),
-indentationContext(JsonIndentationContext::approximateWithDocument(jsonFile, aOffsetStart, indentSize))
+: tokStreamAndCo(tokenStreamAtBeginningOfLine(jsonFile.getText(), jsonFile, aOffsetStart)),
+indentationContext(JsonIndentationContext::approximateWithDocument(jsonFile, aOffsetStart, indentSize)),
+input(jsonFile.getText()),
+reindented(false)
 {
-    TextLength textLen = (TextLength)text.length();
+    TextLength textLen = (TextLength)input.length();
     startOffset = aOffsetStart;
     
     if(startOffset+aLen > TextCoordinate(textLen)) {
@@ -43,22 +44,76 @@ indentationContext(JsonIndentationContext::approximateWithDocument(jsonFile, aOf
 }
 
 TextLength JsonIndentFormatter::getIndentedLength() {
-    if(!output.length()) {
+    if(!reindented) {
         reindent();
     }
     
     return endOffset - startOffset;
 }
 
-const std::wstring &JsonIndentFormatter::getIndented() {
-    if(!output.length()) {
+const TextString &JsonIndentFormatter::getIndented() {
+    if(!reindented) {
         reindent();
     }
     
     return output;
 }
 
+const std::vector<json::Splice> &JsonIndentFormatter::getIndentSplices() {
+    if(!reindented) {
+        reindent();
+    }
+    
+    return splices;
+}
+
+static inline bool isIndentWhitespace(TextChar c) {
+    return c == u' ' || c == u'\t' || c == u'\n';
+}
+
+void JsonIndentFormatter::computeIndentSplices() {
+    // Output only differs from the input in whitespace runs between tokens, and
+    // both have the same non-whitespace characters. Walk them side by side and
+    // emit a splice for each whitespace run that differs.
+    const TextChar *in = input.data() + startOffset.getAddress();
+    const TextChar *inEnd = input.data() + endOffset.getAddress();
+    const TextChar *out = output.data();
+    const TextChar *outEnd = out + output.length();
+    
+    while(in < inEnd || out < outEnd) {
+        const TextChar *inRunStart = in, *outRunStart = out;
+        while(in < inEnd && isIndentWhitespace(*in)) in++;
+        while(out < outEnd && isIndentWhitespace(*out)) out++;
+        
+        // Only replace the part of the run that differs
+        const TextChar *inChangeEnd = in, *outChangeEnd = out;
+        while(inRunStart < inChangeEnd && outRunStart < outChangeEnd && *inRunStart == *outRunStart) {
+            inRunStart++; outRunStart++;
+        }
+        while(inRunStart < inChangeEnd && outRunStart < outChangeEnd && inChangeEnd[-1] == outChangeEnd[-1]) {
+            inChangeEnd--; outChangeEnd--;
+        }
+        
+        if(inRunStart != inChangeEnd || outRunStart != outChangeEnd) {
+            splices.emplace_back(TextCoordinate(inRunStart - input.data()),
+                                 (TextLength)(inChangeEnd-inRunStart),
+                                 TextString(outRunStart, outChangeEnd));
+        }
+        
+        // Same character on both sides
+        if(in < inEnd && out < outEnd) {
+            assert(*in == *out);
+            in++; out++;
+        } else {
+            assert(in == inEnd && out == outEnd);
+            break;
+        }
+    }
+}
+
 void JsonIndentFormatter::reindent() {
+    reindented = true;
+    
     int peekedInputCol = tokStreamAndCo.tokenStream.Col();
     
     outputCol = peekedInputCol;
@@ -77,7 +132,7 @@ void JsonIndentFormatter::reindent() {
         switch(tok.nType) {
             case json::Token::TOKEN_WHITESPACE:
                 outputString(tok.orgText());
-                if(tok.isValueEquals(L"\n")) {
+                if(tok.isValueEquals("\n")) {
                     skipInputWhitespace();
                 }
                 break;
@@ -93,7 +148,7 @@ void JsonIndentFormatter::reindent() {
             case json::Token::TOKEN_OBJECT_END:
                 indentationContext.popIndentLevel();
                 if(outputCol != 0) {
-                    outputString(L"\n");
+                    outputString(u"\n");
                 }
                 outputString(tok.orgText());
                 break;
@@ -112,6 +167,8 @@ void JsonIndentFormatter::reindent() {
         lastIndented = tok.locEnd;
     }
     endOffset = lastIndented;
+    
+    computeIndentSplices();
 }
 
 void JsonIndentFormatter::skipInputWhitespace() {
@@ -125,7 +182,7 @@ void JsonIndentFormatter::outputIndent() {
     outputCol += indentSize;
     
     while(indentSize--) {
-        output.push_back(L' ');
+        output.push_back(u' ');
     }
 }
 
@@ -135,7 +192,7 @@ void JsonIndentFormatter::copyAndEnsureNewLine() {
         
         if(tok.nType == json::Token::TOKEN_WHITESPACE) {
             tokStreamAndCo.tokenStream.Get();
-            if(tok.isValueEquals(L"\n")) {
+            if(tok.isValueEquals("\n")) {
                 outputString(tok.orgText());
                 skipInputWhitespace();
                 return;
@@ -145,10 +202,10 @@ void JsonIndentFormatter::copyAndEnsureNewLine() {
         }
     }
     
-    outputString(L"\n");
+    outputString(u"\n");
 }
 
-void JsonIndentFormatter::outputString(const std::wstring &string) {
+void JsonIndentFormatter::outputString(const TextString &string) {
     for(auto iter = string.begin(); iter != string.end(); iter ++) {
         if(!outputCol) {
             outputIndent();
@@ -158,7 +215,7 @@ void JsonIndentFormatter::outputString(const std::wstring &string) {
         
         outputCol++;
         
-        if(*iter == L'\n') {
+        if(*iter == u'\n') {
             outputCol = 0;
         }
     }
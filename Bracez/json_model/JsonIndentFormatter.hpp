@@ -14,10 +14,10 @@
 #include "reader.h"
 
 struct TokenStreamAndUnderlying {
-    TokenStreamAndUnderlying(const std::wstring &text,
+    TokenStreamAndUnderlying(const TextString &text,
                              unsigned long startOffset,
                              int startRow, int startCol)
-    : inputStream(text.c_str(), text.size(), NULL, TextCoordinate(startOffset)),
+    : inputStream(text.c_str(), text.size(), TextCoordinate(startOffset)),
     tokenStream(inputStream, NULL, false, startRow, startCol)
     {
     }
@@ -51,21 +51,26 @@ private:
 
 class JsonIndentFormatter {
 public:
-    JsonIndentFormatter(const std::wstring &text,
-                        const json::JsonFile &jsonFile,
+    // Reindents a region of jsonFile's text; the file must not change while the formatter is used.
+    JsonIndentFormatter(const json::JsonFile &jsonFile,
                         TextCoordinate aOffsetStart, TextLength aLen, int indentSize);
     
-    const std::wstring &getIndented();
+    const TextString &getIndented();
     TextLength getIndentedLength();
     
+    // Whitespace changes that reindent the region, in text order. Offsets are in
+    // the original text, so apply them last to first.
+    const std::vector<json::Splice> &getIndentSplices();
+    
 private:
     void reindent();
+    void computeIndentSplices();
     
     void skipInputWhitespace();
     void outputIndent();
     void copyAndEnsureNewLine();
     
-    void outputString(const std::wstring &string);
+    void outputString(const TextString &string);
     
 private:
     
@@ -76,7 +81,11 @@ private:
     TextCoordinate endOffset;
     
     unsigned int outputCol;
-    std::wstring output;
+    TextString output;
+    
+    const TextString &input;
+    std::vector<json::Splice> splices;
+    bool reindented;
 };
 
 #endif /* JsonIndentFormatter_hpp */
@@ -0,0 +1,210 @@
+//
+//  JsonLexicalHighlighter.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "JsonLexicalHighlighter.hpp"
+#include <algorithm>
+
+namespace json
+{
+
+// Lexer states at a line start; mirror TokenStream, where strings may span lines
+#define LEX_STATE_DEFAULT       0
+#define LEX_STATE_IN_STRING     1
+#define LEX_STATE_STRING_ESCAPE 2
+
+static inline bool isLexWhitespace(TextChar c)
+{
+    return c == u' ' || c == u'\t' || c == u'\n' || c == u'\r';
+}
+
+static inline bool isNumberChar(TextChar c)
+{
+    return (c >= u'0' && c <= u'9') || c == u'-' || c == u'+' || c == u'.' || c == u'e' || c == u'E';
+}
+
+static unsigned char advanceLexState(unsigned char aState, const TextChar *aBegin, const TextChar *aEnd)
+{
+    for(const TextChar *p = aBegin; p<aEnd; p++) {
+        switch(aState) {
+            case LEX_STATE_STRING_ESCAPE:
+                aState = LEX_STATE_IN_STRING;
+                break;
+
+            case LEX_STATE_IN_STRING:
+                if(*p == u'\\') {
+                    aState = LEX_STATE_STRING_ESCAPE;
+                } else
+                if(*p == u'"') {
+                    aState = LEX_STATE_DEFAULT;
+                }
+                break;
+
+            default:
+                if(*p == u'"') {
+                    aState = LEX_STATE_IN_STRING;
+                }
+                break;
+        }
+    }
+
+    return aState;
+}
+
+// Returns the end of a string whose content starts at aBegin (past the closing quote)
+static const TextChar *scanStringEnd(const TextChar *aBegin, const TextChar *aEnd, bool aEscaped)
+{
+    const TextChar *p = aBegin;
+    if(aEscaped && p < aEnd) {
+        p++;
+    }
+
+    while(p < aEnd && *p != u'"') {
+        if(*p == u'\\' && p+1 < aEnd) {
+            p++;
+        }
+        p++;
+    }
+
+    return p < aEnd ? p+1 : aEnd;
+}
+
+// A string is a member name if the next token is ':'
+static LexicalTokenClass stringClass(const TextChar *aStringEnd, const TextChar *aEnd)
+{
+    const TextChar *p = aStringEnd;
+    while(p < aEnd && isLexWhitespace(*p)) {
+        p++;
+    }
+
+    return p < aEnd && *p == u':' ? ltcKey : ltcString;
+}
+
+// Appends spans for tokens starting in [p, aEnd); p must be outside of any string
+static void lexTokens(const TextChar *aText, const TextChar *p, const TextChar *aEnd, const TextChar *aTextEnd,
+                      std::vector<LexicalSpan> &aOutSpans)
+{
+    while(p < aEnd) {
+        const TextChar *lTokenStart = p;
+        TextChar c = *p;
+
+        if(isLexWhitespace(c)) {
+            p++;
+            continue;
+        } else
+        if(c == u'"') {
+            p = scanStringEnd(p+1, aTextEnd, false);
+            aOutSpans.push_back(LexicalSpan(TextCoordinate(lTokenStart-aText), p-lTokenStart, stringClass(p, aTextEnd)));
+        } else
+        if(c == u'{' || c == u'}' || c == u'[' || c == u']' || c == u',' || c == u':') {
+            p++;
+            aOutSpans.push_back(LexicalSpan(TextCoordinate(lTokenStart-aText), 1, ltcPunctuation));
+        } else
+        if(c == u'-' || (c >= u'0' && c <= u'9')) {
+            while(p < aTextEnd && isNumberChar(*p)) {
+                p++;
+            }
+            aOutSpans.push_back(LexicalSpan(TextCoordinate(lTokenStart-aText), p-lTokenStart, ltcNumber));
+        } else
+        if(c >= u'a' && c <= u'z') {
+            // Barewords break once recognized, as in TokenStream::MatchBareWordToken
+            TextString lWord;
+            while(p < aTextEnd && *p >= u'a' && *p <= u'z' && lWord.length() < 7) {
+                lWord.push_back(*p++);
+                if(lWord == u"true" || lWord == u"null" || lWord == u"false") {
+                    aOutSpans.push_back(LexicalSpan(TextCoordinate(lTokenStart-aText), p-lTokenStart, ltcLiteral));
+                    break;
+                }
+            }
+        } else {
+            p++;
+        }
+    }
+}
+
+void JsonLexicalHighlighter::reset(size_t aNumLineBreaks)
+{
+    lineStates.assign(aNumLineBreaks+1, LEX_STATE_DEFAULT);
+    validLines = 1;
+    convergeLine = lineStates.size();
+}
+
+void JsonLexicalHighlighter::spliceLines(size_t aLineBreakIndex, size_t aNumRemoved, size_t aNumInserted)
+{
+    // Line i starts past line break i-1
+    size_t lFirstLine = aLineBreakIndex + 1;
+    bool lWasValid = validLines >= lineStates.size();
+
+    lineStates.erase(lineStates.begin() + lFirstLine, lineStates.begin() + lFirstLine + aNumRemoved);
+    lineStates.insert(lineStates.begin() + lFirstLine, aNumInserted, LEX_STATE_DEFAULT);
+
+    // Old checkpoints can only be trusted again past the last edit
+    size_t lEditEnd = lFirstLine + aNumInserted;
+    if(lWasValid) {
+        convergeLine = lEditEnd;
+    } else {
+        if(convergeLine >= lFirstLine + aNumRemoved) {
+            convergeLine = convergeLine - aNumRemoved + aNumInserted;
+        }
+        convergeLine = std::max(convergeLine, lEditEnd);
+    }
+
+    validLines = std::min(validLines, lFirstLine);
+}
+
+void JsonLexicalHighlighter::ensureCheckpoint(const TextString &aText, const SimpleMarkerList &aLineBreaks, size_t aLine)
+{
+    const TextChar *lText = aText.data();
+    while(validLines <= aLine) {
+        size_t lLine = validLines;
+        const TextChar *lPrevLineStart = lText + (lLine > 1 ? aLineBreaks[(int)(lLine-2)].getCoordinate().getAddress() + 1 : 0);
+        const TextChar *lLineStart = lText + aLineBreaks[(int)(lLine-1)].getCoordinate().getAddress() + 1;
+
+        unsigned char lState = advanceLexState(lineStates[lLine-1], lPrevLineStart, lLineStart);
+        if(lLine >= convergeLine) {
+            if(lState == lineStates[lLine]) {
+                validLines = lineStates.size();
+                break;
+            }
+
+            // Old checkpoints past this one still follow from it, not from the new state
+            convergeLine = lLine+1;
+        }
+
+        lineStates[lLine] = lState;
+        validLines++;
+    }
+}
+
+void JsonLexicalHighlighter::getTokenSpans(const TextString &aText, TextCoordinate aStart, TextCoordinate aEnd,
+                                           std::vector<LexicalSpan> &aOutSpans)
+{
+    const TextChar *lText = aText.data();
+    lexTokens(lText, lText + aStart.getAddress(), lText + aEnd.getAddress(), lText + aText.length(), aOutSpans);
+}
+
+void JsonLexicalHighlighter::getSpans(const TextString &aText, const SimpleMarkerList &aLineBreaks,
+                                      TextCoordinate aStart, TextCoordinate aEnd, std::vector<LexicalSpan> &aOutSpans)
+{
+    size_t lLine = std::lower_bound(aLineBreaks.begin(), aLineBreaks.end(), aStart) - aLineBreaks.begin();
+    ensureCheckpoint(aText, aLineBreaks, lLine);
+
+    const TextChar *lText = aText.data();
+    const TextChar *lTextEnd = lText + aText.length();
+    const TextChar *lEnd = lText + std::min<TextLength>(aEnd.getAddress(), aText.length());
+    const TextChar *p = lText + (lLine ? aLineBreaks[(int)(lLine-1)].getCoordinate().getAddress() + 1 : 0);
+
+    // Line starts inside a string
+    if(lineStates[lLine] != LEX_STATE_DEFAULT) {
+        const TextChar *lStringEnd = scanStringEnd(p, lTextEnd, lineStates[lLine] == LEX_STATE_STRING_ESCAPE);
+        aOutSpans.push_back(LexicalSpan(TextCoordinate(p-lText), lStringEnd-p, stringClass(lStringEnd, lTextEnd)));
+        p = lStringEnd;
+    }
+
+    lexTokens(lText, p, lEnd, lTextEnd, aOutSpans);
+}
+
+}
@@ -0,0 +1,77 @@
+//
+//  JsonLexicalHighlighter.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef JsonLexicalHighlighter_hpp
+#define JsonLexicalHighlighter_hpp
+
+#include <vector>
+#include "marker_list.h"
+#include "TextEncoding.hpp"
+
+namespace json
+{
+
+enum LexicalTokenClass
+{
+    ltcString,
+    ltcKey,
+    ltcNumber,
+    ltcLiteral,         // true, false, null
+    ltcPunctuation
+};
+
+struct LexicalSpan
+{
+    LexicalSpan(TextCoordinate aStart, TextLength aLength, LexicalTokenClass aTokenClass) :
+    start(aStart), length(aLength), tokenClass(aTokenClass) {}
+
+    TextCoordinate start;
+    TextLength length;
+    LexicalTokenClass tokenClass;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// JsonLexicalHighlighter - token classes for any range of text, without a DOM.
+//
+// Only string state crosses line boundaries, so the lexer state at the start of each line
+// is kept as a checkpoint and a line can be lexed on its own. Checkpoints past an edit are
+// recomputed lazily, and only up to the point where they agree with the old ones again.
+
+class JsonLexicalHighlighter
+{
+public:
+    JsonLexicalHighlighter() : validLines(1), convergeLine(1) { lineStates.push_back(0); }
+
+    // The text was replaced; aNumLineBreaks is the number of line breaks in the new text
+    void reset(size_t aNumLineBreaks);
+
+    // Text was spliced: line breaks [aLineBreakIndex, aLineBreakIndex+aNumRemoved) were
+    // replaced by aNumInserted new ones.
+    void spliceLines(size_t aLineBreakIndex, size_t aNumRemoved, size_t aNumInserted);
+
+    // Appends spans for tokens intersecting [aStart, aEnd) to aOutSpans, in text order. Spans
+    // are not clipped to the range. aLineBreaks holds the offsets of aText's line breaks.
+    void getSpans(const TextString &aText, const SimpleMarkerList &aLineBreaks,
+                  TextCoordinate aStart, TextCoordinate aEnd, std::vector<LexicalSpan> &aOutSpans);
+
+    // Spans for tokens starting in [aStart, aEnd), where aStart is known to be outside of
+    // any string (e.g text generated from the DOM); no checkpoints needed.
+    static void getTokenSpans(const TextString &aText, TextCoordinate aStart, TextCoordinate aEnd,
+                              std::vector<LexicalSpan> &aOutSpans);
+
+private:
+    void ensureCheckpoint(const TextString &aText, const SimpleMarkerList &aLineBreaks, size_t aLine);
+
+    std::vector<unsigned char> lineStates;  // Lexer state at the start of each line
+    size_t validLines;                      // Checkpoints before this line are up to date
+    size_t convergeLine;                    // From this line on a recomputed checkpoint that
+                                            // matches the old one validates all that follow
+};
+
+}
+
+#endif /* JsonLexicalHighlighter_hpp */
@@ -0,0 +1,174 @@
+//
+//  MemberNameIndex.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "MemberNameIndex.hpp"
+#include "json_file.h"
+
+#include <algorithm>
+
+namespace json
+{
+
+// Objects in aNode's subtree, in document order
+static void collectObjects(Node *aNode, std::vector<ObjectNode*> &aOutObjects)
+{
+    std::vector<Node*> lStack(1, aNode);
+    while(!lStack.empty()) {
+        Node *lNode = lStack.back();
+        lStack.pop_back();
+        if(!lNode) {
+            continue;
+        }
+
+        if(ObjectNode *lObject = dynamic_cast<ObjectNode*>(lNode)) {
+            aOutObjects.push_back(lObject);
+        }
+
+        if(ContainerNode *lContainer = dynamic_cast<ContainerNode*>(lNode)) {
+            for(int i=lContainer->getChildCount()-1; i>=0; i--) {
+                lStack.push_back(lContainer->getChildAt(i));
+            }
+        }
+    }
+}
+
+static MemberNameIndex::ObjectList::iterator lowerBoundByPosition(MemberNameIndex::ObjectList &aList, TextCoordinate aCoord)
+{
+    return std::lower_bound(aList.begin(), aList.end(), aCoord, [](const ObjectNode *aObject, TextCoordinate aCoord) {
+        return aObject->getAbsTextRange().start < aCoord;
+    });
+}
+
+void MemberNameIndex::clear()
+{
+    nameIds.clear();
+    objectsByName.clear();
+    namesByObject.clear();
+}
+
+MemberNameIndex::NameId MemberNameIndex::internName(const std::wstring &aName)
+{
+    auto lInserted = nameIds.emplace(aName, (NameId)objectsByName.size());
+    if(lInserted.second) {
+        objectsByName.emplace_back();
+    }
+
+    return lInserted.first->second;
+}
+
+void MemberNameIndex::removeObjects(const std::vector<ObjectNode*> &aObjects)
+{
+    std::vector<const ObjectNode*> lRemoved;
+    std::vector<NameId> lNames;
+    for(ObjectNode *lObject: aObjects) {
+        auto lRecord = namesByObject.find(lObject);
+        if(lRecord != namesByObject.end()) {
+            lRemoved.push_back(lObject);
+            lNames.insert(lNames.end(), lRecord->second.begin(), lRecord->second.end());
+            namesByObject.erase(lRecord);
+        }
+    }
+
+    if(lRemoved.empty()) {
+        return;
+    }
+
+    // Positions of nodes on their way out can't be trusted, so scan the lists they're on
+    std::sort(lRemoved.begin(), lRemoved.end());
+    std::sort(lNames.begin(), lNames.end());
+    lNames.erase(std::unique(lNames.begin(), lNames.end()), lNames.end());
+    for(NameId lName: lNames) {
+        ObjectList &lObjects = objectsByName[lName];
+        lObjects.erase(std::remove_if(lObjects.begin(), lObjects.end(), [&lRemoved](const ObjectNode *aObject) {
+            return std::binary_search(lRemoved.begin(), lRemoved.end(), aObject);
+        }), lObjects.end());
+    }
+}
+
+void MemberNameIndex::removeSubtree(Node *aNode)
+{
+    if(empty() || !aNode) {
+        return;
+    }
+
+    std::vector<ObjectNode*> lObjects;
+    collectObjects(aNode, lObjects);
+    removeObjects(lObjects);
+}
+
+void MemberNameIndex::refreshSubtree(Node *aNode)
+{
+    std::vector<ObjectNode*> lObjects;
+    collectObjects(aNode, lObjects);
+    if(lObjects.empty()) {
+        return;
+    }
+
+    // All listed objects are live, so the ones in aNode's subtree are a contiguous range
+    // of each list they're on
+    TextRange lRange = aNode->getAbsTextRange();
+    std::vector<NameId> lOldNames;
+    for(ObjectNode *lObject: lObjects) {
+        auto lRecord = namesByObject.find(lObject);
+        if(lRecord != namesByObject.end()) {
+            lOldNames.insert(lOldNames.end(), lRecord->second.begin(), lRecord->second.end());
+            namesByObject.erase(lRecord);
+        }
+    }
+
+    std::sort(lOldNames.begin(), lOldNames.end());
+    lOldNames.erase(std::unique(lOldNames.begin(), lOldNames.end()), lOldNames.end());
+    for(NameId lName: lOldNames) {
+        ObjectList &lList = objectsByName[lName];
+        lList.erase(lowerBoundByPosition(lList, lRange.start), lowerBoundByPosition(lList, lRange.end));
+    }
+
+    // Collect the subtree's objects per name, then splice each name's block into place
+    std::unordered_map<NameId, ObjectList> lAdded;
+    for(ObjectNode *lObject: lObjects) {
+        std::vector<NameId> lNames;
+        for(int i=0; i<lObject->getChildCount(); i++) {
+            lNames.push_back(internName(lObject->getChildMemberAt(i)->name));
+        }
+
+        // Duplicate keys list the object once
+        std::sort(lNames.begin(), lNames.end());
+        lNames.erase(std::unique(lNames.begin(), lNames.end()), lNames.end());
+        for(NameId lName: lNames) {
+            lAdded[lName].push_back(lObject);
+        }
+
+        if(!lNames.empty()) {
+            namesByObject.emplace(lObject, std::move(lNames));
+        }
+    }
+
+    for(auto &lBlock: lAdded) {
+        ObjectList &lList = objectsByName[lBlock.first];
+        lList.insert(lowerBoundByPosition(lList, lRange.start), lBlock.second.begin(), lBlock.second.end());
+    }
+}
+
+MemberNameIndex::ObjectRange MemberNameIndex::objectsWithMember(const Node *aNode, const std::wstring &aName) const
+{
+    auto lName = nameIds.find(aName);
+    if(lName == nameIds.end()) {
+        return ObjectRange();
+    }
+
+    // Objects in aNode's subtree are those starting within its range
+    const ObjectList &lList = objectsByName[lName->second];
+    TextRange lRange = aNode->getAbsTextRange();
+    auto lStartsBefore = [](const ObjectNode *aObject, TextCoordinate aCoord) {
+        return aObject->getAbsTextRange().start < aCoord;
+    };
+
+    return ObjectRange(std::lower_bound(lList.begin(), lList.end(), lRange.start, lStartsBefore),
+                       std::lower_bound(lList.begin(), lList.end(), lRange.end, lStartsBefore));
+}
+
+}
@@ -0,0 +1,67 @@
+//
+//  MemberNameIndex.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef MemberNameIndex_hpp
+#define MemberNameIndex_hpp
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+namespace json
+{
+
+class Node;
+class ObjectNode;
+
+/////////////////////////////////////////////////////////////////////////
+// MemberNameIndex - the objects of a DOM by the names of their members.
+//
+// Names are interned; each lists the objects that have a member by that name, in document
+// order. JsonFile keeps the index in sync with its DOM: subtrees are dropped as they're
+// detached or retired, and subtrees reported refreshed are reindexed once the change is
+// delivered. Lookups compare node positions, so all listed objects must be live.
+
+class MemberNameIndex
+{
+public:
+    typedef std::vector<ObjectNode*> ObjectList;
+    typedef std::pair<ObjectList::const_iterator, ObjectList::const_iterator> ObjectRange;
+
+    void clear();
+    bool empty() const { return namesByObject.empty(); }
+
+    // aNode's subtree is leaving the DOM
+    void removeSubtree(Node *aNode);
+
+    // aNode's subtree changed in place; all objects in it are reindexed. Objects elsewhere
+    // in the DOM must not have moved relative to it.
+    void refreshSubtree(Node *aNode);
+
+    // Objects in aNode's subtree (aNode included) that have a member named aName, in
+    // document order. O(log n) in the number of objects having the name.
+    ObjectRange objectsWithMember(const Node *aNode, const std::wstring &aName) const;
+
+    size_t numNames() const { return objectsByName.size(); }
+    size_t numObjects() const { return namesByObject.size(); }
+
+private:
+    typedef unsigned int NameId;
+
+    NameId internName(const std::wstring &aName);
+    void removeObjects(const std::vector<ObjectNode*> &aObjects);
+
+private:
+    std::unordered_map<std::wstring, NameId> nameIds;
+    std::vector<ObjectList> objectsByName;
+    std::unordered_map<const ObjectNode*, std::vector<NameId>> namesByObject;
+};
+
+}
+
+#endif /* MemberNameIndex_hpp */
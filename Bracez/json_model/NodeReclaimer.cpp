@@ -0,0 +1,117 @@
+//
+//  NodeReclaimer.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "NodeReclaimer.hpp"
+#include "json_file.h"
+
+namespace json
+{
+
+NodeReclaimer::Pin &NodeReclaimer::Pin::operator=(Pin &&aOther)
+{
+    if(this != &aOther)
+    {
+        release();
+        reclaimer = std::move(aOther.reclaimer);
+        epoch = aOther.epoch;
+    }
+    
+    return *this;
+}
+
+void NodeReclaimer::Pin::release()
+{
+    if(reclaimer)
+    {
+        reclaimer->unpin(epoch);
+        reclaimer.reset();
+    }
+}
+
+NodeReclaimer::~NodeReclaimer()
+{
+    // Pins hold a reference to us, so no reader is left by now
+    for(RetiredNode &lRetired: retired)
+    {
+        delete lRetired.node;
+    }
+}
+
+NodeReclaimer::Pin NodeReclaimer::pin()
+{
+    std::lock_guard<std::mutex> lLock(mutex);
+    pinnedEpochs[epoch]++;
+    
+    return Pin(shared_from_this(), epoch);
+}
+
+void NodeReclaimer::unpin(unsigned long aEpoch)
+{
+    {
+        std::lock_guard<std::mutex> lLock(mutex);
+        auto lIter = pinnedEpochs.find(aEpoch);
+        if(!--lIter->second)
+        {
+            pinnedEpochs.erase(lIter);
+        }
+    }
+    
+    reclaim();
+}
+
+void NodeReclaimer::retire(Node *aNode)
+{
+    if(!aNode)
+    {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lLock(mutex);
+        
+        // Pins taken from now on can't reach aNode
+        retired.push_back(RetiredNode { epoch, aNode });
+        epoch++;
+    }
+    
+    reclaim();
+}
+
+void NodeReclaimer::reclaim()
+{
+    std::deque<Node*> lReclaimed;
+    
+    {
+        std::lock_guard<std::mutex> lLock(mutex);
+        unsigned long lMinPinnedEpoch = pinnedEpochs.empty() ? epoch : pinnedEpochs.begin()->first;
+        while(!retired.empty() && retired.front().epoch < lMinPinnedEpoch)
+        {
+            lReclaimed.push_back(retired.front().node);
+            retired.pop_front();
+        }
+    }
+    
+    // Large subtrees take a while to free; don't hold up pinning readers
+    for(Node *lNode: lReclaimed)
+    {
+        delete lNode;
+    }
+}
+
+size_t NodeReclaimer::numRetired() const
+{
+    std::lock_guard<std::mutex> lLock(mutex);
+    return retired.size();
+}
+
+unsigned long NodeReclaimer::getEpoch() const
+{
+    std::lock_guard<std::mutex> lLock(mutex);
+    return epoch;
+}
+
+}
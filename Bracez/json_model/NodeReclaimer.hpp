@@ -0,0 +1,85 @@
+//
+//  NodeReclaimer.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef NodeReclaimer_hpp
+#define NodeReclaimer_hpp
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace json
+{
+
+class Node;
+
+/////////////////////////////////////////////////////////////////////////
+// NodeReclaimer - epoch based deferred deletion of nodes replaced in the DOM.
+//
+// Readers (UI caches, background queries) pin the current epoch while they hold on to
+// node pointers. A retired subtree is deleted only once every pin taken before it was
+// retired is released, so a pinned reader can keep dereferencing nodes it already has
+// and revalidate them lazily (Node::isLive) instead of being rebuilt on every reparse.
+// Readers that hold nodes for long (e.g UI caches) do so through PinnedNodes, whose pin
+// the file moves on with each change set.
+
+class NodeReclaimer : public std::enable_shared_from_this<NodeReclaimer>
+{
+public:
+    class Pin
+    {
+    public:
+        Pin() : epoch(0) {}
+        Pin(Pin &&aOther) : reclaimer(std::move(aOther.reclaimer)), epoch(aOther.epoch) {}
+        Pin &operator=(Pin &&aOther);
+        ~Pin() { release(); }
+        
+        Pin(const Pin&) = delete;
+        Pin &operator=(const Pin&) = delete;
+        
+        void release();
+        
+    private:
+        friend class NodeReclaimer;
+        Pin(std::shared_ptr<NodeReclaimer> aReclaimer, unsigned long aEpoch) : reclaimer(aReclaimer), epoch(aEpoch) {}
+        
+        std::shared_ptr<NodeReclaimer> reclaimer;
+        unsigned long epoch;
+    };
+    
+    NodeReclaimer() : epoch(0) {}
+    ~NodeReclaimer();
+    
+    Pin pin();
+    
+    // Takes ownership of aNode; it's deleted once no pin can reference it.
+    void retire(Node *aNode);
+    void reclaim();
+    
+    size_t numRetired() const;
+    // Incremented by each retire
+    unsigned long getEpoch() const;
+    
+private:
+    void unpin(unsigned long aEpoch);
+    
+    struct RetiredNode
+    {
+        unsigned long epoch;
+        Node *node;
+    };
+    
+    mutable std::mutex mutex;
+    unsigned long epoch;
+    std::map<unsigned long, int> pinnedEpochs;   // Epoch -> pin count
+    std::deque<RetiredNode> retired;              // Ordered by retire epoch
+};
+
+}
+
+#endif /* NodeReclaimer_hpp */
@@ -0,0 +1,263 @@
+//
+//  PathSummary.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "PathSummary.hpp"
+
+#include <algorithm>
+#include <cwctype>
+
+namespace json
+{
+
+static bool isPlainName(const std::wstring &aName)
+{
+    if(aName.empty() || std::iswdigit(aName[0])) {
+        return false;
+    }
+
+    return std::all_of(aName.begin(), aName.end(), [](wchar_t aChar) { return aChar == L'_' || std::iswalnum(aChar); });
+}
+
+std::wstring PathSummaryEntry::getPathString() const
+{
+    if(!parent) {
+        return L"$";
+    }
+
+    std::wstring lRet = parent->getPathString();
+    if(elements) {
+        lRet += L"[*]";
+    } else
+    if(isPlainName(name)) {
+        lRet += L"." + name;
+    } else {
+        lRet += L"[" + jsonizeString(name) + L"]";
+    }
+
+    return lRet;
+}
+
+double PathSummaryEntry::getMeanArrayLength() const
+{
+    size_t lNumArrays = typeCounts[ntArray];
+    return lNumArrays ? totalArrayLength / (double)lNumArrays : 0;
+}
+
+const PathSummaryEntry *PathSummaryEntry::getMember(const std::wstring &aName) const
+{
+    Members::const_iterator lIter = members.find(aName);
+    return lIter != members.end() ? lIter->second.get() : NULL;
+}
+
+bool PathSummaryEntry::mayContainMember(const std::wstring &aName) const
+{
+    if(members.count(aName)) {
+        return true;
+    }
+
+    for(const Members::value_type &lMember: members) {
+        if(lMember.second->mayContainMember(aName)) {
+            return true;
+        }
+    }
+
+    return elementsEntry && elementsEntry->mayContainMember(aName);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+// Steps from the root to aNode: member names, or NULL for array elements. False if aNode
+// isn't in a document.
+static bool getPathSteps(const Node *aNode, std::vector<const std::wstring*> &aOutSteps)
+{
+    const Node *lNode = aNode;
+    while(true) {
+        const ContainerNode *lParent = lNode->getParent();
+        if(!lParent) {
+            return false;
+        }
+
+        if(dynamic_cast<const DocumentNode*>(lParent)) {
+            break;
+        }
+
+        if(const ObjectNode *lObject = dynamic_cast<const ObjectNode*>(lParent)) {
+            int lIdx = lObject->getIndexOfChild(lNode);
+            if(lIdx == -1) {
+                return false;
+            }
+            aOutSteps.push_back(&lObject->getMemberNameAt(lIdx));
+        } else {
+            aOutSteps.push_back(NULL);
+        }
+
+        lNode = lParent;
+    }
+
+    std::reverse(aOutSteps.begin(), aOutSteps.end());
+    return true;
+}
+
+void PathSummary::clear()
+{
+    records.clear();
+    root.reset(new PathSummaryEntry(NULL, std::wstring(), false));
+}
+
+const PathSummaryEntry *PathSummary::findEntry(const Node *aNode) const
+{
+    std::vector<const std::wstring*> lSteps;
+    if(dynamic_cast<const DocumentNode*>(aNode) || !getPathSteps(aNode, lSteps)) {
+        return NULL;
+    }
+
+    const PathSummaryEntry *lEntry = root.get();
+    for(const std::wstring *lStep: lSteps) {
+        lEntry = lStep ? lEntry->getMember(*lStep) : lEntry->getElements();
+        if(!lEntry) {
+            break;
+        }
+    }
+
+    return lEntry;
+}
+
+PathSummaryEntry *PathSummary::entryForNode(const Node *aNode)
+{
+    std::vector<const std::wstring*> lSteps;
+    if(!getPathSteps(aNode, lSteps)) {
+        return NULL;
+    }
+
+    PathSummaryEntry *lEntry = root.get();
+    for(const std::wstring *lStep: lSteps) {
+        std::unique_ptr<PathSummaryEntry> &lChild = lStep ? lEntry->members[*lStep] : lEntry->elementsEntry;
+        if(!lChild) {
+            lChild.reset(new PathSummaryEntry(lEntry, lStep ? *lStep : std::wstring(), !lStep));
+        }
+        lEntry = lChild.get();
+    }
+
+    return lEntry;
+}
+
+void PathSummary::addSubtree(const Node *aNode, PathSummaryEntry *aEntry)
+{
+    std::vector<std::pair<const Node*, PathSummaryEntry*>> lStack(1, std::make_pair(aNode, aEntry));
+    while(!lStack.empty()) {
+        const Node *lNode = lStack.back().first;
+        PathSummaryEntry *lEntry = lStack.back().second;
+        lStack.pop_back();
+
+        Record lRecord = { lEntry, lNode->getNodeTypeId(), 0 };
+        lEntry->count++;
+        lEntry->typeCounts[lRecord.type]++;
+
+        if(const ObjectNode *lObject = dynamic_cast<const ObjectNode*>(lNode)) {
+            for(int i=0; i<lObject->getChildCount(); i++) {
+                const ObjectNode::Member *lMember = lObject->getChildMemberAt(i);
+                if(lMember->node) {
+                    std::unique_ptr<PathSummaryEntry> &lChild = lEntry->members[lMember->name];
+                    if(!lChild) {
+                        lChild.reset(new PathSummaryEntry(lEntry, lMember->name, false));
+                    }
+                    lStack.push_back(std::make_pair(lMember->node.get(), lChild.get()));
+                }
+            }
+        } else
+        if(const ArrayNode *lArray = dynamic_cast<const ArrayNode*>(lNode)) {
+            lRecord.arrayLength = lArray->getChildCount();
+            lEntry->totalArrayLength += lRecord.arrayLength;
+            lEntry->arrayLengths[lRecord.arrayLength]++;
+
+            if(lRecord.arrayLength) {
+                if(!lEntry->elementsEntry) {
+                    lEntry->elementsEntry.reset(new PathSummaryEntry(lEntry, std::wstring(), true));
+                }
+                for(int i=0; i<lArray->getChildCount(); i++) {
+                    if(const Node *lElement = lArray->getChildAt(i)) {
+                        lStack.push_back(std::make_pair(lElement, lEntry->elementsEntry.get()));
+                    }
+                }
+            }
+        }
+
+        records[lNode] = lRecord;
+    }
+}
+
+void PathSummary::removeRecords(const Node *aNode)
+{
+    std::vector<const Node*> lStack(1, aNode);
+    while(!lStack.empty()) {
+        const Node *lNode = lStack.back();
+        lStack.pop_back();
+
+        if(const ContainerNode *lContainer = dynamic_cast<const ContainerNode*>(lNode)) {
+            for(int i=0; i<lContainer->getChildCount(); i++) {
+                if(const Node *lChild = lContainer->getChildAt(i)) {
+                    lStack.push_back(lChild);
+                }
+            }
+        }
+
+        auto lRecordIter = records.find(lNode);
+        if(lRecordIter == records.end()) {
+            continue;
+        }
+
+        Record lRecord = lRecordIter->second;
+        records.erase(lRecordIter);
+
+        PathSummaryEntry *lEntry = lRecord.entry;
+        lEntry->count--;
+        lEntry->typeCounts[lRecord.type]--;
+        if(lRecord.type == ntArray) {
+            lEntry->totalArrayLength -= lRecord.arrayLength;
+            auto lLengthIter = lEntry->arrayLengths.find(lRecord.arrayLength);
+            if(!--lLengthIter->second) {
+                lEntry->arrayLengths.erase(lLengthIter);
+            }
+        }
+
+        // Drop paths no node is at anymore
+        while(lEntry != root.get() && lEntry->unused()) {
+            PathSummaryEntry *lParent = lEntry->parent;
+            if(lEntry->elements) {
+                lParent->elementsEntry.reset();
+            } else {
+                lParent->members.erase(lParent->members.find(lEntry->name));
+            }
+            lEntry = lParent;
+        }
+    }
+}
+
+void PathSummary::removeSubtree(const Node *aNode)
+{
+    if(aNode && !records.empty()) {
+        removeRecords(aNode);
+    }
+}
+
+void PathSummary::refreshSubtree(const Node *aNode)
+{
+    if(dynamic_cast<const DocumentNode*>(aNode)) {
+        aNode = static_cast<const DocumentNode*>(aNode)->getChildAt(0);
+    }
+
+    if(!aNode) {
+        return;
+    }
+
+    removeRecords(aNode);
+    if(PathSummaryEntry *lEntry = entryForNode(aNode)) {
+        addSubtree(aNode, lEntry);
+    }
+}
+
+}
@@ -0,0 +1,121 @@
+//
+//  PathSummary.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef PathSummary_hpp
+#define PathSummary_hpp
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "json_file.h"
+
+namespace json
+{
+
+// Nodes of a DOM found at one key path; array elements are all at their array's path + [*]
+class PathSummaryEntry
+{
+public:
+    typedef std::map<std::wstring, std::unique_ptr<PathSummaryEntry>> Members;
+
+    const PathSummaryEntry *getParent() const { return parent; }
+
+    // Member name of this step; empty for the root and for array elements
+    const std::wstring &getName() const { return name; }
+    bool isElements() const { return elements; }
+
+    // E.g $.store.book[*].title
+    std::wstring getPathString() const;
+
+    size_t getCount() const { return count; }
+    size_t getTypeCount(NodeTypeId aType) const { return typeCounts[aType]; }
+
+    // Lengths of the arrays at this path
+    size_t getTotalArrayLength() const { return totalArrayLength; }
+    size_t getMinArrayLength() const { return arrayLengths.empty() ? 0 : arrayLengths.begin()->first; }
+    size_t getMaxArrayLength() const { return arrayLengths.empty() ? 0 : arrayLengths.rbegin()->first; }
+    double getMeanArrayLength() const;
+
+    const Members &getMembers() const { return members; }
+    const PathSummaryEntry *getMember(const std::wstring &aName) const;
+    const PathSummaryEntry *getElements() const { return elementsEntry.get(); }
+
+    // Some node at this path or below it has a member named aName
+    bool mayContainMember(const std::wstring &aName) const;
+
+private:
+    friend class PathSummary;
+
+    PathSummaryEntry(PathSummaryEntry *aParent, const std::wstring &aName, bool aElements) :
+    parent(aParent), name(aName), elements(aElements) {}
+
+    bool unused() const { return !count && members.empty() && !elementsEntry; }
+
+    PathSummaryEntry *parent;
+    std::wstring name;
+    bool elements;
+
+    size_t count = 0;
+    size_t typeCounts[ntArray+1] = {};
+    size_t totalArrayLength = 0;
+    std::map<size_t, size_t> arrayLengths;   // Number of arrays of each length
+
+    Members members;
+    std::unique_ptr<PathSummaryEntry> elementsEntry;
+};
+
+/////////////////////////////////////////////////////////////////////////
+// PathSummary - the distinct key paths of a DOM (a "DataGuide"), with node counts, value type
+// histograms and array length statistics for each.
+//
+// JsonFile keeps it in sync with its DOM the same way as the MemberNameIndex: subtrees leaving
+// the DOM are subtracted as they go, and refreshed subtrees are summarized again once the
+// change is delivered. Each node remembers what it added, so subtracting doesn't depend on
+// the DOM around it.
+
+class PathSummary
+{
+public:
+    PathSummary() : root(new PathSummaryEntry(NULL, std::wstring(), false)) {}
+
+    void clear();
+
+    // aNode's subtree is leaving the DOM
+    void removeSubtree(const Node *aNode);
+
+    // aNode's subtree changed in place; its nodes are summarized again
+    void refreshSubtree(const Node *aNode);
+
+    const PathSummaryEntry *getRoot() const { return root.get(); }
+
+    // Entry for the path of aNode, which is in the summarized DOM
+    const PathSummaryEntry *findEntry(const Node *aNode) const;
+
+    size_t numNodes() const { return records.size(); }
+
+private:
+    struct Record {
+        PathSummaryEntry *entry;
+        NodeTypeId type;
+        size_t arrayLength;
+    };
+
+    PathSummaryEntry *entryForNode(const Node *aNode);
+    void addSubtree(const Node *aNode, PathSummaryEntry *aEntry);
+    void removeRecords(const Node *aNode);
+
+private:
+    std::unique_ptr<PathSummaryEntry> root;
+    std::unordered_map<const Node*, Record> records;
+};
+
+}
+
+#endif /* PathSummary_hpp */
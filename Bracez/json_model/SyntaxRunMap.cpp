@@ -0,0 +1,96 @@
+//
+//  SyntaxRunMap.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "SyntaxRunMap.hpp"
+
+namespace json
+{
+
+static bool isSameRun(const SyntaxRun &aLeft, const SyntaxRun &aRight)
+{
+    return aLeft.getCoordinate() == aRight.getCoordinate() &&
+           aLeft.getLength() == aRight.getLength() &&
+           aLeft.getTokenClass() == aRight.getTokenClass();
+}
+
+bool SyntaxRunMap::setRuns(SyntaxRunList &&aRuns, MarkerListDelta *aOutDelta)
+{
+    return runs.replaceMarkers(std::move(aRuns), isSameRun, aOutDelta);
+}
+
+void SyntaxRunMap::getChangedRange(const MarkerListDelta &aDelta, TextCoordinate aTextEnd,
+                                   TextCoordinate &aOutStart, TextCoordinate &aOutEnd) const
+{
+    size_t lFirstKeptAfter = aDelta.index + aDelta.numInserted;
+    aOutStart = aDelta.index && aDelta.index <= runs.size() ? runs[(int)aDelta.index-1].getEnd() : TextCoordinate(0);
+    aOutEnd = lFirstKeptAfter < runs.size() ? runs[(int)lFirstKeptAfter].getCoordinate() : aTextEnd;
+}
+
+void SyntaxRunMap::spliceRuns(TextCoordinate aStart, TextLength aLen, TextLength aNewLen, SyntaxRunList *aNewRuns)
+{
+    // spliceCoordinatesList drops the runs starting in the spliced range; grow it back to
+    // the start of a run that crosses into it
+    SyntaxRunList::const_iterator lIter = std::lower_bound(runs.begin(), runs.end(), aStart);
+    if(lIter != runs.begin() && (lIter-1)->getEnd() > aStart) {
+        TextLength lGrowBy = aStart - (lIter-1)->getCoordinate();
+        aStart = (lIter-1)->getCoordinate();
+        aLen += lGrowBy;
+        aNewLen += lGrowBy;
+    }
+
+    runs.spliceCoordinatesList(aStart, aLen, aNewLen, aNewRuns);
+}
+
+void SyntaxRunMap::invalidateRuns(TextCoordinate aStart, TextLength aLen, TextLength aNewLen)
+{
+    SyntaxRunList::const_iterator lIter = std::lower_bound(runs.begin(), runs.end(), aStart);
+    if(lIter != runs.begin() && (lIter-1)->getEnd() >= aStart) {
+        TextLength lGrowBy = aStart - (lIter-1)->getCoordinate();
+        aStart = (lIter-1)->getCoordinate();
+        aLen += lGrowBy;
+        aNewLen += lGrowBy;
+    }
+
+    // A run starting right at the end of the range is dropped too
+    lIter = std::lower_bound(runs.begin(), runs.end(), aStart + aLen);
+    if(lIter != runs.end() && lIter->getCoordinate() == aStart + aLen) {
+        aLen++;
+        aNewLen++;
+    }
+
+    runs.spliceCoordinatesList(aStart, aLen, aNewLen);
+}
+
+std::pair<SyntaxRunMap::const_iterator, SyntaxRunMap::const_iterator>
+SyntaxRunMap::runsIntersecting(TextCoordinate aStart, TextCoordinate aEnd) const
+{
+    // Runs are disjoint, so only the one before the first starting in range may cross into it
+    const_iterator lBegin = std::lower_bound(runs.begin(), runs.end(), aStart);
+    if(lBegin != runs.begin() && (lBegin-1)->getEnd() > aStart) {
+        lBegin--;
+    }
+
+    const_iterator lEnd = std::lower_bound(lBegin, runs.end(), aEnd);
+    return std::make_pair(lBegin, lEnd);
+}
+
+const SyntaxRun *SyntaxRunMap::findRun(TextCoordinate aCoord, TextCoordinate aTextEnd,
+                                       TextCoordinate &aOutStart, TextCoordinate &aOutEnd) const
+{
+    const_iterator lNext = std::upper_bound(runs.begin(), runs.end(), aCoord);
+    if(lNext != runs.begin() && (lNext-1)->getEnd() > aCoord) {
+        aOutStart = (lNext-1)->getCoordinate();
+        aOutEnd = (lNext-1)->getEnd();
+        return &*(lNext-1);
+    }
+
+    aOutStart = lNext != runs.begin() ? (lNext-1)->getEnd() : TextCoordinate(0);
+    aOutEnd = lNext != runs.end() ? lNext->getCoordinate() : aTextEnd;
+    return NULL;
+}
+
+}
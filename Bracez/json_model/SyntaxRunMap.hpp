@@ -0,0 +1,90 @@
+//
+//  SyntaxRunMap.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef SyntaxRunMap_hpp
+#define SyntaxRunMap_hpp
+
+#include <utility>
+#include "marker_list.h"
+#include "JsonLexicalHighlighter.hpp"
+
+namespace json
+{
+
+// A run of text of a single token class
+class SyntaxRun : public BaseMarker
+{
+public:
+    SyntaxRun(TextCoordinate aStart, TextLength aLength, LexicalTokenClass aTokenClass) :
+    BaseMarker(aStart), length(aLength), tokenClass(aTokenClass) {}
+
+    TextLength getLength() const { return length; }
+    TextCoordinate getEnd() const { return coordinate + length; }
+    LexicalTokenClass getTokenClass() const { return tokenClass; }
+
+private:
+    TextLength length;
+    LexicalTokenClass tokenClass;
+} ;
+
+typedef MarkerList<SyntaxRun> SyntaxRunList;
+
+/////////////////////////////////////////////////////////////////////////
+// SyntaxRunMap - token classes of the whole text as sorted, disjoint runs.
+//
+// Text outside any run (punctuation, whitespace) has the default class. Kept up to date by
+// JsonFile across splices and reparses, so the text system can query any range without
+// walking the DOM.
+
+class SyntaxRunMap
+{
+public:
+    typedef SyntaxRunList::const_iterator const_iterator;
+
+    void clear() { runs.clear(); }
+
+    // Replaces all runs, returns whether any of them changed
+    bool setRuns(SyntaxRunList &&aRuns, MarkerListDelta *aOutDelta = NULL);
+
+    // Text whose runs may have changed by a delta of setRuns: everything between the runs
+    // it kept before and after the change, up to aTextEnd
+    void getChangedRange(const MarkerListDelta &aDelta, TextCoordinate aTextEnd,
+                         TextCoordinate &aOutStart, TextCoordinate &aOutEnd) const;
+
+    // Text in [aStart, aStart+aLen) was replaced by aNewLen units whose runs are aNewRuns.
+    // Runs intersecting the replaced range are dropped, and the ones past it shifted.
+    void spliceRuns(TextCoordinate aStart, TextLength aLen, TextLength aNewLen, SyntaxRunList *aNewRuns);
+
+    // Text was spliced without being reparsed. Tokens next to the splice may have grown
+    // into it, so runs touching the replaced range are dropped as well.
+    void invalidateRuns(TextCoordinate aStart, TextLength aLen, TextLength aNewLen);
+
+    // Batch counterpart of spliceRuns, see MarkerList::remapCoordinates
+    template<class KEEP, class MAP>
+    void remapRuns(KEEP aKeep, MAP aMapCoordinate, const SyntaxRunList *aNewRuns = NULL) {
+        runs.remapCoordinates(aKeep, aMapCoordinate, aNewRuns);
+    }
+
+    // Runs intersecting [aStart, aEnd), in O(log n + k)
+    std::pair<const_iterator, const_iterator> runsIntersecting(TextCoordinate aStart, TextCoordinate aEnd) const;
+
+    // Run containing aCoord, or NULL if it has the default class; [aOutStart, aOutEnd) is set
+    // to the run, or to the space between runs that contains aCoord (up to aTextEnd).
+    const SyntaxRun *findRun(TextCoordinate aCoord, TextCoordinate aTextEnd,
+                             TextCoordinate &aOutStart, TextCoordinate &aOutEnd) const;
+
+    size_t size() const { return runs.size(); }
+    const_iterator begin() const { return runs.begin(); }
+    const_iterator end() const { return runs.end(); }
+
+private:
+    SyntaxRunList runs;
+} ;
+
+}
+
+#endif /* SyntaxRunMap_hpp */
@@ -0,0 +1,112 @@
+//
+//  TextEncoding.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef TextEncoding_hpp
+#define TextEncoding_hpp
+
+#include <string>
+
+// Document text is kept as UTF-16 code units -- half the size of wchar_t text, and the same
+// encoding NSString uses, so TextCoordinates map 1:1 to editor (NSRange) locations.
+// Decoded DOM values (string nodes, member names) remain std::wstring.
+typedef char16_t TextChar;
+typedef std::basic_string<TextChar> TextString;
+
+inline bool isHighSurrogate(unsigned long aUnit) { return (aUnit & 0xFC00) == 0xD800; }
+inline bool isLowSurrogate(unsigned long aUnit) { return (aUnit & 0xFC00) == 0xDC00; }
+
+inline void appendCodePoint(TextString &aDest, unsigned long aCodePoint)
+{
+    if(aCodePoint >= 0x10000 && aCodePoint <= 0x10FFFF)
+    {
+        aCodePoint -= 0x10000;
+        aDest.push_back((TextChar)(0xD800 | (aCodePoint >> 10)));
+        aDest.push_back((TextChar)(0xDC00 | (aCodePoint & 0x3FF)));
+    } else
+    {
+        aDest.push_back((TextChar)aCodePoint);
+    }
+}
+
+inline TextString textStringFromWstring(const std::wstring &aSrc)
+{
+    TextString lRet;
+    lRet.reserve(aSrc.length());
+    for(wchar_t c: aSrc)
+    {
+        appendCodePoint(lRet, (unsigned long)c);
+    }
+
+    return lRet;
+}
+
+// Decodes surrogate pairs; unpaired surrogates are kept as-is.
+inline std::wstring wstringFromText(const TextChar *aBegin, const TextChar *aEnd)
+{
+    std::wstring lRet;
+    lRet.reserve(aEnd-aBegin);
+    for(const TextChar *p = aBegin; p<aEnd; p++)
+    {
+        if(isHighSurrogate(*p) && p+1 < aEnd && isLowSurrogate(p[1]))
+        {
+            lRet.push_back((wchar_t)(0x10000 + (((unsigned long)(*p & 0x3FF)) << 10) + (p[1] & 0x3FF)));
+            p++;
+        } else
+        {
+            lRet.push_back((wchar_t)*p);
+        }
+    }
+
+    return lRet;
+}
+
+inline std::wstring wstringFromText(const TextString &aSrc)
+{
+    return wstringFromText(aSrc.data(), aSrc.data() + aSrc.length());
+}
+
+// Decodes surrogate pairs like wstringFromText; unpaired surrogates are encoded as-is.
+inline std::string utf8FromText(const TextChar *aBegin, const TextChar *aEnd)
+{
+    std::string lRet;
+    lRet.reserve(aEnd-aBegin);
+    for(const TextChar *p = aBegin; p<aEnd; p++)
+    {
+        unsigned long c = *p;
+        if(isHighSurrogate(c) && p+1 < aEnd && isLowSurrogate(p[1]))
+        {
+            c = 0x10000 + ((c & 0x3FF) << 10) + (p[1] & 0x3FF);
+            p++;
+        }
+        
+        if(c < 0x80)
+        {
+            lRet.push_back((char)c);
+        } else
+        if(c < 0x800)
+        {
+            lRet.push_back((char)(0xC0 | (c >> 6)));
+            lRet.push_back((char)(0x80 | (c & 0x3F)));
+        } else
+        if(c < 0x10000)
+        {
+            lRet.push_back((char)(0xE0 | (c >> 12)));
+            lRet.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+            lRet.push_back((char)(0x80 | (c & 0x3F)));
+        } else
+        {
+            lRet.push_back((char)(0xF0 | (c >> 18)));
+            lRet.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+            lRet.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+            lRet.push_back((char)(0x80 | (c & 0x3F)));
+        }
+    }
+
+    return lRet;
+}
+
+#endif /* TextEncoding_hpp */
@@ -13,8 +13,11 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <climits>
 
 #include "reader.h"
+#include "PathSummary.hpp"
 
 #include "stopwatch.h"
 
@@ -36,14 +39,9 @@ public:
         
     }
     
-    SpliceNotification *clone() const
+    void addToChangeSet(JsonFileChangeSet &aChangeSet) const
     {
-        return new SpliceNotification(*this);
-    }
-    
-    void deliverToListener(JsonFile *aSender, JsonFileChangeListener *aListener) const
-    {
-        aListener->notifyTextSpliced(aSender, offsetStart, len, newLen, lineOffsetStart, lineLen, lineNewLen);
+        aChangeSet.addSplice({ offsetStart, len, newLen, lineOffsetStart, lineLen, lineNewLen });
     }
     
 private:
@@ -59,18 +57,30 @@ private:
 class ErrorsChangedNotification : public Notification
 {
 public:
-    ErrorsChangedNotification() {}
-    ErrorsChangedNotification(const ErrorsChangedNotification &aOther) {}
+    ErrorsChangedNotification(const MarkerListDelta &aDelta) : delta(aDelta) {}
     
-    ErrorsChangedNotification *clone() const
+    void addToChangeSet(JsonFileChangeSet &aChangeSet) const
     {
-        return new ErrorsChangedNotification(*this);
+        aChangeSet.addErrorsDelta(delta);
     }
     
-    void deliverToListener(JsonFile *aSender, JsonFileChangeListener *aListener) const
+private:
+    MarkerListDelta delta;
+} ;
+
+
+class SyntaxRunsChangedNotification : public Notification
+{
+public:
+    SyntaxRunsChangedNotification(const MarkerListDelta &aDelta) : delta(aDelta) {}
+    
+    void addToChangeSet(JsonFileChangeSet &aChangeSet) const
     {
-        aListener->notifyErrorsChanged(aSender);
+        aChangeSet.addSyntaxRunsDelta(delta);
     }
+    
+private:
+    MarkerListDelta delta;
 } ;
 
 
@@ -80,20 +90,9 @@ public:
     NodeRefreshNotification(JsonPath &&path) :
     _path(path) {}
     
-    NodeRefreshNotification(const NodeRefreshNotification &aOther)
-    : _path(aOther._path)
-    {
-        
-    }
-    
-    NodeRefreshNotification *clone() const
+    void addToChangeSet(JsonFileChangeSet &aChangeSet) const
     {
-        return new NodeRefreshNotification(*this);
-    }
-    
-    void deliverToListener(JsonFile *aSender, JsonFileChangeListener *aListener) const
-    {
-        aListener->notifyNodeChanged(aSender, _path);
+        aChangeSet.addRefreshedNode(_path);
     }
     
 private:
@@ -110,6 +109,81 @@ private:
     JsonFile *who;
 } ;
 
+// Maps coordinates in the text before a batch of sorted, disjoint edits to the text after it.
+class EditCoordinateMapper
+{
+public:
+    EditCoordinateMapper(const std::vector<Splice> &aEdits) : edits(aEdits)
+    {
+        deltas.reserve(edits.size()+1);
+        deltas.push_back(0);
+        for(const Splice &lEdit: edits)
+        {
+            deltas.push_back(deltas.back() + (long)lEdit.newText.length() - (long)lEdit.len);
+        }
+    }
+    
+    // An insertion at aCoord is taken to be inside a range that starts at aCoord (it's
+    // not shifted by it) or ends at aCoord (it is).
+    TextCoordinate map(TextCoordinate aCoord, bool aIsRangeStart) const
+    {
+        size_t lIdx = numEditsEndingBefore(aCoord);
+        while(aIsRangeStart && lIdx > 0 && edits[lIdx-1].start == aCoord)
+        {
+            lIdx--;
+        }
+        
+        return TextCoordinate(aCoord.getAddress() + deltas[lIdx]);
+    }
+    
+    // Maps the range of a node kept across the edits. An insertion at one of its boundaries
+    // is inside it only if a reparsed region (which owns the insertion) shares that boundary.
+    TextRange mapKeptRange(const TextRange &aRange) const
+    {
+        auto lSharesStart = [&](const TextRange &aRegion) { return aRegion.start == aRange.start; };
+        auto lSharesEnd = [&](const TextRange &aRegion) { return aRegion.end == aRange.end; };
+        bool lStartOwnsInsertion = std::any_of(reparsedRanges.begin(), reparsedRanges.end(), lSharesStart);
+        bool lEndOwnsInsertion = std::any_of(reparsedRanges.begin(), reparsedRanges.end(), lSharesEnd);
+        
+        return TextRange(map(aRange.start, lStartOwnsInsertion), map(aRange.end, !lEndOwnsInsertion));
+    }
+    
+    void addReparsedRange(const TextRange &aRange) { reparsedRanges.push_back(aRange); }
+    
+    // Length change of the edits before edit aIdx
+    long deltaBefore(size_t aIdx) const { return deltas[aIdx]; }
+    
+    bool hasEditWithin(const TextRange &aRange) const
+    {
+        auto lIter = std::partition_point(edits.begin(), edits.end(), [&aRange](const Splice &aEdit) {
+            return aEdit.start + aEdit.len < aRange.start;
+        });
+        
+        return lIter != edits.end() && lIter->start <= aRange.end;
+    }
+    
+    bool isInsideEdit(TextCoordinate aCoord) const
+    {
+        auto lIter = std::partition_point(edits.begin(), edits.end(), [aCoord](const Splice &aEdit) {
+            return aEdit.start + aEdit.len <= aCoord;
+        });
+        
+        return lIter != edits.end() && lIter->start <= aCoord;
+    }
+    
+private:
+    size_t numEditsEndingBefore(TextCoordinate aCoord) const
+    {
+        return std::partition_point(edits.begin(), edits.end(), [aCoord](const Splice &aEdit) {
+            return aEdit.start + aEdit.len <= aCoord;
+        }) - edits.begin();
+    }
+    
+    const std::vector<Splice> &edits;
+    std::vector<long> deltas;
+    std::vector<TextRange> reparsedRanges;
+} ;
+
 }
 
 using namespace priv;
@@ -125,13 +199,19 @@ DocumentNode *Node::getDocument() const
     return const_cast<DocumentNode*>(dynamic_cast<const DocumentNode*>(lCurNode));
 }
 
+bool Node::isLive() const
+{
+    const DocumentNode *lDocument = getDocument();
+    return lDocument && lDocument->getOwner();
+}
+
 const TextRange &Node::getTextRange() const
 {
     return textRange;
 }
 
 
-wstring Node::getDocumentText() const
+TextString Node::getDocumentText() const
 {
     TextRange lAbsRange = getAbsTextRange();
     return getDocument()->getOwner()->getText().substr(lAbsRange.start, lAbsRange.length());
@@ -175,8 +255,9 @@ void ContainerNode::setChildAt(int aIdx, Node *aNode, bool fromReparse)
         TextCoordinate lNewStart = lOldNode->textRange.start;
         TextCoordinate lNewEnd;
         
-        std::wstring lNewNodeText;
-        aNode->calculateJsonTextRepresentation(lNewNodeText);
+        std::wstring lNewNodeRepresentation;
+        aNode->calculateJsonTextRepresentation(lNewNodeRepresentation);
+        TextString lNewNodeText = textStringFromWstring(lNewNodeRepresentation);
         
         lNewEnd = lNewStart + (int)lNewNodeText.length();
         
@@ -189,27 +270,30 @@ void ContainerNode::setChildAt(int aIdx, Node *aNode, bool fromReparse)
         getDocument()->getOwner()->notifyUpdatedNode(this);
     }
     
-    // Update in child list and import to document
-    storeChildAt(aIdx, aNode);
+    // Update in child list and import to document; the old node may still be
+    // referenced by pinned readers
+    Node *lReplacedNode = storeChildAt(aIdx, aNode);
     aNode->parent = this;
+    getDocument()->getOwner()->retireNode(lReplacedNode);
 }
 
 int ContainerNode::findChildContaining(const TextCoordinate &aDocOffset, bool strict) const
 {
     // Fast path for cached child
-    if(cachedLastRangeFoundChild != -1 && cachedLastRangeFoundChild < getChildCount()) {
-        TextRange tr = getChildAt(cachedLastRangeFoundChild)->getTextRange();
+    int lCached = cachedLastRangeFoundChild.load(std::memory_order_relaxed);
+    if(lCached != -1 && lCached < getChildCount()) {
+        TextRange tr = getChildAt(lCached)->getTextRange();
         if( (tr.start < aDocOffset || (!strict && tr.start == aDocOffset)) &&
            (tr.end > aDocOffset) ) {
-            return cachedLastRangeFoundChild;
+            return lCached;
         }
         
-        if(aDocOffset >= tr.end && cachedLastRangeFoundChild+1 < getChildCount()) {
-            TextRange tr2 = getChildAt(cachedLastRangeFoundChild+1)->getTextRange();
+        if(aDocOffset >= tr.end && lCached+1 < getChildCount()) {
+            TextRange tr2 = getChildAt(lCached+1)->getTextRange();
             if( (tr2.start < aDocOffset || (!strict && tr2.start == aDocOffset)) &&
                (tr2.end > aDocOffset) ) {
-                cachedLastRangeFoundChild = cachedLastRangeFoundChild+1;
-                return cachedLastRangeFoundChild;
+                cachedLastRangeFoundChild.store(lCached+1, std::memory_order_relaxed);
+                return lCached+1;
             } else
                 if(tr2.start > aDocOffset) {
                     return -1;
@@ -222,7 +306,7 @@ int ContainerNode::findChildContaining(const TextCoordinate &aDocOffset, bool st
     {
         TextRange tr = getChildAt(lRet)->getTextRange();
         if(tr.start < aDocOffset || (!strict && tr.start == aDocOffset)) {
-            cachedLastRangeFoundChild = lRet;
+            cachedLastRangeFoundChild.store(lRet, std::memory_order_relaxed);
             return lRet;
         }
     }
@@ -232,6 +316,14 @@ int ContainerNode::findChildContaining(const TextCoordinate &aDocOffset, bool st
 
 int ContainerNode::getIndexOfChild(const Node *aChild) const
 {
+    // Children are ordered by their text ranges, so the child is usually found by its start
+    int lIdx = findChildEndingAfter(aChild->getTextRange().start);
+    if(lIdx >= 0 && lIdx < getChildCount() && getChildAt(lIdx) == aChild)
+    {
+        return lIdx;
+    }
+    
+    // Nodes without text (e.g built with the DOM-only modifiers) are scanned for
     int lChildCount = getChildCount();
     for(int lIdx = 0; lIdx<lChildCount; lIdx++)
     {
@@ -249,7 +341,7 @@ void ContainerNode::removeChildAt(int aIdx)
     Node *lChild;
     detachChildAt(aIdx, &lChild);
     
-    delete lChild;
+    getDocument()->getOwner()->retireNode(lChild);
 }
 
 
@@ -321,8 +413,11 @@ const Node *ArrayNode::getChildAt(int aIdx) const
     return elements[aIdx].get();
 }
 
-void ArrayNode::storeChildAt(int aIdx, Node *aNode) {
+Node *ArrayNode::storeChildAt(int aIdx, Node *aNode) {
+    Node *lReplaced = elements[aIdx].release();
     elements[aIdx].reset(aNode);
+    
+    return lReplaced;
 }
 
 void ArrayNode::detachChildAt(int aIdx, Node **aNode)
@@ -345,16 +440,17 @@ void ArrayNode::detachChildAt(int aIdx, Node **aNode)
         }
     }
     
+    getDocument()->getOwner()->unindexNode(lIter->get());
     *aNode = lIter->release();
     (*aNode)->parent = NULL;
     
     elements.erase(lIter);
     
-    getDocument()->getOwner()->spliceJsonTextByDomChange(lSpliceRange.start, lSpliceRange.length(), wstring(L""));
+    getDocument()->getOwner()->spliceJsonTextByDomChange(lSpliceRange.start, lSpliceRange.length(), TextString());
     getDocument()->getOwner()->notifyUpdatedNode(this);
 }
 
-void ArrayNode::InsertMemberAt(int aIdx, Node *aElement, const wstring *aElementText)
+void ArrayNode::InsertMemberAt(int aIdx, Node *aElement, const TextString *aElementText)
 {
     // Don't send notifications till we're thru
     DeferNotificationsInBlock lDnib(getDocument()->getOwner());
@@ -384,10 +480,10 @@ void ArrayNode::InsertMemberAt(int aIdx, Node *aElement, const wstring *aElement
     aElement->parent = this;
     
     // Calculate element text: start with name
-    wstring lCalculatedText;
+    TextString lCalculatedText;
     if(lIsLast && aIdx)
     {
-        lCalculatedText = L", ";
+        lCalculatedText = u", ";
         lElemAddr+=2;
     }
     
@@ -400,14 +496,15 @@ void ArrayNode::InsertMemberAt(int aIdx, Node *aElement, const wstring *aElement
     } else {
         wstring lTxt;
         aElement->calculateJsonTextRepresentation(lTxt);
-        lElementTextLen = lTxt.length();
-        lCalculatedText += lTxt;
+        TextString lElementText = textStringFromWstring(lTxt);
+        lElementTextLen = lElementText.length();
+        lCalculatedText += lElementText;
     }
     
     // Add comma if not last element
     if(!lIsLast)
     {
-        lCalculatedText += L", ";
+        lCalculatedText += u", ";
     }
     
     // Update document text
@@ -604,8 +701,11 @@ const ObjectNode::Member *ObjectNode::getChildMemberAt(int aIdx) const
     return &members[aIdx];
 }
 
-void ObjectNode::storeChildAt(int aIdx, Node *aNode) {
+Node *ObjectNode::storeChildAt(int aIdx, Node *aNode) {
+    Node *lReplaced = members[aIdx].node.release();
     members[aIdx].node.reset(aNode);
+    
+    return lReplaced;
 }
 
 void ObjectNode::adjustChildRangeAt(int aIdx, long aDiff)
@@ -654,7 +754,7 @@ void ObjectNode::renameMemberAt(int aIdx, const wstring &aName) {
     TextRange orgRange = members[aIdx].nameRange;
     std::wstring orgName = members[aIdx].name;
     
-    std::wstring jsonizedName = jsonizeString(aName);
+    TextString jsonizedName = textStringFromWstring(jsonizeString(aName));
     TextRange myAbs = getAbsTextRange();
     members[aIdx].name = aName;
     getDocument()->getOwner()->spliceJsonTextByDomChange(orgRange.start + myAbs.start, orgRange.length(),
@@ -668,7 +768,7 @@ void ObjectNode::renameMemberAt(int aIdx, const wstring &aName) {
     members[aIdx].nameRange.end = members[aIdx].nameRange.start + (int)jsonizedName.length();
 }
 
-ObjectNode::Member &ObjectNode::insertMemberAt(int aIdx, const wstring &aName, Node *aElement, const wstring *aElementText)
+ObjectNode::Member &ObjectNode::insertMemberAt(int aIdx, const wstring &aName, Node *aElement, const TextString *aElementText)
 {
     // Don't send notifications till we're thru
     DeferNotificationsInBlock lDnib(getDocument()->getOwner());
@@ -701,19 +801,19 @@ ObjectNode::Member &ObjectNode::insertMemberAt(int aIdx, const wstring &aName, N
     aElement->parent = this;
     
     // Calculate element text: start with name
-    wstring lCalculatedText;
+    TextString lCalculatedText;
     unsigned long lNameLen;
     
-    lCalculatedText = jsonizeString(lMember.name);
+    lCalculatedText = textStringFromWstring(jsonizeString(lMember.name));
     lNameLen = lCalculatedText.length();
     
     if(lIsLast && aIdx)
     {
-        lCalculatedText = L", " + lCalculatedText;
+        lCalculatedText = u", " + lCalculatedText;
         lNameAddr+=2;
     }
     
-    lCalculatedText += L": ";
+    lCalculatedText += u": ";
     
     // (Update node start address to skip name)
     unsigned long lElemAddr = lChangeAddr + lCalculatedText.length();
@@ -727,13 +827,14 @@ ObjectNode::Member &ObjectNode::insertMemberAt(int aIdx, const wstring &aName, N
     } else {
         wstring lTxt;
         aElement->calculateJsonTextRepresentation(lTxt);
-        lCalculatedText += lTxt;
-        lElementTextLen = lTxt.length();
+        TextString lElementText = textStringFromWstring(lTxt);
+        lCalculatedText += lElementText;
+        lElementTextLen = lElementText.length();
     }
     
     if(!lIsLast)
     {
-        lCalculatedText += L", ";
+        lCalculatedText += u", ";
     }
     
     // Update document text
@@ -803,12 +904,13 @@ void ObjectNode::detachChildAt(int aIdx, Node **aNode)
         lSpliceRange.end = lSpliceRange.end - 1;
     }
     
+    getDocument()->getOwner()->unindexNode(lIter->node.get());
     *aNode = lIter->node.release();
     (*aNode)->parent = NULL;
     
     members.erase(lIter);
     
-    getDocument()->getOwner()->spliceJsonTextByDomChange(lSpliceRange.start, lSpliceRange.length(), L"");
+    getDocument()->getOwner()->spliceJsonTextByDomChange(lSpliceRange.start, lSpliceRange.length(), TextString());
     getDocument()->getOwner()->notifyUpdatedNode(this);
 }
 
@@ -940,6 +1042,12 @@ DocumentNode::DocumentNode(JsonFile *aOwner, Node *aChild)
     }
 }
 
+DocumentNode::DocumentNode(Node *aChild, TextCoordinate aStart)
+: DocumentNode(NULL, aChild)
+{
+    textRange = TextRange(aStart, aStart + aChild->getTextRange().end.getAddress());
+}
+
 NodeTypeId DocumentNode::getNodeTypeId() const 
 {
     return ntObject;
@@ -960,13 +1068,16 @@ const Node *DocumentNode::getChildAt(int aIdx) const
     return rootNode.get();
 }
 
-void DocumentNode::storeChildAt(int aIdx, Node *aNode)
+Node *DocumentNode::storeChildAt(int aIdx, Node *aNode)
 {
     assert(aIdx == 0);
+    Node *lReplaced = rootNode.release();
     rootNode.reset(aNode);
     if(rootNode.get()) {
         rootNode->parent = this;
     }
+    
+    return lReplaced;
 }
 
 int DocumentNode::findChildEndingAfter(const TextCoordinate &aDocOffset) const
@@ -974,6 +1085,30 @@ int DocumentNode::findChildEndingAfter(const TextCoordinate &aDocOffset) const
     return 0;
 }
 
+Node *DocumentNode::findNodeWithRange(const TextRange &aRange)
+{
+    // Ranges of children are relative to their parent's start
+    TextCoordinate lStart = aRange.start.relativeTo(textRange.start);
+    Node *lNode = rootNode.get();
+    while(lNode) {
+        const TextRange &lRange = lNode->getTextRange();
+        if(lRange.start == lStart && lRange.length() == aRange.length()) {
+            return lNode;
+        }
+        
+        ContainerNode *lContainer = dynamic_cast<ContainerNode*>(lNode);
+        if(!lContainer || lStart < lRange.start || lStart >= lRange.end) {
+            return NULL;
+        }
+        
+        lStart = lStart.relativeTo(lRange.start);
+        int lChild = lContainer->findChildContaining(lStart, false);
+        lNode = lChild >= 0 ? lContainer->getChildAt(lChild) : NULL;
+    }
+    
+    return NULL;
+}
+
 void DocumentNode::accept(NodeVisitor *aVisitor) const
 {
     aVisitor->visitNode(this);
@@ -1119,61 +1254,326 @@ void ValueNode<bool>::calculateJsonTextRepresentation(std::wstring &aDest, int m
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Collects up to aMaxErrors errors; the rest are only counted, and summarized by a single marker
+// once the parse is done (finish()). End-of-stream errors are always kept: they're few, and
+// local reparse relies on them to detect regions that were predicted wrong.
 class JsonParseErrorCollectionListenerListener : public ParseListener
 {
 public:
-    JsonParseErrorCollectionListenerListener(MarkerList<ParseErrorMarker> &errors)
-    : _errors(errors) {   }
+    JsonParseErrorCollectionListenerListener(MarkerList<ParseErrorMarker> &errors, size_t aMaxErrors)
+    : _errors(errors), _maxErrors(aMaxErrors), _numReported(0), _numSuppressed(0) {   }
     
-    void EndOfLine(TextCoordinate aCoord)
+    void Error(TextCoordinate aWhere, int aCode, ParseErrorMessage aMessage, unsigned int aArg)
     {
+        bool lEndOfStream = aCode == PARSER_ERROR_UNEXPECTED_EOS || aCode == PARSER_ERROR_EXPECTED_EOS;
+        if(_numReported >= _maxErrors && !lEndOfStream) {
+            // Only one error is kept per coordinate, so don't count repeats
+            if(_numReported + _numSuppressed && aWhere == _lastWhere) {
+                return;
+            }
+            if(!_numSuppressed) {
+                _firstSuppressed = aWhere;
+            }
+            _numSuppressed++;
+            _lastWhere = aWhere;
+            return;
+        }
+        
+        size_t lNumErrors = _errors.size();
+        _errors.addMarker(ParseErrorMarker(aWhere, aCode, aMessage, aArg));
+        if(!lEndOfStream && _errors.size() > lNumErrors) {
+            _numReported++;
+            _lastWhere = aWhere;
+        }
     }
     
-    void Error(TextCoordinate aWhere, int aCode, const string &aText)
+    void finish()
     {
-        _errors.addMarker(ParseErrorMarker(aWhere, aCode, aText));
+        if(_numSuppressed) {
+            _errors.addMarker(ParseErrorMarker(_firstSuppressed, PARSER_ERROR_TOO_MANY_ERRORS, PARSE_MSG_MORE_ERRORS,
+                                               (unsigned int)std::min<size_t>(_numSuppressed, UINT_MAX)));
+            _numSuppressed = 0;
+        }
     }
     
 private:
     MarkerList<ParseErrorMarker> &_errors;
+    size_t _maxErrors;
+    size_t _numReported;
+    size_t _numSuppressed;
+    TextCoordinate _firstSuppressed;
+    TextCoordinate _lastWhere;
 } ;
 
+std::string ParseErrorMarker::getErrorText(const TextString *aText) const
+{
+    if(aText && coordinate < TextCoordinate(aText->length())) {
+        const TextChar *lText = aText->data();
+        return FormatParseError(errorMessage, errorArg, lText + coordinate.getAddress(), lText + aText->length());
+    }
+    
+    return FormatParseError(errorMessage, errorArg);
+}
+
+
+// Branch-free so that the compiler can vectorize it.
+static TextLength countLineBreaks(const TextChar *aText, TextLength aLen)
+{
+    TextLength lCount = 0;
+    for(TextLength i = 0; i < aLen; i++) {
+        lCount += (aText[i] == u'\n');
+    }
+    
+    return lCount;
+}
+
+static void appendLineBreaks(SimpleMarkerList &aLineBreaks, const TextChar *aText, TextLength aLen, TextCoordinate aBaseOfs)
+{
+    TextLength lNumLineBreaks = countLineBreaks(aText, aLen);
+    if(!lNumLineBreaks) {
+        return;
+    }
+    
+    aLineBreaks.reserve(aLineBreaks.size() + lNumLineBreaks);
+    
+    const TextChar *lEnd = aText + aLen;
+    for(const TextChar *lCur = aText; lCur != lEnd; lCur++) {
+        if(*lCur == u'\n') {
+            aLineBreaks.appendMarker(BaseMarker(aBaseOfs + (TextLength)(lCur - aText)));
+        }
+    }
+}
+
+// Trailing units of surrogate pairs in [aFrom, aTo) of aText
+static void appendSurrogatePairs(SimpleMarkerList &aPairs, const TextChar *aText, TextLength aFrom, TextLength aTo)
+{
+    for(TextLength i = aFrom ? aFrom : 1; i < aTo; i++) {
+        if(isLowSurrogate(aText[i]) && isHighSurrogate(aText[i-1])) {
+            aPairs.appendMarker(BaseMarker(TextCoordinate(i)));
+        }
+    }
+}
+
+// Runs for the scalars and member names in aNode, whose parent starts at aParentStart
+static void appendSyntaxRuns(const Node *aNode, TextCoordinate aParentStart, TextCoordinate aTextEnd, SyntaxRunList &aRuns)
+{
+    auto lAppendRun = [&aRuns, aTextEnd](TextCoordinate aStart, TextCoordinate aEnd, LexicalTokenClass aTokenClass) {
+        // Nodes left open by a parse error extend to the end of the text
+        if(aEnd.infinite() || aEnd > aTextEnd) {
+            aEnd = aTextEnd;
+        }
+        
+        if(aStart < aEnd && (!aRuns.size() || aRuns.rbegin()->getEnd() <= aStart)) {
+            aRuns.appendMarker(SyntaxRun(aStart, aEnd - aStart, aTokenClass));
+        }
+    };
+    
+    TextCoordinate lStart = aParentStart + aNode->getTextRange().start.getAddress();
+    TextCoordinate lEnd = aNode->getTextRange().end.infinite() ? aTextEnd : aParentStart + aNode->getTextRange().end.getAddress();
+    
+    switch(aNode->getNodeTypeId()) {
+        case ntString:
+            lAppendRun(lStart, lEnd, ltcString);
+            break;
+            
+        case ntNumber:
+            lAppendRun(lStart, lEnd, ltcNumber);
+            break;
+            
+        case ntBoolean:
+        case ntNull:
+            lAppendRun(lStart, lEnd, ltcLiteral);
+            break;
+            
+        case ntObject: {
+            const ObjectNode *lObject = static_cast<const ObjectNode*>(aNode);
+            int lChildCount = lObject->getChildCount();
+            for(int i=0; i<lChildCount; i++) {
+                const ObjectNode::Member *lMember = lObject->getChildMemberAt(i);
+                lAppendRun(lStart + lMember->nameRange.start.getAddress(), lStart + lMember->nameRange.end.getAddress(), ltcKey);
+                if(lMember->node) {
+                    appendSyntaxRuns(lMember->node.get(), lStart, aTextEnd, aRuns);
+                }
+            }
+            break;
+        }
+            
+        case ntArray: {
+            const ArrayNode *lArray = static_cast<const ArrayNode*>(aNode);
+            int lChildCount = lArray->getChildCount();
+            for(int i=0; i<lChildCount; i++) {
+                if(const Node *lChild = lArray->getChildAt(i)) {
+                    appendSyntaxRuns(lChild, lStart, aTextEnd, aRuns);
+                }
+            }
+            break;
+        }
+    }
+}
+
+// Runs for a reparsed node that replaces its predecessor's range of text. Recovering from
+// errors, a member name can overlap the value's range; its run is then replaced too.
+static void appendReparsedSyntaxRuns(const Node *aNode, TextCoordinate aTextEnd, SyntaxRunList &aRuns)
+{
+    const ContainerNode *lParent = aNode->getParent();
+    TextCoordinate lParentStart = lParent->getAbsTextRange().start;
+    
+    if(const ObjectNode *lObject = dynamic_cast<const ObjectNode*>(lParent)) {
+        const TextRange &lNameRange = lObject->getChildMemberAt(lObject->getIndexOfChild(aNode))->nameRange;
+        if(lNameRange.start >= aNode->getTextRange().start && lNameRange.start < lNameRange.end &&
+           (!aRuns.size() || aRuns.rbegin()->getEnd() <= lParentStart + lNameRange.start.getAddress())) {
+            aRuns.appendMarker(SyntaxRun(lParentStart + lNameRange.start.getAddress(), lNameRange.length(), ltcKey));
+        }
+    }
+    
+    appendSyntaxRuns(aNode, lParentStart, aTextEnd, aRuns);
+}
 
 JsonFile::JsonFile()
-: notificationsDeferred(0), jsonDom(new DocumentNode(this, new NullNode())), jsonText(new std::wstring())
+: notificationsDeferred(0), jsonDom(new DocumentNode(this, new NullNode())), jsonText(new TextString()), maxParseErrors(DEFAULT_MAX_PARSE_ERRORS), version(0),
+  reclaimer(make_shared<NodeReclaimer>()), pinnedNodeHoldersEpoch(0)
+{
+}
+
+JsonFile::~JsonFile()
 {
-    lineStarts.appendMarker(BaseMarker(TextCoordinate(0)));
+    for(PinnedNodes *lHolder: pinnedNodeHolders) {
+        lHolder->file = NULL;
+        lHolder->nodes.clear();
+    }
+    pinnedNodeHolders.clear();
+    pinnedNodeHoldersPin.release();
+    
+    // Readers may still pin nodes of the DOM; it's deleted once they let go, and they
+    // find it no longer live
+    retireDom();
 }
 
 
-void JsonFile::setText(const wstring &aText)
+void JsonFile::setText(const TextString &aText)
 {
-    JsonParseErrorCollectionListenerListener listener(errors);
+    // Don't send notifications till we're thru
+    DeferNotificationsInBlock lDnib(this);
     
-    lineStarts.clear();
-    lineStarts.appendMarker(BaseMarker(TextCoordinate(0)));
+    JsonParseErrorCollectionListenerListener listener(errors, maxParseErrors);
     
-    jsonText = make_shared<std::wstring>(aText);
+    jsonText = make_shared<TextString>(aText);
+    TextLength lTextLen = jsonText->length();
+    version++;
     
+    size_t lNumOldErrors = errors.size();
     errors.clear();
     
+    // Line index is collected by the input stream as it's being parsed
+    lineStarts.clear();
+    lineStarts.reserve(countLineBreaks(jsonText->c_str(), lTextLen));
+    
     stopwatch lStopWatch("Read Json");
     Node *lNode = NULL;
-    Reader::Read(lNode, aText, &listener);
+    InputStream lInputStream(jsonText->c_str(), lTextLen, TextCoordinate(0), &lineStarts);
+    TokenStream lTokenStream(lInputStream, &listener);
+    Reader lReader(&listener);
+    lReader.Parse(lNode, lTokenStream, false);
+    listener.finish();
     lStopWatch.stop();
     
+    // Parser stops at unexpected suffix; index the rest of the text
+    TextCoordinate lParseEnd = lInputStream.GetLocation();
+    if(lParseEnd < TextCoordinate(lTextLen)) {
+        appendLineBreaks(lineStarts, jsonText->c_str() + lParseEnd.getAddress(), lTextLen - lParseEnd, lParseEnd);
+    }
+    
+    surrogatePairs.clear();
+    appendSurrogatePairs(surrogatePairs, jsonText->c_str(), 0, lTextLen);
+    lexicalHighlighter.reset(lineStarts.size());
+    
+    retireDom();
     jsonDom.reset(new DocumentNode(this, lNode));
     jsonDom->textRange.start = TextCoordinate(0);
-    jsonDom->textRange.end = TextCoordinate(aText.length());
+    jsonDom->textRange.end = TextCoordinate(lTextLen);
+    rebuildSyntaxRuns();
     
-    TextCoordinate lineChangeStart;
-    TextLength lineChangeOldLen, lineChangeNewLen;
-    updateLineOffsetsAfterSplice((TextCoordinate)0, 0, aText.length(), aText.c_str(), &lineChangeStart, &lineChangeOldLen, &lineChangeNewLen);
-    
-    notify(ErrorsChangedNotification());
+    // The whole DOM was replaced; indexes are rebuilt when this is delivered
+    notify(NodeRefreshNotification(JsonPath()));
+    notify(ErrorsChangedNotification(MarkerListDelta(0, lNumOldErrors, errors.size(), 0, 0)));
+}
+
+shared_ptr<JsonFileSemanticModelReconciliationTask> JsonFile::setTextWithSpeculativeParse(const TextString &aText,
+                                                                                         TextLength aSpeculativeParseLength)
+{
+    // Don't send notifications till we're thru
+    DeferNotificationsInBlock lDnib(this);
+
+    pendingReconciliationTask.reset();
+    spliceJsonTextContent(TextCoordinate(0), jsonText->length(), aText);
+
+    // Parse up to the end of the line containing the end of the speculative region
+    TextLength lTextLen = jsonText->length();
+    TextLength lParseLen = aSpeculativeParseLength < lTextLen ? aSpeculativeParseLength : lTextLen;
+    while(lParseLen < lTextLen && (*jsonText)[lParseLen] != u'\n') {
+        lParseLen++;
+    }
+
+    bool lParsedEntireText = (lParseLen == lTextLen);
+
+    // Errors found in a partial parse are mostly artifacts of the truncation, so
+    // we only keep them if we got to parse the entire text.
+    MarkerList<ParseErrorMarker> lParseErrors;
+    JsonParseErrorCollectionListenerListener listener(lParseErrors, maxParseErrors);
+
+    stopwatch lStopWatch("Speculative read Json");
+    Node *lNode = NULL;
+    InputStream lInputStream(jsonText->c_str(), lParseLen);
+    TokenStream lTokenStream(lInputStream, &listener);
+    Reader lReader(&listener);
+    lReader.Parse(lNode, lTokenStream, false);
+    listener.finish();
+    lStopWatch.stop();
+
+    if(lNode && !lParsedEntireText) {
+        closeTruncatedNodes(lNode, TextCoordinate(lParseLen));
+    }
+
+    retireDom();
+    jsonDom.reset(new DocumentNode(this, lNode));
+    jsonDom->textRange.start = TextCoordinate(0);
+    jsonDom->textRange.end = TextCoordinate(lTextLen);
+    rebuildSyntaxRuns();
+    notify(NodeRefreshNotification(JsonPath()));
+
+    size_t lNumOldErrors = errors.size();
+    errors.clear();
+    if(lParsedEntireText) {
+        errors = std::move(lParseErrors);
+    } else {
+        pendingReconciliationTask = make_shared<JsonFileSemanticModelReconciliationTask>(jsonText, maxParseErrors);
+    }
+
+    notify(ErrorsChangedNotification(MarkerListDelta(0, lNumOldErrors, errors.size(), 0, 0)));
+
+    return pendingReconciliationTask;
+}
+
+void JsonFile::closeTruncatedNodes(Node *aNode, TextCoordinate aEnd)
+{
+    // Containers left open by truncating the parsed text are all on the
+    // last-child path from the root; end them where the parsed region ends.
+    while(aNode) {
+        if(aNode->textRange.end.infinite() || aNode->textRange.end > aEnd) {
+            aNode->textRange.end = aEnd;
+        }
+
+        ContainerNode *lContainer = dynamic_cast<ContainerNode*>(aNode);
+        if(!lContainer || !lContainer->getChildCount()) {
+            break;
+        }
+
+        aEnd = aEnd.relativeTo(aNode->textRange.start);
+        aNode = lContainer->getChildAt(lContainer->getChildCount()-1);
+    }
 }
 
-const wstring &JsonFile::getText() const
+const TextString &JsonFile::getText() const
 {
     return *jsonText;
 }
@@ -1261,7 +1661,7 @@ bool JsonFile::attemptReparseClosure(Node *spliceContainer,
                                      TextCoordinate aOffsetStart,
                                      TextLength aLen,
                                      TextLength maxParsedRegionLength,
-                                     const std::wstring &aNewText,
+                                     const TextString &aNewText,
                                      TextRange *outAbsReparseRange,
                                      Node **outParsedNode,
                                      MarkerList<ParseErrorMarker> *outReparseErrors) {
@@ -1287,17 +1687,25 @@ bool JsonFile::attemptReparseClosure(Node *spliceContainer,
     }
     
     // Construct updated JSON for node
-    std::wstring updatedJsonRegion = this->jsonText->substr(absReparseRange.start, absReparseRange.length());
+    TextString updatedJsonRegion = this->jsonText->substr(absReparseRange.start, absReparseRange.length());
     updatedJsonRegion.insert(aOffsetStart - absReparseRange.start, aNewText);
     updatedJsonRegion.erase(aOffsetStart - absReparseRange.start + aNewText.length(), aLen);
     
+    return reparseRegion(updatedJsonRegion, absReparseRange.start, outParsedNode, outReparseErrors);
+}
+
+bool JsonFile::reparseRegion(const TextString &aRegionText,
+                             TextCoordinate aRegionStart,
+                             Node **outParsedNode,
+                             MarkerList<ParseErrorMarker> *outReparseErrors) {
     // Re-parse updated JSON
     MarkerList<ParseErrorMarker> reparseErrors;
-    JsonParseErrorCollectionListenerListener listener(reparseErrors);
+    JsonParseErrorCollectionListenerListener listener(reparseErrors, maxParseErrors);
     
     stopwatch repraseStopWatch("Reparse Json");
     Node *reparsedNode = NULL;
-    Reader::Read(reparsedNode, updatedJsonRegion, &listener);
+    Reader::Read(reparsedNode, aRegionText, &listener);
+    listener.finish();
     repraseStopWatch.stop();
     
     if(!reparsedNode) {
@@ -1309,8 +1717,8 @@ bool JsonFile::attemptReparseClosure(Node *spliceContainer,
     // Return failure to parse if there are errors that indicate that the entire region
     // is incomplete or there's further content to process (which means that we need to parse
     // a bigger region than we expected, e.g because the change modifies node boundaries)
-    for_each(reparseErrors.begin(), reparseErrors.end(), [&predictedChangeRegionWrong, &absReparseRange](ParseErrorMarker &error) {
-        error.adjustCoordinate(absReparseRange.start.getAddress());
+    for_each(reparseErrors.begin(), reparseErrors.end(), [&predictedChangeRegionWrong, aRegionStart](ParseErrorMarker &error) {
+        error.adjustCoordinate(aRegionStart.getAddress());
        if(error.getErrorCode() == PARSER_ERROR_EXPECTED_EOS || error.getErrorCode() == PARSER_ERROR_UNEXPECTED_EOS) {
             predictedChangeRegionWrong = true;
         }
@@ -1333,10 +1741,10 @@ bool JsonFile::attemptReparseClosure(Node *spliceContainer,
 
 void JsonFile::minimizeChangedRegion(TextCoordinate aOffsetStart,
                                      TextLength aLen,
-                                     const std::wstring &aNewText,
+                                     const TextString &aNewText,
                                      TextCoordinate *outMinimizedStart,
                                      TextLength *outMinimizedLen,
-                                     std::wstring *outMinimizedUpdatedText
+                                     TextString *outMinimizedUpdatedText
                                      ) {
     // Adjust splice range to not include non-modified regions.
     // E.g on MacOS the text system my specific a longer range
@@ -1361,15 +1769,46 @@ void JsonFile::minimizeChangedRegion(TextCoordinate aOffsetStart,
     *outMinimizedUpdatedText = aNewText.substr(trimLeft, newTextLen-trimRight-trimLeft);
 }
 
+// Deepest node whose range contains [aOffsetStart, aOffsetStart+aLen]
+Node *JsonFile::findIntegralNode(TextCoordinate aOffsetStart, TextLength aLen, JsonPath *aOutPath)
+{
+    Node *lIntegralNode = jsonDom->getChildAt(0);
+    ContainerNode *lIntegralNodeAsContainerNode;
+    TextCoordinate lSoughtOffset = aOffsetStart;
+    
+    while( (lIntegralNodeAsContainerNode = dynamic_cast<ContainerNode*>(lIntegralNode)) != NULL )
+    {
+        lSoughtOffset = lSoughtOffset.relativeTo(lIntegralNode->getTextRange().start);
+        
+        stopwatch fcc("FindChildContaining ");
+        int lNextNav = lIntegralNodeAsContainerNode->findChildContaining(lSoughtOffset, false);
+        fcc.stop();
+        if(lNextNav<0)
+            break;
+        
+        
+        Node *lNextNavNode = lIntegralNodeAsContainerNode->getChildAt(lNextNav);
+        if(lNextNavNode->getTextRange().end < lSoughtOffset+aLen) {
+            break;
+        }
+        
+        lIntegralNode = lNextNavNode;
+        
+        aOutPath->push_back(lNextNav);
+    }
+    
+    return lIntegralNode;
+}
+
 bool JsonFile::fastSpliceTextWithWorkLimit(TextCoordinate aOffsetStart,
                                            TextLength aLen,
-                                           const std::wstring &aNewText,
+                                           const TextString &aNewText,
                                            int maxParsedRegionLength) {
     stopwatch spliceStopWatch("Fast spliceText");
     
     TextCoordinate trimmedStart;
     TextLength trimmedLen;
-    std::wstring trimmedUpdatedText;
+    TextString trimmedUpdatedText;
     minimizeChangedRegion(aOffsetStart, aLen, aNewText,
                           &trimmedStart, &trimmedLen, &trimmedUpdatedText);
     
@@ -1378,30 +1817,7 @@ bool JsonFile::fastSpliceTextWithWorkLimit(TextCoordinate aOffsetStart,
     
     // Locate integral node that contains the entire changed region
     JsonPath integralNodeJsonPath;
-    Node *spliceContainer = jsonDom->getChildAt(0);
-    ContainerNode *spliceContainerAsContainerNode;
-    TextCoordinate soughtOffset = trimmedStart;
-    
-    while( (spliceContainerAsContainerNode = dynamic_cast<ContainerNode*>(spliceContainer)) != NULL )
-    {
-        soughtOffset = soughtOffset.relativeTo(spliceContainer->getTextRange().start);
-        
-        stopwatch fcc("FindChildContaining ");
-        int lNextNav = spliceContainerAsContainerNode->findChildContaining(soughtOffset, false);
-        fcc.stop();
-        if(lNextNav<0)
-            break;
-        
-        
-        Node *nextNavNode = spliceContainerAsContainerNode->getChildAt(lNextNav);
-        if(nextNavNode->getTextRange().end < soughtOffset+trimmedLen) {
-            break;
-        }
-        
-        spliceContainer = nextNavNode;
-        
-        integralNodeJsonPath.push_back(lNextNav);
-    }
+    Node *spliceContainer = findIntegralNode(trimmedStart, trimmedLen, &integralNodeJsonPath);
     
     // Attempt reparsing growing containers until
     // succesful or over a threshold of attempts
@@ -1427,12 +1843,12 @@ bool JsonFile::fastSpliceTextWithWorkLimit(TextCoordinate aOffsetStart,
     TextCoordinate lLineChangeStart;
     TextLength lLineChangeLen, lLineChangeNewLen;
     
-    jsonText->insert(trimmedStart, trimmedUpdatedText);
-    jsonText->erase(trimmedStart.getAddress() + trimmedUpdatedTextLength, trimmedLen);
+    spliceTextBuffer(trimmedStart, trimmedLen, trimmedUpdatedText);
     updateTreeOffsetsAfterSplice(trimmedStart, trimmedLen, trimmedUpdatedTextLength);
     updateLineOffsetsAfterSplice(trimmedStart, trimmedLen, trimmedUpdatedTextLength,
                                  trimmedUpdatedText.c_str(), &lLineChangeStart,
                                  &lLineChangeLen, &lLineChangeNewLen);
+    updateSurrogatePairsAfterSplice(trimmedStart, trimmedLen, trimmedUpdatedTextLength);
     updateErrorsAfterSplice(absReparseRange.start, absReparseRange.length(), absReparseRange.length()+trimmedUpdatedTextLength-trimmedLen, &reparseErrors);
     
     ContainerNode *spliceContainerContainer = spliceContainer->getParent();
@@ -1445,18 +1861,23 @@ bool JsonFile::fastSpliceTextWithWorkLimit(TextCoordinate aOffsetStart,
     int spliceContainerIndexInParent = spliceContainer->getParent()->getIndexOfChild(spliceContainer);
     spliceContainerContainer->setChildAt(spliceContainerIndexInParent, reparsedNode, true);
     
+    SyntaxRunList reparsedRuns;
+    appendReparsedSyntaxRuns(reparsedNode, TextCoordinate(jsonText->length()), reparsedRuns);
+    syntaxRuns.spliceRuns(absReparseRange.start, absReparseRange.length(),
+                          absReparseRange.length()+trimmedUpdatedTextLength-trimmedLen, &reparsedRuns);
+    
     // Notify
     notify(NodeRefreshNotification(std::move(integralNodeJsonPath)));
-    notify(SpliceNotification(aOffsetStart, aLen, trimmedUpdatedTextLength, lLineChangeStart, lLineChangeLen, lLineChangeNewLen));
+    notify(SpliceNotification(trimmedStart, trimmedLen, trimmedUpdatedTextLength, lLineChangeStart, lLineChangeLen, lLineChangeNewLen));
     
     return true;
 }
 
-JsonFileSemanticModelReconciliationTask::JsonFileSemanticModelReconciliationTask(std::shared_ptr<std::wstring> text)
+JsonFileSemanticModelReconciliationTask::JsonFileSemanticModelReconciliationTask(std::shared_ptr<TextString> text, size_t aMaxErrors)
 :  newText(text),
 parsedNode(NULL),
-errorCollectionListener(new JsonParseErrorCollectionListenerListener(errors)),
-inputStream(new InputStream(text->c_str(), text->size(), errorCollectionListener.get())),
+errorCollectionListener(new JsonParseErrorCollectionListenerListener(errors, aMaxErrors)),
+inputStream(new InputStream(text->c_str(), text->size())),
 tokenStream(new TokenStream(*inputStream, errorCollectionListener.get())),
 cancelled(false)
 {
@@ -1480,6 +1901,7 @@ void JsonFileSemanticModelReconciliationTask::executeInBackground() {
         stopwatch lStopWatch("Read Json");
         Reader reader(errorCollectionListener.get());
         reader.Parse(parsedNode, *tokenStream, false);
+        static_cast<JsonParseErrorCollectionListenerListener*>(errorCollectionListener.get())->finish();
         lStopWatch.stop();
     } catch(...) {
         if(!cancelled) {
@@ -1495,20 +1917,12 @@ void JsonFileSemanticModelReconciliationTask::executeInBackground() {
 
 size_t JsonFile::spliceJsonTextContent(TextCoordinate aOffsetStart,
                                        TextLength aLen,
-                                       const std::wstring &aNewText) {
+                                       const TextString &aNewText) {
     stopwatch lSpliceTime("spliceJsonTextContent");
     
     size_t lNewLen = aNewText.length();
     
-    // Create new string if there's a pending reconciliation task since that
-    // may actually look at the current string.
-    if(pendingReconciliationTask) {
-        jsonText = make_shared<std::wstring>(jsonText->substr(0, aOffsetStart) + aNewText + jsonText->substr(aOffsetStart+aLen));
-    } else {
-        // Update text and line lengths
-        jsonText->insert(aOffsetStart, aNewText);
-        jsonText->erase(aOffsetStart+lNewLen, aLen);
-    }
+    spliceTextBuffer(aOffsetStart, aLen, aNewText);
     
     lSpliceTime.lap("Text update");
     
@@ -1516,6 +1930,7 @@ size_t JsonFile::spliceJsonTextContent(TextCoordinate aOffsetStart,
     TextLength lLineDelLen, lNumNewLines;
     updateLineOffsetsAfterSplice(aOffsetStart, aLen, lNewLen, aNewText.c_str(), &
                                  lLineDelStart, &lLineDelLen, &lNumNewLines);
+    updateSurrogatePairsAfterSplice(aOffsetStart, aLen, lNewLen);
     
     updateErrorsAfterSplice(aOffsetStart, aLen, lNewLen);
     
@@ -1528,70 +1943,662 @@ size_t JsonFile::spliceJsonTextContent(TextCoordinate aOffsetStart,
 
 shared_ptr<JsonFileSemanticModelReconciliationTask> JsonFile::spliceTextWithDirtySemanticModel(TextCoordinate aOffsetStart,
                                                                                                TextLength aLen,
-                                                                                               const std::wstring &aNewText) {
+                                                                                               const TextString &aNewText) {
     // Don't send notifications till we're thru
     DeferNotificationsInBlock lDnib(this);
     
     spliceJsonTextContent(aOffsetStart, aLen, aNewText);
+    syntaxRuns.invalidateRuns(aOffsetStart, aLen, aNewText.length());
     
-    pendingReconciliationTask = make_shared<JsonFileSemanticModelReconciliationTask>(jsonText);
+    pendingReconciliationTask = make_shared<JsonFileSemanticModelReconciliationTask>(jsonText, maxParseErrors);
     return pendingReconciliationTask;
 }
 
-void JsonFile::spliceJsonTextByDomChange(TextCoordinate aOffsetStart, TextLength aLen, const std::wstring &aNewText)
-{
+shared_ptr<JsonFileSemanticModelReconciliationTask> JsonFile::applyEdits(const std::vector<Splice> &aEdits,
+                                                                        int maxParsedRegionLength) {
+    stopwatch lStopWatch("applyEdits");
+    
+    if(aEdits.empty()) {
+        return shared_ptr<JsonFileSemanticModelReconciliationTask>();
+    }
+    
     // Don't send notifications till we're thru
     DeferNotificationsInBlock lDnib(this);
     
-    size_t lNewLen = spliceJsonTextContent(aOffsetStart, aLen, aNewText);
-    
-    // Update tree offsets
-    updateTreeOffsetsAfterSplice(aOffsetStart, aLen, lNewLen);
-}
-
-
-void JsonFile::applyReconciliationTask(shared_ptr<JsonFileSemanticModelReconciliationTask> task) {
-    if(pendingReconciliationTask == task) {
-        errors = task->errors;
-        
-        jsonDom.reset(new DocumentNode(this, task->parsedNode));
-        jsonDom->textRange.start = TextCoordinate(0);
-        jsonDom->textRange.end = TextCoordinate(jsonText->length());
+    EditCoordinateMapper lMapper(aEdits);
+    
+    // Build updated text in one pass
+    auto lNewText = make_shared<TextString>();
+    lNewText->reserve(jsonText->length() + lMapper.deltaBefore(aEdits.size()));
+    TextLength lCopied = 0;
+    for(const Splice &lEdit: aEdits) {
+        assert(lEdit.start >= TextCoordinate(lCopied));
+        lNewText->append(*jsonText, lCopied, lEdit.start - lCopied);
+        lNewText->append(lEdit.newText);
+        lCopied = lEdit.start + lEdit.len;
+    }
+    lNewText->append(*jsonText, lCopied, TextString::npos);
+    lStopWatch.lap("Text update");
+    
+    // Find the nodes enclosing the edits and reparse them from the updated text; grow
+    // regions that don't reparse cleanly the same way fastSplice does.
+    struct ReparseRegion {
+        Node *node;
+        JsonPath path;
+        TextRange oldAbsRange;
+        TextRange newAbsRange;
+        Node *parsedNode;
+        MarkerList<ParseErrorMarker> errors;
+    } ;
+    std::vector<ReparseRegion> lRegions;
+    
+    bool lReparsed = !pendingReconciliationTask && jsonDom->getChildAt(0);
+    for(size_t i=0; lReparsed && i<aEdits.size(); i++) {
+        ReparseRegion lRegion;
+        lRegion.node = findIntegralNode(aEdits[i].start, aEdits[i].len, &lRegion.path);
+        lRegion.parsedNode = NULL;
         
-        notify(ErrorsChangedNotification());
-        
-        pendingReconciliationTask.reset();
+        // Edits outside the root value (e.g past its end) can't be handled by a local reparse
+        TextRange lNodeRange = lRegion.node->getAbsTextRange();
+        if(lNodeRange.start > aEdits[i].start || lNodeRange.end < aEdits[i].start + aEdits[i].len) {
+            lReparsed = false;
+        }
+        lRegions.push_back(std::move(lRegion));
     }
-}
-
-
-void JsonFile::updateLineOffsetsAfterSplice(TextCoordinate aOffsetStart,
-                                            TextLength aLen,
-                                            TextLength aNewLen,
-                                            const wchar_t *aUpdatedText,
-                                            TextCoordinate *aOutLineDelStart,
-                                            TextLength *aOutLineDelLen,
-                                            TextLength *aOutNumNewLines)
-{
-    SimpleMarkerList newLines;
     
-    const wchar_t *updateEnd = aUpdatedText + aNewLen;
-    
-    for(const wchar_t *cur = aUpdatedText; cur != updateEnd; cur++) {
-        if(*cur == L'\n') {
-            newLines.appendMarker(aOffsetStart + (unsigned long)(cur - aUpdatedText) );
+    auto lDeleteParsedNodes = [&lRegions]() {
+        for(ReparseRegion &lRegion: lRegions) {
+            delete lRegion.parsedNode;
+            lRegion.parsedNode = NULL;
         }
-    }
+    };
     
-    int lLineDelStart, lLineDelLen;
-    if(lineStarts.spliceCoordinatesList(aOffsetStart, aLen, aNewLen,
-                                        &newLines, // TODO
-                                        &lLineDelStart,
-                                        &lLineDelLen))
-    {
-        *aOutLineDelStart = (TextCoordinate)lLineDelStart;
-        *aOutLineDelLen = (TextLength)lLineDelLen;
-        *aOutNumNewLines = (TextLength)newLines.size();
+    while(lReparsed) {
+        // Regions are nested or disjoint; keep the outermost ones
+        for(ReparseRegion &lRegion: lRegions) {
+            lRegion.oldAbsRange = lRegion.node->getAbsTextRange().intersectWith(jsonDom->textRange);
+        }
+        std::sort(lRegions.begin(), lRegions.end(), [](const ReparseRegion &aLeft, const ReparseRegion &aRight) {
+            return aLeft.oldAbsRange.start < aRight.oldAbsRange.start ||
+                   (aLeft.oldAbsRange.start == aRight.oldAbsRange.start && aLeft.oldAbsRange.end > aRight.oldAbsRange.end);
+        });
+        size_t lNumOuterRegions = 0;
+        for(size_t i=0; i<lRegions.size(); i++) {
+            if(lNumOuterRegions && lRegions[i].oldAbsRange.end <= lRegions[lNumOuterRegions-1].oldAbsRange.end) {
+                continue;
+            }
+            if(i != lNumOuterRegions) {
+                lRegions[lNumOuterRegions] = std::move(lRegions[i]);
+            }
+            lNumOuterRegions++;
+        }
+        lRegions.resize(lNumOuterRegions);
+        
+        bool lAllRegionsParsed = true;
+        for(ReparseRegion &lRegion: lRegions) {
+            if(lRegion.parsedNode) {
+                continue;
+            }
+            
+            // Same restrictions as attemptReparseClosure: errors past the end of file won't
+            // be found again by a local reparse.
+            lReparsed = lRegion.node != jsonDom.get() &&
+                        lRegion.oldAbsRange.length() <= (TextLength)maxParsedRegionLength &&
+                        !(lRegion.oldAbsRange.end == jsonDom->textRange.end &&
+                          errors.rbegin() != errors.rend() &&
+                          errors.rbegin()->getCoordinate() >= jsonDom->textRange.end);
+            if(!lReparsed) {
+                break;
+            }
+            
+            lRegion.newAbsRange = TextRange(lMapper.map(lRegion.oldAbsRange.start, true),
+                                            lMapper.map(lRegion.oldAbsRange.end, false));
+            if(!reparseRegion(lNewText->substr(lRegion.newAbsRange.start, lRegion.newAbsRange.length()),
+                              lRegion.newAbsRange.start, &lRegion.parsedNode, &lRegion.errors)) {
+                lRegion.parsedNode = NULL;
+                lRegion.errors.clear();
+                lRegion.node = lRegion.node->getParent();
+                if(lRegion.path.size()) {
+                    lRegion.path.pop_back();
+                }
+                lAllRegionsParsed = false;
+            }
+        }
+        
+        if(!lReparsed || lAllRegionsParsed) {
+            break;
+        }
+        
+        // Regions were grown; the ones they now contain are reparsed as part of them
+        lDeleteParsedNodes();
+    }
+    
+    if(!lReparsed) {
+        lDeleteParsedNodes();
+    }
+    lStopWatch.lap("Reparse");
+    
+    // Text splices for listeners, each in coordinates of the text with preceding edits
+    // applied; line changes are computed against the current line index.
+    long lLineDelta = 0;
+    for(size_t i=0; i<aEdits.size(); i++) {
+        const Splice &lEdit = aEdits[i];
+        long lLineDelStart = std::lower_bound(lineStarts.begin(), lineStarts.end(), lEdit.start) - lineStarts.begin();
+        long lLineDelEnd = std::lower_bound(lineStarts.begin(), lineStarts.end(), lEdit.start + lEdit.len) - lineStarts.begin();
+        TextLength lNumNewLines = countLineBreaks(lEdit.newText.c_str(), lEdit.newText.length());
+        
+        notify(SpliceNotification(TextCoordinate(lEdit.start.getAddress() + lMapper.deltaBefore(i)), lEdit.len, lEdit.newText.length(),
+                                  TextCoordinate(lLineDelStart + lLineDelta), lLineDelEnd - lLineDelStart, lNumNewLines));
+        lexicalHighlighter.spliceLines(lLineDelStart + lLineDelta, lLineDelEnd - lLineDelStart, lNumNewLines);
+        lLineDelta += (long)lNumNewLines - (lLineDelEnd - lLineDelStart);
+    }
+    
+    jsonText = std::move(lNewText);
+    version++;
+    
+    TextLength lTextLen = jsonText->length();
+    lineStarts.clear();
+    appendLineBreaks(lineStarts, jsonText->c_str(), lTextLen, TextCoordinate(0));
+    surrogatePairs.clear();
+    appendSurrogatePairs(surrogatePairs, jsonText->c_str(), 0, lTextLen);
+    lStopWatch.lap("Markers update");
+    
+    MarkerListDelta lErrorsDelta;
+    if(!lReparsed) {
+        if(errors.remapCoordinates([&lMapper](TextCoordinate aCoord) { return !lMapper.isInsideEdit(aCoord); },
+                                   [&lMapper](TextCoordinate aCoord) { return lMapper.map(aCoord, false); },
+                                   NULL, &lErrorsDelta)) {
+            notify(ErrorsChangedNotification(lErrorsDelta));
+        }
+        
+        syntaxRuns.remapRuns([&lMapper](const SyntaxRun &aRun) { return !lMapper.hasEditWithin(TextRange(aRun.getCoordinate(), aRun.getEnd())); },
+                             [&lMapper](TextCoordinate aCoord) { return lMapper.map(aCoord, false); });
+        
+        pendingReconciliationTask = make_shared<JsonFileSemanticModelReconciliationTask>(jsonText, maxParseErrors);
+        return pendingReconciliationTask;
+    }
+    
+    // Errors in reparsed regions are replaced by the ones found reparsing them. An error
+    // right at a region's start is reported by the enclosing container, so it's kept.
+    MarkerList<ParseErrorMarker> lRegionErrors;
+    for(ReparseRegion &lRegion: lRegions) {
+        for(const ParseErrorMarker &lError: lRegion.errors) {
+            lRegionErrors.addMarker(lError);
+        }
+    }
+    
+    auto lOutsideRegions = [&lRegions](TextCoordinate aCoord) {
+        auto lIter = std::partition_point(lRegions.begin(), lRegions.end(), [aCoord](const ReparseRegion &aRegion) {
+            return aRegion.oldAbsRange.end <= aCoord;
+        });
+        return lIter == lRegions.end() || lIter->oldAbsRange.start >= aCoord;
+    };
+    
+    if(errors.remapCoordinates(lOutsideRegions,
+                               [&lMapper](TextCoordinate aCoord) { return lMapper.map(aCoord, false); },
+                               &lRegionErrors, &lErrorsDelta)) {
+        notify(ErrorsChangedNotification(lErrorsDelta));
+    }
+    
+    // Shift nodes outside the regions in one walk, then swap in the reparsed nodes
+    std::set<const Node*> lReplacedNodes;
+    for(ReparseRegion &lRegion: lRegions) {
+        lReplacedNodes.insert(lRegion.node);
+        lMapper.addReparsedRange(lRegion.oldAbsRange);
+    }
+    
+    jsonDom->textRange.end = TextCoordinate(lTextLen);
+    updateTreeOffsetsAfterEdits(jsonDom.get(), TextCoordinate(0), TextCoordinate(0), lMapper, lReplacedNodes);
+    
+    SyntaxRunList lRegionRuns;
+    for(ReparseRegion &lRegion: lRegions) {
+        ContainerNode *lContainer = lRegion.node->getParent();
+        int lIndexInContainer = lRegion.path.empty() ? 0 : lRegion.path.back();
+        
+        // Update node addresses to be relative to parent
+        long lOffsetAdjust = (lRegion.newAbsRange.start - lContainer->getAbsTextRange().start);
+        lRegion.parsedNode->textRange.start += lOffsetAdjust;
+        lRegion.parsedNode->textRange.end += lOffsetAdjust;
+        
+        lContainer->setChildAt(lIndexInContainer, lRegion.parsedNode, true);
+        appendReparsedSyntaxRuns(lRegion.parsedNode, TextCoordinate(lTextLen), lRegionRuns);
+        lRegion.parsedNode = NULL;
+        
+        notify(NodeRefreshNotification(std::move(lRegion.path)));
+    }
+    
+    // Unlike errors, a run at a region's start belongs to the region
+    syntaxRuns.remapRuns([&lRegions](TextCoordinate aCoord) {
+                             auto lIter = std::partition_point(lRegions.begin(), lRegions.end(), [aCoord](const ReparseRegion &aRegion) {
+                                 return aRegion.oldAbsRange.end <= aCoord;
+                             });
+                             return lIter == lRegions.end() || lIter->oldAbsRange.start > aCoord;
+                         },
+                         [&lMapper](TextCoordinate aCoord) { return lMapper.map(aCoord, false); },
+                         &lRegionRuns);
+    
+    return shared_ptr<JsonFileSemanticModelReconciliationTask>();
+}
+
+void JsonFile::updateTreeOffsetsAfterEdits(ContainerNode *aContainer,
+                                           TextCoordinate aOldAbsStart,
+                                           TextCoordinate aNewAbsStart,
+                                           const EditCoordinateMapper &aMapper,
+                                           const std::set<const Node*> &aReplacedNodes)
+{
+    ObjectNode *lObject = dynamic_cast<ObjectNode*>(aContainer);
+    auto lMapRange = [&](TextRange &aRange, bool aMayOwnInsertions) {
+        // Containers left open at the end of the text have an infinite end, which stays so
+        if(aRange.end.infinite()) {
+            TextRange lOldAbsRange(aOldAbsStart + aRange.start.getAddress(), TextCoordinate::infinity);
+            aRange.start = TextCoordinate(aMapper.map(lOldAbsRange.start, false) - aNewAbsStart);
+            return lOldAbsRange;
+        }
+        
+        TextRange lOldAbsRange(aOldAbsStart + aRange.start.getAddress(), aOldAbsStart + aRange.end.getAddress());
+        TextRange lNewAbsRange = aMayOwnInsertions ? aMapper.mapKeptRange(lOldAbsRange) :
+                                 TextRange(aMapper.map(lOldAbsRange.start, false), aMapper.map(lOldAbsRange.end, true));
+        aRange.start = TextCoordinate(lNewAbsRange.start - aNewAbsStart);
+        aRange.end = TextCoordinate(lNewAbsRange.end - aNewAbsStart);
+        return lOldAbsRange;
+    };
+    
+    int lChildCount = aContainer->getChildCount();
+    for(int i=0; i<lChildCount; i++) {
+        if(lObject) {
+            // Member names are never reparsed on their own
+            lMapRange(lObject->members[i].nameRange, false);
+        }
+        
+        Node *lChild = aContainer->getChildAt(i);
+        if(!lChild) {
+            continue;
+        }
+        
+        TextRange lOldAbsRange = lMapRange(lChild->textRange, true);
+        
+        // Offsets within a child are relative to it, so only children with edits need a look
+        ContainerNode *lChildContainer = dynamic_cast<ContainerNode*>(lChild);
+        if(lChildContainer && !aReplacedNodes.count(lChild) && aMapper.hasEditWithin(lOldAbsRange)) {
+            updateTreeOffsetsAfterEdits(lChildContainer, lOldAbsRange.start,
+                                        aNewAbsStart + lChild->textRange.start.getAddress(),
+                                        aMapper, aReplacedNodes);
+        }
+    }
+    
+    aContainer->cachedLastRangeFoundChild.store(-1, std::memory_order_relaxed);
+}
+
+void JsonFile::spliceTextBuffer(TextCoordinate aOffsetStart, TextLength aLen, const TextString &aNewText)
+{
+    // Create new string if the current one is shared (a pending reconciliation task
+    // or a snapshot may actually look at it)
+    if(jsonText.use_count() > 1) {
+        auto lNewText = make_shared<TextString>();
+        lNewText->reserve(jsonText->length() + aNewText.length() - aLen);
+        lNewText->append(*jsonText, 0, aOffsetStart);
+        lNewText->append(aNewText);
+        lNewText->append(*jsonText, aOffsetStart + aLen, TextString::npos);
+        jsonText = std::move(lNewText);
+    } else {
+        jsonText->replace(aOffsetStart, aLen, aNewText);
+    }
+    
+    version++;
+}
+
+void JsonFile::retireNode(Node *aNode)
+{
+    if(!aNode) {
+        return;
+    }
+    
+    unindexNode(aNode);
+    
+    // Cut the subtree off so that isLive() fails for all of its nodes
+    aNode->parent = NULL;
+    if(DocumentNode *lDocument = dynamic_cast<DocumentNode*>(aNode)) {
+        lDocument->owner = NULL;
+    }
+    
+    reclaimer->retire(aNode);
+}
+
+void JsonFile::retireDom()
+{
+    // Indexes are rebuilt for the new DOM; don't bother unindexing the old one
+    if(memberNameIndex) {
+        memberNameIndex->clear();
+    }
+    if(pathSummary) {
+        pathSummary->clear();
+    }
+    
+    retireNode(jsonDom.release());
+}
+
+shared_ptr<const JsonFileSnapshot> JsonFile::getSnapshot()
+{
+    shared_ptr<const JsonFileSnapshot> lSnapshot = lastSnapshot.lock();
+    if(lSnapshot && lSnapshot->getVersion() == version) {
+        return lSnapshot;
+    }
+    
+    lSnapshot.reset(new JsonFileSnapshot(version, jsonText, pendingReconciliationTask != nullptr));
+    lastSnapshot = lSnapshot;
+    
+    return lSnapshot;
+}
+
+unique_ptr<DocumentNode> JsonFileSnapshot::parse() const
+{
+    stopwatch lStopWatch("Parse snapshot");
+    
+    // Errors are the file's to report; the reader gets what could be read, as the file does
+    MarkerList<ParseErrorMarker> lErrors;
+    JsonParseErrorCollectionListenerListener lListener(lErrors, DEFAULT_MAX_PARSE_ERRORS);
+    InputStream lInputStream(text->c_str(), text->length());
+    TokenStream lTokenStream(lInputStream, &lListener);
+    Reader lReader(&lListener);
+    Node *lNode = NULL;
+    lReader.Parse(lNode, lTokenStream, false);
+    
+    if(!lNode) {
+        return unique_ptr<DocumentNode>(new DocumentNode((JsonFile*)NULL, NULL));
+    }
+    return unique_ptr<DocumentNode>(new DocumentNode(lNode, TextCoordinate(0)));
+}
+
+void JsonFileSnapshot::getTokenSpans(TextCoordinate aStart, TextCoordinate aEnd, std::vector<LexicalSpan> &aOutSpans) const
+{
+    TextCoordinate lTextEnd(text->length());
+    JsonLexicalHighlighter::getTokenSpans(*text, std::min(aStart, lTextEnd), std::min(aEnd, lTextEnd), aOutSpans);
+}
+
+void JsonFile::spliceJsonTextByDomChange(TextCoordinate aOffsetStart, TextLength aLen, const TextString &aNewText)
+{
+    // Don't send notifications till we're thru
+    DeferNotificationsInBlock lDnib(this);
+    
+    size_t lNewLen = spliceJsonTextContent(aOffsetStart, aLen, aNewText);
+    
+    // Text generated from the DOM is valid JSON on its own, so lexing it gets the same runs
+    // the new nodes would
+    std::vector<LexicalSpan> lSpans;
+    JsonLexicalHighlighter::getTokenSpans(*jsonText, aOffsetStart, aOffsetStart + lNewLen, lSpans);
+    SyntaxRunList lNewRuns;
+    for(const LexicalSpan &lSpan: lSpans) {
+        if(lSpan.tokenClass != ltcPunctuation) {
+            lNewRuns.appendMarker(SyntaxRun(lSpan.start, lSpan.length, lSpan.tokenClass));
+        }
+    }
+    syntaxRuns.spliceRuns(aOffsetStart, aLen, lNewLen, &lNewRuns);
+    
+    // Update tree offsets
+    updateTreeOffsetsAfterSplice(aOffsetStart, aLen, lNewLen);
+}
+
+
+static bool isSameError(const ParseErrorMarker &aLeft, const ParseErrorMarker &aRight)
+{
+    return aLeft.getCoordinate() == aRight.getCoordinate() &&
+           aLeft.getErrorCode() == aRight.getErrorCode() &&
+           aLeft.getErrorMessage() == aRight.getErrorMessage() &&
+           aLeft.getErrorArg() == aRight.getErrorArg();
+}
+
+void JsonFile::applyReconciliationTask(shared_ptr<JsonFileSemanticModelReconciliationTask> task) {
+    if(pendingReconciliationTask == task) {
+        version++;
+        
+        // Don't send notifications till we're thru
+        DeferNotificationsInBlock lDnib(this);
+        
+        // Text is unchanged, so errors that were found again keep their place
+        MarkerListDelta lErrorsDelta;
+        if(errors.replaceMarkers(std::move(task->errors), isSameError, &lErrorsDelta)) {
+            notify(ErrorsChangedNotification(lErrorsDelta));
+        }
+        
+        // Keep nodes that weren't changed so that listeners only need to refresh
+        // what was actually reparsed differently
+        stopwatch lStopWatch("Merge reparsed DOM");
+        Node *lOldRoot = jsonDom->getChildAt(0);
+        JsonPath lPath;
+        Node *lMergedRoot = mergeReparsedNode(lOldRoot, task->parsedNode, lPath, true);
+        task->parsedNode = NULL;
+        if(lMergedRoot != lOldRoot) {
+            retireNode(jsonDom->storeChildAt(0, lMergedRoot));
+        }
+        lStopWatch.stop();
+        
+        jsonDom->textRange.start = TextCoordinate(0);
+        jsonDom->textRange.end = TextCoordinate(jsonText->length());
+        rebuildSyntaxRuns();
+        
+        pendingReconciliationTask.reset();
+    }
+}
+
+// Merges a reparsed node into the existing one it replaces. Nodes whose structure and value
+// didn't change keep their identity and get aNew's text ranges; aNew is consumed. Returns
+// the node that should be in aOld's place -- if that's not aOld, the caller retires aOld.
+// With aNotify set, each node that's replaced or whose children change is reported once
+// with a NodeRefreshNotification; changes below it aren't reported separately.
+Node *JsonFile::mergeReparsedNode(Node *aOld, Node *aNew, JsonPath &aPath, bool aNotify)
+{
+    if(!aOld || !aNew || aOld->getNodeTypeId() != aNew->getNodeTypeId()) {
+        if(aNotify) {
+            notify(NodeRefreshNotification(JsonPath(aPath)));
+        }
+        return aNew;
+    }
+    
+    if(ArrayNode *lOldArray = dynamic_cast<ArrayNode*>(aOld)) {
+        return mergeReparsedArray(lOldArray, static_cast<ArrayNode*>(aNew), aPath, aNotify);
+    }
+    
+    if(ObjectNode *lOldObject = dynamic_cast<ObjectNode*>(aOld)) {
+        return mergeReparsedObject(lOldObject, static_cast<ObjectNode*>(aNew), aPath, aNotify);
+    }
+    
+    if(!aOld->valueEquals(aNew)) {
+        if(aNotify) {
+            notify(NodeRefreshNotification(JsonPath(aPath)));
+        }
+        return aNew;
+    }
+    
+    aOld->textRange = aNew->textRange;
+    delete aNew;
+    
+    return aOld;
+}
+
+Node *JsonFile::mergeReparsedArray(ArrayNode *aOld, ArrayNode *aNew, JsonPath &aPath, bool aNotify)
+{
+    ArrayNode::Elements &lOldElements = aOld->elements;
+    ArrayNode::Elements &lNewElements = aNew->elements;
+    size_t lOldCount = lOldElements.size();
+    size_t lNewCount = lNewElements.size();
+    
+    if(lOldCount == lNewCount) {
+        // Same structure; merge element by element
+        for(size_t i=0; i<lNewCount; i++) {
+            Node *lOldElement = lOldElements[i].get();
+            aPath.push_back((int)i);
+            Node *lMerged = mergeReparsedNode(lOldElement, lNewElements[i].release(), aPath, aNotify);
+            aPath.pop_back();
+            if(lMerged != lOldElement) {
+                retireNode(aOld->storeChildAt((int)i, lMerged));
+                lMerged->parent = aOld;
+            }
+        }
+    } else {
+        // Elements were added or removed; match the unchanged prefix and suffix by position
+        // and adopt the rest. Listeners refresh the whole array.
+        auto lSameElements = [&](size_t aOldIdx, size_t aNewIdx) {
+            Node *lOldElement = lOldElements[aOldIdx].get();
+            Node *lNewElement = lNewElements[aNewIdx].get();
+            return lOldElement->getNodeTypeId() == lNewElement->getNodeTypeId() &&
+                   (dynamic_cast<ContainerNode*>(lOldElement) || lOldElement->valueEquals(lNewElement));
+        };
+        
+        size_t lPrefixLen = 0;
+        while(lPrefixLen < lOldCount && lPrefixLen < lNewCount && lSameElements(lPrefixLen, lPrefixLen)) {
+            lPrefixLen++;
+        }
+        
+        size_t lSuffixLen = 0;
+        while(lSuffixLen < lOldCount-lPrefixLen && lSuffixLen < lNewCount-lPrefixLen &&
+              lSameElements(lOldCount-lSuffixLen-1, lNewCount-lSuffixLen-1)) {
+            lSuffixLen++;
+        }
+        
+        ArrayNode::Elements lMergedElements;
+        for(size_t i=0; i<lNewCount; i++) {
+            Node *lNewElement = lNewElements[i].release();
+            size_t lOldIdx;
+            bool lMatched = true;
+            if(i < lPrefixLen) {
+                lOldIdx = i;
+            } else if(i >= lNewCount-lSuffixLen) {
+                lOldIdx = i - lNewCount + lOldCount;
+            } else {
+                lMatched = false;
+            }
+            
+            Node *lMerged = lNewElement;
+            if(lMatched) {
+                Node *lOldElement = lOldElements[lOldIdx].release();
+                lMerged = mergeReparsedNode(lOldElement, lNewElement, aPath, false);
+                if(lMerged != lOldElement) {
+                    retireNode(lOldElement);
+                }
+            }
+            
+            lMerged->parent = aOld;
+            lMergedElements.push_back(std::unique_ptr<Node>(lMerged));
+        }
+        
+        for(std::unique_ptr<Node> &lUnmatched: lOldElements) {
+            if(lUnmatched) {
+                retireNode(lUnmatched.release());
+            }
+        }
+        
+        lOldElements.swap(lMergedElements);
+        aOld->cachedLastRangeFoundChild.store(-1, std::memory_order_relaxed);
+        
+        if(aNotify) {
+            notify(NodeRefreshNotification(JsonPath(aPath)));
+        }
+    }
+    
+    aOld->textRange = aNew->textRange;
+    delete aNew;
+    
+    return aOld;
+}
+
+Node *JsonFile::mergeReparsedObject(ObjectNode *aOld, ObjectNode *aNew, JsonPath &aPath, bool aNotify)
+{
+    ObjectNode::Members &lOldMembers = aOld->members;
+    ObjectNode::Members &lNewMembers = aNew->members;
+    
+    bool lSameStructure = lOldMembers.size() == lNewMembers.size();
+    for(size_t i=0; lSameStructure && i<lNewMembers.size(); i++) {
+        lSameStructure = lOldMembers[i].name == lNewMembers[i].name;
+    }
+    
+    if(lSameStructure) {
+        // Same keys in the same order; merge member by member
+        for(size_t i=0; i<lNewMembers.size(); i++) {
+            Node *lOldMemberNode = lOldMembers[i].node.get();
+            lOldMembers[i].nameRange = lNewMembers[i].nameRange;
+            aPath.push_back((int)i);
+            Node *lMerged = mergeReparsedNode(lOldMemberNode, lNewMembers[i].node.release(), aPath, aNotify);
+            aPath.pop_back();
+            if(lMerged != lOldMemberNode) {
+                retireNode(aOld->storeChildAt((int)i, lMerged));
+                lMerged->parent = aOld;
+            }
+        }
+    } else {
+        // Members were added, removed or reordered; match them by key and adopt the rest.
+        // Listeners refresh the whole object.
+        std::map<wstring, std::deque<size_t>> lOldMembersByName;
+        for(size_t i=0; i<lOldMembers.size(); i++) {
+            lOldMembersByName[lOldMembers[i].name].push_back(i);
+        }
+        
+        ObjectNode::Members lMergedMembers;
+        for(ObjectNode::Member &lNewMember: lNewMembers) {
+            Node *lMerged = lNewMember.node.release();
+            
+            auto lOldMatch = lOldMembersByName.find(lNewMember.name);
+            if(lOldMatch != lOldMembersByName.end() && !lOldMatch->second.empty()) {
+                Node *lOldMemberNode = lOldMembers[lOldMatch->second.front()].node.release();
+                lOldMatch->second.pop_front();
+                
+                Node *lNewMemberNode = lMerged;
+                lMerged = mergeReparsedNode(lOldMemberNode, lNewMemberNode, aPath, false);
+                if(lMerged != lOldMemberNode) {
+                    retireNode(lOldMemberNode);
+                }
+            }
+            
+            lMerged->parent = aOld;
+            lMergedMembers.emplace_back(std::move(lNewMember.name), lMerged);
+            lMergedMembers.back().nameRange = lNewMember.nameRange;
+        }
+        
+        for(ObjectNode::Member &lUnmatched: lOldMembers) {
+            if(lUnmatched.node) {
+                retireNode(lUnmatched.node.release());
+            }
+        }
+        
+        lOldMembers.swap(lMergedMembers);
+        aOld->cachedLastRangeFoundChild.store(-1, std::memory_order_relaxed);
+        
+        if(aNotify) {
+            notify(NodeRefreshNotification(JsonPath(aPath)));
+        }
+    }
+    
+    aOld->textRange = aNew->textRange;
+    delete aNew;
+    
+    return aOld;
+}
+
+
+void JsonFile::updateLineOffsetsAfterSplice(TextCoordinate aOffsetStart,
+                                            TextLength aLen,
+                                            TextLength aNewLen,
+                                            const TextChar *aUpdatedText,
+                                            TextCoordinate *aOutLineDelStart,
+                                            TextLength *aOutLineDelLen,
+                                            TextLength *aOutNumNewLines)
+{
+    SimpleMarkerList newLines;
+    appendLineBreaks(newLines, aUpdatedText, aNewLen, aOffsetStart);
+    
+    // The delta is only filled in when line breaks change, but checkpoints past the edited
+    // line go stale either way
+    size_t lFirstBreak = std::lower_bound(lineStarts.begin(), lineStarts.end(), aOffsetStart) - lineStarts.begin();
+    size_t lNumBreaksRemoved = std::lower_bound(lineStarts.begin(), lineStarts.end(), aOffsetStart + aLen) - lineStarts.begin() - lFirstBreak;
+    lexicalHighlighter.spliceLines(lFirstBreak, lNumBreaksRemoved, newLines.size());
+    
+    MarkerListDelta lDelta;
+    if(lineStarts.spliceCoordinatesList(aOffsetStart, aLen, aNewLen,
+                                        &newLines, // TODO
+                                        &lDelta))
+    {
+        *aOutLineDelStart = (TextCoordinate)lDelta.index;
+        *aOutLineDelLen = (TextLength)lDelta.numRemoved;
+        *aOutNumNewLines = (TextLength)newLines.size();
     } else {
         *aOutLineDelStart = (TextCoordinate)0;
         *aOutLineDelLen = 0;
@@ -1599,18 +2606,52 @@ void JsonFile::updateLineOffsetsAfterSplice(TextCoordinate aOffsetStart,
     }
 }
 
+void JsonFile::updateSurrogatePairsAfterSplice(TextCoordinate aOffsetStart,
+                                               TextLength aLen,
+                                               TextLength aNewLen)
+{
+    // Also rescan the unit following the splice: a pair may have been formed or
+    // broken across the splice boundary.
+    TextLength lTextLen = jsonText->length();
+    TextLength lRescanEnd = aOffsetStart + aNewLen + (aOffsetStart + aNewLen < lTextLen ? 1 : 0);
+    TextLength lExtra = lRescanEnd - (aOffsetStart + aNewLen);
+    
+    SimpleMarkerList newPairs;
+    appendSurrogatePairs(newPairs, jsonText->c_str(), aOffsetStart, lRescanEnd);
+    surrogatePairs.spliceCoordinatesList(aOffsetStart, aLen + lExtra, aNewLen + lExtra, &newPairs);
+}
+
 void JsonFile::notifyUpdatedNode(Node *updatedNode) {
     // Notify that the semantic model was updated
-    JsonPath nodePath;
-    Node *lastSought = updatedNode;
-    ContainerNode *currentContainer = updatedNode->getParent();
+    notify(NodeRefreshNotification(getPathOfNode(updatedNode)));
+}
+
+JsonPath JsonFile::getPathOfNode(const Node *aNode) const
+{
+    JsonPath lPath;
+    const Node *lastSought = aNode;
+    const ContainerNode *currentContainer = aNode->getParent();
     while(currentContainer && currentContainer != jsonDom.get()) {
-        nodePath.push_front(currentContainer->getIndexOfChild(lastSought));
+        lPath.push_front(currentContainer->getIndexOfChild(lastSought));
         lastSought = currentContainer;
         currentContainer = lastSought -> getParent();
     }
     
-    notify(NodeRefreshNotification(std::move(nodePath)));
+    return lPath;
+}
+
+Node *JsonFile::findNodeAtPath(const JsonPath &aPath)
+{
+    Node *lNode = jsonDom->getChildAt(0);
+    for(int lIdx: aPath) {
+        ContainerNode *lContainer = dynamic_cast<ContainerNode*>(lNode);
+        if(!lContainer || lIdx < 0 || lIdx >= lContainer->getChildCount() || !lContainer->getChildAt(lIdx)) {
+            break;
+        }
+        lNode = lContainer->getChildAt(lIdx);
+    }
+    
+    return lNode;
 }
 
 void JsonFile::updateTreeOffsetsAfterSplice(TextCoordinate aOffsetStart, TextLength aLen, TextLength aNewLen)
@@ -1671,16 +2712,71 @@ void JsonFile::updateTreeOffsetsAfterSplice(TextCoordinate aOffsetStart, TextLen
 
 void JsonFile::updateErrorsAfterSplice(TextCoordinate aOffsetStart, TextLength aLen, TextLength aNewLen, MarkerList<ParseErrorMarker> *aNewMarkers)
 {
-    if(errors.spliceCoordinatesList(aOffsetStart, aLen, aNewLen, aNewMarkers))
+    MarkerListDelta lDelta;
+    if(errors.spliceCoordinatesList(aOffsetStart, aLen, aNewLen, aNewMarkers, &lDelta))
     {
-        notify(ErrorsChangedNotification());
+        notify(ErrorsChangedNotification(lDelta));
     }
 }
 
 
-void JsonFile::addListener(JsonFileChangeListener *aListener)
+void JsonFile::rebuildSyntaxRuns()
+{
+    SyntaxRunList lRuns;
+    if(const Node *lRoot = jsonDom->getChildAt(0)) {
+        appendSyntaxRuns(lRoot, TextCoordinate(0), TextCoordinate(jsonText->length()), lRuns);
+    }
+    
+    // Text is the same for the old runs and the new ones, so only the runs that were parsed
+    // differently are reported
+    MarkerListDelta lDelta;
+    if(syntaxRuns.setRuns(std::move(lRuns), &lDelta))
+    {
+        notify(SyntaxRunsChangedNotification(lDelta));
+    }
+}
+
+void JsonFile::setMemberNameIndexEnabled(bool aEnabled)
+{
+    if(aEnabled == (memberNameIndex != nullptr)) {
+        return;
+    }
+    
+    memberNameIndex.reset(aEnabled ? new MemberNameIndex() : NULL);
+    if(memberNameIndex) {
+        memberNameIndex->refreshSubtree(jsonDom.get());
+    }
+}
+
+void JsonFile::setPathSummaryEnabled(bool aEnabled)
+{
+    if(aEnabled == (pathSummary != nullptr)) {
+        return;
+    }
+    
+    pathSummary.reset(aEnabled ? new PathSummary() : NULL);
+    if(pathSummary) {
+        pathSummary->refreshSubtree(jsonDom.get());
+    }
+}
+
+void JsonFile::unindexNode(Node *aNode)
+{
+    if(memberNameIndex) {
+        memberNameIndex->removeSubtree(aNode);
+    }
+    if(pathSummary) {
+        pathSummary->removeSubtree(aNode);
+    }
+}
+
+void JsonFile::addListener(JsonFileChangeListener *aListener, bool aNotifyFirst)
 {
-    listeners.push_back(aListener);
+    if(aNotifyFirst) {
+        listeners.push_front(aListener);
+    } else {
+        listeners.push_back(aListener);
+    }
 }
 
 void JsonFile::removeListener(JsonFileChangeListener *aListener)
@@ -1702,38 +2798,308 @@ void JsonFile::endDeferNotifications()
 {
     if(!--notificationsDeferred)
     {
-        while(!deferredNotifications.empty())
-        {
-            Notification *lNotification = deferredNotifications.front();
-            deliverNotification(*lNotification);
-            delete lNotification;
-            deferredNotifications.pop_front();
-        }
+        deliverChanges();
     }
 }
 
-void JsonFile::deliverNotification(const Notification &aNotification)
+void JsonFile::deliverChanges()
 {
-    stopwatch lStopWatch("deliverNotification");
+    // Listeners and whoever they tell find held nodes that left the DOM already dropped
+    revalidatePinnedNodes();
+    
+    if(pendingChanges.empty())
+    {
+        return;
+    }
+    
+    // Listeners may change the file again; those changes go to a new change set
+    JsonFileChangeSet lChanges;
+    std::swap(lChanges, pendingChanges);
+    
+    // Nodes that left the DOM were unindexed as they went; index the ones that replaced them
+    // before listeners get to query the indexes. Paths are resolved as far as they go in the
+    // final DOM.
+    if(memberNameIndex || pathSummary) {
+        for(const JsonPath &lPath: lChanges.refreshedNodes) {
+            Node *lNode = findNodeAtPath(lPath);
+            if(lNode && memberNameIndex) {
+                memberNameIndex->refreshSubtree(lNode);
+            }
+            if(lNode && pathSummary) {
+                pathSummary->refreshSubtree(lNode);
+            }
+        }
+    }
     
     // Update listeners
     for(Listeners::iterator lIter = listeners.begin(); lIter!=listeners.end(); lIter++)
     {
-        aNotification.deliverToListener(this, *lIter);
+        (*lIter)->notifyChangeSet(this, lChanges);
+    }
+}
+
+void JsonFile::addPinnedNodeHolder(PinnedNodes *aHolder)
+{
+    if(pinnedNodeHolders.empty()) {
+        pinnedNodeHoldersPin = reclaimer->pin();
+        pinnedNodeHoldersEpoch = reclaimer->getEpoch();
     }
+    pinnedNodeHolders.insert(aHolder);
+}
+
+void JsonFile::removePinnedNodeHolder(PinnedNodes *aHolder)
+{
+    pinnedNodeHolders.erase(aHolder);
+    if(pinnedNodeHolders.empty()) {
+        pinnedNodeHoldersPin.release();
+    }
+}
+
+void JsonFile::revalidatePinnedNodes()
+{
+    // Held nodes only die by being retired
+    if(pinnedNodeHolders.empty() || reclaimer->getEpoch() == pinnedNodeHoldersEpoch) {
+        return;
+    }
+    
+    // The new pin covers what's live now; the old one is released once no holder has a node
+    // it was needed for
+    NodeReclaimer::Pin lPin = reclaimer->pin();
+    pinnedNodeHoldersEpoch = reclaimer->getEpoch();
+    for(PinnedNodes *lHolder: pinnedNodeHolders) {
+        lHolder->dropDeadNodes();
+    }
+    pinnedNodeHoldersPin = std::move(lPin);
 }
 
 void JsonFile::notify(const Notification &aNotification)
 {
-    if(notificationsDeferred)
+    aNotification.addToChangeSet(pendingChanges);
+    if(!notificationsDeferred)
+    {
+        deliverChanges();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PinnedNodes::assign(JsonFile *aFile, std::vector<Node*> aNodes)
+{
+    if(aFile != file) {
+        clear();
+        file = aFile;
+        if(file) {
+            file->addPinnedNodeHolder(this);
+        }
+    }
+    
+    nodes = std::move(aNodes);
+    if(!file) {
+        nodes.clear();
+    }
+}
+
+void PinnedNodes::assign(Node *aNode)
+{
+    if(aNode && aNode->isLive()) {
+        assign(aNode->getDocument()->getOwner(), std::vector<Node*>(1, aNode));
+    } else {
+        clear();
+    }
+}
+
+void PinnedNodes::clear()
+{
+    nodes.clear();
+    if(file) {
+        file->removePinnedNodeHolder(this);
+        file = NULL;
+    }
+}
+
+Node *PinnedNodes::at(size_t aIdx) const
+{
+    // Nodes retired since the last revalidation are still pinned, so it's safe to look
+    Node *lNode = nodes[aIdx];
+    return lNode && lNode->isLive() ? lNode : NULL;
+}
+
+void PinnedNodes::dropDeadNodes()
+{
+    for(Node *&lNode: nodes) {
+        if(lNode && !lNode->isLive()) {
+            lNode = NULL;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JsonFileChangeListener::notifyChangeSet(JsonFile *aSender, const JsonFileChangeSet &aChangeSet)
+{
+    for(const JsonFileChangeSet::TextSplice &lSplice: aChangeSet.splices)
+    {
+        notifyTextSpliced(aSender, lSplice.offsetStart, lSplice.len, lSplice.newLen,
+                          lSplice.lineOffsetStart, lSplice.lineLen, lSplice.lineNewLen);
+    }
+    
+    for(const JsonPath &lPath: aChangeSet.refreshedNodes)
+    {
+        notifyNodeChanged(aSender, lPath);
+    }
+    
+    if(aChangeSet.errorsChanged)
+    {
+        notifyErrorsChanged(aSender, aChangeSet.errorsDelta);
+    }
+    
+    if(aChangeSet.syntaxRunsChanged)
+    {
+        notifySyntaxRunsChanged(aSender, aChangeSet.syntaxRunsDelta);
+    }
+}
+
+void JsonFileChangeSet::addSplice(const TextSplice &aSplice)
+{
+    if(!aSplice.len && !aSplice.newLen)
+    {
+        return;
+    }
+    
+    // Splices already here are in final text coordinates, as is aSplice. Find the ones
+    // aSplice overlaps or touches.
+    TextCoordinate lSpliceEnd = aSplice.offsetStart + aSplice.len;
+    size_t lFirst = 0;
+    while(lFirst < splices.size() && splices[lFirst].offsetStart + splices[lFirst].newLen < aSplice.offsetStart)
+    {
+        lFirst++;
+    }
+    
+    size_t lLast = lFirst;
+    while(lLast < splices.size() && splices[lLast].offsetStart <= lSpliceEnd)
+    {
+        lLast++;
+    }
+    
+    long lDelta = (long)aSplice.newLen - (long)aSplice.len;
+    long lLineDelta = (long)aSplice.lineNewLen - (long)aSplice.lineLen;
+    
+    TextSplice lMerged = aSplice;
+    if(lLast > lFirst)
+    {
+        // Merge into one splice spanning all of them; in final coordinates it covers
+        // [start, end) before aSplice is applied.
+        auto lLineNoop = [](const TextSplice &aOther) { return !aOther.lineLen && !aOther.lineNewLen; };
+        
+        TextCoordinate lStart = std::min(aSplice.offsetStart, splices[lFirst].offsetStart);
+        TextCoordinate lEnd = std::max(lSpliceEnd, splices[lLast-1].offsetStart + splices[lLast-1].newLen);
+        long lMergedDelta = 0;
+        
+        bool lHasLines = !lLineNoop(aSplice);
+        TextCoordinate lLineStart = aSplice.lineOffsetStart;
+        TextCoordinate lLineEnd = aSplice.lineOffsetStart + aSplice.lineLen;
+        long lMergedLineDelta = 0;
+        
+        for(size_t i=lFirst; i<lLast; i++)
+        {
+            const TextSplice &lOther = splices[i];
+            lMergedDelta += (long)lOther.newLen - (long)lOther.len;
+            if(lLineNoop(lOther))
+            {
+                continue;
+            }
+            
+            lMergedLineDelta += (long)lOther.lineNewLen - (long)lOther.lineLen;
+            if(!lHasLines)
+            {
+                lLineStart = lOther.lineOffsetStart;
+                lLineEnd = lOther.lineOffsetStart + lOther.lineNewLen;
+                lHasLines = true;
+            } else
+            {
+                lLineStart = std::min(lLineStart, lOther.lineOffsetStart);
+                lLineEnd = std::max(lLineEnd, lOther.lineOffsetStart + lOther.lineNewLen);
+            }
+        }
+        
+        lMerged.offsetStart = lStart;
+        lMerged.len = (lEnd - lStart) - lMergedDelta;
+        lMerged.newLen = (lEnd - lStart) + lDelta;
+        
+        if(lHasLines)
+        {
+            lMerged.lineOffsetStart = lLineStart;
+            lMerged.lineLen = (lLineEnd - lLineStart) - lMergedLineDelta;
+            lMerged.lineNewLen = (lLineEnd - lLineStart) + lLineDelta;
+        }
+        
+        splices.erase(splices.begin() + lFirst, splices.begin() + lLast);
+    }
+    
+    splices.insert(splices.begin() + lFirst, lMerged);
+    
+    // Later splices move with the text
+    for(size_t i=lFirst+1; i<splices.size(); i++)
+    {
+        splices[i].offsetStart += lDelta;
+        splices[i].lineOffsetStart += lLineDelta;
+    }
+}
+
+void JsonFileChangeSet::addErrorsDelta(const MarkerListDelta &aDelta)
+{
+    if(errorsChanged)
+    {
+        errorsDelta.append(aDelta);
+    } else
+    {
+        errorsDelta = aDelta;
+        errorsChanged = true;
+    }
+}
+
+void JsonFileChangeSet::addSyntaxRunsDelta(const MarkerListDelta &aDelta)
+{
+    if(syntaxRunsChanged)
     {
-        deferredNotifications.push_back(aNotification.clone());
+        syntaxRunsDelta.append(aDelta);
     } else
     {
-        deliverNotification(aNotification);
+        syntaxRunsDelta = aDelta;
+        syntaxRunsChanged = true;
     }
 }
 
+void JsonFileChangeSet::addRefreshedNode(const JsonPath &aPath)
+{
+    auto lIsPrefix = [](const JsonPath &aPrefix, const JsonPath &aOf) {
+        return aPrefix.size() <= aOf.size() && std::equal(aPrefix.begin(), aPrefix.end(), aOf.begin());
+    };
+    
+    for(const JsonPath &lPath: refreshedNodes)
+    {
+        if(lIsPrefix(lPath, aPath))
+        {
+            return;
+        }
+    }
+    
+    refreshedNodes.erase(std::remove_if(refreshedNodes.begin(), refreshedNodes.end(),
+                                        [&](const JsonPath &lPath) { return lIsPrefix(aPath, lPath); }),
+                         refreshedNodes.end());
+    refreshedNodes.push_back(aPath);
+}
+
+void JsonFileChangeSet::clear()
+{
+    splices.clear();
+    refreshedNodes.clear();
+    errorsChanged = false;
+    errorsDelta = MarkerListDelta();
+    syntaxRunsChanged = false;
+    syntaxRunsDelta = MarkerListDelta();
+}
+
 wstring jsonizeString(const wstring &aSrc)
 {
     StringNode lNode(aSrc);
@@ -1779,6 +3145,38 @@ void JsonFile::getCoordinateRowCol(TextCoordinate aCoord, int &aRow, int &aCol)
     }
 }
 
+unsigned long JsonFile::getCharacterOffset(TextCoordinate aCoord) const
+{
+    SimpleMarkerList::const_iterator iter = lower_bound(surrogatePairs.begin(), surrogatePairs.end(), aCoord);
+    
+    return aCoord.getAddress() - (iter - surrogatePairs.begin());
+}
+
+TextCoordinate JsonFile::getCoordinateForCharacterOffset(unsigned long aCharOffset) const
+{
+    // The i'th pair's trailing unit is preceded by (offset - i) characters, which is strictly
+    // increasing in i; count the pairs that start before aCharOffset ends.
+    int lLow = 0, lHigh = (int)surrogatePairs.size();
+    while(lLow < lHigh) {
+        int lMid = (lLow + lHigh) / 2;
+        if(surrogatePairs[lMid].getCoordinate().getAddress() - lMid <= aCharOffset) {
+            lLow = lMid + 1;
+        } else {
+            lHigh = lMid;
+        }
+    }
+    
+    return TextCoordinate(aCharOffset + lLow);
+}
+
+void JsonFile::getCoordinateRowCharacterCol(TextCoordinate aCoord, int &aRow, int &aCol) const
+{
+    getCoordinateRowCol(aCoord, aRow, aCol);
+    
+    TextCoordinate lLineStart = aCoord - (TextLength)(aCol - 1);
+    aCol = (int)(getCharacterOffset(aCoord) - getCharacterOffset(lLineStart) + 1);
+}
+
 TextCoordinate JsonFile::getLineStart(unsigned long aRow) const {
     if(aRow <= 1) {
         return TextCoordinate(0);
@@ -15,10 +15,18 @@
 #include <string>
 #include <deque>
 #include <vector>
+#include <set>
+#include <unordered_set>
+#include <atomic>
 #include <stdexcept>
 #include "assert.h"
 #include "Exception.hpp"
 #include "marker_list.h"
+#include "TextEncoding.hpp"
+#include "NodeReclaimer.hpp"
+#include "JsonLexicalHighlighter.hpp"
+#include "SyntaxRunMap.hpp"
+#include "MemberNameIndex.hpp"
 
 namespace json
 {
@@ -29,6 +37,7 @@ class NodeVisitor;
 class ContainerNode;
 class DocumentNode;
 class JsonFile;
+class PathSummary;
 class InputStream;
 class TokenStream;
 class ParseListener;
@@ -74,6 +83,17 @@ struct TextRange
     TextCoordinate end; // One past last charcter in range
 };
 
+// Replacement of len characters at start with newText
+struct Splice
+{
+    Splice(TextCoordinate aStart, TextLength aLen, TextString aNewText) :
+    start(aStart), len(aLen), newText(std::move(aNewText)) {}
+    
+    TextCoordinate start;
+    TextLength len;
+    TextString newText;
+};
+
 typedef std::list<int> JsonPath;
 
 enum NodeTypeId {
@@ -96,10 +116,14 @@ public:
     
     DocumentNode *getDocument() const;
     
+    // False once the node was replaced or removed from its file's DOM, or the file was
+    // deleted. Pinned readers use this to revalidate the nodes they hold.
+    bool isLive() const;
+    
     const TextRange &getTextRange() const;
     TextRange getAbsTextRange() const;
     
-    wstring getDocumentText() const;
+    TextString getDocumentText() const;
     
     virtual void accept(NodeVisitor *aVisitor) const = 0;
     virtual void accept(NodeVisitor *aVisitor) = 0;
@@ -158,12 +182,15 @@ public:
     
 protected:
     virtual void adjustChildRangeAt(int aIdx, long aDiff);
-    virtual void storeChildAt(int aIdx, Node *aNode) = 0;
+    // Returns the replaced child, now owned by the caller
+    virtual Node *storeChildAt(int aIdx, Node *aNode) = 0;
     
     friend class JsonFile;
     
 private:
-    mutable int cachedLastRangeFoundChild;
+    // Written by lookups, which may run concurrently (e.g parallel JSONPath filters), so
+    // it's atomic; a lookup reads it once and falls back to searching if it's stale
+    mutable std::atomic<int> cachedLastRangeFoundChild;
     
 } ;
 
@@ -190,7 +217,7 @@ public:
     int findChildEndingAfter(const TextCoordinate &aDocOffset) const;
     
     void InsertMemberAt(int aIdx, Node *aElement,
-                        const wstring *aElementText);
+                        const TextString *aElementText);
     
     void accept(NodeVisitor *aVisitor) const;
     void accept(NodeVisitor *aVisitor);
@@ -212,10 +239,12 @@ public:
     virtual ObjectNode *createDebugRepresentation() const;
     
 protected:
-    virtual void storeChildAt(int aIdx, Node *aNode);
+    virtual Node *storeChildAt(int aIdx, Node *aNode);
     
 private:
     Elements elements;
+    
+    friend class JsonFile;
 };
 
 class ObjectNode : public ContainerNode
@@ -252,7 +281,7 @@ public:
     
     void detachChildAt(int aIdx, Node **aNode);
     ObjectNode::Member &insertMemberAt(int aIdx, const wstring &aName,
-                                       Node *aElement, const wstring *aElementText);
+                                       Node *aElement, const TextString *aElementText);
     void renameMemberAt(int aIdx, const wstring &aName);
     
     int findChildEndingAfter(const TextCoordinate &aDocOffset) const;
@@ -283,17 +312,20 @@ public:
     virtual ObjectNode *createDebugRepresentation() const;
 protected:
     void adjustChildRangeAt(int aIdx, long aDiff);
-    virtual void storeChildAt(int aIdx, Node *aNode);
+    virtual Node *storeChildAt(int aIdx, Node *aNode);
     
 private:
     Members members;
     
+    friend class JsonFile;
 } ;
 
 class DocumentNode : public ContainerNode
 {
 public:
     DocumentNode(JsonFile *aOwner, Node *aChild);
+    // Holds a subtree read out of the middle of a text, at aStart of it
+    DocumentNode(Node *aChild, TextCoordinate aStart);
     
     virtual void accept(NodeVisitor *aVisitor) const;
     virtual void accept(NodeVisitor *aVisitor);
@@ -309,6 +341,9 @@ public:
     
     int findChildEndingAfter(const TextCoordinate &aDocOffset) const;
     
+    // Node whose text is exactly aRange, in document coordinates; NULL if there's none
+    Node *findNodeWithRange(const TextRange &aRange);
+    
     JsonFile *getOwner() const { return owner; }
     
     virtual Node *clone() const { return new DocumentNode(owner, rootNode->clone()); }
@@ -322,11 +357,13 @@ public:
     virtual ObjectNode *createDebugRepresentation() const;
     
 protected:
-    virtual void storeChildAt(int aIdx, Node *aNode);
+    virtual Node *storeChildAt(int aIdx, Node *aNode);
     
 private:
     std::unique_ptr<Node> rootNode;
     JsonFile *owner;
+    
+    friend class JsonFile;
 } ;
 
 class LeafNode : public Node
@@ -445,14 +482,61 @@ typedef ValueNode<std::wstring> StringNode;
 typedef ValueNode<double> NumberNode;
 typedef ValueNode<bool> BooleanNode;
 
+// Changes made to a JsonFile while notifications are deferred, coalesced so that listeners
+// do their work once per batch.
+struct JsonFileChangeSet
+{
+    struct TextSplice
+    {
+        TextCoordinate offsetStart;
+        TextLength len;
+        TextLength newLen;
+        
+        TextCoordinate lineOffsetStart;
+        TextLength lineLen;
+        TextLength lineNewLen;
+    };
+    
+    JsonFileChangeSet() : errorsChanged(false), syntaxRunsChanged(false) {}
+    
+    // Overlapping and adjacent splices are merged into one
+    void addSplice(const TextSplice &aSplice);
+    // Paths below a refreshed node are dropped
+    void addRefreshedNode(const JsonPath &aPath);
+    // Successive error list changes are composed into one delta
+    void addErrorsDelta(const MarkerListDelta &aDelta);
+    // Same for the syntax run map
+    void addSyntaxRunsDelta(const MarkerListDelta &aDelta);
+    
+    bool empty() const { return splices.empty() && refreshedNodes.empty() && !errorsChanged && !syntaxRunsChanged; }
+    void clear();
+    
+    // Sorted and disjoint; each splice is in coordinates of the text after the ones before it
+    // were applied, so the final text at offsetStart holds the splice's new text.
+    std::vector<TextSplice> splices;
+    std::vector<JsonPath> refreshedNodes;
+    bool errorsChanged;
+    // Turns the error list as of the start of the batch into the current one
+    MarkerListDelta errorsDelta;
+    // Runs rebuilt by a reparse (see SyntaxRunMap::getChangedRange); runs moved by
+    // splices are reported with the splices
+    bool syntaxRunsChanged;
+    MarkerListDelta syntaxRunsDelta;
+};
+
 struct JsonFileChangeListener
 {
     virtual void notifyTextSpliced(JsonFile *aSender, TextCoordinate aOldOffset,
                                    TextLength aOldLength, TextLength aNewLength,
                                    TextCoordinate aOldLineStart, TextLength aOldLineLength,
                                    TextLength aNewLineLength) = 0;
-    virtual void notifyErrorsChanged(JsonFile *aSender) {}
+    virtual void notifyErrorsChanged(JsonFile *aSender, const MarkerListDelta &aDelta) {}
     virtual void notifyNodeChanged(JsonFile *aSender, const JsonPath &nodePath) {}
+    virtual void notifySyntaxRunsChanged(JsonFile *aSender, const MarkerListDelta &aDelta) {}
+    
+    // Called once per batch of changes; default delivers splices, then refreshed nodes,
+    // then errors and syntax runs through the methods above.
+    virtual void notifyChangeSet(JsonFile *aSender, const JsonFileChangeSet &aChangeSet);
 };
 
 
@@ -463,21 +547,30 @@ public:
     virtual bool visitNode(const Node *aNode) = 0;
 } ;
 
+// Errors are kept compact -- a message id (ParseErrorMessage) and an argument, typically the
+// length of the offending token starting at the error coordinate -- and only formatted on display.
 class ParseErrorMarker : public BaseMarker
 {
 public:
-    ParseErrorMarker(TextCoordinate aErrorCoord, int aErrorCode, const std::string &aErrorText) :
-    BaseMarker(aErrorCoord), errorCode(aErrorCode), errorText(aErrorText)
+    ParseErrorMarker(TextCoordinate aErrorCoord, int aErrorCode, int aErrorMessage, unsigned int aErrorArg = 0) :
+    BaseMarker(aErrorCoord), errorCode(aErrorCode), errorMessage(aErrorMessage), errorArg(aErrorArg)
     {}
     
-    const std::string &getErrorText() const { return errorText; }
+    // If aText (the text the error was found in) is specified, the message quotes the offending token
+    std::string getErrorText(const TextString *aText = NULL) const;
     int getErrorCode() const  { return errorCode; }
+    int getErrorMessage() const { return errorMessage; }
+    unsigned int getErrorArg() const { return errorArg; }
     
 private:
-    std::string errorText;
-    int errorCode;
+    unsigned short errorCode;
+    unsigned short errorMessage;
+    unsigned int errorArg;
 } ;
 
+// Errors found in a single parse beyond this many are summarized by one marker
+#define DEFAULT_MAX_PARSE_ERRORS 1000
+
 namespace priv
 {
 class Notification
@@ -485,22 +578,22 @@ class Notification
 public:
     virtual ~Notification() {};
     
-    virtual void deliverToListener(JsonFile *aSender, JsonFileChangeListener *aListener) const = 0;
-    virtual Notification *clone() const = 0;
+    virtual void addToChangeSet(JsonFileChangeSet &aChangeSet) const = 0;
 } ;
 
 class DeferNotificationsInBlock;
+class EditCoordinateMapper;
 }
 
 class JsonFileSemanticModelReconciliationTask {
 public:
-    JsonFileSemanticModelReconciliationTask(std::shared_ptr<std::wstring> text);
+    JsonFileSemanticModelReconciliationTask(std::shared_ptr<TextString> text, size_t aMaxErrors = DEFAULT_MAX_PARSE_ERRORS);
     
     void executeInBackground();
     void cancelExecution();
     
 private:
-    shared_ptr<std::wstring> newText;
+    shared_ptr<TextString> newText;
     MarkerList<ParseErrorMarker> errors;
     Node *parsedNode;
     
@@ -513,13 +606,91 @@ private:
     friend class JsonFile;
 };
 
+// Nodes of a file's DOM held on to across its changes, e.g by UI caches. They're pinned (see
+// NodeReclaimer) only up to the file's next change set: before it's delivered, nodes that are
+// no longer live are dropped and the file moves one pin shared by all holders on, so what it
+// replaced is deleted even if a holder is never looked at again. Used on the thread that
+// changes the file.
+class PinnedNodes
+{
+public:
+    PinnedNodes() : file(NULL) {}
+    ~PinnedNodes() { clear(); }
+    
+    PinnedNodes(const PinnedNodes&) = delete;
+    PinnedNodes &operator=(const PinnedNodes&) = delete;
+    
+    // aNodes must be live nodes of aFile
+    void assign(JsonFile *aFile, std::vector<Node*> aNodes);
+    // A single node, or none if aNode is NULL or no longer live
+    void assign(Node *aNode);
+    void clear();
+    
+    bool empty() const { return nodes.empty(); }
+    size_t size() const { return nodes.size(); }
+    
+    // NULL once the node is no longer live
+    Node *at(size_t aIdx) const;
+    Node *get() const { return nodes.empty() ? NULL : at(0); }
+    
+private:
+    friend class JsonFile;
+    
+    void dropDeadNodes();
+    
+    JsonFile *file;
+    std::vector<Node*> nodes;
+};
+
+// Immutable view of a JsonFile's text as of a given version; it can be read from any
+// thread while the file keeps changing. The DOM isn't part of it: background readers parse
+// or stream what they need out of the text (e.g with JsonPathStreamingEvaluator).
+class JsonFileSnapshot
+{
+public:
+    unsigned long getVersion() const { return version; }
+    const TextString &getText() const { return *text; }
+    
+    // DOM was not yet reconciled with the text when the snapshot was taken
+    bool isSemanticModelDirty() const { return semanticModelDirty; }
+    
+    // Text wasn't edited between the two snapshots, though the DOM may have been reconciled
+    bool hasSameText(const JsonFileSnapshot &aOther) const { return text == aOther.text; }
+    
+    // A DOM of the reader's own, parsed from the text; a full parse, so it's for work too slow
+    // for the thread editing the file. Its nodes aren't live, but they have the same ranges as
+    // the file's once the file's DOM is reconciled with this text (see findNodeWithRange).
+    std::unique_ptr<DocumentNode> parse() const;
+    
+    // Token spans for [aStart, aEnd), where aStart is outside of any string
+    void getTokenSpans(TextCoordinate aStart, TextCoordinate aEnd, std::vector<LexicalSpan> &aOutSpans) const;
+    
+private:
+    JsonFileSnapshot(unsigned long aVersion, shared_ptr<const TextString> aText, bool aSemanticModelDirty) :
+    version(aVersion), text(std::move(aText)), semanticModelDirty(aSemanticModelDirty) {}
+    
+    friend class JsonFile;
+    
+    unsigned long version;
+    shared_ptr<const TextString> text;
+    bool semanticModelDirty;
+};
+
 class JsonFile
 {
 public:
     JsonFile();
+    ~JsonFile();
+    
+    void setText(const TextString &aText);
+    const TextString &getText() const;
     
-    void setText(const std::wstring &aText);
-    const std::wstring &getText() const;
+    // Set text and line index right away, but only parse a prefix of the text at least
+    // aSpeculativeParseLength characters long (e.g what the editor initially shows). Returned
+    // task builds the complete semantic model; apply it with applyReconciliationTask once done.
+    // Returns an empty pointer if the entire text was parsed.
+    shared_ptr<JsonFileSemanticModelReconciliationTask> setTextWithSpeculativeParse(const TextString &aText,
+                                                                                    TextLength aSpeculativeParseLength);
     
     DocumentNode *getDom();
     const DocumentNode *getDom() const;
@@ -530,67 +701,153 @@ public:
     
     bool findPathForJsonPathString(std::wstring aPathString, JsonPath &aRet);
     
-    void addListener(JsonFileChangeListener *aListener);
+    // Path of aNode from the root of the DOM, as refreshed nodes are reported
+    JsonPath getPathOfNode(const Node *aNode) const;
+    // Node at aPath, or its deepest ancestor that's in the DOM; NULL if there's no root
+    Node *findNodeAtPath(const JsonPath &aPath);
+    // Node whose text is exactly aRange, e.g one a background reader found in a snapshot
+    Node *findNodeWithRange(const TextRange &aRange) { return jsonDom->findNodeWithRange(aRange); }
+    
+    // Listeners that keep data derived from the DOM (e.g query results) are added with
+    // aNotifyFirst, so the data is current by the time other listeners get the changes
+    void addListener(JsonFileChangeListener *aListener, bool aNotifyFirst = false);
     void removeListener(JsonFileChangeListener *aListener);
     
     const MarkerList<ParseErrorMarker> &getErrors() { return errors; }
+    std::string getErrorText(const ParseErrorMarker &aError) const { return aError.getErrorText(jsonText.get()); }
+    
+    // Each parse reports at most this many errors; the rest are summarized by a single
+    // PARSER_ERROR_TOO_MANY_ERRORS marker at the first error not reported. Applies from the next parse.
+    void setMaxParseErrors(size_t aMaxErrors) { maxParseErrors = aMaxErrors; }
+    size_t getMaxParseErrors() const { return maxParseErrors; }
     
     
     bool fastSpliceTextWithWorkLimit(TextCoordinate aOffsetStart,
                                      TextLength aLen,
-                                     const std::wstring &aNewText,
+                                     const TextString &aNewText,
                                      int maxParsedRegionLength);
     
     
     shared_ptr<JsonFileSemanticModelReconciliationTask>  spliceTextWithDirtySemanticModel(
                                                                                           TextCoordinate aOffsetStart,
                                                                                           TextLength aLen,
-                                                                                          const std::wstring &newText);
+                                                                                          const TextString &newText);
     void applyReconciliationTask(shared_ptr<JsonFileSemanticModelReconciliationTask> task);
     
+    // Applies a batch of edits, sorted and disjoint and given in coordinates of the current text.
+    // Text, line index, errors and DOM offsets are updated in one pass, and the nodes enclosing
+    // the edits are reparsed once; listeners get a single change set. If the enclosing nodes
+    // can't be reparsed locally (or the model is already dirty) the semantic model is left
+    // dirty and the returned task reconciles it; otherwise returns an empty pointer.
+    shared_ptr<JsonFileSemanticModelReconciliationTask> applyEdits(const std::vector<Splice> &aEdits,
+                                                                   int maxParsedRegionLength);
+    
     
     void getCoordinateRowCol(TextCoordinate aCoord, int &aRow, int &aCol) const;
+    
+    // Coordinates count UTF-16 units; these convert to and from character (code point)
+    // offsets, e.g for user-visible columns. O(log n) in the number of non-BMP characters.
+    unsigned long getCharacterOffset(TextCoordinate aCoord) const;
+    TextCoordinate getCoordinateForCharacterOffset(unsigned long aCharOffset) const;
+    void getCoordinateRowCharacterCol(TextCoordinate aCoord, int &aRow, int &aCol) const;
     TextCoordinate getLineStart(unsigned long aRow) const;
     TextCoordinate getLineFirstCharacter(unsigned long aRow) const;
     TextCoordinate getLineEnd(unsigned long aRow) const;
     
     inline unsigned long numLines() const { return lineStarts.size()+1; }
     
+    // Token spans for [aStart, aEnd) from the text alone, e.g for highlighting while the
+    // semantic model is dirty. See JsonLexicalHighlighter.
+    void getLexicalSpans(TextCoordinate aStart, TextCoordinate aEnd, std::vector<LexicalSpan> &aOutSpans) {
+        lexicalHighlighter.getSpans(*jsonText, lineStarts, aStart, aEnd, aOutSpans);
+    }
+    
+    // Token classes of the text as known to the semantic model. Runs around text spliced
+    // while the model is dirty are missing till it's reconciled.
+    const SyntaxRunMap &getSyntaxRuns() const { return syntaxRuns; }
+    
+    // Objects by the names of their members, e.g for JsonPath's recursive descent. Off by
+    // default; once enabled it's kept up to date across reparses and DOM edits. NULL if disabled.
+    void setMemberNameIndexEnabled(bool aEnabled);
+    const MemberNameIndex *getMemberNameIndex() const { return memberNameIndex.get(); }
+    
+    // Distinct key paths of the DOM with node counts, type and array length statistics, e.g
+    // for suggesting projections. Off by default, kept up to date like the member name index.
+    void setPathSummaryEnabled(bool aEnabled);
+    const PathSummary *getPathSummary() const { return pathSummary.get(); }
+    
+    // Incremented whenever text or DOM change.
+    unsigned long getVersion() const { return version; }
+    
+    // Snapshot of the current version. Text is shared with the file, which copies it
+    // on its next modification only while a snapshot still holds it.
+    shared_ptr<const JsonFileSnapshot> getSnapshot();
+    
+    // Nodes replaced in the DOM (e.g by a reparse) while the pin is held aren't deleted until
+    // it's released. The pin may be held and released on any thread.
+    NodeReclaimer::Pin pinNodes() { return reclaimer->pin(); }
+    size_t numRetiredNodes() const { return reclaimer->numRetired(); }
+    size_t numPinnedNodeHolders() const { return pinnedNodeHolders.size(); }
+    
     void beginDeferNotifications();
     void endDeferNotifications();
 
     
 private:
+    void spliceTextBuffer(TextCoordinate aOffsetStart, TextLength aLen, const TextString &aNewText);
+    void retireNode(Node *aNode);
+    void retireDom();
+    void addPinnedNodeHolder(PinnedNodes *aHolder);
+    void removePinnedNodeHolder(PinnedNodes *aHolder);
+    void revalidatePinnedNodes();
+    
     size_t spliceJsonTextContent(TextCoordinate aOffsetStart,
                                  TextLength aLen,
-                                 const std::wstring &aNewText);
+                                 const TextString &aNewText);
     
-    void spliceJsonTextByDomChange(TextCoordinate aOffsetStart, TextLength aLen, const std::wstring &aNewText);
+    void spliceJsonTextByDomChange(TextCoordinate aOffsetStart, TextLength aLen, const TextString &aNewText);
     void updateLineOffsetsAfterSplice(TextCoordinate aOffsetStart,
                                       TextLength aLen,
                                       TextLength aNewLen,
-                                      const wchar_t *updatedText,
+                                      const TextChar *updatedText,
                                       TextCoordinate *aOutLineDelStart,
                                       TextLength *aOutLineDelLen,
                                       TextLength *aOutNumNewLines);
+    void updateSurrogatePairsAfterSplice(TextCoordinate aOffsetStart, TextLength aLen, TextLength aNewLen);
     
     void updateTreeOffsetsAfterSplice(TextCoordinate aOffsetStart, TextLength aLen, TextLength aNewLen);
+    void updateTreeOffsetsAfterEdits(ContainerNode *aContainer,
+                                     TextCoordinate aOldAbsStart,
+                                     TextCoordinate aNewAbsStart,
+                                     const priv::EditCoordinateMapper &aMapper,
+                                     const std::set<const Node*> &aReplacedNodes);
     void updateErrorsAfterSplice(TextCoordinate aOffsetStart, TextLength aLen, TextLength aNewLen, MarkerList<ParseErrorMarker> *aNewMarkers = NULL);
+    void rebuildSyntaxRuns();
+    void unindexNode(Node *aNode);
     
     void notifyUpdatedNode(Node *updatedNode);
+    Node *mergeReparsedNode(Node *aOld, Node *aNew, JsonPath &aPath, bool aNotify);
+    Node *mergeReparsedArray(ArrayNode *aOld, ArrayNode *aNew, JsonPath &aPath, bool aNotify);
+    Node *mergeReparsedObject(ObjectNode *aOld, ObjectNode *aNew, JsonPath &aPath, bool aNotify);
+    void closeTruncatedNodes(Node *aNode, TextCoordinate aEnd);
     
     void minimizeChangedRegion(TextCoordinate aOffsetStart,
                                TextLength aLen,
-                               const std::wstring &aNewText,
+                               const TextString &aNewText,
                                TextCoordinate *outMinimizedStart,
                                TextLength *outMinimizedLen,
-                               std::wstring *outMinimizedUpdatedText);
+                               TextString *outMinimizedUpdatedText);
     
+    Node *findIntegralNode(TextCoordinate aOffsetStart, TextLength aLen, JsonPath *aOutPath);
+    bool reparseRegion(const TextString &aRegionText,
+                       TextCoordinate aRegionStart,
+                       Node **outParsedNode,
+                       MarkerList<ParseErrorMarker> *outReparseErrors);
     bool attemptReparseClosure(Node *spliceContainer,
                                TextCoordinate aOffsetStart,
                                TextLength aLen,
                                TextLength maxParsedRegionLength,
-                               const std::wstring &aNewText,
+                               const TextString &aNewText,
                                TextRange *outAbsReparseRange,
                                Node **outParsedNode,
                                MarkerList<ParseErrorMarker> *outReparseErrors);
@@ -599,7 +856,7 @@ private:
     void notify(const priv::Notification &aNotification);
     
 private:
-    void deliverNotification(const priv::Notification &aNotification);
+    void deliverChanges();
     
 private:
     friend class JsonFileParseListener;
@@ -608,21 +865,37 @@ private:
     friend class ObjectNode;
     friend class Notification;
     friend class priv::DeferNotificationsInBlock;
+    friend class PinnedNodes;
     
     std::unique_ptr<DocumentNode> jsonDom;
-    std::shared_ptr<std::wstring> jsonText;
+    std::shared_ptr<TextString> jsonText;
     
     SimpleMarkerList lineStarts;
+    SimpleMarkerList surrogatePairs; // Offset of the trailing unit of each surrogate pair
+    JsonLexicalHighlighter lexicalHighlighter;
+    SyntaxRunMap syntaxRuns;
+    std::unique_ptr<MemberNameIndex> memberNameIndex;
+    std::unique_ptr<PathSummary> pathSummary;
     MarkerList<ParseErrorMarker> errors;
+    size_t maxParseErrors;
     
     typedef list<JsonFileChangeListener*> Listeners;
     Listeners listeners;
     
     int notificationsDeferred;
-    typedef list<priv::Notification*> DeferredNotifications;
-    DeferredNotifications deferredNotifications;
+    JsonFileChangeSet pendingChanges;
     
     shared_ptr<JsonFileSemanticModelReconciliationTask> pendingReconciliationTask;
+    
+    unsigned long version;
+    weak_ptr<const JsonFileSnapshot> lastSnapshot;
+    
+    shared_ptr<NodeReclaimer> reclaimer;
+    
+    // Holders' nodes are pinned by a single pin, taken as of the last revalidation
+    std::unordered_set<PinnedNodes*> pinnedNodeHolders;
+    NodeReclaimer::Pin pinnedNodeHoldersPin;
+    unsigned long pinnedNodeHoldersEpoch;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
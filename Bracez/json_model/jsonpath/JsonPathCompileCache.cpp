@@ -0,0 +1,71 @@
+//
+//  JsonPathCompileCache.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "JsonPathCompileCache.hpp"
+
+JsonPathCompileCache &JsonPathCompileCache::shared() {
+    static JsonPathCompileCache cache;
+    return cache;
+}
+
+JsonPathExpression JsonPathCompileCache::compile(const std::wstring &inputExpression,
+                                                 CompiledExpressionType expressionType) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Key key(inputExpression, expressionType);
+    auto indexIter = _index.find(key);
+    if(indexIter != _index.end()) {
+        _numHits++;
+        _entries.splice(_entries.begin(), _entries, indexIter->second);
+    } else {
+        // Misses compile under the lock as well: the grammar's parsers and converters are
+        // shared, and compiling isn't reentrant
+        _numMisses++;
+        Entry entry = { key, JsonPathExpression(), nullptr };
+        try {
+            entry.expression = JsonPathExpression::compile(inputExpression, expressionType);
+        } catch(...) {
+            entry.error = std::current_exception();
+        }
+
+        while(!_entries.empty() && _entries.size() >= _maxEntries) {
+            _index.erase(_entries.back().key);
+            _entries.pop_back();
+        }
+
+        _entries.push_front(entry);
+        _index[key] = _entries.begin();
+    }
+
+    const Entry &entry = _entries.front();
+    if(entry.error) {
+        std::rethrow_exception(entry.error);
+    }
+
+    return entry.expression;
+}
+
+void JsonPathCompileCache::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _index.clear();
+}
+
+size_t JsonPathCompileCache::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+size_t JsonPathCompileCache::numHits() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numHits;
+}
+
+size_t JsonPathCompileCache::numMisses() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _numMisses;
+}
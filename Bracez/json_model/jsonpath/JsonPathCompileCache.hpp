@@ -0,0 +1,73 @@
+//
+//  JsonPathCompileCache.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef JsonPathCompileCache_hpp
+#define JsonPathCompileCache_hpp
+
+#include <exception>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "JsonPathExpressionCompiler.hpp"
+
+/*
+ * Compiled JsonPath expressions by their text and type.
+ *
+ * Compiled expressions share their plan, which is immutable, so a cached expression is
+ * returned by value at the cost of a reference count. Expressions that fail to compile are
+ * cached too, and compiling them again rethrows the original error (e.g a parse_error with
+ * its offsets), so partial input typed into the search box isn't parsed over and over.
+ *
+ * The cache may be used from any thread. The least recently used entries are evicted past
+ * the maximum number of entries.
+ */
+class JsonPathCompileCache {
+public:
+    JsonPathCompileCache(size_t maxEntries = 256) : _maxEntries(maxEntries) {}
+
+    JsonPathCompileCache(const JsonPathCompileCache&) = delete;
+    JsonPathCompileCache &operator=(const JsonPathCompileCache&) = delete;
+
+    // Process wide cache used by the UI
+    static JsonPathCompileCache &shared();
+
+    // Same as JsonPathExpression::compile, including the exceptions it throws
+    JsonPathExpression compile(const std::wstring &inputExpression,
+                               CompiledExpressionType expressionType = jsonPath);
+
+    void clear();
+
+    size_t size() const;
+    size_t numHits() const;
+    size_t numMisses() const;
+
+private:
+    typedef std::pair<std::wstring, CompiledExpressionType> Key;
+
+    struct Entry {
+        Key key;
+        JsonPathExpression expression;
+        std::exception_ptr error;
+    };
+
+    // Most recently used first
+    typedef std::list<Entry> Entries;
+
+private:
+    mutable std::mutex _mutex;
+    size_t _maxEntries;
+
+    Entries _entries;
+    std::map<Key, Entries::iterator> _index;
+
+    size_t _numHits = 0;
+    size_t _numMisses = 0;
+};
+
+#endif /* JsonPathCompileCache_hpp */
@@ -107,8 +107,7 @@ class parse_json {
     public:
         bool error = false;
         
-        virtual void EndOfLine(TextCoordinate aWhere) {}
-        virtual void Error(TextCoordinate aWhere, int aCode, const string &aText) { error = true; }
+        virtual void Error(TextCoordinate aWhere, int aCode, json::ParseErrorMessage aMessage, unsigned int aArg) { error = true; }
     };
     
 public:
@@ -389,37 +388,19 @@ constexpr auto binary_operator(P1 const &opand, P2 const &opor) {
                },
                opand,
                many(all([](std::list<binary_operator_and_operand> *result,
-                            binary_operator_fn &opor,
+                            JsonPathBinaryOperator &opor,
                             JsonPathExpressionNode* opand) {
                          result->push_back(binary_operator_and_operand(opor, opand));
                       },
                       opor, strict("operand", opand))));
 }
 
-auto operator_parser(const char *operatorSyntax,
-                               std::function<expr_operand_value (expr_operand_value, expr_operand_value)> operatorFn) {
-    return all([operatorFn](std::function<expr_operand_value (expr_operand_value, expr_operand_value)> *result, std::string opname) {
-        *result = operatorFn;
+auto operator_parser(const char *operatorSyntax, JsonPathBinaryOperator op) {
+    return all([op](JsonPathBinaryOperator *result, std::string opname) {
+        *result = op;
     }, tokenise(accept_str(operatorSyntax)));
 }
 
-template<class LT, class RT>
-auto scalar_operator_parser(const char *operatorSyntax,
-                                      expr_operand_value(*operatorFn)(LT *, RT *)) {
-    return operator_parser(operatorSyntax, [operatorFn](expr_operand_value l, expr_operand_value r) {
-        if(l.nodeList.size() == 1 && r.nodeList.size() == 1) {
-            LT *lt = dynamic_cast<LT*>(l.nodeList.front());
-            RT *rt = dynamic_cast<RT*>(r.nodeList.front());
-            
-            if(lt && rt) {
-                return operatorFn(lt, rt);
-            }
-        }
-        
-        return expr_operand_value::nullResult();
-    });
-}
-
 auto exprlist =        sep_by(all([](std::list<std::unique_ptr<JsonPathExpressionNode>> *result,
                                      JsonPathExpressionNode* expr) {
                                     result->push_back(std::unique_ptr<JsonPathExpressionNode>(expr));
@@ -460,14 +441,14 @@ auto expression_terminal =  attempt(context_member_name) ||
                             
 
 auto muldiv_expression = binary_operator(expression_terminal,
-                                        scalar_operator_parser("*", JsonPathExpressionNodeBinaryOperators::mul) ||
-                                        scalar_operator_parser("/", JsonPathExpressionNodeBinaryOperators::div) ||
-                                        scalar_operator_parser("%", JsonPathExpressionNodeBinaryOperators::mod)
+                                        operator_parser("*", JsonPathBinaryOperator::mul) ||
+                                        operator_parser("/", JsonPathBinaryOperator::div) ||
+                                        operator_parser("%", JsonPathBinaryOperator::mod)
                                         );
 
 auto addsub_expression = binary_operator(muldiv_expression,
-                                         operator_parser("+", JsonPathExpressionNodeBinaryOperators::add) ||
-                                         scalar_operator_parser("-", JsonPathExpressionNodeBinaryOperators::subtract)
+                                         operator_parser("+", JsonPathBinaryOperator::add) ||
+                                         operator_parser("-", JsonPathBinaryOperator::subtract)
                                         );
 
 auto negate_expression = attempt(addsub_expression) ||
@@ -476,22 +457,22 @@ auto negate_expression = attempt(addsub_expression) ||
                             }, discard(logical_negate_token) && addsub_expression);
 
 auto rel_expression = binary_operator(negate_expression,
-                                        scalar_operator_parser(">=", JsonPathExpressionNodeBinaryOperators::relGte) ||
-                                        scalar_operator_parser("<=", JsonPathExpressionNodeBinaryOperators::relLte) ||
-                                        scalar_operator_parser(">", JsonPathExpressionNodeBinaryOperators::relGt) ||
-                                        scalar_operator_parser("<", JsonPathExpressionNodeBinaryOperators::relLt) ||
-                                        scalar_operator_parser("in", JsonPathExpressionNodeBinaryOperators::relIn) ||
-                                        scalar_operator_parser("nin", JsonPathExpressionNodeBinaryOperators::relNotIn) ||
-                                        scalar_operator_parser("subsetof", JsonPathExpressionNodeBinaryOperators::relSubsetOf) ||
-                                        scalar_operator_parser("anyof", JsonPathExpressionNodeBinaryOperators::relAnyOf) ||
-                                        scalar_operator_parser("noneof", JsonPathExpressionNodeBinaryOperators::relNoneOf));
+                                        operator_parser(">=", JsonPathBinaryOperator::relGte) ||
+                                        operator_parser("<=", JsonPathBinaryOperator::relLte) ||
+                                        operator_parser(">", JsonPathBinaryOperator::relGt) ||
+                                        operator_parser("<", JsonPathBinaryOperator::relLt) ||
+                                        operator_parser("in", JsonPathBinaryOperator::relIn) ||
+                                        operator_parser("nin", JsonPathBinaryOperator::relNotIn) ||
+                                        operator_parser("subsetof", JsonPathBinaryOperator::relSubsetOf) ||
+                                        operator_parser("anyof", JsonPathBinaryOperator::relAnyOf) ||
+                                        operator_parser("noneof", JsonPathBinaryOperator::relNoneOf));
 
 auto eqneq_expression = binary_operator(rel_expression,
-                                        attempt(operator_parser("==", JsonPathExpressionNodeBinaryOperators::relEq)) ||
-                                        operator_parser("!=", JsonPathExpressionNodeBinaryOperators::relNeq)
+                                        attempt(operator_parser("==", JsonPathBinaryOperator::relEq)) ||
+                                        operator_parser("!=", JsonPathBinaryOperator::relNeq)
                                         );
-auto and_expression = binary_operator(eqneq_expression, operator_parser("&&", JsonPathExpressionNodeBinaryOperators::logicalAnd));
-auto or_expression = binary_operator(and_expression, operator_parser("||", JsonPathExpressionNodeBinaryOperators::logicalOr));
+auto and_expression = binary_operator(eqneq_expression, operator_parser("&&", JsonPathBinaryOperator::logicalAnd));
+auto or_expression = binary_operator(and_expression, operator_parser("||", JsonPathBinaryOperator::logicalOr));
 
 expression_parser_handle expression = or_expression;
 
@@ -509,13 +490,18 @@ auto json_path_expr_compiler =
 JsonPathExpressionNodeEvalResult JsonPathExpression::execute(json::Node *root,
                                                              JsonPathExpressionOptions *options,
                                                              json::Node *initialContext,
-                                                             json::Node *cursorNode) {
+                                                             json::Node *cursorNode) const {
     JsonPathExpressionNodeEvalContext evalContext;
     evalContext.rootNode = root;
     evalContext.contextNode = initialContext ? initialContext : root;
     evalContext.cursorNode = cursorNode;
     evalContext.options = options;
-    return _rootNode->evaluate(evalContext);
+
+    if(!_plan) {
+        throw JsonPathEvalError("Empty expression");
+    }
+    
+    return _plan->execute(evalContext);
 }
 
 JsonPathExpression JsonPathExpression::compile(const std::wstring &inputExpression,
@@ -535,6 +521,10 @@ JsonPathExpression JsonPathExpression::compile(const std::wstring &inputExpressi
             break;
     }
     
+    if(!out) {
+        throw JsonPathEvalError("Invalid expression");
+    }
+    
     return JsonPathExpression(std::unique_ptr<JsonPathExpressionNode>(out));
 }
 
@@ -544,25 +534,16 @@ JsonPathExpression JsonPathExpression::compile(const std::string &inputExpressio
 }
 
 bool JsonPathExpression::isCursorDependent() const {
-    bool cursorDependent = false;
-    enumerateNodes([&cursorDependent](const JsonPathExpressionNode *node) {
-        const JsonPathExpressionNodeNavPipeline *pipeline = dynamic_cast<const JsonPathExpressionNodeNavPipeline *>(node);
-        if(pipeline && pipeline->getPipelineStart() == JsonPathExpressionNodeNavPipeline::pipelineStartAtCursor) {
-            cursorDependent = true;
-        }
-    });
-    
-    return cursorDependent;
+    return _plan && _plan->isCursorDependent();
 }
 
-void JsonPathExpression::enumerateNodes(const std::function<void (const JsonPathExpressionNode*)> &enumerator) const {
-    std::list<const JsonPathExpressionNode *> nodes;
-    nodes.push_back(_rootNode.get());
-    while(nodes.size()) {
-        enumerator(nodes.front());
-        nodes.front()->pushDirectDependentNodes(nodes);
-        nodes.pop_front();
-    }
+const std::wstring &JsonPathExpression::getNormalizedForm() const {
+    static const std::wstring emptyForm;
+    return _plan ? _plan->getNormalizedForm() : emptyForm;
+}
+
+json::Node *JsonPathExpression::findReadScope(json::Node *root, JsonPathExpressionOptions *options) const {
+    return _plan ? _plan->findReadScope(root, options) : root;
 }
 
 bool JsonPathExpression::isValidIdentifier(const std::wstring &input) {
@@ -8,7 +8,10 @@
 #ifndef JsonPathExpressionCompiler_hpp
 #define JsonPathExpressionCompiler_hpp
 
+#include <functional>
+
 #include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionPlan.hpp"
 #include "Parser-Combinators/parser_combinators.hpp"
 
 enum CompiledExpressionType {
@@ -16,8 +19,20 @@ enum CompiledExpressionType {
     jsonPathExpression
 };
 
+// Calls body with 0..count-1, possibly concurrently; returns once all calls are done
+typedef std::function<void (size_t count, const std::function<void (size_t)> &body)> JsonPathParallelFor;
+
 struct JsonPathExpressionOptions {
-    bool fuzzy;
+    bool fuzzy = false;
+    
+    // Filters over at least parallelThreshold candidates are split into partitions that are
+    // evaluated concurrently. Results keep document order. Filters only read the DOM, which
+    // must not change while the expression executes.
+    bool parallel = false;
+    size_t parallelThreshold = 4096;
+    
+    // Runs the partitions; GCD (or a thread per core elsewhere) when not set
+    JsonPathParallelFor parallelFor;
 };
 
 class JsonPathExpression {
@@ -25,7 +40,7 @@ public:
     JsonPathExpressionNodeEvalResult execute(json::Node *root,
                                              JsonPathExpressionOptions *options = NULL,
                                              json::Node *initialContext = NULL,
-                                             json::Node *cursorNode = NULL);
+                                             json::Node *cursorNode = NULL) const;
     
 public:
     static JsonPathExpression compile(const std::wstring &inputExpression,
@@ -34,22 +49,23 @@ public:
                                       CompiledExpressionType expressionType = jsonPath);
     static bool isValidIdentifier(const std::wstring &input);
     
-    JsonPathExpression(JsonPathExpression &&expr) : _rootNode(std::move(expr._rootNode)) {}
     JsonPathExpression() {}
 
-    JsonPathExpression &operator=(JsonPathExpression &&expr) {
-        _rootNode = std::move(expr._rootNode);
-        return *this;
-    }
-    
     bool isCursorDependent() const;
+
+    // See JsonPathExpressionPlan
+    const std::wstring &getNormalizedForm() const;
+    json::Node *findReadScope(json::Node *root, JsonPathExpressionOptions *options = NULL) const;
     
 private:
-    JsonPathExpression(std::unique_ptr<JsonPathExpressionNode> &&rootNode) : _rootNode(std::move(rootNode)) {}
-    void enumerateNodes(const std::function<void (const JsonPathExpressionNode*)> &enumerator) const;
+    friend class JsonPathLiveQuery;
+    friend class JsonPathResultIterator;
+    friend class JsonPathStreamingEvaluator;
+
+    JsonPathExpression(std::unique_ptr<JsonPathExpressionNode> &&rootNode) : _plan(JsonPathExpressionPlan::lower(*rootNode)) {}
     
 private:
-    std::unique_ptr<JsonPathExpressionNode> _rootNode;
+    std::shared_ptr<const JsonPathExpressionPlan> _plan;
 };
 
 #endif /* JsonPathExpressionCompiler_hpp */
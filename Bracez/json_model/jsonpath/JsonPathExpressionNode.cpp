@@ -7,6 +7,7 @@
 
 #include "JsonPathExpressionNode.hpp"
 #include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathExpressionPlan.hpp"
 #include <math.h>
 #include <numeric>
 
@@ -16,6 +17,23 @@ static std::wstring_convert<convert_type, wchar_t> wide_utf8_converter;
 
 
 bool JsonPathExpressionNodeEvalResult::getTruthValue() const {
+    switch(_valueType) {
+        case valueNull:
+            return false;
+            
+        case valueBoolean:
+            return _booleanValue;
+            
+        case valueNumber:
+            return _numberValue != 0;
+            
+        case valueString:
+            return _stringValue.size() > 0;
+            
+        case valueNodeList:
+            break;
+    }
+    
     if(!nodeList.size()) {
         return false;
     }
@@ -49,6 +67,10 @@ bool JsonPathExpressionNodeEvalResult::getTruthValue() const {
 }
 
 double JsonPathExpressionNodeEvalResult::getNumericValue() const {
+    if(_valueType == valueNumber) {
+        return _numberValue;
+    }
+    
     if(!nodeList.size()) {
         throw JsonPathEvalError("Invalid numeric value");
     }
@@ -66,47 +88,83 @@ double JsonPathExpressionNodeEvalResult::getNumericValue() const {
     return numNode->getValue();
 }
 
-JsonPathExpressionNodeEvalResult JsonPathExpressionNodeEvalResult::booleanResult(bool r) {
-    JsonPathExpressionNodeEvalResult ret;
+json::Node *JsonPathExpressionNodeEvalResult::createScalarNode() const {
+    switch(_valueType) {
+        case valueNull:
+            return new json::NullNode();
+            
+        case valueBoolean:
+            return new json::BooleanNode(_booleanValue);
+            
+        case valueNumber:
+            return new json::NumberNode(_numberValue);
+            
+        case valueString:
+            return new json::StringNode(std::wstring(_stringValue));
+            
+        case valueNodeList:
+            break;
+    }
     
-    json::BooleanNode *b = new json::BooleanNode(r);
+    throw JsonPathEvalError("Result is not a scalar");
+}
+
+void JsonPathExpressionNodeEvalResult::materialize() {
+    if(_valueType == valueNodeList) {
+        return;
+    }
     
-    ret.localOwners.push_back(std::shared_ptr<json::Node>(b));
-    ret.nodeList.push_back(b);
+    json::Node *node = createScalarNode();
+    localOwners.push_back(std::shared_ptr<json::Node>(node));
+    nodeList.push_back(node);
     
+    _valueType = valueNodeList;
+    _stringValue = std::wstring_view();
+    _ownedString.reset();
+}
+
+void JsonPathExpressionNodeEvalResult::assignNode(json::Node *node) {
+    _valueType = valueNodeList;
+    _stringValue = std::wstring_view();
+    _ownedString.reset();
+    localOwners.clear();
+    
+    nodeList.clear();
+    nodeList.push_back(node);
+}
+
+JsonPathExpressionNodeEvalResult JsonPathExpressionNodeEvalResult::booleanResult(bool r) {
+    JsonPathExpressionNodeEvalResult ret;
+    ret._valueType = valueBoolean;
+    ret._booleanValue = r;
     return ret;
 }
 
 JsonPathExpressionNodeEvalResult JsonPathExpressionNodeEvalResult::nullResult() {
     JsonPathExpressionNodeEvalResult ret;
-    
-    json::NullNode *b = new json::NullNode();
-    
-    ret.localOwners.push_back(std::shared_ptr<json::Node>(b));
-    ret.nodeList.push_back(b);
-    
+    ret._valueType = valueNull;
     return ret;
 }
 
 JsonPathExpressionNodeEvalResult JsonPathExpressionNodeEvalResult::doubleResult(double result) {
     JsonPathExpressionNodeEvalResult ret;
-    
-    json::NumberNode *n = new json::NumberNode(result);
-    
-    ret.localOwners.push_back(std::shared_ptr<json::Node>(n));
-    ret.nodeList.push_back(n);
-    
+    ret._valueType = valueNumber;
+    ret._numberValue = result;
     return ret;
 }
 
 JsonPathExpressionNodeEvalResult JsonPathExpressionNodeEvalResult::stringResult(const std::wstring &result) {
     JsonPathExpressionNodeEvalResult ret;
-    
-    json::StringNode *n = new json::StringNode(result);
-    
-    ret.localOwners.push_back(std::shared_ptr<json::Node>(n));
-    ret.nodeList.push_back(n);
-    
+    ret._valueType = valueString;
+    ret._ownedString = std::make_shared<const std::wstring>(result);
+    ret._stringValue = *ret._ownedString;
+    return ret;
+}
+
+JsonPathExpressionNodeEvalResult JsonPathExpressionNodeEvalResult::stringViewResult(std::wstring_view result) {
+    JsonPathExpressionNodeEvalResult ret;
+    ret._valueType = valueString;
+    ret._stringValue = result;
     return ret;
 }
 
@@ -154,36 +212,30 @@ void JsonPathExpressionNodeNavPipeline::pushDirectDependentNodes(std::list<const
 }
 
 
-JsonPathExpressionNodeEvalResult JsonPathExpressionNodeNavPipeline::evaluate(JsonPathExpressionNodeEvalContext &context) {
-    JsonPathExpressionNodeEvalResult result;
+void JsonPathExpressionNodeNavPipeline::lower(JsonPathPlanBuilder &builder, int resultRegister) const {
     switch (_pipelineStart) {
         case pipelineStartAtCursor:
-            result.nodeList.push_back(context.cursorNode);
+            builder.emit(JsonPathPlanOp::loadCursor, resultRegister);
+            builder.setCursorDependent();
             break;
-            
+
         case pipelineStartAtContext:
-            result.nodeList.push_back(context.contextNode);
+            builder.emit(JsonPathPlanOp::loadContext, resultRegister);
             break;
 
         case pipelineStartAtRoot:
-            result.nodeList.push_back(context.rootNode);
+            builder.emit(JsonPathPlanOp::loadRoot, resultRegister);
             break;
 
         default:
-            break;
+            throw JsonPathEvalError("Invalid pipeline start");
     }
-    
-    if(!result.nodeList.front()) {
-        throw JsonPathEvalError("Missing node for pipeline start");
-    }
-    
+
     std::for_each(_nodes.begin(),
                   _nodes.end(),
-                  [&result, &context](const std::unique_ptr<JsonPathExpressionNodeNavPipelineStep> &n) {
-                        n->stepFromNode(context, result);
+                  [&builder, resultRegister](const std::unique_ptr<JsonPathExpressionNodeNavPipelineStep> &n) {
+                        n->lower(builder, resultRegister);
                   });
-
-    return result;
 }
 
 
@@ -202,39 +254,12 @@ void JsonPathExpressionNodeNavRecurse::inspect(std::ostream &out) const {
     out << "Fetch any decsendant named '" << wide_utf8_converter.to_bytes(_name) << "'";
 }
 
-void JsonPathExpressionNodeNavRecurse::stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    JsonPathResultNodeList bfsQueue;
-    
-    while(nodes.nodeList.size()) {
-        // Get current node
-        json::Node *node = nodes.nodeList.front();
-        nodes.nodeList.pop_front();
-        
-        // Add children to queue (for BFS)
-        json::ContainerNode *containerNode = dynamic_cast<json::ContainerNode*>(node);
-        if(containerNode) {
-            for(int childIdx=0; childIdx<containerNode->getChildCount(); childIdx++) {
-                nodes.nodeList.push_back(containerNode->getChildAt(childIdx));
-            }
-        }
-        
-        if(_wildcard) {
-            resultList.push_back(node);
-        } else {
-            // Resolve name
-            json::ObjectNode *obNode = dynamic_cast<json::ObjectNode*>(node);
-            int idx = -1;
-            if(obNode) {
-                idx = obNode->getIndexOfMemberWithName(_name);
-            }
-            if(idx != -1) {
-                resultList.push_back(obNode->getChildAt(idx));
-            }
-        }
+void JsonPathExpressionNodeNavRecurse::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    if(_wildcard) {
+        builder.emit(JsonPathPlanOp::navRecurseAll, nodesRegister);
+    } else {
+        builder.emit(JsonPathPlanOp::navRecurseName, nodesRegister, 0, 0, builder.addName(_name));
     }
-
-    nodes.nodeList = std::move(resultList);
 }
 
 
@@ -247,40 +272,8 @@ void JsonPathExpressionNodeNavResolveName::inspect(std::ostream &out) const {
     out << "Navigate to '" << wide_utf8_converter.to_bytes(_name) << "'";
 }
 
-void JsonPathExpressionNodeNavResolveName::stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    if(!(context.options && context.options->fuzzy)) {
-        std::for_each(nodes.nodeList.begin(),
-                      nodes.nodeList.end(),
-                      [this, &resultList](json::Node* node) {
-                            json::ObjectNode *obNode = dynamic_cast<json::ObjectNode*>(node);
-                            int idx = -1;
-                            if(obNode) {
-                                idx = obNode->getIndexOfMemberWithName(_name);
-                            }
-                            if(idx != -1) {
-                                resultList.push_back(obNode->getChildAt(idx));
-                            }
-                      });
-        
-    } else {
-        std::for_each(nodes.nodeList.begin(),
-                      nodes.nodeList.end(),
-                      [this, &resultList](json::Node* node) {
-                            json::ObjectNode *obNode = dynamic_cast<json::ObjectNode*>(node);
-                            if(obNode) {
-                                int childCount = obNode->getChildCount();
-                                for(int idx=0; idx<childCount; idx++) {
-                                    if(obNode->getMemberNameAt(idx).substr(0, _name.length()) == _name) {
-                                        resultList.push_back(obNode->getChildAt(idx));
-                                    }
-                                }
-                            }
-                      });
-    }
-        
-
-    nodes.nodeList = std::move(resultList);
+void JsonPathExpressionNodeNavResolveName::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    builder.emit(JsonPathPlanOp::navName, nodesRegister, 0, 0, builder.addName(_name));
 }
 
 
@@ -294,24 +287,8 @@ void JsonPathExpressionNodeNavParent::inspect(std::ostream &out) const {
     out << "Navigate to " << (_allAncestors ? "ancestors" : "parent");
 }
 
-void JsonPathExpressionNodeNavParent::stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    std::for_each(nodes.nodeList.begin(),
-                  nodes.nodeList.end(),
-                  [this, &resultList](json::Node* node) {
-                        if(node->getParent()) {
-                            node = node->getParent();
-                            resultList.push_back(node);
-                        }
-        
-                        if(_allAncestors) {
-                            while(node->getParent()) {
-                                node = node->getParent();
-                                resultList.push_back(node);
-                            }
-                        }
-                  });
-    nodes.nodeList = std::move(resultList);
+void JsonPathExpressionNodeNavParent::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    builder.emit(_allAncestors ? JsonPathPlanOp::navAncestors : JsonPathPlanOp::navParent, nodesRegister);
 }
 
 
@@ -324,20 +301,8 @@ void JsonPathExpressionNodeNavAllChildren::inspect(std::ostream &out) const {
     out << "Fetch all children";
 }
 
-void JsonPathExpressionNodeNavAllChildren::stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    std::for_each(nodes.nodeList.begin(),
-                  nodes.nodeList.end(),
-                  [&resultList](json::Node* node) {
-                        json::ContainerNode *contNode = dynamic_cast<json::ContainerNode*>(node);
-                        if(contNode) {
-                            int ccount = contNode->getChildCount();
-                            for(int idx=0; idx<ccount; idx++) {
-                                resultList.push_back(contNode->getChildAt(idx));
-                            }
-                        }
-                  });
-    nodes.nodeList = std::move(resultList);
+void JsonPathExpressionNodeNavAllChildren::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    builder.emit(JsonPathPlanOp::navChildren, nodesRegister);
 }
 
 
@@ -349,18 +314,8 @@ void JsonPathExpressionNodeContextMemberName::inspect(std::ostream &out) const {
     out << "Fetch current node name";
 }
 
-JsonPathExpressionNodeEvalResult JsonPathExpressionNodeContextMemberName::evaluate(JsonPathExpressionNodeEvalContext &context) {
-    if(context.contextNode) {
-        int childIndex = context.contextNode->getParent()->getIndexOfChild(context.contextNode);
-        if(json::ObjectNode *onode = dynamic_cast<json::ObjectNode*>(context.contextNode->getParent())) {
-            return JsonPathExpressionNodeEvalResult::stringResult(onode->getMemberNameAt(childIndex));
-        } else
-        {
-            return JsonPathExpressionNodeEvalResult::doubleResult(childIndex);
-        }
-    }
-    
-    return JsonPathExpressionNodeEvalResult::nullResult();
+void JsonPathExpressionNodeContextMemberName::lower(JsonPathPlanBuilder &builder, int resultRegister) const {
+    builder.emit(JsonPathPlanOp::loadMemberName, resultRegister);
 }
 
 
@@ -373,18 +328,8 @@ void JsonPathExpressionNodeNavIndexArray::inspect(std::ostream &out) const {
     out << "Access index " << _index;
 }
 
-void JsonPathExpressionNodeNavIndexArray::stepFromNode(JsonPathExpressionNodeEvalContext &context,
-                                                       JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    std::for_each(nodes.nodeList.begin(),
-                  nodes.nodeList.end(),
-                  [this, &resultList](json::Node* node) {
-                        json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
-                        if(arrNode && _index < arrNode->getChildCount()) {
-                            resultList.push_back(arrNode->getChildAt(_index));
-                        }
-                  });
-    nodes.nodeList = std::move(resultList);
+void JsonPathExpressionNodeNavIndexArray::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    builder.emit(JsonPathPlanOp::navIndex, nodesRegister, 0, 0, _index);
 }
 
 JsonPathExpressionNodeNavSliceArray::JsonPathExpressionNodeNavSliceArray(int startIndex, bool startInverted, int endIndex, bool endInverted)
@@ -396,28 +341,9 @@ void JsonPathExpressionNodeNavSliceArray::inspect(std::ostream &out) const {
         << " to " << (_endInverted ? "-": "") << _endIndex;
 }
 
-void JsonPathExpressionNodeNavSliceArray::stepFromNode(JsonPathExpressionNodeEvalContext &context,
-                                                       JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    std::for_each(nodes.nodeList.begin(),
-                  nodes.nodeList.end(),
-                  [this, &resultList](json::Node* node) {
-                        json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
-                        if(arrNode) {
-                            int childCount = arrNode->getChildCount();
-                            
-                            int start = _startIndex;
-                            int end = _endIndex;
-                            
-                            if(_startInverted) start = childCount - start;
-                            if(_endInverted) end = childCount - end;
-                            
-                            for(int idx=start; idx < end && idx < childCount; idx++) {
-                                resultList.push_back(arrNode->getChildAt(idx));
-                            }
-                        }
-                  });
-    nodes.nodeList = std::move(resultList);
+void JsonPathExpressionNodeNavSliceArray::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    JsonPathPlanSlice slice = { _startIndex, _startInverted, _endIndex, _endInverted };
+    builder.emit(JsonPathPlanOp::navSlice, nodesRegister, 0, 0, builder.addSlice(slice));
 }
 
 
@@ -431,25 +357,8 @@ void JsonPathExpressionNodeNavIndexArrayByList::inspect(std::ostream &out) const
     out << "Access " <<  _indexList.size() << " indices";
 }
 
-void JsonPathExpressionNodeNavIndexArrayByList::stepFromNode(JsonPathExpressionNodeEvalContext &context,
-                                                             JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    std::for_each(nodes.nodeList.begin(),
-                  nodes.nodeList.end(),
-                  [this, &resultList](json::Node* node) {
-                        json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
-                        if(arrNode) {
-                            int arrLen = arrNode->getChildCount();
-                            std::for_each(_indexList.begin(),
-                                          _indexList.end(),
-                                          [arrNode, arrLen, &resultList](int index) {
-                                            if(index < arrLen) {
-                                                resultList.push_back(arrNode->getChildAt(index));
-                                            }
-                                           });
-                        }
-                  });
-    nodes.nodeList = std::move(resultList);
+void JsonPathExpressionNodeNavIndexArrayByList::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    builder.emit(JsonPathPlanOp::navIndexList, nodesRegister, 0, 0, builder.addIndexList(_indexList));
 }
 
 
@@ -460,42 +369,12 @@ JsonPathExpressionNodeFilter::JsonPathExpressionNodeFilter(std::unique_ptr<JsonP
 }
 
 
-void JsonPathExpressionNodeFilter::stepFromNode(JsonPathExpressionNodeEvalContext &context,
-                                                        JsonPathExpressionNodeEvalResult &nodes) {
-    JsonPathResultNodeList resultList;
-    std::for_each(nodes.nodeList.begin(),
-                  nodes.nodeList.end(),
-                  [this, &context, &resultList](json::Node* node) {
-                            if(_filterChildren) {
-                                json::ContainerNode *contNode = dynamic_cast<json::ContainerNode*>(node);
-                                if(contNode) {
-                                    int ccount = contNode->getChildCount();
-                                    for(int idx=0; idx<ccount; idx++) {
-                                        json::Node *oldContext = context.contextNode;
-                                        context.contextNode = contNode->getChildAt(idx);
-                                        JsonPathExpressionNodeEvalResult filterRes = _filter->evaluate(context);
-                                        
-                                        if(filterRes.getTruthValue()) {
-                                            resultList.push_back(context.contextNode);
-                                        }
-                                        
-                                        context.contextNode = oldContext;
-                                    }
-                                }
-                            } else {
-                                json::Node *oldContext = context.contextNode;
-                                context.contextNode = node;
-                                JsonPathExpressionNodeEvalResult filterRes = _filter->evaluate(context);
-                                    
-                                if(filterRes.getTruthValue()) {
-                                    resultList.push_back(context.contextNode);
-                                }
-                                    
-                                context.contextNode = oldContext;
-                            }
-                        }
-                  );
-    nodes.nodeList = std::move(resultList);
+void JsonPathExpressionNodeFilter::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    int filterRegister = builder.allocRegister();
+    size_t filterAt = builder.emit(_filterChildren ? JsonPathPlanOp::navFilterChildren : JsonPathPlanOp::navFilter,
+                                   nodesRegister, 0, filterRegister);
+    _filter->lower(builder, filterRegister);
+    builder.instructionAt(filterAt).a = (int)(builder.here() - filterAt - 1);
 }
 
 void JsonPathExpressionNodeFilter::inspect(std::ostream &out) const {
@@ -517,26 +396,11 @@ JsonPathExpressionNodeIndexByExpression::JsonPathExpressionNodeIndexByExpression
     
 }
 
-void JsonPathExpressionNodeIndexByExpression::stepFromNode(JsonPathExpressionNodeEvalContext &context,
-                                                           JsonPathExpressionNodeEvalResult &nodes) {
-    json::Node *oldContext = context.contextNode;
-
-    JsonPathResultNodeList resultList;
-    std::for_each(nodes.nodeList.begin(),
-                  nodes.nodeList.end(),
-                  [this, &context, &resultList](json::Node* node) {
-                        json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
-                        if(arrNode) {
-                            context.contextNode = arrNode;
-                            int filterRes = (int)_filter->evaluate(context).getNumericValue();
-                            if(filterRes < arrNode->getChildCount() && filterRes >= 0) {
-                                resultList.push_back(arrNode->getChildAt(filterRes));
-                            }
-                        }
-                  });
-    
-    nodes.nodeList = std::move(resultList);
-    context.contextNode = oldContext;
+void JsonPathExpressionNodeIndexByExpression::lower(JsonPathPlanBuilder &builder, int nodesRegister) const {
+    int indexRegister = builder.allocRegister();
+    size_t indexAt = builder.emit(JsonPathPlanOp::navIndexByExpression, nodesRegister, 0, indexRegister);
+    _filter->lower(builder, indexRegister);
+    builder.instructionAt(indexAt).a = (int)(builder.here() - indexAt - 1);
 }
 
 
@@ -569,15 +433,50 @@ void JsonPathExpressionNodeBinaryOp::inspect(std::ostream &out) const {
     out << "]";
 }
 
-JsonPathExpressionNodeEvalResult JsonPathExpressionNodeBinaryOp::evaluate(JsonPathExpressionNodeEvalContext &context) {
-    JsonPathExpressionNodeEvalResult curLeftResult = _leftMost->evaluate(context);
+static JsonPathPlanOp planOpForOperator(JsonPathBinaryOperator op) {
+    switch(op) {
+        case JsonPathBinaryOperator::relEq: return JsonPathPlanOp::relEq;
+        case JsonPathBinaryOperator::relNeq: return JsonPathPlanOp::relNeq;
+        case JsonPathBinaryOperator::relGte: return JsonPathPlanOp::relGte;
+        case JsonPathBinaryOperator::relLte: return JsonPathPlanOp::relLte;
+        case JsonPathBinaryOperator::relGt: return JsonPathPlanOp::relGt;
+        case JsonPathBinaryOperator::relLt: return JsonPathPlanOp::relLt;
+        case JsonPathBinaryOperator::relIn: return JsonPathPlanOp::relIn;
+        case JsonPathBinaryOperator::relNotIn: return JsonPathPlanOp::relNotIn;
+        case JsonPathBinaryOperator::relSubsetOf: return JsonPathPlanOp::relSubsetOf;
+        case JsonPathBinaryOperator::relAnyOf: return JsonPathPlanOp::relAnyOf;
+        case JsonPathBinaryOperator::relNoneOf: return JsonPathPlanOp::relNoneOf;
+        case JsonPathBinaryOperator::add: return JsonPathPlanOp::add;
+        case JsonPathBinaryOperator::div: return JsonPathPlanOp::div;
+        case JsonPathBinaryOperator::mul: return JsonPathPlanOp::mul;
+        case JsonPathBinaryOperator::mod: return JsonPathPlanOp::mod;
+        case JsonPathBinaryOperator::subtract: return JsonPathPlanOp::subtract;
+
+        default:
+            throw JsonPathEvalError("Invalid binary operator");
+    }
+}
+
+void JsonPathExpressionNodeBinaryOp::lower(JsonPathPlanBuilder &builder, int resultRegister) const {
+    _leftMost->lower(builder, resultRegister);
     std::for_each(_operandList.begin(),
                   _operandList.end(),
-                  [&curLeftResult, &context](const binary_operator_and_operand &oporAndOpand) {
-                    JsonPathExpressionNodeEvalResult curRightResult = std::get<1>(oporAndOpand)->evaluate(context);
-                    curLeftResult = std::get<0>(oporAndOpand)(curLeftResult, curRightResult);
+                  [&builder, resultRegister](const binary_operator_and_operand &oporAndOpand) {
+                    JsonPathBinaryOperator op = std::get<0>(oporAndOpand);
+                    const std::unique_ptr<JsonPathExpressionNode> &operand = std::get<1>(oporAndOpand);
+
+                    if(op == JsonPathBinaryOperator::logicalOr || op == JsonPathBinaryOperator::logicalAnd) {
+                        // The left value is the result unless the right operand is needed
+                        size_t jumpAt = builder.emit(op == JsonPathBinaryOperator::logicalOr ? JsonPathPlanOp::jumpIfTrue : JsonPathPlanOp::jumpIfFalse,
+                                                     resultRegister);
+                        operand->lower(builder, resultRegister);
+                        builder.instructionAt(jumpAt).arg = (int)builder.here();
+                    } else {
+                        int operandRegister = builder.allocRegister();
+                        operand->lower(builder, operandRegister);
+                        builder.emit(planOpForOperator(op), resultRegister, resultRegister, operandRegister);
+                    }
                   });
-    return curLeftResult;
 }
 
 void JsonPathExpressionNodeBinaryOp::pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const {
@@ -601,8 +500,9 @@ void JsonPathExpressionNodeNegateOp::inspect(std::ostream &out) const {
     out << "]";
 }
 
-JsonPathExpressionNodeEvalResult JsonPathExpressionNodeNegateOp::evaluate(JsonPathExpressionNodeEvalContext &context) {
-    return JsonPathExpressionNodeEvalResult::booleanResult(!_operand->evaluate(context).getTruthValue());
+void JsonPathExpressionNodeNegateOp::lower(JsonPathPlanBuilder &builder, int resultRegister) const {
+    _operand->lower(builder, resultRegister);
+    builder.emit(JsonPathPlanOp::negate, resultRegister, resultRegister);
 }
 
 
@@ -630,11 +530,8 @@ void JsonPathExpressionNodeJsonLiteral::inspect(std::ostream &out) const {
     out << "]";
 }
 
-JsonPathExpressionNodeEvalResult JsonPathExpressionNodeJsonLiteral::evaluate(JsonPathExpressionNodeEvalContext &context) {
-    JsonPathExpressionNodeEvalResult ret;
-    ret.nodeList.push_back(_literal.get());
-    ret.localOwners.push_back(_literal);
-    return ret;
+void JsonPathExpressionNodeJsonLiteral::lower(JsonPathPlanBuilder &builder, int resultRegister) const {
+    builder.emit(JsonPathPlanOp::loadLiteral, resultRegister, 0, 0, builder.addLiteral(_literal));
 }
 
 
@@ -648,14 +545,14 @@ void JsonPathExpressionNodeFunctionInvoke::inspect(std::ostream &out) const {
     
 }
 
-JsonPathExpressionNodeEvalResult JsonPathExpressionNodeFunctionInvoke::evaluate(JsonPathExpressionNodeEvalContext &context) {
-    std::list<JsonPathExpressionNodeEvalResult> evaledArgs;
-    
-    std::transform(_args.begin(), _args.end(), back_inserter(evaledArgs), [&context](std::unique_ptr<JsonPathExpressionNode>& arg) {
-        return arg->evaluate(context);
+void JsonPathExpressionNodeFunctionInvoke::lower(JsonPathPlanBuilder &builder, int resultRegister) const {
+    int firstArgRegister = builder.allocRegisters((int)_args.size());
+    int argRegister = firstArgRegister;
+    std::for_each(_args.begin(), _args.end(), [&builder, &argRegister](const std::unique_ptr<JsonPathExpressionNode>& arg) {
+        arg->lower(builder, argRegister++);
     });
-    
-    return _fn->invoke(evaledArgs);
+
+    builder.emit(JsonPathPlanOp::call, resultRegister, firstArgRegister, (int)_args.size(), builder.addFunction(_fn));
 }
 
 void JsonPathExpressionNodeFunctionInvoke::pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const {
@@ -664,154 +561,6 @@ void JsonPathExpressionNodeFunctionInvoke::pushDirectDependentNodes(std::list<co
     });
 }
 
-namespace JsonPathExpressionNodeBinaryOperators {
-
-    expr_operand_value logicalOr(expr_operand_value opLeft,  expr_operand_value opRight) {
-        if(opLeft.getTruthValue()) {
-            return opLeft;
-        } else {
-            return opRight;
-        }
-    }
-
-    expr_operand_value logicalAnd(expr_operand_value opLeft,  expr_operand_value opRight) {
-        if(opLeft.getTruthValue()) {
-            return opRight;
-        } else {
-            return opLeft;
-        }
-    }
-
-    bool isEqualInternal(expr_operand_value opLeft,  expr_operand_value opRight) {
-        JsonPathResultNodeList &leftNodes = opLeft.nodeList;
-        JsonPathResultNodeList &rightNodes = opRight.nodeList;
-        
-        if(leftNodes.size() != rightNodes.size()) {
-            return false;
-        }
-        
-        for(auto liter = leftNodes.begin(),
-                 riter = rightNodes.begin();
-            liter != leftNodes.end() && riter != rightNodes.end();
-            liter++, riter++) {
-            if(!(*liter)->valueEquals(*riter)) {
-                return false;
-            }
-        }
-        
-        
-        return true;
-    }
-
-    expr_operand_value relEq(expr_operand_value opLeft,  expr_operand_value opRight) {
-        return expr_operand_value::booleanResult(isEqualInternal(opLeft, opRight));
-    }
-
-    expr_operand_value relNeq(expr_operand_value opLeft,  expr_operand_value opRight) {
-        return expr_operand_value::booleanResult(!isEqualInternal(opLeft, opRight));
-    }
-
-    expr_operand_value relGte(json::Node *left, json::Node *right) {
-        return expr_operand_value::booleanResult(right->valueLt(left) || right->valueEquals(left));
-    }
-
-    expr_operand_value relLte(json::Node *left, json::Node *right) {
-        return expr_operand_value::booleanResult(left->valueLt(right) || left->valueEquals(right));
-    }
-
-    expr_operand_value relGt(json::Node *left, json::Node *right) {
-        return expr_operand_value::booleanResult(right->valueLt(left));
-    }
-
-    expr_operand_value relLt(json::Node *left, json::Node *right) {
-        return expr_operand_value::booleanResult(left->valueLt(right));
-    }
-
-    inline bool relInInternal(json::Node *left, json::ArrayNode *right) {
-        return find_if(right->begin(), right->end(), [left](unique_ptr<json::Node> &n) {
-            return n->valueEquals(left);
-        }) != right->end();
-    }
-
-    expr_operand_value relIn(json::Node *left, json::ArrayNode *right) {
-        return expr_operand_value::booleanResult(relInInternal(left, right));
-    }
-
-    expr_operand_value relNotIn(json::Node *left, json::ArrayNode *right) {
-        return expr_operand_value::booleanResult(!relInInternal(left, right));
-    }
-    
-    expr_operand_value relSubsetOf(json::ArrayNode *left, json::ArrayNode *right) {
-        bool notSubset = std::find_if_not(left->begin(), left->end(), [right](unique_ptr<json::Node> &node) {
-            return relInInternal(node.get(), right);
-        }) != left->end();
-        
-        return expr_operand_value::booleanResult(!notSubset);
-    }
-    
-    inline bool relAnyOfInternal(json::ArrayNode *left, json::ArrayNode *right) {
-        return std::find_if(left->begin(), left->end(), [right](unique_ptr<json::Node> &node ) {
-            return relInInternal(node.get(), right);
-        }) != left->end();
-
-    }
-    expr_operand_value relAnyOf(json::ArrayNode *left, json::ArrayNode *right) {
-        return expr_operand_value::booleanResult(relAnyOfInternal(left, right));
-    }
-    
-    expr_operand_value relNoneOf(json::ArrayNode *left, json::ArrayNode *right) {
-        return expr_operand_value::booleanResult(!relAnyOfInternal(left, right));
-    }
-
-    expr_operand_value div(json::NumberNode *opLeft,  json::NumberNode *opRight) {
-        return expr_operand_value::doubleResult(opLeft->getValue() / opRight->getValue());
-    }
-
-    expr_operand_value mod(json::NumberNode *opLeft,  json::NumberNode *opRight) {
-        return expr_operand_value::doubleResult((long)opLeft->getValue() % (long)opRight->getValue());
-    }
-
-
-    expr_operand_value mul(json::NumberNode *opLeft,  json::NumberNode *opRight) {
-        return expr_operand_value::doubleResult(opLeft->getValue() * opRight->getValue());
-    }
-    
-    expr_operand_value add(expr_operand_value opLeft,  expr_operand_value opRight) {
-        if(opLeft.nodeList.size() == 1 && opRight.nodeList.size() == 1) {
-            json::NumberNode *numLeft = dynamic_cast<json::NumberNode*>(opLeft.nodeList.front());
-            json::NumberNode *numRight = dynamic_cast<json::NumberNode*>(opRight.nodeList.front());
-            if(numLeft && numRight) {
-                return expr_operand_value::doubleResult(numLeft->getValue() + numRight->getValue());
-            } else
-            if(json::StringNode *strLeft = dynamic_cast<json::StringNode*>(opLeft.nodeList.front())) {
-                return expr_operand_value::stringResult(strLeft->getValue() + opRight.nodeList.front()->toString());
-            } else
-            if(json::ArrayNode *arrLeft = dynamic_cast<json::ArrayNode*>(opLeft.nodeList.front())) {
-                json::ArrayNode *arrResult = arrLeft->clone();
-                
-                if(json::ArrayNode *arrRight = dynamic_cast<json::ArrayNode*>(opRight.nodeList.front())) {
-                    for(auto iter = arrRight->begin(); iter != arrRight->end(); iter++) {
-                        arrResult->domAddElementNode((*iter)->clone());
-                    }
-                } else {
-                    arrResult->domAddElementNode(arrRight->clone());
-                }
-                
-                expr_operand_value ret;
-                ret.nodeList.push_back(arrResult);
-                ret.localOwners.push_back(shared_ptr<json::Node>(arrResult));
-            }
-        }
-         
-        return expr_operand_value::nullResult();
-    }
-    
-    expr_operand_value subtract(json::NumberNode *opLeft,  json::NumberNode *opRight) {
-        return expr_operand_value::doubleResult(opLeft->getValue() - opRight->getValue());
-    }
-}
-
-
 template<class T>
 JsonPathExpressionNodeEvalResult convertToJsonPathResult(const T &&from) {
     throw JsonPathEvalError("Cannot convert return type");
@@ -884,6 +633,10 @@ JsonPathExpressionFunction* AdaptToJsonPathExpressionFunction(R (*f)(A...))  {
 
 namespace json_path_functions {
     double length(const JsonPathExpressionNodeEvalResult &input) {
+        if(input.getValueType() == JsonPathExpressionNodeEvalResult::valueString) {
+            return input.getStringValue().size();
+        }
+        
         if(input.nodeList.size() == 1) {
             if(const json::ContainerNode *container = dynamic_cast<json::ContainerNode*>(input.nodeList.front())) {
                 return container->getChildCount();
@@ -948,6 +701,10 @@ namespace json_path_functions {
 
     JsonPathExpressionNodeEvalResult toarray(const JsonPathExpressionNodeEvalResult &input) {
         std::unique_ptr<json::ArrayNode> result = make_unique<json::ArrayNode>();
+        if(input.isScalar()) {
+            result->domAddElementNode(input.createScalarNode());
+        }
+        
         std::for_each(input.nodeList.begin(), input.nodeList.end(), [&result](json::Node* node) {
             result->domAddElementNode(node->clone());
         });
@@ -9,14 +9,17 @@
 #define JsonPathExpressionNode_hpp
 
 #include <list>
+#include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <map>
 
 #include "reader.h"
 
 struct JsonPathExpressionOptions;
+class JsonPathPlanBuilder;
 
 struct JsonPathExpressionNodeEvalContext {
     json::Node *rootNode;
@@ -25,10 +28,20 @@ struct JsonPathExpressionNodeEvalContext {
     JsonPathExpressionOptions *options;
 } ;
 
-typedef std::list<json::Node *> JsonPathResultNodeList;
+typedef std::vector<json::Node *> JsonPathResultNodeList;
 
 class JsonPathExpressionNodeEvalResult {
 public:
+    // Scalars computed during evaluation are held inline; nodes are only created for
+    // them when they escape into a result set (see materialize)
+    enum ValueType : unsigned char {
+        valueNodeList,
+        valueNull,
+        valueBoolean,
+        valueNumber,
+        valueString
+    };
+
     JsonPathResultNodeList nodeList;
     bool getTruthValue() const;
     double getNumericValue() const;
@@ -45,16 +58,42 @@ public:
         return dynamic_cast<T*>(nodeList.front());
     }
 
+    ValueType getValueType() const { return _valueType; }
+    bool isScalar() const { return _valueType != valueNodeList; }
+
+    bool getBooleanValue() const { return _booleanValue; }
+    double getNumberValue() const { return _numberValue; }
+    std::wstring_view getStringValue() const { return _stringValue; }
+
+    // Creates a node holding the inline scalar value
+    json::Node *createScalarNode() const;
+
+    // Replaces an inline scalar with an owned node in nodeList
+    void materialize();
+
+    // Makes this a single non-owned node result, keeping the node buffer's capacity
+    void assignNode(json::Node *node);
+
 public:
-    std::list<std::shared_ptr<json::Node>> localOwners;
+    std::vector<std::shared_ptr<json::Node>> localOwners;
     
 public:
     static JsonPathExpressionNodeEvalResult booleanResult(bool r);
     static JsonPathExpressionNodeEvalResult nullResult();
     static JsonPathExpressionNodeEvalResult doubleResult(double result);
     static JsonPathExpressionNodeEvalResult stringResult(const std::wstring &result);
+    static JsonPathExpressionNodeEvalResult stringViewResult(std::wstring_view result);
     static JsonPathExpressionNodeEvalResult nonOwnedNodeResult(json::Node *node);
     static JsonPathExpressionNodeEvalResult ownedNodeResult(json::Node *node);
+
+private:
+    ValueType _valueType = valueNodeList;
+    bool _booleanValue = false;
+    double _numberValue = 0;
+
+    // Views either a string that outlives the evaluation (DOM, plan literals) or _ownedString
+    std::wstring_view _stringValue;
+    std::shared_ptr<const std::wstring> _ownedString;
 } ;
 
 class JsonPathExpressionNode;
@@ -76,14 +115,17 @@ class JsonPathExpressionNode: public JsonPathInspectable {
 public:
     virtual ~JsonPathExpressionNode() {}
 
-    virtual JsonPathExpressionNodeEvalResult evaluate(JsonPathExpressionNodeEvalContext &context) = 0;
+    // Emits plan code leaving the node's value in resultRegister
+    virtual void lower(JsonPathPlanBuilder &builder, int resultRegister) const = 0;
     
 } ;
 
 class JsonPathExpressionNodeNavPipelineStep: public JsonPathInspectable {
 public:
     virtual ~JsonPathExpressionNodeNavPipelineStep() {}
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node) {} // TODO PURE
+
+    // Emits plan code replacing the node list in nodesRegister by the step's result
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const = 0;
     
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const {}
 };
@@ -94,7 +136,7 @@ public:
     JsonPathExpressionNodeContextMemberName();
     
     virtual void inspect(std::ostream &out) const;
-    virtual JsonPathExpressionNodeEvalResult evaluate(JsonPathExpressionNodeEvalContext &context);
+    virtual void lower(JsonPathPlanBuilder &builder, int resultRegister) const;
 
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const {};
     
@@ -113,7 +155,7 @@ public:
     void addStep(std::unique_ptr<JsonPathExpressionNodeNavPipelineStep> &&node);
         
     virtual void inspect(std::ostream &out) const;
-    virtual JsonPathExpressionNodeEvalResult evaluate(JsonPathExpressionNodeEvalContext &context);
+    virtual void lower(JsonPathPlanBuilder &builder, int resultRegister) const;
 
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const;
     
@@ -129,7 +171,7 @@ public:
     JsonPathExpressionNodeNavRecurse(const std::wstring &name);
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
     
 private:
     std::wstring _name;
@@ -141,7 +183,7 @@ public:
     JsonPathExpressionNodeNavResolveName(const std::wstring &name);
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 
 private:
     std::wstring _name;
@@ -152,7 +194,7 @@ public:
     JsonPathExpressionNodeNavParent(bool allAncestors);
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 
 private:
     bool _allAncestors;
@@ -163,7 +205,7 @@ public:
     JsonPathExpressionNodeNavAllChildren();
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 };
 
 class JsonPathExpressionNodeNavIndexArray: public JsonPathExpressionNodeNavPipelineStep {
@@ -171,7 +213,7 @@ public:
     JsonPathExpressionNodeNavIndexArray(int index);
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 
 private:
     int _index;
@@ -183,7 +225,7 @@ public:
     JsonPathExpressionNodeNavSliceArray(int startIndex, bool startInverted, int endIndex, bool endInverted);
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 
 private:
     int _startIndex;
@@ -199,7 +241,7 @@ public:
     JsonPathExpressionNodeNavIndexArrayByList(const std::list<int> &indexList);
             
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 
 private:
     std::list<int> _indexList;
@@ -212,7 +254,7 @@ public:
     JsonPathExpressionNodeFilter(std::unique_ptr<JsonPathExpressionNode> &&filter, bool filterChildren);
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const;
 private:
@@ -227,40 +269,38 @@ public:
     JsonPathExpressionNodeIndexByExpression(std::unique_ptr<JsonPathExpressionNode> &&filter);
     
     virtual void inspect(std::ostream &out) const;
-    virtual void stepFromNode(JsonPathExpressionNodeEvalContext &context, JsonPathExpressionNodeEvalResult &node);
+    virtual void lower(JsonPathPlanBuilder &builder, int nodesRegister) const;
 
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const;
 private:
     std::unique_ptr<JsonPathExpressionNode> _filter;
 };
 
-using expr_operand_value = JsonPathExpressionNodeEvalResult;
-using binary_operator_fn = std::function<expr_operand_value(expr_operand_value, expr_operand_value)>;
-using binary_operator_and_operand = std::tuple<binary_operator_fn, std::unique_ptr<JsonPathExpressionNode>>;
-
-namespace JsonPathExpressionNodeBinaryOperators {
-    expr_operand_value logicalOr(expr_operand_value opLeft,  expr_operand_value opRight);
-    expr_operand_value logicalAnd(expr_operand_value opLeft,  expr_operand_value opRight);
-
-    expr_operand_value relEq(expr_operand_value opLeft,  expr_operand_value opRight);
-    expr_operand_value relNeq(expr_operand_value opLeft,  expr_operand_value opRight);
-
-    expr_operand_value relGte(json::Node *opLeft, json::Node *opRight);
-    expr_operand_value relLte(json::Node *opLeft, json::Node *opRight);
-    expr_operand_value relGt(json::Node *opLeft, json::Node *opRight);
-    expr_operand_value relLt(json::Node *opLeft, json::Node *opRight);
-    expr_operand_value relIn(json::Node *opLeft, json::ArrayNode *right);
-    expr_operand_value relNotIn(json::Node *opLeft, json::ArrayNode *right);
-    expr_operand_value relSubsetOf(json::ArrayNode *left, json::ArrayNode *right);
-    expr_operand_value relAnyOf(json::ArrayNode *left, json::ArrayNode *right);
-    expr_operand_value relNoneOf(json::ArrayNode *left, json::ArrayNode *right);
+enum class JsonPathBinaryOperator {
+    logicalOr,
+    logicalAnd,
+
+    relEq,
+    relNeq,
+
+    relGte,
+    relLte,
+    relGt,
+    relLt,
+    relIn,
+    relNotIn,
+    relSubsetOf,
+    relAnyOf,
+    relNoneOf,
+
+    add,
+    div,
+    mul,
+    mod,
+    subtract
+};
 
-    expr_operand_value add(expr_operand_value opLeft,  expr_operand_value opRight);
-    expr_operand_value div(json::NumberNode *opLeft,  json::NumberNode *opRight);
-    expr_operand_value mul(json::NumberNode *opLeft,  json::NumberNode *opRight);
-    expr_operand_value mod(json::NumberNode *opLeft,  json::NumberNode *opRight);
-    expr_operand_value subtract(json::NumberNode *opLeft,  json::NumberNode *opRight);
-}
+using binary_operator_and_operand = std::tuple<JsonPathBinaryOperator, std::unique_ptr<JsonPathExpressionNode>>;
 
 
 class JsonPathExpressionNodeBinaryOp: public JsonPathExpressionNode {
@@ -268,7 +308,7 @@ public:
     JsonPathExpressionNodeBinaryOp(std::unique_ptr<JsonPathExpressionNode> &&leftMost, std::list<binary_operator_and_operand> &operands);
     
     virtual void inspect(std::ostream &out) const;
-    virtual JsonPathExpressionNodeEvalResult evaluate(JsonPathExpressionNodeEvalContext &context);
+    virtual void lower(JsonPathPlanBuilder &builder, int resultRegister) const;
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const;
     
 private:
@@ -282,7 +322,7 @@ public:
     JsonPathExpressionNodeNegateOp(std::unique_ptr<JsonPathExpressionNode> &&operand);
     
     virtual void inspect(std::ostream &out) const;
-    virtual JsonPathExpressionNodeEvalResult evaluate(JsonPathExpressionNodeEvalContext &context);
+    virtual void lower(JsonPathPlanBuilder &builder, int resultRegister) const;
     
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const;
 private:
@@ -295,7 +335,7 @@ public:
     JsonPathExpressionNodeJsonLiteral(std::unique_ptr<json::Node> literal);
     
     virtual void inspect(std::ostream &out) const;
-    virtual JsonPathExpressionNodeEvalResult evaluate(JsonPathExpressionNodeEvalContext &context);
+    virtual void lower(JsonPathPlanBuilder &builder, int resultRegister) const;
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const {}
     
 private:
@@ -316,7 +356,7 @@ public:
     JsonPathExpressionNodeFunctionInvoke(JsonPathExpressionFunction *fn, std::list<std::unique_ptr<JsonPathExpressionNode>> &&args);
     
     virtual void inspect(std::ostream &out) const;
-    virtual JsonPathExpressionNodeEvalResult evaluate(JsonPathExpressionNodeEvalContext &context);
+    virtual void lower(JsonPathPlanBuilder &builder, int resultRegister) const;
     virtual void pushDirectDependentNodes(std::list<const JsonPathExpressionNode*> &output) const;
     
 private:
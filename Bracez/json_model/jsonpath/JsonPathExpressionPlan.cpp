@@ -0,0 +1,1409 @@
+//
+//  JsonPathExpressionPlan.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "JsonPathExpressionPlan.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "PathSummary.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <unordered_map>
+
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#endif
+
+/*
+ * Lowering
+ */
+std::shared_ptr<const JsonPathExpressionPlan> JsonPathExpressionPlan::lower(const JsonPathExpressionNode &rootNode) {
+    std::shared_ptr<JsonPathExpressionPlan> plan = std::make_shared<JsonPathExpressionPlan>();
+    JsonPathPlanBuilder builder(*plan);
+
+    plan->_resultRegister = builder.allocRegister();
+    rootNode.lower(builder, plan->_resultRegister);
+    plan->analyze();
+
+    return plan;
+}
+
+void JsonPathExpressionPlan::analyze() {
+    std::wostringstream form;
+    for(const JsonPathPlanInstruction &instr: _code) {
+        form << (int)instr.op << L' ' << instr.dest << L' ' << instr.a << L' ' << instr.b << L' ';
+        switch(instr.op) {
+            case JsonPathPlanOp::navName:
+            case JsonPathPlanOp::navRecurseName:
+                form << json::jsonizeString(_names[instr.arg]);
+                break;
+
+            case JsonPathPlanOp::loadLiteral: {
+                std::wstring literalText;
+                _literals[instr.arg]->calculateJsonTextRepresentation(literalText);
+                form << literalText;
+                break;
+            }
+
+            case JsonPathPlanOp::navSlice: {
+                const JsonPathPlanSlice &slice = _slices[instr.arg];
+                form << (slice.startInverted ? L"-" : L"") << slice.startIndex << L':'
+                     << (slice.endInverted ? L"-" : L"") << slice.endIndex;
+                break;
+            }
+
+            case JsonPathPlanOp::navIndexList:
+                for(int index: _indexLists[instr.arg]) {
+                    form << index << L',';
+                }
+                break;
+
+            case JsonPathPlanOp::call:
+                form << (const void*)_functions[instr.arg];
+                break;
+
+            default:
+                form << instr.arg;
+                break;
+        }
+        form << L';';
+    }
+    _normalizedForm = form.str();
+
+    // The main pipeline is all there is: it loads a start node, then only navigates it
+    _navigationPipeline = !_code.empty() && _code[0].op <= JsonPathPlanOp::loadCursor && _code[0].dest == _resultRegister;
+    for(size_t pc = 1; _navigationPipeline && pc < _code.size(); pc = nextStep(pc)) {
+        const JsonPathPlanInstruction &instr = _code[pc];
+        _navigationPipeline = instr.dest == _resultRegister &&
+                              instr.op >= JsonPathPlanOp::navName && instr.op <= JsonPathPlanOp::navIndexByExpression;
+    }
+
+    // Read scope: the start node, then name and index steps from it...
+    _readScopeLength = 0;
+    _downwardPipeline = false;
+    if(_code.empty() || (_code[0].op != JsonPathPlanOp::loadRoot && _code[0].op != JsonPathPlanOp::loadContext)) {
+        return;
+    }
+
+    auto isSingleStep = [this](const JsonPathPlanInstruction &instr) {
+        return instr.dest == _code[0].dest &&
+               (instr.op == JsonPathPlanOp::navName || instr.op == JsonPathPlanOp::navIndex ||
+                (instr.op == JsonPathPlanOp::navIndexList && _indexLists[instr.arg].size() == 1));
+    };
+
+    size_t scopeLength = 1;
+    while(scopeLength < _code.size() && isSingleStep(_code[scopeLength])) {
+        scopeLength++;
+    }
+
+    // ...unless anything else reads outside of the node being navigated or filtered. Outside of
+    // filter and subscript blocks the context is the root as well.
+    bool navigationOnly = _code[0].dest == _resultRegister;
+    std::vector<size_t> blockEnds;
+    for(size_t pc = 0; pc < _code.size(); pc++) {
+        while(!blockEnds.empty() && blockEnds.back() <= pc) {
+            blockEnds.pop_back();
+        }
+
+        const JsonPathPlanInstruction &instr = _code[pc];
+        switch(instr.op) {
+            case JsonPathPlanOp::navParent:
+            case JsonPathPlanOp::navAncestors:
+            case JsonPathPlanOp::loadCursor:
+                return;
+
+            case JsonPathPlanOp::loadRoot:
+                if(pc > 0) {
+                    return;
+                }
+                break;
+
+            case JsonPathPlanOp::loadContext:
+                if(pc > 0 && blockEnds.empty()) {
+                    return;
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        // The main pipeline only navigates the result register
+        if(pc > 0 && blockEnds.empty() &&
+           (instr.dest != _resultRegister || instr.op < JsonPathPlanOp::navName || instr.op > JsonPathPlanOp::navIndexByExpression)) {
+            navigationOnly = false;
+        }
+
+        if(instr.op == JsonPathPlanOp::navFilter || instr.op == JsonPathPlanOp::navFilterChildren ||
+           instr.op == JsonPathPlanOp::navIndexByExpression) {
+            blockEnds.push_back(pc + 1 + instr.a);
+        }
+    }
+
+    _readScopeLength = scopeLength;
+    _downwardPipeline = navigationOnly;
+}
+
+json::Node *JsonPathExpressionPlan::findReadScope(json::Node *root, JsonPathExpressionOptions *options) const {
+    if(_readScopeLength <= 1 || !root) {
+        return root;
+    }
+
+    JsonPathExpressionNodeEvalContext context = { root, root, NULL, options };
+    JsonPathPlanRegisters registers(_numRegisters);
+    run(0, _readScopeLength, context, registers);
+
+    const JsonPathResultNodeList &scope = registers[_code[0].dest].nodeList;
+    return scope.size() == 1 ? scope.front() : root;
+}
+
+int JsonPathPlanBuilder::allocRegisters(int count) {
+    int first = _plan._numRegisters;
+    _plan._numRegisters += count;
+    return first;
+}
+
+size_t JsonPathPlanBuilder::emit(JsonPathPlanOp op, int dest, int a, int b, int arg) {
+    _plan._code.push_back({ op, dest, a, b, arg });
+    return _plan._code.size() - 1;
+}
+
+int JsonPathPlanBuilder::addLiteral(const std::shared_ptr<json::Node> &literal) {
+    _plan._literals.push_back(literal);
+    return (int)_plan._literals.size() - 1;
+}
+
+int JsonPathPlanBuilder::addName(const std::wstring &name) {
+    auto existing = std::find(_plan._names.begin(), _plan._names.end(), name);
+    if(existing != _plan._names.end()) {
+        return (int)(existing - _plan._names.begin());
+    }
+
+    _plan._names.push_back(name);
+    return (int)_plan._names.size() - 1;
+}
+
+int JsonPathPlanBuilder::addSlice(const JsonPathPlanSlice &slice) {
+    _plan._slices.push_back(slice);
+    return (int)_plan._slices.size() - 1;
+}
+
+int JsonPathPlanBuilder::addIndexList(const std::list<int> &indexList) {
+    _plan._indexLists.push_back(std::vector<int>(indexList.begin(), indexList.end()));
+    return (int)_plan._indexLists.size() - 1;
+}
+
+int JsonPathPlanBuilder::addFunction(JsonPathExpressionFunction *fn) {
+    _plan._functions.push_back(fn);
+    return (int)_plan._functions.size() - 1;
+}
+
+/*
+ * Navigation steps
+ */
+
+// Moves a computed result into a register; a result without nodes takes over the
+// register's node buffer so the next navigation into it doesn't allocate
+static inline void storeResult(JsonPathExpressionNodeEvalResult &dest, JsonPathExpressionNodeEvalResult &&result) {
+    if(result.nodeList.capacity() == 0) {
+        result.nodeList.swap(dest.nodeList);
+        result.nodeList.clear();
+    }
+
+    dest = std::move(result);
+}
+
+static void loadStartNode(JsonPathExpressionNodeEvalResult &dest, json::Node *node) {
+    if(!node) {
+        throw JsonPathEvalError("Missing node for pipeline start");
+    }
+
+    dest.assignNode(node);
+}
+
+static void loadMemberName(JsonPathExpressionNodeEvalResult &dest, json::Node *contextNode) {
+    if(contextNode && contextNode->getParent()) {
+        int childIndex = contextNode->getParent()->getIndexOfChild(contextNode);
+        if(json::ObjectNode *onode = dynamic_cast<json::ObjectNode*>(contextNode->getParent())) {
+            storeResult(dest, JsonPathExpressionNodeEvalResult::stringViewResult(onode->getMemberNameAt(childIndex)));
+        } else {
+            storeResult(dest, JsonPathExpressionNodeEvalResult::doubleResult(childIndex));
+        }
+    } else {
+        storeResult(dest, JsonPathExpressionNodeEvalResult::nullResult());
+    }
+}
+
+// Scalar literals load inline, strings as views into the plan's literal node
+static void loadLiteral(JsonPathExpressionNodeEvalResult &dest, const std::shared_ptr<json::Node> &literal) {
+    typedef JsonPathExpressionNodeEvalResult R;
+
+    switch(literal->getNodeTypeId()) {
+        case json::ntNull:
+            storeResult(dest, R::nullResult());
+            break;
+
+        case json::ntBoolean:
+            storeResult(dest, R::booleanResult(static_cast<json::BooleanNode*>(literal.get())->getValue()));
+            break;
+
+        case json::ntNumber:
+            storeResult(dest, R::doubleResult(static_cast<json::NumberNode*>(literal.get())->getValue()));
+            break;
+
+        case json::ntString:
+            storeResult(dest, R::stringViewResult(static_cast<json::StringNode*>(literal.get())->getValue()));
+            break;
+
+        default: {
+            R result;
+            result.nodeList.push_back(literal.get());
+            result.localOwners.push_back(literal);
+            storeResult(dest, std::move(result));
+            break;
+        }
+    }
+}
+
+static void navigateToName(const JsonPathResultNodeList &nodes, const std::wstring &name, bool fuzzy, JsonPathResultNodeList &resultList) {
+    resultList.reserve(nodes.size());
+    for(json::Node *node: nodes) {
+        json::ObjectNode *obNode = dynamic_cast<json::ObjectNode*>(node);
+        if(!obNode) {
+            continue;
+        }
+
+        if(!fuzzy) {
+            int idx = obNode->getIndexOfMemberWithName(name);
+            if(idx != -1) {
+                resultList.push_back(obNode->getChildAt(idx));
+            }
+        } else {
+            int childCount = obNode->getChildCount();
+            for(int idx=0; idx<childCount; idx++) {
+                if(obNode->getMemberNameAt(idx).substr(0, name.length()) == name) {
+                    resultList.push_back(obNode->getChildAt(idx));
+                }
+            }
+        }
+    }
+}
+
+// `..name` from the member name index of node's document, if it has one, so the cost is in
+// the number of matches rather than the size of the subtree. Results are in BFS order, as a walk
+// would find them.
+static json::JsonFile *owningFile(json::Node *node) {
+    json::DocumentNode *document = node->getDocument();
+    return document ? document->getOwner() : NULL;
+}
+
+static bool navigateRecurseByIndex(json::Node *node, const std::wstring &name, JsonPathResultNodeList &resultList) {
+    json::JsonFile *file = owningFile(node);
+    const json::MemberNameIndex *index = file ? file->getMemberNameIndex() : NULL;
+    if(!index) {
+        return false;
+    }
+
+    // Objects come in document order; a stable sort by depth below node makes it BFS order
+    json::MemberNameIndex::ObjectRange objects = index->objectsWithMember(node, name);
+    std::vector<std::pair<int, json::ObjectNode*>> objectsByDepth;
+    objectsByDepth.reserve(objects.second - objects.first);
+    for(auto objectIter = objects.first; objectIter != objects.second; objectIter++) {
+        int depth = 0;
+        for(const json::Node *ancestor = *objectIter; ancestor && ancestor != node; ancestor = ancestor->getParent()) {
+            depth++;
+        }
+        objectsByDepth.emplace_back(depth, *objectIter);
+    }
+
+    std::stable_sort(objectsByDepth.begin(), objectsByDepth.end(), [](const auto &left, const auto &right) {
+        return left.first < right.first;
+    });
+
+    resultList.reserve(resultList.size() + objectsByDepth.size());
+    for(const auto &entry: objectsByDepth) {
+        resultList.push_back(entry.second->getChildAt(entry.second->getIndexOfMemberWithName(name)));
+    }
+
+    return true;
+}
+
+static void navigateRecurse(const JsonPathResultNodeList &nodes, const std::wstring *name, JsonPathResultNodeList &resultList) {
+    if(name && nodes.size() == 1 && navigateRecurseByIndex(nodes.front(), *name, resultList)) {
+        return;
+    }
+
+    // Without a name every visited node is a result, so the result list doubles as the BFS queue
+    JsonPathResultNodeList nameQueue;
+    JsonPathResultNodeList &bfsQueue = name ? nameQueue : resultList;
+    bfsQueue.insert(bfsQueue.end(), nodes.begin(), nodes.end());
+
+    // With a path summary, subtrees whose paths can't have a member by that name aren't visited.
+    // Each queued node has its summary entry, or NULL if it's not to be pruned.
+    json::JsonFile *file = name && !nodes.empty() ? owningFile(nodes.front()) : NULL;
+    const json::PathSummary *summary = file ? file->getPathSummary() : NULL;
+    std::vector<const json::PathSummaryEntry*> entryQueue;
+    std::unordered_map<const json::PathSummaryEntry*, bool> entryMayContainName;
+    if(summary) {
+        for(json::Node *node: nodes) {
+            entryQueue.push_back(summary->findEntry(node));
+        }
+    }
+
+    for(size_t queueIdx = 0; queueIdx < bfsQueue.size(); queueIdx++) {
+        // Get current node
+        json::Node *node = bfsQueue[queueIdx];
+        json::ObjectNode *obNode = dynamic_cast<json::ObjectNode*>(node);
+        const json::PathSummaryEntry *entry = summary ? entryQueue[queueIdx] : NULL;
+
+        // Add children to queue (for BFS)
+        json::ContainerNode *containerNode = dynamic_cast<json::ContainerNode*>(node);
+        if(containerNode) {
+            int childCount = containerNode->getChildCount();
+            for(int childIdx=0; childIdx<childCount; childIdx++) {
+                if(summary) {
+                    const json::PathSummaryEntry *childEntry = NULL;
+                    if(entry) {
+                        childEntry = obNode ? entry->getMember(obNode->getMemberNameAt(childIdx)) : entry->getElements();
+                    }
+
+                    if(childEntry) {
+                        auto mayContain = entryMayContainName.find(childEntry);
+                        if(mayContain == entryMayContainName.end()) {
+                            mayContain = entryMayContainName.emplace(childEntry, childEntry->mayContainMember(*name)).first;
+                        }
+                        if(!mayContain->second) {
+                            continue;
+                        }
+                    }
+
+                    entryQueue.push_back(childEntry);
+                }
+
+                bfsQueue.push_back(containerNode->getChildAt(childIdx));
+            }
+        }
+
+        if(name) {
+            // Resolve name
+            int idx = -1;
+            if(obNode) {
+                idx = obNode->getIndexOfMemberWithName(*name);
+            }
+            if(idx != -1) {
+                resultList.push_back(obNode->getChildAt(idx));
+            }
+        }
+    }
+}
+
+static void navigateToParent(const JsonPathResultNodeList &nodes, bool allAncestors, JsonPathResultNodeList &resultList) {
+    resultList.reserve(nodes.size());
+    for(json::Node *node: nodes) {
+        if(node->getParent()) {
+            node = node->getParent();
+            resultList.push_back(node);
+        }
+
+        if(allAncestors) {
+            while(node->getParent()) {
+                node = node->getParent();
+                resultList.push_back(node);
+            }
+        }
+    }
+}
+
+static void navigateToChildren(const JsonPathResultNodeList &nodes, JsonPathResultNodeList &resultList) {
+    for(json::Node *node: nodes) {
+        json::ContainerNode *contNode = dynamic_cast<json::ContainerNode*>(node);
+        if(contNode) {
+            int ccount = contNode->getChildCount();
+            for(int idx=0; idx<ccount; idx++) {
+                resultList.push_back(contNode->getChildAt(idx));
+            }
+        }
+    }
+}
+
+static void navigateToIndex(const JsonPathResultNodeList &nodes, int index, JsonPathResultNodeList &resultList) {
+    resultList.reserve(nodes.size());
+    for(json::Node *node: nodes) {
+        json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
+        if(arrNode && index < arrNode->getChildCount()) {
+            resultList.push_back(arrNode->getChildAt(index));
+        }
+    }
+}
+
+static void navigateToSlice(const JsonPathResultNodeList &nodes, const JsonPathPlanSlice &slice, JsonPathResultNodeList &resultList) {
+    for(json::Node *node: nodes) {
+        json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
+        if(arrNode) {
+            int childCount = arrNode->getChildCount();
+
+            int start = slice.startIndex;
+            int end = slice.endIndex;
+
+            if(slice.startInverted) start = childCount - start;
+            if(slice.endInverted) end = childCount - end;
+
+            for(int idx=std::max(start, 0); idx < end && idx < childCount; idx++) {
+                resultList.push_back(arrNode->getChildAt(idx));
+            }
+        }
+    }
+}
+
+static void navigateToIndexList(const JsonPathResultNodeList &nodes, const std::vector<int> &indexList, JsonPathResultNodeList &resultList) {
+    for(json::Node *node: nodes) {
+        json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
+        if(arrNode) {
+            int arrLen = arrNode->getChildCount();
+            for(int index: indexList) {
+                if(index < arrLen) {
+                    resultList.push_back(arrNode->getChildAt(index));
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Operators
+ */
+
+// A single operand value: inline scalars and leaf nodes are unpacked, containers are kept as nodes
+struct JsonPathPlanValue {
+    JsonPathExpressionNodeEvalResult::ValueType type;
+    bool booleanValue;
+    double numberValue;
+    std::wstring_view stringValue;
+    json::Node *node;
+};
+
+enum JsonPathPlanOrdering {
+    orderLess,
+    orderEqual,
+    orderGreater,
+    orderNone
+};
+
+static void valueOfNode(json::Node *node, JsonPathPlanValue &value) {
+    typedef JsonPathExpressionNodeEvalResult R;
+
+    value.node = node;
+    switch(node->getNodeTypeId()) {
+        case json::ntNull:
+            value.type = R::valueNull;
+            break;
+
+        case json::ntBoolean:
+            value.type = R::valueBoolean;
+            value.booleanValue = static_cast<json::BooleanNode*>(node)->getValue();
+            break;
+
+        case json::ntNumber:
+            value.type = R::valueNumber;
+            value.numberValue = static_cast<json::NumberNode*>(node)->getValue();
+            break;
+
+        case json::ntString:
+            value.type = R::valueString;
+            value.stringValue = static_cast<json::StringNode*>(node)->getValue();
+            break;
+
+        default:
+            value.type = R::valueNodeList;
+            break;
+    }
+}
+
+// Unpacks a result holding exactly one value; false for empty or multi-node results
+static bool singleValue(const JsonPathExpressionNodeEvalResult &result, JsonPathPlanValue &value) {
+    if(result.isScalar()) {
+        value.type = result.getValueType();
+        value.booleanValue = result.getBooleanValue();
+        value.numberValue = result.getNumberValue();
+        value.stringValue = result.getStringValue();
+        value.node = NULL;
+        return true;
+    }
+
+    if(result.nodeList.size() != 1 || !result.nodeList.front()) {
+        return false;
+    }
+
+    valueOfNode(result.nodeList.front(), value);
+    return true;
+}
+
+// Orders two values the way json::Node::valueLt / valueEquals would
+template<class T>
+static inline JsonPathPlanOrdering orderOf(const T &left, const T &right) {
+    return left < right ? orderLess :
+           right < left ? orderGreater :
+           left == right ? orderEqual : orderNone;
+}
+
+static JsonPathPlanOrdering compareValues(const JsonPathPlanValue &left, const JsonPathPlanValue &right) {
+    typedef JsonPathExpressionNodeEvalResult R;
+
+    if(left.type != right.type) {
+        return orderNone;
+    }
+
+    switch(left.type) {
+        case R::valueNull:
+            return orderEqual;
+
+        case R::valueBoolean:
+            return orderOf(left.booleanValue, right.booleanValue);
+
+        case R::valueNumber:
+            return orderOf(left.numberValue, right.numberValue);
+
+        case R::valueString:
+            return orderOf(left.stringValue, right.stringValue);
+
+        case R::valueNodeList:
+            break;
+    }
+
+    return left.node->valueEquals(right.node) ? orderEqual : orderNone;
+}
+
+static bool isEqual(const JsonPathExpressionNodeEvalResult &opLeft, const JsonPathExpressionNodeEvalResult &opRight) {
+    if(opLeft.isScalar() || opRight.isScalar()) {
+        JsonPathPlanValue left, right;
+        return singleValue(opLeft, left) && singleValue(opRight, right) && compareValues(left, right) == orderEqual;
+    }
+
+    const JsonPathResultNodeList &leftNodes = opLeft.nodeList;
+    const JsonPathResultNodeList &rightNodes = opRight.nodeList;
+
+    if(leftNodes.size() != rightNodes.size()) {
+        return false;
+    }
+
+    for(auto liter = leftNodes.begin(),
+             riter = rightNodes.begin();
+        liter != leftNodes.end() && riter != rightNodes.end();
+        liter++, riter++) {
+        if(!(*liter)->valueEquals(*riter)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static inline bool isIn(const JsonPathPlanValue &left, json::ArrayNode *right) {
+    return std::find_if(right->begin(), right->end(), [&left](std::unique_ptr<json::Node> &n) {
+        JsonPathPlanValue element;
+        valueOfNode(n.get(), element);
+        return compareValues(element, left) == orderEqual;
+    }) != right->end();
+}
+
+static inline bool isIn(json::Node *left, json::ArrayNode *right) {
+    return std::find_if(right->begin(), right->end(), [left](std::unique_ptr<json::Node> &n) {
+        return n->valueEquals(left);
+    }) != right->end();
+}
+
+static inline bool isAnyOf(json::ArrayNode *left, json::ArrayNode *right) {
+    return std::find_if(left->begin(), left->end(), [right](std::unique_ptr<json::Node> &node) {
+        return isIn(node.get(), right);
+    }) != left->end();
+}
+
+static inline json::ArrayNode *singleArray(const JsonPathExpressionNodeEvalResult &result) {
+    if(result.isScalar() || result.nodeList.size() != 1) {
+        return NULL;
+    }
+
+    return dynamic_cast<json::ArrayNode*>(result.nodeList.front());
+}
+
+// Compares single-value operands; anything else yields null
+template<class OP>
+static inline JsonPathExpressionNodeEvalResult relationalOperator(const JsonPathExpressionNodeEvalResult &l,
+                                                                  const JsonPathExpressionNodeEvalResult &r,
+                                                                  OP op) {
+    JsonPathPlanValue left, right;
+    if(singleValue(l, left) && singleValue(r, right)) {
+        return JsonPathExpressionNodeEvalResult::booleanResult(op(compareValues(left, right)));
+    }
+
+    return JsonPathExpressionNodeEvalResult::nullResult();
+}
+
+// Applies op to array operands; anything else yields null
+template<class OP>
+static inline JsonPathExpressionNodeEvalResult arrayOperator(const JsonPathExpressionNodeEvalResult &l,
+                                                             const JsonPathExpressionNodeEvalResult &r,
+                                                             OP op) {
+    json::ArrayNode *left = singleArray(l);
+    json::ArrayNode *right = singleArray(r);
+    if(left && right) {
+        return JsonPathExpressionNodeEvalResult::booleanResult(op(left, right));
+    }
+
+    return JsonPathExpressionNodeEvalResult::nullResult();
+}
+
+// Applies op to numeric operands; anything else yields null
+template<class OP>
+static inline JsonPathExpressionNodeEvalResult numericOperator(const JsonPathExpressionNodeEvalResult &l,
+                                                               const JsonPathExpressionNodeEvalResult &r,
+                                                               OP op) {
+    typedef JsonPathExpressionNodeEvalResult R;
+
+    JsonPathPlanValue left, right;
+    if(singleValue(l, left) && singleValue(r, right) && left.type == R::valueNumber && right.type == R::valueNumber) {
+        return R::doubleResult(op(left.numberValue, right.numberValue));
+    }
+
+    return R::nullResult();
+}
+
+static std::wstring valueToString(const JsonPathPlanValue &value) {
+    typedef JsonPathExpressionNodeEvalResult R;
+
+    switch(value.type) {
+        case R::valueNull:
+            return L"null";
+
+        case R::valueBoolean:
+            return value.booleanValue ? L"true" : L"false";
+
+        case R::valueNumber:
+            return std::to_wstring(value.numberValue);
+
+        case R::valueString:
+            return std::wstring(value.stringValue);
+
+        case R::valueNodeList:
+            break;
+    }
+
+    return value.node->toString();
+}
+
+static JsonPathExpressionNodeEvalResult add(const JsonPathExpressionNodeEvalResult &opLeft, const JsonPathExpressionNodeEvalResult &opRight) {
+    typedef JsonPathExpressionNodeEvalResult R;
+
+    JsonPathPlanValue left, right;
+    if(!singleValue(opLeft, left) || !singleValue(opRight, right)) {
+        return R::nullResult();
+    }
+
+    if(left.type == R::valueNumber && right.type == R::valueNumber) {
+        return R::doubleResult(left.numberValue + right.numberValue);
+    } else
+    if(left.type == R::valueString) {
+        return R::stringResult(std::wstring(left.stringValue) + valueToString(right));
+    } else
+    if(json::ArrayNode *arrLeft = singleArray(opLeft)) {
+        json::ArrayNode *arrResult = arrLeft->clone();
+
+        if(json::ArrayNode *arrRight = singleArray(opRight)) {
+            for(auto iter = arrRight->begin(); iter != arrRight->end(); iter++) {
+                arrResult->domAddElementNode((*iter)->clone());
+            }
+        } else {
+            arrResult->domAddElementNode(right.node ? right.node->clone() : opRight.createScalarNode());
+        }
+
+        return R::ownedNodeResult(arrResult);
+    }
+
+    return R::nullResult();
+}
+
+static JsonPathExpressionNodeEvalResult binaryOperator(JsonPathPlanOp op,
+                                                       const JsonPathExpressionNodeEvalResult &l,
+                                                       const JsonPathExpressionNodeEvalResult &r) {
+    typedef JsonPathExpressionNodeEvalResult R;
+
+    switch(op) {
+        case JsonPathPlanOp::relEq:
+            return R::booleanResult(isEqual(l, r));
+
+        case JsonPathPlanOp::relNeq:
+            return R::booleanResult(!isEqual(l, r));
+
+        case JsonPathPlanOp::relGte:
+            return relationalOperator(l, r, [](JsonPathPlanOrdering o) { return o == orderGreater || o == orderEqual; });
+
+        case JsonPathPlanOp::relLte:
+            return relationalOperator(l, r, [](JsonPathPlanOrdering o) { return o == orderLess || o == orderEqual; });
+
+        case JsonPathPlanOp::relGt:
+            return relationalOperator(l, r, [](JsonPathPlanOrdering o) { return o == orderGreater; });
+
+        case JsonPathPlanOp::relLt:
+            return relationalOperator(l, r, [](JsonPathPlanOrdering o) { return o == orderLess; });
+
+        case JsonPathPlanOp::relIn:
+        case JsonPathPlanOp::relNotIn: {
+            JsonPathPlanValue left;
+            json::ArrayNode *right = singleArray(r);
+            if(!singleValue(l, left) || !right) {
+                return R::nullResult();
+            }
+
+            return R::booleanResult(isIn(left, right) == (op == JsonPathPlanOp::relIn));
+        }
+
+        case JsonPathPlanOp::relSubsetOf:
+            return arrayOperator(l, r, [](json::ArrayNode *left, json::ArrayNode *right) {
+                return std::find_if_not(left->begin(), left->end(), [right](std::unique_ptr<json::Node> &node) {
+                    return isIn(node.get(), right);
+                }) == left->end();
+            });
+
+        case JsonPathPlanOp::relAnyOf:
+            return arrayOperator(l, r, [](json::ArrayNode *left, json::ArrayNode *right) {
+                return isAnyOf(left, right);
+            });
+
+        case JsonPathPlanOp::relNoneOf:
+            return arrayOperator(l, r, [](json::ArrayNode *left, json::ArrayNode *right) {
+                return !isAnyOf(left, right);
+            });
+
+        case JsonPathPlanOp::add:
+            return add(l, r);
+
+        case JsonPathPlanOp::div:
+            return numericOperator(l, r, [](double left, double right) { return left / right; });
+
+        case JsonPathPlanOp::mul:
+            return numericOperator(l, r, [](double left, double right) { return left * right; });
+
+        case JsonPathPlanOp::mod:
+            return numericOperator(l, r, [](double left, double right) { return (double)((long)left % (long)right); });
+
+        case JsonPathPlanOp::subtract:
+            return numericOperator(l, r, [](double left, double right) { return left - right; });
+
+        default:
+            throw JsonPathEvalError("Invalid binary operator");
+    }
+}
+
+/*
+ * Parallel filters
+ */
+static void defaultParallelFor(size_t count, const std::function<void (size_t)> &body) {
+#if defined(__APPLE__)
+    dispatch_apply_f(count, DISPATCH_APPLY_AUTO, (void*)&body, [](void *bodyPtr, size_t idx) {
+        (*(const std::function<void (size_t)>*)bodyPtr)(idx);
+    });
+#else
+    // Workers claim indices from a shared counter, so idle ones pick up the slack
+    std::atomic<size_t> nextIdx(0);
+    auto worker = [&nextIdx, count, &body]() {
+        for(size_t idx = nextIdx++; idx < count; idx = nextIdx++) {
+            body(idx);
+        }
+    };
+
+    size_t numThreads = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for(size_t threadIdx = 1; threadIdx < numThreads; threadIdx++) {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+    for(std::thread &thread: threads) {
+        thread.join();
+    }
+#endif
+}
+
+void JsonPathExpressionPlan::filterInParallel(size_t begin, size_t end, int predicateRegister,
+                                              const JsonPathResultNodeList &candidates,
+                                              const JsonPathExpressionNodeEvalContext &context,
+                                              JsonPathResultNodeList &resultList) const {
+    // More partitions than cores, so uneven predicate costs even out
+    size_t numPartitions = std::min<size_t>(candidates.size(), std::max(1u, std::thread::hardware_concurrency()) * 4);
+    size_t partitionSize = (candidates.size() + numPartitions - 1) / numPartitions;
+
+    // Nested filters within a partition run sequentially
+    JsonPathExpressionOptions partitionOptions = *context.options;
+    partitionOptions.parallel = false;
+
+    std::vector<JsonPathResultNodeList> partitionResults(numPartitions);
+    std::vector<std::exception_ptr> partitionErrors(numPartitions);
+
+    auto filterPartition = [&](size_t partition) {
+        try {
+            // Each partition evaluates with its own registers and context
+            JsonPathExpressionNodeEvalContext partitionContext = context;
+            partitionContext.options = &partitionOptions;
+            JsonPathPlanRegisters registers(_numRegisters);
+
+            auto first = candidates.begin() + partition * partitionSize;
+            auto last = candidates.begin() + std::min(candidates.size(), (partition + 1) * partitionSize);
+            for(auto iter = first; iter != last; iter++) {
+                partitionContext.contextNode = *iter;
+                run(begin, end, partitionContext, registers);
+                if(registers[predicateRegister].getTruthValue()) {
+                    partitionResults[partition].push_back(*iter);
+                }
+            }
+        } catch(...) {
+            partitionErrors[partition] = std::current_exception();
+        }
+    };
+
+    if(context.options->parallelFor) {
+        context.options->parallelFor(numPartitions, filterPartition);
+    } else {
+        defaultParallelFor(numPartitions, filterPartition);
+    }
+
+    // Report the error the sequential evaluation would have hit first
+    for(std::exception_ptr &error: partitionErrors) {
+        if(error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Partitions are in candidate order, so concatenating keeps document order
+    size_t numResults = 0;
+    for(JsonPathResultNodeList &partitionResult: partitionResults) {
+        numResults += partitionResult.size();
+    }
+
+    resultList.reserve(numResults);
+    for(JsonPathResultNodeList &partitionResult: partitionResults) {
+        resultList.insert(resultList.end(), partitionResult.begin(), partitionResult.end());
+    }
+}
+
+/*
+ * Interpreter
+ */
+JsonPathExpressionNodeEvalResult JsonPathExpressionPlan::execute(JsonPathExpressionNodeEvalContext &context) const {
+    JsonPathPlanRegisters registers(_numRegisters);
+    run(0, _code.size(), context, registers);
+
+    // Scalars escape into the result set as nodes
+    JsonPathExpressionNodeEvalResult result = std::move(registers[_resultRegister]);
+    result.materialize();
+    return result;
+}
+
+void JsonPathExpressionPlan::run(size_t begin, size_t end, JsonPathExpressionNodeEvalContext &context, JsonPathPlanRegisters &registers) const {
+    size_t pc = begin;
+    while(pc < end) {
+        const JsonPathPlanInstruction &instr = _code[pc++];
+        JsonPathExpressionNodeEvalResult &dest = registers[instr.dest];
+        JsonPathResultNodeList &resultList = registers.spareList(instr.dest);
+
+        switch(instr.op) {
+            case JsonPathPlanOp::loadRoot:
+                loadStartNode(dest, context.rootNode);
+                break;
+
+            case JsonPathPlanOp::loadContext:
+                loadStartNode(dest, context.contextNode);
+                break;
+
+            case JsonPathPlanOp::loadCursor:
+                loadStartNode(dest, context.cursorNode);
+                break;
+
+            case JsonPathPlanOp::loadLiteral:
+                loadLiteral(dest, _literals[instr.arg]);
+                break;
+
+            case JsonPathPlanOp::loadMemberName:
+                loadMemberName(dest, context.contextNode);
+                break;
+
+            case JsonPathPlanOp::navName:
+                navigateToName(dest.nodeList, _names[instr.arg], context.options && context.options->fuzzy, resultList);
+                break;
+
+            case JsonPathPlanOp::navRecurseName:
+                navigateRecurse(dest.nodeList, &_names[instr.arg], resultList);
+                break;
+
+            case JsonPathPlanOp::navRecurseAll:
+                navigateRecurse(dest.nodeList, NULL, resultList);
+                break;
+
+            case JsonPathPlanOp::navParent:
+            case JsonPathPlanOp::navAncestors:
+                navigateToParent(dest.nodeList, instr.op == JsonPathPlanOp::navAncestors, resultList);
+                break;
+
+            case JsonPathPlanOp::navChildren:
+                navigateToChildren(dest.nodeList, resultList);
+                break;
+
+            case JsonPathPlanOp::navIndex:
+                navigateToIndex(dest.nodeList, instr.arg, resultList);
+                break;
+
+            case JsonPathPlanOp::navSlice:
+                navigateToSlice(dest.nodeList, _slices[instr.arg], resultList);
+                break;
+
+            case JsonPathPlanOp::navIndexList:
+                navigateToIndexList(dest.nodeList, _indexLists[instr.arg], resultList);
+                break;
+
+            case JsonPathPlanOp::navFilter:
+            case JsonPathPlanOp::navFilterChildren: {
+                if(context.options && context.options->parallel) {
+                    JsonPathResultNodeList children;
+                    const JsonPathResultNodeList *candidates = &dest.nodeList;
+                    if(instr.op == JsonPathPlanOp::navFilterChildren) {
+                        navigateToChildren(dest.nodeList, children);
+                        candidates = &children;
+                    }
+
+                    // Partitions only read the DOM. The one cache lookups write to,
+                    // ContainerNode's last found child, is atomic; anything else a filter
+                    // evaluation caches in the DOM must be too
+                    if(!candidates->empty() && candidates->size() >= context.options->parallelThreshold) {
+                        filterInParallel(pc, pc + instr.a, instr.b, *candidates, context, resultList);
+                        pc += instr.a;
+                        break;
+                    }
+                }
+
+                json::Node *oldContext = context.contextNode;
+                auto filterNode = [this, &instr, pc, &context, &registers, &resultList](json::Node *node) {
+                    context.contextNode = node;
+                    run(pc, pc + instr.a, context, registers);
+                    if(registers[instr.b].getTruthValue()) {
+                        resultList.push_back(node);
+                    }
+                };
+
+                for(json::Node *node: dest.nodeList) {
+                    if(instr.op == JsonPathPlanOp::navFilterChildren) {
+                        json::ContainerNode *contNode = dynamic_cast<json::ContainerNode*>(node);
+                        if(contNode) {
+                            int ccount = contNode->getChildCount();
+                            for(int idx=0; idx<ccount; idx++) {
+                                filterNode(contNode->getChildAt(idx));
+                            }
+                        }
+                    } else {
+                        filterNode(node);
+                    }
+                }
+
+                context.contextNode = oldContext;
+                pc += instr.a;
+                break;
+            }
+
+            case JsonPathPlanOp::navIndexByExpression: {
+                json::Node *oldContext = context.contextNode;
+                for(json::Node *node: dest.nodeList) {
+                    json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
+                    if(arrNode) {
+                        context.contextNode = arrNode;
+                        run(pc, pc + instr.a, context, registers);
+
+                        int index = (int)registers[instr.b].getNumericValue();
+                        if(index < arrNode->getChildCount() && index >= 0) {
+                            resultList.push_back(arrNode->getChildAt(index));
+                        }
+                    }
+                }
+
+                context.contextNode = oldContext;
+                pc += instr.a;
+                break;
+            }
+
+            case JsonPathPlanOp::jumpIfTrue:
+                if(dest.getTruthValue()) {
+                    pc = instr.arg;
+                }
+                break;
+
+            case JsonPathPlanOp::jumpIfFalse:
+                if(!dest.getTruthValue()) {
+                    pc = instr.arg;
+                }
+                break;
+
+            case JsonPathPlanOp::negate:
+                storeResult(dest, JsonPathExpressionNodeEvalResult::booleanResult(!registers[instr.a].getTruthValue()));
+                break;
+
+            case JsonPathPlanOp::call: {
+                std::list<JsonPathExpressionNodeEvalResult> args;
+                for(int argRegister = instr.a; argRegister < instr.a + instr.b; argRegister++) {
+                    args.push_back(registers[argRegister]);
+                }
+
+                storeResult(dest, _functions[instr.arg]->invoke(args));
+                break;
+            }
+
+            default:
+                storeResult(dest, binaryOperator(instr.op, registers[instr.a], registers[instr.b]));
+                break;
+        }
+
+        // Navigation steps leave their result in resultList
+        if(instr.op >= JsonPathPlanOp::navName && instr.op <= JsonPathPlanOp::navIndexByExpression) {
+            dest.nodeList.swap(resultList);
+            resultList.clear();
+        }
+    }
+}
+
+/*
+ * Branch evaluation
+ */
+static bool isAncestorOrSelf(const json::Node *ancestor, const json::Node *node) {
+    for(; node; node = node->getParent()) {
+        if(node == ancestor) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t JsonPathExpressionPlan::nextStep(size_t pc) const {
+    const JsonPathPlanInstruction &instr = _code[pc];
+    bool hasBlock = instr.op == JsonPathPlanOp::navFilter || instr.op == JsonPathPlanOp::navFilterChildren ||
+                    instr.op == JsonPathPlanOp::navIndexByExpression;
+    return pc + 1 + (hasBlock ? instr.a : 0);
+}
+
+// Maps each strict ancestor of node to its child on the path down to node, and that child's index
+static void findPathChildren(json::Node *node, JsonPathBranchPath &pathChildren) {
+    pathChildren.clear();
+    for(json::Node *child = node; child->getParent(); child = child->getParent()) {
+        json::ContainerNode *parent = child->getParent();
+        pathChildren.emplace(parent, std::make_pair(child, parent->getIndexOfChild(child)));
+    }
+}
+
+bool JsonPathExpressionPlan::reachesPathChild(size_t pc, json::Node *node, json::Node *child, int childIdx,
+                                              JsonPathExpressionNodeEvalContext &context, JsonPathPlanRegisters &registers) const {
+    const JsonPathPlanInstruction &instr = _code[pc];
+    json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(node);
+    switch(instr.op) {
+        case JsonPathPlanOp::navName: {
+            json::ObjectNode *obNode = dynamic_cast<json::ObjectNode*>(node);
+            if(!obNode) {
+                return false;
+            }
+
+            const std::wstring &name = _names[instr.arg];
+            const std::wstring &memberName = obNode->getMemberNameAt(childIdx);
+            if(context.options && context.options->fuzzy) {
+                return memberName.compare(0, name.length(), name) == 0;
+            }
+            return memberName == name && obNode->getIndexOfMemberWithName(name) == childIdx;
+        }
+
+        case JsonPathPlanOp::navChildren:
+            return true;
+
+        case JsonPathPlanOp::navIndex:
+            return arrNode && childIdx == instr.arg;
+
+        case JsonPathPlanOp::navSlice: {
+            if(!arrNode) {
+                return false;
+            }
+
+            const JsonPathPlanSlice &slice = _slices[instr.arg];
+            int childCount = arrNode->getChildCount();
+            int start = slice.startInverted ? childCount - slice.startIndex : slice.startIndex;
+            int end = slice.endInverted ? childCount - slice.endIndex : slice.endIndex;
+            return childIdx >= std::max(start, 0) && childIdx < end;
+        }
+
+        case JsonPathPlanOp::navIndexList: {
+            const std::vector<int> &indexList = _indexLists[instr.arg];
+            return arrNode && std::find(indexList.begin(), indexList.end(), childIdx) != indexList.end();
+        }
+
+        case JsonPathPlanOp::navFilterChildren: {
+            json::Node *oldContext = context.contextNode;
+            context.contextNode = child;
+            run(pc + 1, pc + 1 + instr.a, context, registers);
+            context.contextNode = oldContext;
+            return registers[instr.b].getTruthValue();
+        }
+
+        default:
+            return false;
+    }
+}
+
+void JsonPathExpressionPlan::runBranchStep(size_t pc, json::Node *limit, bool keepLimitSubtree,
+                                           const JsonPathBranchPath &pathChildren,
+                                           JsonPathExpressionNodeEvalContext &context, JsonPathPlanRegisters &registers) const {
+    const JsonPathPlanInstruction &instr = _code[pc];
+    JsonPathResultNodeList &stage = registers[instr.dest].nodeList;
+
+    JsonPathResultNodeList pathMatches;
+    switch(instr.op) {
+        case JsonPathPlanOp::navRecurseName:
+        case JsonPathPlanOp::navRecurseAll: {
+            // Recursing from a node above limit would walk subtrees off the path; the path is
+            // matched instead, and the recursion starts at limit
+            json::Node *top = NULL;
+            JsonPathResultNodeList below;
+            for(json::Node *node: stage) {
+                if(isAncestorOrSelf(node, limit) && !(keepLimitSubtree && node == limit)) {
+                    if(!top || isAncestorOrSelf(node, top)) {
+                        top = node;
+                    }
+                } else {
+                    below.push_back(node);
+                }
+            }
+
+            if(top) {
+                std::vector<json::Node*> path;
+                for(json::Node *node = limit; node != top; node = node->getParent()) {
+                    path.push_back(node);
+                }
+
+                if(instr.op == JsonPathPlanOp::navRecurseAll) {
+                    pathMatches.push_back(top);
+                    pathMatches.insert(pathMatches.end(), path.rbegin(), path.rend());
+                } else {
+                    const std::wstring &name = _names[instr.arg];
+                    for(auto nodeIter = path.rbegin(); nodeIter != path.rend(); nodeIter++) {
+                        json::ObjectNode *parent = dynamic_cast<json::ObjectNode*>((*nodeIter)->getParent());
+                        int idx = parent ? parent->getIndexOfMemberWithName(name) : -1;
+                        if(idx != -1 && parent->getChildAt(idx) == *nodeIter) {
+                            pathMatches.push_back(*nodeIter);
+                        }
+                    }
+                }
+
+                if(keepLimitSubtree && std::find(below.begin(), below.end(), limit) == below.end()) {
+                    below.push_back(limit);
+                }
+            }
+
+            stage.swap(below);
+            break;
+        }
+
+        case JsonPathPlanOp::navFilter:
+        case JsonPathPlanOp::navIndexByExpression:
+            // Applied to the nodes themselves (or reach one child of each), so the stage is
+            // run as it is
+            break;
+
+        default: {
+            // A step from a node above limit only needs to reach the child on the path down to
+            // limit, so the rest of its children aren't visited; it runs in full from limit's
+            // subtree
+            JsonPathResultNodeList below;
+            for(json::Node *node: stage) {
+                auto pathChild = pathChildren.find(node);
+                if(pathChild != pathChildren.end()) {
+                    if(reachesPathChild(pc, node, pathChild->second.first, pathChild->second.second, context, registers)) {
+                        pathMatches.push_back(pathChild->second.first);
+                    }
+                } else if(keepLimitSubtree) {
+                    below.push_back(node);
+                }
+            }
+
+            stage.swap(below);
+            break;
+        }
+    }
+
+    run(pc, nextStep(pc), context, registers);
+    stage.insert(stage.end(), pathMatches.begin(), pathMatches.end());
+
+    std::unordered_set<json::Node*> kept;
+    stage.erase(std::remove_if(stage.begin(), stage.end(), [&](json::Node *node) {
+        bool inBranch = isAncestorOrSelf(node, limit) || (keepLimitSubtree && isAncestorOrSelf(limit, node));
+        return !inBranch || !kept.insert(node).second;
+    }), stage.end());
+}
+
+json::Node *JsonPathExpressionPlan::evaluateBranch(json::Node *root, json::Node *changed, JsonPathExpressionOptions *options,
+                                                   JsonPathResultNodeList &results) const {
+    JsonPathExpressionNodeEvalContext context = { root, root, NULL, options };
+    JsonPathPlanRegisters registers(_numRegisters);
+    JsonPathExpressionNodeEvalResult &pipeline = registers[_code[0].dest];
+
+    // Follow the pipeline down the path to changed. Whatever is reached on the path is an
+    // ancestor of changed (or changed itself), so the shallowest one a filter reads is the
+    // one closest to the root.
+    JsonPathBranchPath pathChildren;
+    findPathChildren(changed, pathChildren);
+
+    json::Node *branch = changed;
+    pipeline.assignNode(root);
+    for(size_t pc = 1; pc < _code.size(); pc = nextStep(pc)) {
+        switch(_code[pc].op) {
+            case JsonPathPlanOp::navFilter:
+            case JsonPathPlanOp::navIndexByExpression:
+                for(json::Node *node: pipeline.nodeList) {
+                    if(isAncestorOrSelf(node, branch)) {
+                        branch = node;
+                    }
+                }
+                break;
+
+            case JsonPathPlanOp::navFilterChildren:
+                for(json::Node *node: pipeline.nodeList) {
+                    json::Node *child = changed;
+                    while(child != node && child->getParent() != node) {
+                        child = child->getParent();
+                    }
+                    if(child != node && isAncestorOrSelf(child, branch)) {
+                        branch = child;
+                    }
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        runBranchStep(pc, changed, false, pathChildren, context, registers);
+    }
+
+    // Evaluate down the path to the branch, then all of its subtree
+    findPathChildren(branch, pathChildren);
+    pipeline.assignNode(root);
+    for(size_t pc = 1; pc < _code.size(); pc = nextStep(pc)) {
+        runBranchStep(pc, branch, true, pathChildren, context, registers);
+    }
+
+    for(json::Node *node: pipeline.nodeList) {
+        if(isAncestorOrSelf(branch, node)) {
+            results.push_back(node);
+        }
+    }
+
+    return branch;
+}
+
+/*
+ * Streaming
+ */
+
+bool JsonPathExpressionPlan::getStreamingSteps(std::vector<JsonPathStreamingStep> &steps, size_t &suffixPc) const {
+    steps.clear();
+    if(!_downwardPipeline) {
+        return false;
+    }
+
+    // Steps that need the size of an array (negative indices, slices from the end) aren't
+    // known until the array was read, and end the streamed steps
+    size_t pc = 1;
+    for(; pc < _code.size(); pc = nextStep(pc)) {
+        const JsonPathPlanInstruction &instr = _code[pc];
+        JsonPathStreamingStep step;
+        bool streamable = true;
+        switch(instr.op) {
+            case JsonPathPlanOp::navName:
+            case JsonPathPlanOp::navRecurseName:
+                step.kind = instr.op == JsonPathPlanOp::navName ? JsonPathStreamingStep::member : JsonPathStreamingStep::recurseMember;
+                step.name = _names[instr.arg];
+                break;
+
+            case JsonPathPlanOp::navRecurseAll:
+                step.kind = JsonPathStreamingStep::recurseAll;
+                break;
+
+            case JsonPathPlanOp::navChildren:
+                step.kind = JsonPathStreamingStep::children;
+                break;
+
+            case JsonPathPlanOp::navIndex:
+                step.kind = JsonPathStreamingStep::indexList;
+                step.indices.push_back(instr.arg);
+                streamable = instr.arg >= 0;
+                break;
+
+            case JsonPathPlanOp::navIndexList:
+                step.kind = JsonPathStreamingStep::indexList;
+                step.indices = _indexLists[instr.arg];
+                streamable = std::all_of(step.indices.begin(), step.indices.end(), [](int index) { return index >= 0; });
+                break;
+
+            case JsonPathPlanOp::navSlice: {
+                const JsonPathPlanSlice &slice = _slices[instr.arg];
+                step.kind = JsonPathStreamingStep::indexRange;
+                step.rangeStart = std::max(slice.startIndex, 0);
+                step.rangeEnd = slice.endInverted ? std::numeric_limits<int>::max() : slice.endIndex;
+                streamable = !slice.startInverted && !(slice.endInverted && slice.endIndex);
+                break;
+            }
+
+            case JsonPathPlanOp::navFilterChildren:
+                // The children are streamed, and each is read to be filtered
+                step.kind = JsonPathStreamingStep::children;
+                steps.push_back(step);
+                streamable = false;
+                break;
+
+            default:
+                streamable = false;
+                break;
+        }
+
+        if(!streamable) {
+            break;
+        }
+        steps.push_back(step);
+    }
+
+    suffixPc = pc;
+    return true;
+}
+
+JsonPathExpressionNodeEvalResult JsonPathExpressionPlan::executeFrom(size_t pc, json::Node *start,
+                                                                     JsonPathExpressionOptions *options) const {
+    // A downward pipeline doesn't read above start, so start may as well be the root
+    JsonPathExpressionNodeEvalContext context = { start, start, NULL, options };
+    JsonPathPlanRegisters registers(_numRegisters);
+
+    // Start is one of the children a children filter is applied to
+    if(pc < _code.size() && _code[pc].op == JsonPathPlanOp::navFilterChildren) {
+        const JsonPathPlanInstruction &instr = _code[pc];
+        run(pc + 1, pc + 1 + instr.a, context, registers);
+        if(!registers[instr.b].getTruthValue()) {
+            return JsonPathExpressionNodeEvalResult();
+        }
+
+        pc = nextStep(pc);
+    }
+
+    registers[_code[0].dest].assignNode(start);
+    run(pc, _code.size(), context, registers);
+
+    JsonPathExpressionNodeEvalResult result = std::move(registers[_resultRegister]);
+    result.materialize();
+    return result;
+}
@@ -0,0 +1,251 @@
+//
+//  JsonPathExpressionPlan.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef JsonPathExpressionPlan_hpp
+#define JsonPathExpressionPlan_hpp
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "JsonPathExpressionNode.hpp"
+
+enum class JsonPathPlanOp : unsigned char {
+    // dest = a single pipeline start node
+    loadRoot,
+    loadContext,
+    loadCursor,
+
+    // dest = literals[arg]
+    loadLiteral,
+
+    // dest = member name (or index) of the context node
+    loadMemberName,
+
+    // Navigation steps, replace the node list in dest
+    navName,                // names[arg]
+    navRecurseName,         // names[arg]
+    navRecurseAll,
+    navParent,
+    navAncestors,
+    navChildren,
+    navIndex,               // index arg
+    navSlice,               // slices[arg]
+    navIndexList,           // indexLists[arg]
+
+    // Run the a instructions that follow with each node (or child) as context; keep
+    // nodes for which register b is true
+    navFilter,
+    navFilterChildren,
+
+    // Run the a instructions that follow with each array as context; index it by register b
+    navIndexByExpression,
+
+    // Jump to instruction arg if the truth value of dest is (not) set
+    jumpIfTrue,
+    jumpIfFalse,
+
+    // dest = a <op> b
+    relEq,
+    relNeq,
+    relGte,
+    relLte,
+    relGt,
+    relLt,
+    relIn,
+    relNotIn,
+    relSubsetOf,
+    relAnyOf,
+    relNoneOf,
+    add,
+    div,
+    mul,
+    mod,
+    subtract,
+
+    // dest = !a
+    negate,
+
+    // dest = functions[arg](a, a+1, ... a+b-1)
+    call
+};
+
+struct JsonPathPlanInstruction {
+    JsonPathPlanOp op;
+    int dest;
+    int a;
+    int b;
+    int arg;
+};
+
+struct JsonPathPlanSlice {
+    int startIndex;
+    bool startInverted;
+    int endIndex;
+    bool endInverted;
+};
+
+// A step of a plan's main pipeline as matched against a token stream (see
+// JsonPathStreamingEvaluator): it only depends on the member name or index of each node
+struct JsonPathStreamingStep {
+    enum Kind {
+        member,             // member by name
+        recurseMember,      // member by name, at any depth
+        recurseAll,         // the node and all its descendants
+        children,
+        indexList,          // indices
+        indexRange          // [rangeStart, rangeEnd)
+    };
+
+    Kind kind;
+    std::wstring name;
+    std::vector<int> indices;
+    int rangeStart = 0;
+    int rangeEnd = 0;
+};
+
+// Strict ancestors of a node, each with its child on the path down to the node and that
+// child's index
+typedef std::unordered_map<const json::Node*, std::pair<json::Node*, int>> JsonPathBranchPath;
+
+/*
+ * Registers of one execution. Each register has a spare node buffer that navigation steps
+ * fill and then swap with the register's own, so buffers are reused from step to step.
+ */
+class JsonPathPlanRegisters {
+public:
+    JsonPathPlanRegisters(int count) : _values(count), _spareLists(count) {}
+
+    JsonPathExpressionNodeEvalResult &operator[](int index) { return _values[index]; }
+    JsonPathResultNodeList &spareList(int index) { return _spareLists[index]; }
+
+private:
+    std::vector<JsonPathExpressionNodeEvalResult> _values;
+    std::vector<JsonPathResultNodeList> _spareLists;
+};
+
+/*
+ * A JsonPath expression lowered to a flat instruction list over numbered registers.
+ *
+ * Filter and subscript expressions are inlined as blocks following the step that runs
+ * them, and logical operators are lowered to jumps so they short-circuit. A plan is
+ * immutable once built; all evaluation state lives in the registers of an execution.
+ */
+class JsonPathExpressionPlan {
+public:
+    static std::shared_ptr<const JsonPathExpressionPlan> lower(const JsonPathExpressionNode &rootNode);
+
+    JsonPathExpressionNodeEvalResult execute(JsonPathExpressionNodeEvalContext &context) const;
+
+    bool isCursorDependent() const { return _cursorDependent; }
+
+    // Canonical text of the plan; expressions that lower to the same plan (e.g `$.a` and
+    // `$['a']`) have the same normalized form
+    const std::wstring &getNormalizedForm() const { return _normalizedForm; }
+
+    // Node whose subtree is all the plan reads when executed from root with no initial
+    // context: the end of a leading run of name and index steps. Root if the plan may read
+    // anywhere in the document (e.g it navigates to parents, or uses the cursor).
+    json::Node *findReadScope(json::Node *root, JsonPathExpressionOptions *options) const;
+
+    // The plan navigates from the root, and its steps and filters only read down from the
+    // nodes they're applied to. Whether a node is reached then only depends on the path to it
+    // and on the subtrees filters are applied to along that path.
+    bool isDownwardPipeline() const { return _downwardPipeline; }
+
+    // For a downward pipeline, once the subtree of changed was replaced: returns the node whose
+    // subtree holds all results that may have changed -- changed, or the shallowest node above
+    // it that a filter or subscript expression reads -- and the results in that subtree. Only
+    // the path to that node and its subtree are evaluated.
+    json::Node *evaluateBranch(json::Node *root, json::Node *changed, JsonPathExpressionOptions *options,
+                               JsonPathResultNodeList &results) const;
+
+    // For a downward pipeline: its leading steps that can be matched against a token stream,
+    // and the instruction of the first step that can't (e.g a filter). That and the rest of
+    // the pipeline are run from each node the streamed steps reach, by executeFrom. A filter
+    // over children streams the children, and executeFrom applies it to each of them.
+    bool getStreamingSteps(std::vector<JsonPathStreamingStep> &steps, size_t &suffixPc) const;
+    JsonPathExpressionNodeEvalResult executeFrom(size_t pc, json::Node *start, JsonPathExpressionOptions *options) const;
+    size_t size() const { return _code.size(); }
+
+private:
+    friend class JsonPathPlanBuilder;
+    friend class JsonPathResultIterator;
+
+    void analyze();
+
+    // Index of the main pipeline step following the one at pc
+    size_t nextStep(size_t pc) const;
+
+    // Runs the main pipeline step at pc, keeping the nodes on the path to limit and, if
+    // keepLimitSubtree, the nodes in its subtree. pathChildren is the path to limit; from the
+    // nodes above limit only the path is followed, so the cost is in the depth of limit
+    // rather than in the breadth of the step.
+    void runBranchStep(size_t pc, json::Node *limit, bool keepLimitSubtree, const JsonPathBranchPath &pathChildren,
+                       JsonPathExpressionNodeEvalContext &context, JsonPathPlanRegisters &registers) const;
+
+    // Whether the child step at pc, applied to node, reaches child (node's childIdx'th child)
+    bool reachesPathChild(size_t pc, json::Node *node, json::Node *child, int childIdx,
+                          JsonPathExpressionNodeEvalContext &context, JsonPathPlanRegisters &registers) const;
+
+    void run(size_t begin, size_t end, JsonPathExpressionNodeEvalContext &context, JsonPathPlanRegisters &registers) const;
+
+    // Runs the filter block [begin, end) over the candidates, partitioned across threads
+    void filterInParallel(size_t begin, size_t end, int predicateRegister,
+                          const JsonPathResultNodeList &candidates,
+                          const JsonPathExpressionNodeEvalContext &context,
+                          JsonPathResultNodeList &resultList) const;
+
+private:
+    std::vector<JsonPathPlanInstruction> _code;
+    std::vector<std::shared_ptr<json::Node>> _literals;
+    std::vector<std::wstring> _names;
+    std::vector<JsonPathPlanSlice> _slices;
+    std::vector<std::vector<int>> _indexLists;
+    std::vector<JsonPathExpressionFunction*> _functions;
+
+    int _numRegisters = 0;
+    int _resultRegister = 0;
+    bool _cursorDependent = false;
+
+    std::wstring _normalizedForm;
+    size_t _readScopeLength = 0;    // Leading instructions leading to the read scope; 0 if root
+    bool _navigationPipeline = false;   // A start node, then navigation steps only
+    bool _downwardPipeline = false;
+};
+
+class JsonPathPlanBuilder {
+public:
+    JsonPathPlanBuilder(JsonPathExpressionPlan &plan) : _plan(plan) {}
+
+    int allocRegister() { return _plan._numRegisters++; }
+
+    // Allocates count consecutive registers, returns the first
+    int allocRegisters(int count);
+
+    // Appends an instruction, returns its index
+    size_t emit(JsonPathPlanOp op, int dest, int a = 0, int b = 0, int arg = 0);
+
+    // Index of the next instruction to be emitted
+    size_t here() const { return _plan._code.size(); }
+
+    JsonPathPlanInstruction &instructionAt(size_t index) { return _plan._code[index]; }
+
+    int addLiteral(const std::shared_ptr<json::Node> &literal);
+    int addName(const std::wstring &name);
+    int addSlice(const JsonPathPlanSlice &slice);
+    int addIndexList(const std::list<int> &indexList);
+    int addFunction(JsonPathExpressionFunction *fn);
+
+    void setCursorDependent() { _plan._cursorDependent = true; }
+
+private:
+    JsonPathExpressionPlan &_plan;
+};
+
+#endif /* JsonPathExpressionPlan_hpp */
@@ -0,0 +1,181 @@
+//
+//  JsonPathLiveQuery.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "JsonPathLiveQuery.hpp"
+
+#include <algorithm>
+
+static bool isPathPrefix(const json::JsonPath &prefix, const json::JsonPath &path) {
+    return prefix.size() <= path.size() && std::equal(prefix.begin(), prefix.end(), path.begin());
+}
+
+JsonPathLiveQuery::JsonPathLiveQuery(json::JsonFile *file,
+                                     const JsonPathExpression &expression,
+                                     const JsonPathExpressionOptions &options,
+                                     json::Node *cursorNode)
+    : _file(file), _expression(expression), _options(options), _hasCursor(cursorNode != NULL)
+{
+    if(cursorNode) {
+        _cursorPath = _file->getPathOfNode(cursorNode);
+    }
+
+    evaluateAll(_results);
+    _file->addListener(this, true);
+}
+
+JsonPathLiveQuery::~JsonPathLiveQuery() {
+    _file->removeListener(this);
+}
+
+void JsonPathLiveQuery::setCursorNode(json::Node *cursorNode) {
+    _hasCursor = cursorNode != NULL;
+    _cursorPath = cursorNode ? _file->getPathOfNode(cursorNode) : json::JsonPath();
+    if(!_expression.isCursorDependent()) {
+        return;
+    }
+
+    Results newResults;
+    evaluateAll(newResults);
+
+    Delta delta;
+    replaceResults(json::JsonPath(), newResults, std::vector<json::JsonPath>(), delta);
+    if(!delta.empty() && _listener) {
+        _listener(delta);
+    }
+}
+
+std::vector<json::Node*> JsonPathLiveQuery::getResults() const {
+    std::vector<json::Node*> results;
+    results.reserve(_results.size());
+    for(const auto &result: _results) {
+        results.push_back(result.second);
+    }
+
+    return results;
+}
+
+void JsonPathLiveQuery::getResults(size_t first, size_t count, std::vector<json::Node*> &outResults) const {
+    if(first >= _results.size()) {
+        return;
+    }
+
+    auto iter = std::next(_results.begin(), first);
+    for(; count && iter != _results.end(); iter++, count--) {
+        outResults.push_back(iter->second);
+    }
+}
+
+bool JsonPathLiveQuery::isIncremental() const {
+    return _expression._plan && _expression._plan->isDownwardPipeline();
+}
+
+void JsonPathLiveQuery::addResults(const JsonPathResultNodeList &nodes, Results &outResults) const {
+    // Values computed by the expression aren't in the DOM, and aren't kept
+    for(json::Node *node: nodes) {
+        if(node && node->getDocument() == _file->getDom()) {
+            outResults.emplace(_file->getPathOfNode(node), node);
+        }
+    }
+}
+
+void JsonPathLiveQuery::evaluateAll(Results &outResults) {
+    json::Node *root = _file->getDom()->getChildAt(0);
+    if(!root || !_expression._plan) {
+        return;
+    }
+
+    // Results of an expression that fails to evaluate are empty
+    json::Node *cursorNode = _hasCursor ? _file->findNodeAtPath(_cursorPath) : NULL;
+    try {
+        addResults(_expression.execute(root, &_options, NULL, cursorNode).nodeList, outResults);
+    } catch(const std::exception &) {
+        outResults.clear();
+    }
+}
+
+void JsonPathLiveQuery::replaceResults(const json::JsonPath &scope, const Results &newResults,
+                                       const std::vector<json::JsonPath> &refreshed, Delta &delta) {
+    auto isRefreshed = [&refreshed](const json::JsonPath &path) {
+        return std::any_of(refreshed.begin(), refreshed.end(), [&path](const json::JsonPath &refreshedPath) {
+            return isPathPrefix(refreshedPath, path);
+        });
+    };
+
+    Results::iterator scopeBegin = _results.lower_bound(scope);
+    Results::iterator scopeEnd = scopeBegin;
+    while(scopeEnd != _results.end() && isPathPrefix(scope, scopeEnd->first)) {
+        scopeEnd++;
+    }
+
+    // Nodes outside of refreshed subtrees are the same nodes they were; others may not be
+    for(Results::iterator oldResult = scopeBegin; oldResult != scopeEnd; oldResult++) {
+        Results::const_iterator newResult = newResults.find(oldResult->first);
+        if(newResult == newResults.end() || newResult->second != oldResult->second || isRefreshed(oldResult->first)) {
+            delta.removed.push_back(oldResult->second);
+        }
+    }
+
+    for(const auto &newResult: newResults) {
+        Results::iterator oldResult = _results.find(newResult.first);
+        if(oldResult == _results.end() || oldResult->second != newResult.second || isRefreshed(newResult.first)) {
+            delta.added.push_back(newResult.second);
+        }
+    }
+
+    _results.erase(scopeBegin, scopeEnd);
+    _results.insert(newResults.begin(), newResults.end());
+}
+
+void JsonPathLiveQuery::notifyChangeSet(json::JsonFile *aSender, const json::JsonFileChangeSet &aChangeSet) {
+    const std::vector<json::JsonPath> &refreshed = aChangeSet.refreshedNodes;
+    if(refreshed.empty()) {
+        return;
+    }
+
+    Delta delta;
+    try {
+        json::Node *root = _file->getDom()->getChildAt(0);
+        if(!root || !isIncremental()) {
+            Results newResults;
+            evaluateAll(newResults);
+            replaceResults(json::JsonPath(), newResults, refreshed, delta);
+        } else {
+            // Evaluate the branch of each refreshed node; branches come in document order, so a
+            // branch containing others comes right before them
+            std::vector<std::pair<json::JsonPath, Results>> branches;
+            for(const json::JsonPath &path: refreshed) {
+                JsonPathResultNodeList nodes;
+                json::Node *branch = _expression._plan->evaluateBranch(root, _file->findNodeAtPath(path), &_options, nodes);
+
+                branches.emplace_back(_file->getPathOfNode(branch), Results());
+                addResults(nodes, branches.back().second);
+            }
+
+            std::sort(branches.begin(), branches.end(), [](const auto &left, const auto &right) {
+                return left.first < right.first;
+            });
+
+            const json::JsonPath *lastBranch = NULL;
+            for(const auto &branch: branches) {
+                if(lastBranch && isPathPrefix(*lastBranch, branch.first)) {
+                    continue;
+                }
+
+                replaceResults(branch.first, branch.second, refreshed, delta);
+                lastBranch = &branch.first;
+            }
+        }
+    } catch(const std::exception &) {
+        // Results of an expression that fails to evaluate are empty
+        delta = Delta();
+        replaceResults(json::JsonPath(), Results(), refreshed, delta);
+    }
+
+    if(!delta.empty() && _listener) {
+        _listener(delta);
+    }
+}
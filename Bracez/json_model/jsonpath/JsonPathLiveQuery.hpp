@@ -0,0 +1,95 @@
+//
+//  JsonPathLiveQuery.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef JsonPathLiveQuery_hpp
+#define JsonPathLiveQuery_hpp
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "json_file.h"
+#include "JsonPathExpressionCompiler.hpp"
+
+/*
+ * A standing JsonPath query over a file's DOM, with its results kept current as the DOM changes.
+ *
+ * Results are the DOM nodes the expression finds, in document order. When a change set is
+ * delivered, each refreshed node is mapped to the branch of the document whose results it may
+ * change (see JsonPathExpressionPlan::evaluateBranch), and only that branch is evaluated again,
+ * so the cost is in the size of the edit rather than of the document. Expressions that read up
+ * or across the document (parents, the cursor, `$` in filters) or compute values rather than
+ * navigate are evaluated in full instead.
+ *
+ * Either way the delta listener gets the results that were removed and added. Results in
+ * replaced subtrees are reported as removed and added again, even if their node was kept.
+ */
+class JsonPathLiveQuery : public json::JsonFileChangeListener {
+public:
+    struct Delta {
+        // Nodes in document order. Removed nodes may have left the DOM; compare, don't dereference.
+        std::vector<json::Node*> removed;
+        std::vector<json::Node*> added;
+
+        bool empty() const { return removed.empty() && added.empty(); }
+    };
+
+    typedef std::function<void (const Delta &delta)> DeltaListener;
+
+    JsonPathLiveQuery(json::JsonFile *file,
+                      const JsonPathExpression &expression,
+                      const JsonPathExpressionOptions &options = JsonPathExpressionOptions(),
+                      json::Node *cursorNode = NULL);
+    ~JsonPathLiveQuery();
+
+    JsonPathLiveQuery(const JsonPathLiveQuery&) = delete;
+    JsonPathLiveQuery &operator=(const JsonPathLiveQuery&) = delete;
+
+    void setDeltaListener(const DeltaListener &listener) { _listener = listener; }
+
+    // Cursor dependent expressions are evaluated again for the new cursor. The cursor is
+    // followed by its path across edits.
+    void setCursorNode(json::Node *cursorNode);
+
+    // In document order
+    std::vector<json::Node*> getResults() const;
+    // Up to count of the results from the first'th on
+    void getResults(size_t first, size_t count, std::vector<json::Node*> &outResults) const;
+    size_t size() const { return _results.size(); }
+
+    // Edits are applied to the results by evaluating the affected branches only
+    bool isIncremental() const;
+
+    virtual void notifyTextSpliced(json::JsonFile *aSender, TextCoordinate aOldOffset,
+                                   TextLength aOldLength, TextLength aNewLength,
+                                   TextCoordinate aOldLineStart, TextLength aOldLineLength,
+                                   TextLength aNewLineLength) {}
+    virtual void notifyChangeSet(json::JsonFile *aSender, const json::JsonFileChangeSet &aChangeSet);
+
+private:
+    // Results by their path, i.e in document order
+    typedef std::map<json::JsonPath, json::Node*> Results;
+
+    void evaluateAll(Results &outResults);
+    void addResults(const JsonPathResultNodeList &nodes, Results &outResults) const;
+
+    // Replaces the results under scope with newResults and adds the difference to delta
+    void replaceResults(const json::JsonPath &scope, const Results &newResults,
+                        const std::vector<json::JsonPath> &refreshed, Delta &delta);
+
+private:
+    json::JsonFile *_file;
+    JsonPathExpression _expression;
+    JsonPathExpressionOptions _options;
+    json::JsonPath _cursorPath;
+    bool _hasCursor;
+
+    Results _results;
+    DeltaListener _listener;
+};
+
+#endif /* JsonPathLiveQuery_hpp */
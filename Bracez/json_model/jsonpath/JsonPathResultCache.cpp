@@ -0,0 +1,74 @@
+//
+//  JsonPathResultCache.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "JsonPathResultCache.hpp"
+
+#include <algorithm>
+
+JsonPathResultCache::JsonPathResultCache(json::JsonFile *file, size_t maxEntries)
+    : _file(file), _maxEntries(maxEntries)
+{
+    _file->addListener(this, true);
+}
+
+JsonPathResultCache::~JsonPathResultCache() {
+    _file->removeListener(this);
+}
+
+JsonPathExpressionNodeEvalResult JsonPathResultCache::execute(const JsonPathExpression &expression,
+                                                              JsonPathExpressionOptions *options,
+                                                              json::Node *cursorNode) {
+    Key key = { expression.getNormalizedForm(), options && options->fuzzy, expression.isCursorDependent() ? cursorNode : NULL };
+
+    auto entryIter = _entries.find(key);
+    if(entryIter != _entries.end() && entryIter->second.version == _file->getVersion()) {
+        _numHits++;
+        entryIter->second.lastUsed = ++_useClock;
+        return entryIter->second.result;
+    }
+
+    _numMisses++;
+    json::Node *root = _file->getDom()->getChildAt(0);
+    json::Node *scope = expression.findReadScope(root, options);
+    JsonPathExpressionNodeEvalResult result = expression.execute(root, options, NULL, cursorNode);
+
+    Entry &entry = _entries[key];
+    entry.result = result;
+    entry.scopePath = scope ? _file->getPathOfNode(scope) : json::JsonPath();
+    entry.version = _file->getVersion();
+    entry.lastUsed = ++_useClock;
+
+    evict();
+    return result;
+}
+
+void JsonPathResultCache::evict() {
+    while(_entries.size() > _maxEntries) {
+        _entries.erase(std::min_element(_entries.begin(), _entries.end(), [](const auto &left, const auto &right) {
+            return left.second.lastUsed < right.second.lastUsed;
+        }));
+    }
+}
+
+void JsonPathResultCache::notifyChangeSet(json::JsonFile *aSender, const json::JsonFileChangeSet &aChangeSet) {
+    auto overlaps = [](const json::JsonPath &left, const json::JsonPath &right) {
+        size_t common = std::min(left.size(), right.size());
+        return std::equal(left.begin(), std::next(left.begin(), common), right.begin());
+    };
+
+    for(auto entryIter = _entries.begin(); entryIter != _entries.end(); ) {
+        const json::JsonPath &scopePath = entryIter->second.scopePath;
+        bool refreshed = std::any_of(aChangeSet.refreshedNodes.begin(), aChangeSet.refreshedNodes.end(),
+                                     [&](const json::JsonPath &path) { return overlaps(path, scopePath); });
+        if(refreshed) {
+            entryIter = _entries.erase(entryIter);
+        } else {
+            entryIter->second.version = aSender->getVersion();
+            entryIter++;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+//
+//  JsonPathResultCache.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef JsonPathResultCache_hpp
+#define JsonPathResultCache_hpp
+
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "json_file.h"
+#include "JsonPathExpressionCompiler.hpp"
+
+/*
+ * Results of JsonPath expressions over a file's DOM, kept across edits that can't change them.
+ *
+ * Entries are keyed by the expression's normalized form, whether it's fuzzy and, for cursor
+ * dependent expressions, the cursor node. Each entry remembers the path of the expression's
+ * read scope (see JsonPathExpressionPlan::findReadScope) and the file version it's valid at.
+ * When a change set is delivered, entries whose scope is in, or contains, a refreshed node are
+ * dropped and the rest are carried over to the new version. An entry is only used at the
+ * version it's valid at, so results are never served from a DOM that changed in a way the
+ * cache wasn't told about yet.
+ *
+ * The least recently used entries are evicted past the maximum number of entries.
+ */
+class JsonPathResultCache : public json::JsonFileChangeListener {
+public:
+    JsonPathResultCache(json::JsonFile *file, size_t maxEntries = 32);
+    ~JsonPathResultCache();
+
+    JsonPathResultCache(const JsonPathResultCache&) = delete;
+    JsonPathResultCache &operator=(const JsonPathResultCache&) = delete;
+
+    // Same as expression.execute(root, options, NULL, cursorNode) for the root of the file's DOM
+    JsonPathExpressionNodeEvalResult execute(const JsonPathExpression &expression,
+                                             JsonPathExpressionOptions *options = NULL,
+                                             json::Node *cursorNode = NULL);
+
+    void clear() { _entries.clear(); }
+
+    size_t size() const { return _entries.size(); }
+    size_t numHits() const { return _numHits; }
+    size_t numMisses() const { return _numMisses; }
+
+    virtual void notifyTextSpliced(json::JsonFile *aSender, TextCoordinate aOldOffset,
+                                   TextLength aOldLength, TextLength aNewLength,
+                                   TextCoordinate aOldLineStart, TextLength aOldLineLength,
+                                   TextLength aNewLineLength) {}
+    virtual void notifyChangeSet(json::JsonFile *aSender, const json::JsonFileChangeSet &aChangeSet);
+
+private:
+    struct Key {
+        std::wstring normalizedForm;
+        bool fuzzy;
+        json::Node *cursorNode;
+
+        bool operator<(const Key &other) const {
+            return std::tie(normalizedForm, fuzzy, cursorNode) < std::tie(other.normalizedForm, other.fuzzy, other.cursorNode);
+        }
+    };
+
+    struct Entry {
+        JsonPathExpressionNodeEvalResult result;
+        json::JsonPath scopePath;
+        unsigned long version;
+        unsigned long lastUsed;
+    };
+
+    void evict();
+
+private:
+    json::JsonFile *_file;
+    size_t _maxEntries;
+
+    std::map<Key, Entry> _entries;
+    unsigned long _useClock = 0;
+
+    size_t _numHits = 0;
+    size_t _numMisses = 0;
+};
+
+#endif /* JsonPathResultCache_hpp */
@@ -0,0 +1,370 @@
+//
+//  JsonPathResultIterator.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "JsonPathResultIterator.hpp"
+
+#include <algorithm>
+
+JsonPathResultIterator::JsonPathResultIterator(const JsonPathExpression &expression,
+                                               json::Node *root,
+                                               JsonPathExpressionOptions *options,
+                                               json::Node *initialContext,
+                                               json::Node *cursorNode)
+    : _plan(expression._plan)
+{
+    _context.rootNode = root;
+    _context.contextNode = initialContext ? initialContext : root;
+    _context.cursorNode = cursorNode;
+    _context.options = options ? &_options : NULL;
+    if(options) {
+        _options = *options;
+    }
+
+    if(!_plan) {
+        throw JsonPathEvalError("Empty expression");
+    }
+
+    if(!_plan->_navigationPipeline) {
+        _executed = _plan->execute(_context);
+        return;
+    }
+
+    _pipelined = true;
+    _registers.reset(new JsonPathPlanRegisters(_plan->_numRegisters));
+    for(size_t pc = 0; pc < _plan->_code.size(); pc = _plan->nextStep(pc)) {
+        _steps.push_back(pc);
+    }
+
+    // The first frame loads the start node
+    _frames.resize(_steps.size());
+    pushFrame(NULL);
+}
+
+json::Node *JsonPathResultIterator::next() {
+    if(!_pipelined) {
+        while(_nextExecuted < _executed.nodeList.size()) {
+            json::Node *node = _executed.nodeList[_nextExecuted++];
+            if(isInWindow(node)) {
+                return node;
+            }
+        }
+
+        return NULL;
+    }
+
+    // Depth first: a node the last step yields is a result, any other is taken to the next step
+    while(_depth) {
+        json::Node *node = advance(_frames[_depth - 1]);
+        if(!node) {
+            _depth--;
+        } else
+        if(_depth == _steps.size()) {
+            if(isInWindow(node)) {
+                return node;
+            }
+        } else
+        if(!_pruneToWindow || mayReachWindow(node)) {
+            pushFrame(node);
+        }
+    }
+
+    return NULL;
+}
+
+size_t JsonPathResultIterator::take(size_t limit, JsonPathResultNodeList &results) {
+    size_t numTaken = 0;
+    for(; numTaken < limit; numTaken++) {
+        json::Node *node = next();
+        if(!node) {
+            break;
+        }
+
+        results.push_back(node);
+    }
+
+    return numTaken;
+}
+
+size_t JsonPathResultIterator::count() {
+    size_t numResults = 0;
+    while(next()) {
+        numResults++;
+    }
+
+    return numResults;
+}
+
+json::Node *JsonPathResultIterator::firstAtOrAfter(TextCoordinate position) {
+    // Branch and bound: each result found closes the window past its start, so only what may
+    // start before it is walked from then on
+    _windowed = true;
+    _pruneToWindow = _pipelined && _plan->isDownwardPipeline();
+    _windowBegin = position;
+    _windowEnd = TextCoordinate::infinity;
+
+    json::Node *first = NULL;
+    while(json::Node *node = next()) {
+        first = node;
+        _windowEnd = node->getAbsTextRange().start;
+    }
+
+    return first;
+}
+
+size_t JsonPathResultIterator::takeAtOrAfter(TextCoordinate position, size_t limit, JsonPathResultNodeList &results) {
+    if(!limit) {
+        return 0;
+    }
+
+    // As firstAtOrAfter, with the window closed past the last of the limit best results once
+    // there are that many
+    _windowed = true;
+    _pruneToWindow = _pipelined && _plan->isDownwardPipeline();
+    _windowBegin = position;
+    _windowEnd = TextCoordinate::infinity;
+
+    std::map<TextCoordinate, json::Node*> best;
+    while(json::Node *node = next()) {
+        best.emplace(node->getAbsTextRange().start, node);
+        if(best.size() > limit) {
+            best.erase(std::prev(best.end()));
+        }
+        if(best.size() == limit) {
+            _windowEnd = best.rbegin()->first;
+        }
+    }
+
+    for(const auto &result: best) {
+        results.push_back(result.second);
+    }
+
+    return best.size();
+}
+
+/*
+ * Steps
+ */
+
+void JsonPathResultIterator::pushFrame(json::Node *input) {
+    Frame &frame = _frames[_depth];
+    frame.pc = _steps[_depth];
+    frame.input = input;
+    frame.outputs.clear();
+    frame.nextOutput = 0;
+    frame.container = NULL;
+    frame.nextChild = 0;
+    frame.endChild = 0;
+    frame.walk.clear();
+    frame.walkPending = NULL;
+    frame.indexed = false;
+
+    const JsonPathPlanInstruction &instr = _plan->_code[frame.pc];
+    switch(instr.op) {
+        case JsonPathPlanOp::navChildren:
+        case JsonPathPlanOp::navFilterChildren:
+            frame.container = dynamic_cast<json::ContainerNode*>(input);
+            frame.endChild = frame.container ? frame.container->getChildCount() : 0;
+            break;
+
+        case JsonPathPlanOp::navSlice:
+            if(json::ArrayNode *arrNode = dynamic_cast<json::ArrayNode*>(input)) {
+                const JsonPathPlanSlice &slice = _plan->_slices[instr.arg];
+                int childCount = arrNode->getChildCount();
+
+                int start = slice.startIndex;
+                int end = slice.endIndex;
+
+                if(slice.startInverted) start = childCount - start;
+                if(slice.endInverted) end = childCount - end;
+
+                frame.container = arrNode;
+                frame.nextChild = std::max(start, 0);
+                frame.endChild = std::max(frame.nextChild, std::min(end, childCount));
+            }
+            break;
+
+        case JsonPathPlanOp::navRecurseAll:
+            frame.outputs.push_back(input);
+            frame.walkPending = input;
+            break;
+
+        case JsonPathPlanOp::navRecurseName: {
+            json::DocumentNode *document = input->getDocument();
+            json::JsonFile *file = document ? document->getOwner() : NULL;
+            const json::MemberNameIndex *index = file ? file->getMemberNameIndex() : NULL;
+            if(index) {
+                json::MemberNameIndex::ObjectRange objects = index->objectsWithMember(input, _plan->_names[instr.arg]);
+                frame.indexed = true;
+                frame.nextIndexed = objects.first;
+                frame.endIndexed = objects.second;
+            } else {
+                frame.walkPending = input;
+            }
+            break;
+        }
+
+        default: {
+            // Any other step is run on the input node alone
+            JsonPathExpressionNodeEvalResult &pipeline = (*_registers)[instr.dest];
+            if(frame.pc > 0) {
+                pipeline.assignNode(input);
+            }
+
+            _plan->run(frame.pc, _plan->nextStep(frame.pc), _context, *_registers);
+            frame.outputs.swap(pipeline.nodeList);
+            break;
+        }
+    }
+
+    if(frame.container && _pruneToWindow) {
+        frame.nextChild = firstChildInWindow(frame.container, frame.nextChild, frame.endChild);
+    }
+
+    _depth++;
+}
+
+json::Node *JsonPathResultIterator::advance(Frame &frame) {
+    if(frame.nextOutput < frame.outputs.size()) {
+        return frame.outputs[frame.nextOutput++];
+    }
+
+    while(frame.container && frame.nextChild < frame.endChild) {
+        json::Node *child = frame.container->getChildAt(frame.nextChild++);
+        if(_pruneToWindow && !mayReachWindow(child)) {
+            // Children are in document order; once one starts past the window, so do the rest
+            if(child->getAbsTextRange().start >= _windowEnd) {
+                frame.nextChild = frame.endChild;
+            }
+            continue;
+        }
+
+        if(_plan->_code[frame.pc].op == JsonPathPlanOp::navFilterChildren && !filterAccepts(frame.pc, child)) {
+            continue;
+        }
+
+        return child;
+    }
+
+    if(frame.indexed) {
+        return advanceIndexed(frame);
+    }
+
+    return advanceWalk(frame);
+}
+
+// Pre-order: a child is yielded when its container's walk gets to it, and walked into on the
+// call that follows
+json::Node *JsonPathResultIterator::advanceWalk(Frame &frame) {
+    const JsonPathPlanInstruction &instr = _plan->_code[frame.pc];
+    const std::wstring *name = instr.op == JsonPathPlanOp::navRecurseName ? &_plan->_names[instr.arg] : NULL;
+
+    while(true) {
+        if(frame.walkPending) {
+            json::ContainerNode *container = dynamic_cast<json::ContainerNode*>(frame.walkPending);
+            frame.walkPending = NULL;
+            if(container) {
+                int childCount = container->getChildCount();
+                frame.walk.emplace_back(container, _pruneToWindow ? firstChildInWindow(container, 0, childCount) : 0);
+            }
+        }
+
+        if(frame.walk.empty()) {
+            return NULL;
+        }
+
+        json::ContainerNode *container = frame.walk.back().first;
+        int childIdx = frame.walk.back().second++;
+        if(childIdx >= container->getChildCount()) {
+            frame.walk.pop_back();
+            continue;
+        }
+
+        json::Node *child = container->getChildAt(childIdx);
+        if(_pruneToWindow && !mayReachWindow(child)) {
+            if(child->getAbsTextRange().start >= _windowEnd) {
+                frame.walk.back().second = container->getChildCount();
+            }
+            continue;
+        }
+
+        frame.walkPending = child;
+        if(!name) {
+            return child;
+        }
+
+        // The first member by the name is the one a name step would navigate to
+        json::ObjectNode *obNode = dynamic_cast<json::ObjectNode*>(container);
+        if(obNode && obNode->getMemberNameAt(childIdx) == *name && obNode->getIndexOfMemberWithName(*name) == childIdx) {
+            return child;
+        }
+    }
+}
+
+json::Node *JsonPathResultIterator::advanceIndexed(Frame &frame) {
+    const std::wstring &name = _plan->_names[_plan->_code[frame.pc].arg];
+    while(frame.nextIndexed != frame.endIndexed) {
+        json::ObjectNode *obNode = *frame.nextIndexed++;
+        if(_pruneToWindow && !mayReachWindow(obNode)) {
+            // Objects are in document order
+            if(obNode->getAbsTextRange().start >= _windowEnd) {
+                frame.nextIndexed = frame.endIndexed;
+            }
+            continue;
+        }
+
+        return obNode->getChildAt(obNode->getIndexOfMemberWithName(name));
+    }
+
+    return NULL;
+}
+
+bool JsonPathResultIterator::filterAccepts(size_t pc, json::Node *candidate) {
+    const JsonPathPlanInstruction &instr = _plan->_code[pc];
+
+    json::Node *oldContext = _context.contextNode;
+    _context.contextNode = candidate;
+    _plan->run(pc + 1, pc + 1 + instr.a, _context, *_registers);
+    _context.contextNode = oldContext;
+
+    return (*_registers)[instr.b].getTruthValue();
+}
+
+/*
+ * Window
+ */
+
+bool JsonPathResultIterator::mayReachWindow(json::Node *node) const {
+    if(!_windowed) {
+        return true;
+    }
+
+    json::TextRange range = node->getAbsTextRange();
+    return range.end > _windowBegin && range.start < _windowEnd;
+}
+
+bool JsonPathResultIterator::isInWindow(json::Node *node) const {
+    if(!_windowed) {
+        return true;
+    }
+
+    TextCoordinate start = node->getAbsTextRange().start;
+    return start >= _windowBegin && start < _windowEnd;
+}
+
+// The first of container's children in [begin, end) that ends past the window's start
+int JsonPathResultIterator::firstChildInWindow(json::ContainerNode *container, int begin, int end) const {
+    while(begin < end) {
+        int mid = begin + (end - begin) / 2;
+        if(container->getChildAt(mid)->getAbsTextRange().end > _windowBegin) {
+            end = mid;
+        } else {
+            begin = mid + 1;
+        }
+    }
+
+    return begin;
+}
@@ -0,0 +1,135 @@
+//
+//  JsonPathResultIterator.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef JsonPathResultIterator_hpp
+#define JsonPathResultIterator_hpp
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "json_file.h"
+#include "JsonPathExpressionCompiler.hpp"
+
+/*
+ * Pulls the results of a JsonPath expression one at a time, rather than listing them all as
+ * JsonPathExpression::execute does.
+ *
+ * The steps of the main pipeline are run as nested generators: each node a step yields is
+ * taken through the steps that follow before the step goes on, so taking the first few results
+ * only evaluates as much of the document as they need. Child, slice and children filter steps
+ * go over the children of their input one at a time, and recursive steps walk its subtree in
+ * pre-order (`..name` goes over the objects in the member name index instead, when the
+ * document has one); the other steps are run on each input node at once.
+ *
+ * Results are those execute would list, a node reached along several paths once for each. The
+ * order may differ: recursive matches come in pre-order rather than level by level, which is
+ * document order unless a later step goes up, or a match's results come after those of a match
+ * nested in it. Expressions that compute values rather than navigate are executed in full when
+ * the iterator is created.
+ *
+ * The DOM must not change while the iterator is in use.
+ */
+class JsonPathResultIterator {
+public:
+    // Options are copied. Throws JsonPathEvalError for an empty expression, or a missing
+    // pipeline start node.
+    JsonPathResultIterator(const JsonPathExpression &expression,
+                           json::Node *root,
+                           JsonPathExpressionOptions *options = NULL,
+                           json::Node *initialContext = NULL,
+                           json::Node *cursorNode = NULL);
+
+    JsonPathResultIterator(const JsonPathResultIterator&) = delete;
+    JsonPathResultIterator &operator=(const JsonPathResultIterator&) = delete;
+
+    // The next result, NULL once there are no more
+    json::Node *next();
+
+    // Appends up to limit of the next results to results; returns the number appended
+    size_t take(size_t limit, JsonPathResultNodeList &results);
+
+    // Number of results left. They're counted without being kept.
+    size_t count();
+
+    // Of the results left: the one that starts first at or after position, NULL if none.
+    // For expressions that only navigate down from the root, subtrees that end before position
+    // or start after the best result found so far aren't walked.
+    json::Node *firstAtOrAfter(TextCoordinate position);
+
+    // Of the results left: up to limit of those that start first at or after position, appended
+    // to results in document order (each once); returns the number appended. Pruned like
+    // firstAtOrAfter, with subtrees that start after the last of the best results found so far.
+    size_t takeAtOrAfter(TextCoordinate position, size_t limit, JsonPathResultNodeList &results);
+
+private:
+    // A main pipeline step being run over one input node
+    struct Frame {
+        size_t pc;
+        json::Node *input;
+
+        // Steps run at once: their results, and the next one to yield
+        JsonPathResultNodeList outputs;
+        size_t nextOutput;
+
+        // Child, slice and children filter steps: the children left to yield
+        json::ContainerNode *container;
+        int nextChild;
+        int endChild;
+
+        // Recursive steps: the containers being walked, each with its next child, and a
+        // node that was yielded and is to be walked into next
+        std::vector<std::pair<json::ContainerNode*, int>> walk;
+        json::Node *walkPending;
+
+        // Recursive name steps over a document with a member name index: the objects left
+        // that have the member, in document order
+        bool indexed;
+        json::MemberNameIndex::ObjectList::const_iterator nextIndexed;
+        json::MemberNameIndex::ObjectList::const_iterator endIndexed;
+    };
+
+    // Starts the step at the current depth over input
+    void pushFrame(json::Node *input);
+    json::Node *advance(Frame &frame);
+    json::Node *advanceWalk(Frame &frame);
+    json::Node *advanceIndexed(Frame &frame);
+
+    bool filterAccepts(size_t pc, json::Node *candidate);
+
+    // With a window set: whether a result starting in it may be found in node's subtree, and
+    // whether node is such a result
+    bool mayReachWindow(json::Node *node) const;
+    bool isInWindow(json::Node *node) const;
+    int firstChildInWindow(json::ContainerNode *container, int begin, int end) const;
+
+private:
+    std::shared_ptr<const JsonPathExpressionPlan> _plan;
+    JsonPathExpressionOptions _options;
+    JsonPathExpressionNodeEvalContext _context;
+    std::unique_ptr<JsonPathPlanRegisters> _registers;
+
+    // Frames [0, _depth) are in use; the rest keep their buffers for reuse
+    std::vector<size_t> _steps;
+    std::vector<Frame> _frames;
+    size_t _depth = 0;
+
+    // Results of an expression that isn't a navigation pipeline
+    JsonPathExpressionNodeEvalResult _executed;
+    size_t _nextExecuted = 0;
+    bool _pipelined = false;
+
+    // Only results starting in [_windowBegin, _windowEnd) are yielded; subtrees that can't hold
+    // any are pruned when _pruneToWindow
+    bool _windowed = false;
+    bool _pruneToWindow = false;
+    TextCoordinate _windowBegin;
+    TextCoordinate _windowEnd;
+};
+
+#endif /* JsonPathResultIterator_hpp */
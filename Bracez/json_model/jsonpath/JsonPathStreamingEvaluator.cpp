@@ -0,0 +1,501 @@
+//
+//  JsonPathStreamingEvaluator.cpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "JsonPathStreamingEvaluator.hpp"
+
+#include <algorithm>
+#include <string>
+
+// Keeps the first error reported while reading a value
+struct JsonPathStreamingErrorListener : public json::ParseListener {
+    virtual void Error(TextCoordinate aWhere, int aCode, json::ParseErrorMessage aMessage, unsigned int aArg) {
+        if(!failed) {
+            failed = true;
+            where = aWhere;
+            message = aMessage;
+            arg = aArg;
+        }
+    }
+
+    bool failed = false;
+    TextCoordinate where;
+    int message = 0;
+    unsigned int arg = 0;
+};
+
+static void throwMalformed(const std::string &message, TextCoordinate where) {
+    std::string what = "Malformed JSON at offset " + std::to_string(where.getAddress()) + ": " + message;
+    throw JsonPathEvalError(what.c_str());
+}
+
+// Tracks the strings in text scanned a character at a time; true for the characters outside
+// them, other than quotes
+static inline bool isOutsideStrings(TextChar c, bool &inString, bool &escaped) {
+    if(inString) {
+        if(escaped) {
+            escaped = false;
+        } else if(c == '\\') {
+            escaped = true;
+        } else if(c == '"') {
+            inString = false;
+        }
+        return false;
+    }
+
+    inString = c == '"';
+    return !inString;
+}
+
+static inline bool isStructural(TextChar c) {
+    return c == '{' || c == '}' || c == '[' || c == ']' || c == ',' || c == ':';
+}
+
+/*
+ * The text being streamed, and the tokens read off it. Text read in chunks is only kept from
+ * the token being read on, and read on far enough for the next token to be in whole: up to a
+ * bracket, comma or colon outside strings.
+ */
+class JsonPathTokenWindow {
+public:
+    JsonPathTokenWindow(const TextChar *text, TextLength length) : _data(text), _length(length), _atEnd(true) {
+        reset(0);
+    }
+
+    JsonPathTokenWindow(const JsonPathStreamingEvaluator::ChunkReader &reader, TextLength chunkSize) :
+        _reader(&reader), _chunkSize(std::max<TextLength>(chunkSize, 1)), _data(NULL), _length(0), _atEnd(false) {
+        reset(0);
+    }
+
+    const json::Token &Peek() {
+        if(!_peeked) {
+            ensureToken();
+            _peeked = true;
+        }
+        return _tokenStream->Peek();
+    }
+
+    const json::Token &Get() {
+        if(!_peeked) {
+            ensureToken();
+        }
+        _peeked = false;
+        return _tokenStream->Get();
+    }
+
+    // Reads on until the value starting at the next token is in whole; the value is then read
+    // off the returned stream, and nothing past it
+    json::TokenStream &valueTokens();
+
+    // Offset in the text of a location in the token stream
+    TextCoordinate toText(TextCoordinate where) const { return TextCoordinate(_base + where.getAddress()); }
+
+    TextLength maxBufferedLength() const { return _maxBufferedLength; }
+
+private:
+    void ensureToken();
+    void readChunk();
+    void reset(TextLength location);
+
+private:
+    const JsonPathStreamingEvaluator::ChunkReader *_reader = NULL;
+    TextLength _chunkSize = 0;
+    TextString _buffer;
+
+    // Text from offset _base on that's been read
+    const TextChar *_data;
+    TextLength _length;
+    TextLength _base = 0;
+    bool _atEnd;
+
+    // Read text is scanned up to _scanned; _safeEnd is one past the last bracket, comma or
+    // colon outside strings in it, 0 if there's none
+    TextLength _scanned = 0;
+    TextLength _safeEnd = 0;
+    bool _inString = false;
+    bool _escaped = false;
+
+    std::unique_ptr<json::InputStream> _inputStream;
+    std::unique_ptr<json::TokenStream> _tokenStream;
+    bool _peeked = false;
+
+    TextLength _maxBufferedLength = 0;
+};
+
+void JsonPathTokenWindow::reset(TextLength location) {
+    _tokenStream.reset();
+    _inputStream.reset(new json::InputStream(_data, _length));
+    _inputStream->seek(location);
+    _tokenStream.reset(new json::TokenStream(*_inputStream, NULL));
+    _peeked = false;
+}
+
+void JsonPathTokenWindow::ensureToken() {
+    while(!_atEnd && _inputStream->GetLocation().getAddress() >= _safeEnd) {
+        readChunk();
+    }
+}
+
+void JsonPathTokenWindow::readChunk() {
+    // Text before the token being read is dropped; a token peeked at is read again
+    TextLength lKeepFrom = _peeked ? _tokenStream->Peek().locBegin.getAddress() : _inputStream->GetLocation().getAddress();
+    _buffer.erase(0, lKeepFrom);
+    _base += lKeepFrom;
+    _scanned -= lKeepFrom;
+    _safeEnd = _safeEnd > lKeepFrom ? _safeEnd - lKeepFrom : 0;
+
+    TextLength lKept = _buffer.length();
+    _buffer.resize(lKept + _chunkSize);
+    TextLength lRead = (*_reader)(&_buffer[lKept], _chunkSize);
+    _buffer.resize(lKept + lRead);
+    _atEnd = !lRead;
+
+    for(; _scanned < _buffer.length(); _scanned++) {
+        TextChar c = _buffer[_scanned];
+        if(isOutsideStrings(c, _inString, _escaped) && isStructural(c)) {
+            _safeEnd = _scanned + 1;
+        }
+    }
+
+    _maxBufferedLength = std::max(_maxBufferedLength, _buffer.length());
+    _data = _buffer.data();
+    _length = _buffer.length();
+    reset(0);
+}
+
+json::TokenStream &JsonPathTokenWindow::valueTokens() {
+    const json::Token &first = Peek();
+    if(first.nType == json::Token::TOKEN_OBJECT_BEGIN || first.nType == json::Token::TOKEN_ARRAY_BEGIN) {
+        // Look for the closing bracket, reading on (and keeping the value's start) as needed
+        TextLength valueStart = first.locBegin.getAddress();
+        TextLength pos = valueStart;
+        int depth = 0;
+        bool inString = false, escaped = false, closed = false;
+        while(true) {
+            for(; pos < _length && !closed; pos++) {
+                TextChar c = _data[pos];
+                if(!isOutsideStrings(c, inString, escaped)) {
+                    continue;
+                }
+
+                if(c == '{' || c == '[') {
+                    depth++;
+                } else if(c == '}' || c == ']') {
+                    closed = !--depth;
+                }
+            }
+
+            if(closed || _atEnd) {
+                break;
+            }
+
+            readChunk();
+            pos -= valueStart;
+            valueStart = 0;
+            Peek();
+        }
+    }
+
+    // The reader takes the peeked token first
+    _peeked = false;
+    return *_tokenStream;
+}
+
+static void throwUnexpected(JsonPathTokenWindow &tokens, const json::Token &token) {
+    throwMalformed(token.nType == json::Token::TOKEN_EOS ? "unexpected end of input" : "unexpected token", tokens.toText(token.locBegin));
+}
+
+static const json::Token &getExpected(JsonPathTokenWindow &tokens, json::Token::Type expected) {
+    if(tokens.Peek().nType != expected) {
+        throwUnexpected(tokens, tokens.Peek());
+    }
+
+    return tokens.Get();
+}
+
+// After a member or element: true if another one follows, false at the end of the container
+static bool getSeparatorOrEnd(JsonPathTokenWindow &tokens, json::Token::Type end) {
+    const json::Token &token = tokens.Get();
+    if(token.nType != json::Token::TOKEN_NEXT_ELEMENT && token.nType != end) {
+        throwUnexpected(tokens, token);
+    }
+
+    return token.nType == json::Token::TOKEN_NEXT_ELEMENT;
+}
+
+JsonPathStreamingEvaluator::JsonPathStreamingEvaluator(const JsonPathExpression &expression,
+                                                       const JsonPathExpressionOptions &options)
+    : _plan(expression._plan), _options(options), _suffixPc(0)
+{
+    if(!_plan || !_plan->getStreamingSteps(_steps, _suffixPc)) {
+        throw JsonPathEvalError("Expression can't be evaluated over a stream");
+    }
+
+    if(matchesRoot(_steps)) {
+        throw JsonPathEvalError("Expression matches the whole document, which can't be evaluated over a stream");
+    }
+}
+
+bool JsonPathStreamingEvaluator::canStream(const JsonPathExpression &expression) {
+    std::vector<JsonPathStreamingStep> steps;
+    size_t suffixPc;
+    return expression._plan && expression._plan->getStreamingSteps(steps, suffixPc) && !matchesRoot(steps);
+}
+
+// The root is reached by all steps when there are only recursion steps
+bool JsonPathStreamingEvaluator::matchesRoot(const std::vector<JsonPathStreamingStep> &steps) {
+    return std::all_of(steps.begin(), steps.end(), [](const JsonPathStreamingStep &step) {
+        return step.kind == JsonPathStreamingStep::recurseAll;
+    });
+}
+
+void JsonPathStreamingEvaluator::evaluate(JsonPathTokenWindow &tokens, const MatchListener &listener) {
+    _numMaterialized = 0;
+    _maxMaterializedLength = 0;
+
+    States states(1, 0);
+    addRecursion(states);
+    matchValue(tokens, states, listener);
+}
+
+void JsonPathStreamingEvaluator::evaluate(const TextChar *text, TextLength length, const MatchListener &listener) {
+    JsonPathTokenWindow tokens(text, length);
+    _maxBufferedLength = 0;
+    evaluate(tokens, listener);
+}
+
+void JsonPathStreamingEvaluator::evaluate(const ChunkReader &reader, const MatchListener &listener, TextLength chunkSize) {
+    JsonPathTokenWindow tokens(reader, chunkSize);
+    evaluate(tokens, listener);
+    _maxBufferedLength = tokens.maxBufferedLength();
+}
+
+/*
+ * Steps
+ */
+
+// A value a recursion step was reached by is also reached by the step that follows it
+void JsonPathStreamingEvaluator::addRecursion(States &states) const {
+    for(size_t idx = 0; idx < states.size(); idx++) {
+        int state = states[idx];
+        if(state < (int)_steps.size() && _steps[state].kind == JsonPathStreamingStep::recurseAll) {
+            states.push_back(state + 1);
+        }
+    }
+
+    std::sort(states.begin(), states.end());
+    states.erase(std::unique(states.begin(), states.end()), states.end());
+}
+
+// States of a member (memberName set) or an element (index set) of a value in states
+void JsonPathStreamingEvaluator::advance(const States &states, const std::wstring *memberName, int index,
+                                         States &outStates) const {
+    bool fuzzy = _options.fuzzy;
+    for(int state: states) {
+        if(state == (int)_steps.size()) {
+            continue;
+        }
+
+        const JsonPathStreamingStep &step = _steps[state];
+        switch(step.kind) {
+            case JsonPathStreamingStep::member:
+                if(memberName && (fuzzy ? memberName->compare(0, step.name.length(), step.name) == 0 : *memberName == step.name)) {
+                    outStates.push_back(state + 1);
+                }
+                break;
+
+            case JsonPathStreamingStep::recurseMember:
+                outStates.push_back(state);
+                if(memberName && *memberName == step.name) {
+                    outStates.push_back(state + 1);
+                }
+                break;
+
+            case JsonPathStreamingStep::recurseAll:
+                outStates.push_back(state);
+                break;
+
+            case JsonPathStreamingStep::children:
+                outStates.push_back(state + 1);
+                break;
+
+            case JsonPathStreamingStep::indexList:
+                if(!memberName && std::find(step.indices.begin(), step.indices.end(), index) != step.indices.end()) {
+                    outStates.push_back(state + 1);
+                }
+                break;
+
+            case JsonPathStreamingStep::indexRange:
+                if(!memberName && index >= step.rangeStart && index < step.rangeEnd) {
+                    outStates.push_back(state + 1);
+                }
+                break;
+        }
+    }
+
+    addRecursion(outStates);
+}
+
+bool JsonPathStreamingEvaluator::isMatch(const States &states) const {
+    return !states.empty() && states.back() == (int)_steps.size();
+}
+
+/*
+ * Reading
+ */
+
+void JsonPathStreamingEvaluator::matchValue(JsonPathTokenWindow &tokens, const States &states,
+                                            const MatchListener &listener) {
+    if(states.empty()) {
+        skipValue(tokens);
+        return;
+    }
+
+    if(isMatch(states)) {
+        materialize(tokens, states, listener);
+        return;
+    }
+
+    States childStates;
+    switch(tokens.Peek().nType) {
+        case json::Token::TOKEN_OBJECT_BEGIN:
+            tokens.Get();
+            if(tokens.Peek().nType == json::Token::TOKEN_OBJECT_END) {
+                tokens.Get();
+                break;
+            }
+
+            do {
+                std::wstring memberName = getExpected(tokens, json::Token::TOKEN_STRING).value();
+                getExpected(tokens, json::Token::TOKEN_MEMBER_ASSIGN);
+
+                childStates.clear();
+                advance(states, &memberName, -1, childStates);
+                matchValue(tokens, childStates, listener);
+            } while(getSeparatorOrEnd(tokens, json::Token::TOKEN_OBJECT_END));
+            break;
+
+        case json::Token::TOKEN_ARRAY_BEGIN: {
+            tokens.Get();
+            if(tokens.Peek().nType == json::Token::TOKEN_ARRAY_END) {
+                tokens.Get();
+                break;
+            }
+
+            int index = 0;
+            do {
+                childStates.clear();
+                advance(states, NULL, index++, childStates);
+                matchValue(tokens, childStates, listener);
+            } while(getSeparatorOrEnd(tokens, json::Token::TOKEN_ARRAY_END));
+            break;
+        }
+
+        case json::Token::TOKEN_STRING:
+        case json::Token::TOKEN_NUMBER:
+        case json::Token::TOKEN_BOOLEAN:
+        case json::Token::TOKEN_NULL:
+            tokens.Get();
+            break;
+
+        default:
+            throwUnexpected(tokens, tokens.Peek());
+    }
+}
+
+void JsonPathStreamingEvaluator::skipValue(JsonPathTokenWindow &tokens) {
+    int depth = 0;
+    do {
+        const json::Token &token = tokens.Get();
+        switch(token.nType) {
+            case json::Token::TOKEN_OBJECT_BEGIN:
+            case json::Token::TOKEN_ARRAY_BEGIN:
+                depth++;
+                break;
+
+            case json::Token::TOKEN_OBJECT_END:
+            case json::Token::TOKEN_ARRAY_END:
+                if(!depth) {
+                    throwUnexpected(tokens, token);
+                }
+                depth--;
+                break;
+
+            case json::Token::TOKEN_NEXT_ELEMENT:
+            case json::Token::TOKEN_MEMBER_ASSIGN:
+                if(!depth) {
+                    throwUnexpected(tokens, token);
+                }
+                break;
+
+            case json::Token::TOKEN_STRING:
+            case json::Token::TOKEN_NUMBER:
+            case json::Token::TOKEN_BOOLEAN:
+            case json::Token::TOKEN_NULL:
+                break;
+
+            default:
+                throwUnexpected(tokens, token);
+        }
+    } while(depth);
+}
+
+void JsonPathStreamingEvaluator::materialize(JsonPathTokenWindow &tokens, const States &states,
+                                             const MatchListener &listener) {
+    JsonPathStreamingErrorListener errors;
+    json::Reader reader(&errors);
+    json::Node *node = NULL;
+    reader.Parse(node, tokens.valueTokens(), TextCoordinate(0));
+
+    std::unique_ptr<json::Node> subtree(node);
+    if(errors.failed || !node) {
+        throwMalformed(json::FormatParseError(errors.message, errors.arg), tokens.toText(errors.where));
+    }
+
+    _numMaterialized++;
+    _maxMaterializedLength = std::max(_maxMaterializedLength, node->getTextRange().length());
+
+    // Ranges in the subtree are from the start of the text that's kept; the holder puts them
+    // where they are in the whole text
+    json::DocumentNode holder(subtree.release(), tokens.toText(TextCoordinate(0)));
+
+    std::unordered_set<json::Node*> emitted;
+    matchNode(node, states, emitted, listener);
+}
+
+// The steps go on over the subtree that was read, in document order as they would over the stream
+void JsonPathStreamingEvaluator::matchNode(json::Node *node, const States &states,
+                                           std::unordered_set<json::Node*> &emitted, const MatchListener &listener) {
+    if(isMatch(states)) {
+        if(_suffixPc == _plan->size()) {
+            emitted.insert(node);
+            listener(node);
+        } else {
+            for(json::Node *match: _plan->executeFrom(_suffixPc, node, &_options).nodeList) {
+                if(emitted.insert(match).second) {
+                    listener(match);
+                }
+            }
+        }
+    }
+
+    States childStates;
+    json::ObjectNode *objectNode = dynamic_cast<json::ObjectNode*>(node);
+    json::ArrayNode *arrayNode = dynamic_cast<json::ArrayNode*>(node);
+    int childCount = objectNode ? objectNode->getChildCount() : arrayNode ? arrayNode->getChildCount() : 0;
+    for(int idx = 0; idx < childCount; idx++) {
+        childStates.clear();
+        if(objectNode) {
+            advance(states, &objectNode->getMemberNameAt(idx), -1, childStates);
+        } else {
+            advance(states, NULL, idx, childStates);
+        }
+
+        if(!childStates.empty()) {
+            matchNode(objectNode ? objectNode->getChildAt(idx) : arrayNode->getChildAt(idx), childStates, emitted, listener);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+//
+//  JsonPathStreamingEvaluator.hpp
+//  Bracez
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#ifndef JsonPathStreamingEvaluator_hpp
+#define JsonPathStreamingEvaluator_hpp
+
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "reader.h"
+#include "JsonPathExpressionCompiler.hpp"
+
+/*
+ * Evaluates a JsonPath expression over a token stream, without building a DOM for the
+ * document.
+ *
+ * The leading steps of the expression -- child and recursive names, indices, slices from the
+ * start and wildcards -- are matched against the member names and indices of the values as
+ * they're read; values no step can reach are skipped token by token. Only values the
+ * leading steps reach are read into a DOM subtree, and the rest of the expression (e.g a
+ * filter on the current element) is executed on that subtree. Memory is then in the size
+ * of the largest such value rather than of the document.
+ *
+ * The text can be read a chunk at a time; only the part of it from the token being read on is
+ * kept, along with the value being read into a subtree.
+ *
+ * Expressions that read up or across the document (parents, the cursor, `$` in filters),
+ * compute values, or match the root itself (which would read the whole document into a DOM)
+ * can't be streamed. Matches of the leading steps come in document order, each once; a
+ * duplicate member name matches each time it occurs.
+ */
+class JsonPathTokenWindow;
+
+class JsonPathStreamingEvaluator {
+public:
+    // Called with each match. The match and the subtree it's in are only valid during the call;
+    // clone the match to keep it. Text ranges are those in the streamed text.
+    typedef std::function<void (json::Node *match)> MatchListener;
+
+    // Fills buffer with up to capacity characters of the text that follow those read so far;
+    // returns the number filled, 0 at the end of the text
+    typedef std::function<TextLength (TextChar *buffer, TextLength capacity)> ChunkReader;
+
+    // Throws JsonPathEvalError if the expression can't be streamed
+    JsonPathStreamingEvaluator(const JsonPathExpression &expression,
+                               const JsonPathExpressionOptions &options = JsonPathExpressionOptions());
+
+    static bool canStream(const JsonPathExpression &expression);
+
+    // Reads one value from the text. Throws JsonPathEvalError if the value is malformed;
+    // skipped values are only checked for balanced brackets.
+    void evaluate(const TextChar *text, TextLength length, const MatchListener &listener);
+    void evaluate(const ChunkReader &reader, const MatchListener &listener, TextLength chunkSize = 64 * 1024);
+
+    // Of the last evaluation: the number of values read into a DOM subtree, the text
+    // length of the largest, and the most text that was kept in memory at once when read
+    // in chunks
+    size_t numMaterialized() const { return _numMaterialized; }
+    TextLength maxMaterializedLength() const { return _maxMaterializedLength; }
+    TextLength maxBufferedLength() const { return _maxBufferedLength; }
+
+private:
+    // Indices of the steps each value was reached by; a value reached by all steps matches
+    typedef std::vector<int> States;
+
+    static bool matchesRoot(const std::vector<JsonPathStreamingStep> &steps);
+
+    void evaluate(JsonPathTokenWindow &tokens, const MatchListener &listener);
+
+    void addRecursion(States &states) const;
+    void advance(const States &states, const std::wstring *memberName, int index, States &outStates) const;
+    bool isMatch(const States &states) const;
+
+    void matchValue(JsonPathTokenWindow &tokens, const States &states, const MatchListener &listener);
+    void matchNode(json::Node *node, const States &states, std::unordered_set<json::Node*> &emitted, const MatchListener &listener);
+    void materialize(JsonPathTokenWindow &tokens, const States &states, const MatchListener &listener);
+    void skipValue(JsonPathTokenWindow &tokens);
+
+private:
+    std::shared_ptr<const JsonPathExpressionPlan> _plan;
+    JsonPathExpressionOptions _options;
+
+    std::vector<JsonPathStreamingStep> _steps;
+    size_t _suffixPc;
+
+    size_t _numMaterialized = 0;
+    TextLength _maxMaterializedLength = 0;
+    TextLength _maxBufferedLength = 0;
+};
+
+#endif /* JsonPathStreamingEvaluator_hpp */
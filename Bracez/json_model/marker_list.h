@@ -9,6 +9,7 @@
 #define marker_list_h
 
 #include <vector>
+#include <algorithm>
 #include "TextCoordinate.hpp"
 
 class BaseMarker
@@ -33,6 +34,36 @@ protected:
    TextCoordinate coordinate;
 } ;
 
+// How a marker list changed: numRemoved markers at index were replaced by numInserted
+// markers, and the numShifted markers that followed them were kept, with their coordinates
+// moved by shift. Markers before index are unchanged.
+struct MarkerListDelta
+{
+   MarkerListDelta() : index(0), numRemoved(0), numInserted(0), numShifted(0), shift(0) {}
+   MarkerListDelta(size_t aIndex, size_t aNumRemoved, size_t aNumInserted, size_t aNumShifted, long aShift) :
+      index(aIndex), numRemoved(aNumRemoved), numInserted(aNumInserted), numShifted(aNumShifted), shift(aNumShifted ? aShift : 0) {}
+   
+   bool empty() const { return !numRemoved && !numInserted && !shift; }
+   
+   // Delta of applying this delta and then aNext
+   void append(const MarkerListDelta &aNext)
+   {
+      size_t lOldSize = index + numRemoved + numShifted;
+      size_t lNewSize = aNext.index + aNext.numInserted + aNext.numShifted;
+      size_t lKeptHead = std::min(index, aNext.index);
+      size_t lKeptTail = std::min(numShifted, aNext.numShifted);
+      
+      *this = MarkerListDelta(lKeptHead, lOldSize - lKeptHead - lKeptTail, lNewSize - lKeptHead - lKeptTail,
+                              lKeptTail, shift + aNext.shift);
+   }
+   
+   size_t index;
+   size_t numRemoved;
+   size_t numInserted;
+   size_t numShifted;
+   long shift;
+} ;
+
 template <class MARKER_TYPE>
 class MarkerList
 {
@@ -46,6 +77,7 @@ public:
    void appendMarker(const MARKER_TYPE &aMarker);
    
    void clear() { markers.clear(); }
+   void reserve(size_t aCapacity) { markers.reserve(aCapacity); }
    
    const MARKER_TYPE *nextMarker(TextCoordinate &aBookmark) const;
    const MARKER_TYPE *prevMarker(TextCoordinate &aMarker) const;
@@ -55,7 +87,19 @@ public:
 
    bool spliceCoordinatesList(TextCoordinate aOffsetStart, TextLength aLen, TextLength aNewLen,
                               MarkerList<MARKER_TYPE> *aNewMarkers = NULL,
-                               int *aOutEraseStart = NULL, int *aOutEraseLen = NULL);
+                              MarkerListDelta *aOutDelta = NULL);
+   
+   // Batch counterpart of spliceCoordinatesList: in one pass, drops markers aKeep rejects,
+   // moves the rest to aMapCoordinate(coordinate) and merges aNewMarkers in. aKeep gets the
+   // marker, which converts to its coordinate. aMapCoordinate must preserve marker order.
+   template<class KEEP, class MAP>
+   bool remapCoordinates(KEEP aKeep, MAP aMapCoordinate, const MarkerList<MARKER_TYPE> *aNewMarkers = NULL,
+                         MarkerListDelta *aOutDelta = NULL);
+   
+   // Replaces all markers; markers aSame finds unchanged at the start and end of the list
+   // are reported as kept.
+   template<class SAME>
+   bool replaceMarkers(MarkerList<MARKER_TYPE> &&aNewMarkers, SAME aSame, MarkerListDelta *aOutDelta = NULL);
 
    size_t size() const { return markers.size(); }
 
@@ -157,7 +201,7 @@ const MARKER_TYPE &MarkerList<MARKER_TYPE>::markerAt(TextCoordinate aCoord) cons
 template <class MARKER_TYPE>
 bool MarkerList<MARKER_TYPE>::spliceCoordinatesList(TextCoordinate aOffsetStart, TextLength aLen, TextLength aNewLen,
                                                     MarkerList<MARKER_TYPE> *aNewMarkers,
-                                                    int *aOutEraseStart, int *aOutEraseLen)
+                                                    MarkerListDelta *aOutDelta)
 {
    bool lChanged = false;
    
@@ -193,21 +237,145 @@ bool MarkerList<MARKER_TYPE>::spliceCoordinatesList(TextCoordinate aOffsetStart,
    
    // Delete deletion range
    lChanged = lChanged || delstart_iter!=delend_iter;
-   if(aOutEraseStart) *aOutEraseStart = (int)(delstart_iter - markers.begin());
-   if(aOutEraseLen) *aOutEraseLen = (int)(delend_iter - delstart_iter);
+   size_t lEraseStart = delstart_iter - markers.begin();
+   size_t lEraseLen = delend_iter - delstart_iter;
+   size_t lNumShifted = markers.end() - delend_iter;
    
    markers.erase(delstart_iter, delend_iter);
    
-   // Insert splice range
+   // Insert splice range; new markers all fall between the kept ones
     bool hasNewMarkers = aNewMarkers && aNewMarkers->size();
    lChanged = lChanged || hasNewMarkers;
    if(hasNewMarkers)
    {
-      iterator iter = lower_bound(markers.begin(), markers.end(), aNewMarkers->markers.front());
-      markers.insert(iter, aNewMarkers->markers.begin(), aNewMarkers->markers.end());
+      markers.insert(markers.begin() + lEraseStart, aNewMarkers->markers.begin(), aNewMarkers->markers.end());
+   }
+   
+   if(aOutDelta)
+   {
+      *aOutDelta = MarkerListDelta(lEraseStart, lEraseLen, hasNewMarkers ? aNewMarkers->size() : 0, lNumShifted, lLenDiff);
    }
    
    return lChanged;
 }
 
+template <class MARKER_TYPE>
+template <class KEEP, class MAP>
+bool MarkerList<MARKER_TYPE>::remapCoordinates(KEEP aKeep, MAP aMapCoordinate, const MarkerList<MARKER_TYPE> *aNewMarkers,
+                                               MarkerListDelta *aOutDelta)
+{
+   bool lChanged = false;
+   size_t lOldSize = markers.size();
+   
+   MarkerListType lRemapped;
+   lRemapped.reserve(markers.size() + (aNewMarkers ? aNewMarkers->size() : 0));
+   
+   const_iterator lNewIter, lNewEnd;
+   if(aNewMarkers)
+   {
+      lNewIter = aNewMarkers->begin();
+      lNewEnd = aNewMarkers->end();
+      lChanged = lNewIter != lNewEnd;
+   }
+   
+   // Leading markers left as they were, and trailing ones all moved by the same offset
+   bool lInHead = true;
+   size_t lNumHead = 0;
+   size_t lNumTail = 0;
+   long lTailShift = 0;
+   
+   for(MARKER_TYPE &lMarker: markers)
+   {
+      TextCoordinate lCoord = lMarker.getCoordinate();
+      if(!aKeep(lMarker))
+      {
+         lChanged = true;
+         lInHead = false;
+         lNumTail = 0;
+         continue;
+      }
+      
+      TextCoordinate lNewCoord = aMapCoordinate(lCoord);
+      long lShift = (long)lNewCoord.getAddress() - (long)lCoord.getAddress();
+      if(lShift)
+      {
+         lMarker.adjustCoordinate(lShift);
+         lChanged = true;
+      }
+      
+      size_t lNumRemapped = lRemapped.size();
+      for(; aNewMarkers && lNewIter != lNewEnd && *lNewIter < lMarker; lNewIter++)
+      {
+         lRemapped.push_back(*lNewIter);
+      }
+      
+      if(aNewMarkers && lNewIter != lNewEnd && *lNewIter == lMarker)
+      {
+         lNewIter++;
+      }
+      
+      lInHead = lInHead && lNumRemapped == lRemapped.size() && !lShift;
+      if(lInHead)
+      {
+         lNumHead++;
+      }
+      
+      if(lNumTail && lNumRemapped == lRemapped.size() && lShift == lTailShift)
+      {
+         lNumTail++;
+      } else
+      {
+         lNumTail = 1;
+         lTailShift = lShift;
+      }
+      
+      lRemapped.push_back(std::move(lMarker));
+   }
+   
+   if(aNewMarkers && lNewIter != lNewEnd)
+   {
+      lRemapped.insert(lRemapped.end(), lNewIter, lNewEnd);
+      lNumTail = 0;
+   }
+   
+   if(aOutDelta)
+   {
+      lNumTail = std::min(lNumTail, std::min(lOldSize, lRemapped.size()) - lNumHead);
+      *aOutDelta = MarkerListDelta(lNumHead, lOldSize - lNumHead - lNumTail, lRemapped.size() - lNumHead - lNumTail,
+                                   lNumTail, lTailShift);
+   }
+   
+   markers.swap(lRemapped);
+   return lChanged;
+}
+
+template <class MARKER_TYPE>
+template <class SAME>
+bool MarkerList<MARKER_TYPE>::replaceMarkers(MarkerList<MARKER_TYPE> &&aNewMarkers, SAME aSame, MarkerListDelta *aOutDelta)
+{
+   size_t lOldSize = markers.size();
+   size_t lNewSize = aNewMarkers.size();
+   
+   size_t lNumHead = 0;
+   while(lNumHead < lOldSize && lNumHead < lNewSize && aSame(markers[lNumHead], aNewMarkers.markers[lNumHead]))
+   {
+      lNumHead++;
+   }
+   
+   size_t lNumTail = 0;
+   while(lNumHead + lNumTail < lOldSize && lNumHead + lNumTail < lNewSize &&
+         aSame(markers[lOldSize - lNumTail - 1], aNewMarkers.markers[lNewSize - lNumTail - 1]))
+   {
+      lNumTail++;
+   }
+   
+   if(aOutDelta)
+   {
+      *aOutDelta = MarkerListDelta(lNumHead, lOldSize - lNumHead - lNumTail, lNewSize - lNumHead - lNumTail, lNumTail, 0);
+   }
+   
+   markers.swap(aNewMarkers.markers);
+   return lNumHead != lOldSize || lNumHead != lNewSize;
+}
+
 #endif /* marker_lisst_h */
@@ -9,8 +9,95 @@
 
 namespace json {
 
-bool TokenStream::ProcessStringEscape(std::wstring &tokValue) {
-    wchar_t c = inputStream.Get();
+// Tokens quoted in error messages are cut after this many characters
+#define MAX_QUOTED_TOKEN_LENGTH 40
+
+static std::string quoteToken(unsigned int aArg, const TextChar *aText, const TextChar *aTextEnd)
+{
+    TextLength lTokenLen = aArg & PARSE_ERROR_ARG_LENGTH_MASK;
+    if(!aText || !lTokenLen) {
+        return std::string();
+    }
+    
+    const TextChar *lEnd = aText + std::min<TextLength>(lTokenLen, MAX_QUOTED_TOKEN_LENGTH);
+    if(lEnd > aTextEnd) {
+        lEnd = aTextEnd;
+    }
+    
+    std::string lRet = ": " + utf8FromText(aText, lEnd);
+    if(lTokenLen > MAX_QUOTED_TOKEN_LENGTH) {
+        lRet += "...";
+    }
+    
+    return lRet;
+}
+
+static const char *expectedTokenName(unsigned int aType)
+{
+    switch(aType) {
+        case Token::TOKEN_OBJECT_BEGIN:     return "'{'";
+        case Token::TOKEN_OBJECT_END:       return "'}'";
+        case Token::TOKEN_ARRAY_BEGIN:      return "'['";
+        case Token::TOKEN_ARRAY_END:        return "']'";
+        case Token::TOKEN_NEXT_ELEMENT:     return "','";
+        case Token::TOKEN_MEMBER_ASSIGN:    return "':'";
+        case Token::TOKEN_STRING:           return "string";
+        case Token::TOKEN_NUMBER:           return "number";
+        case Token::TOKEN_BOOLEAN:          return "'true' or 'false'";
+        case Token::TOKEN_NULL:             return "'null'";
+        default:                            return "";
+    }
+}
+
+std::string FormatParseError(int aMessage, unsigned int aArg, const TextChar *aText, const TextChar *aTextEnd)
+{
+    switch(aMessage) {
+        case PARSE_MSG_EXPECTED_HEX_DIGIT:
+            return "Expected a hex digit";
+        case PARSE_MSG_UNRECOGNIZED_ESCAPE: {
+            TextChar c = (TextChar)aArg;
+            return "Unrecognized escape sequence found in string: \\" + utf8FromText(&c, &c+1);
+        }
+        case PARSE_MSG_EXPECTED_SURROGATE_ESCAPE:
+            return "Expected \\u after surrogate character.";
+        case PARSE_MSG_UNTERMINATED_STRING:
+            return "Unterminated string constant.";
+        case PARSE_MSG_UNKNOWN_TOKEN:
+            return "Unknown token in stream" + quoteToken(aArg, aText, aTextEnd);
+        case PARSE_MSG_EXPECTED_EOS:
+            return "Expected End of token stream.";
+        case PARSE_MSG_UNEXPECTED_EOS:
+            return "Unexpected end of token stream";
+        case PARSE_MSG_UNEXPECTED_TOKEN:
+            return "Unexpected token" + quoteToken(aArg, aText, aTextEnd);
+        case PARSE_MSG_EXPECTED_TOKEN:
+            return "Unexpected token" + quoteToken(aArg, aText, aTextEnd) + "; expecting " +
+                   expectedTokenName(aArg >> PARSE_ERROR_ARG_LENGTH_BITS);
+        case PARSE_MSG_EXPECTED_MEMBER_NAME:
+            return "Expected object member name";
+        case PARSE_MSG_EXPECTED_MEMBER_ASSIGN:
+            return "Expected ':'";
+        case PARSE_MSG_EXPECTED_MEMBER_VALUE:
+            return "Expected object member value";
+        case PARSE_MSG_DUPLICATE_MEMBER:
+            return "Duplicate object member" + quoteToken(aArg, aText, aTextEnd);
+        case PARSE_MSG_INVALID_MEMBER:
+            return "Could not parse member value" + quoteToken(aArg, aText, aTextEnd);
+        case PARSE_MSG_UNEXPECTED_EOF:
+            return "Unexpected end of file";
+        case PARSE_MSG_EXPECTED_ARRAY_SEPARATOR:
+            return "Expecting \",\" or \"]\"";
+        case PARSE_MSG_MALFORMED_NUMBER:
+            return "Unexpected character in NUMBER token";
+        case PARSE_MSG_MORE_ERRORS:
+            return std::to_string(aArg) + " more errors in range";
+        default:
+            return "Parse error";
+    }
+}
+
+bool TokenStream::ProcessStringEscape(TextString &tokValue) {
+    TextChar c = inputStream.Get();
     switch (c) {
         case L'/':      tokValue.push_back(L'/');     return true;
         case L'"':      tokValue.push_back(L'"');     return true;
@@ -32,22 +119,23 @@ bool TokenStream::ProcessStringEscape(std::wstring &tokValue) {
                     {
                         inputStream.Get();
                         Match4Hex(surrogate);
-                        codepoint = (((codepoint & 0x3F) << 10) |
-                                     ((((codepoint >> 6) & 0xF) + 1) << 16) |
-                                     (surrogate & 0x3FF));
+                        
+                        // Text is UTF-16, so the pair is stored as-is
+                        tokValue.push_back((TextChar)codepoint);
+                        codepoint = surrogate;
                     } else
                     {
                         if(listener)
-                            listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, "Expected \\u after surrogate character.");
+                            listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, PARSE_MSG_EXPECTED_SURROGATE_ESCAPE);
                     }
                 } else
                 {
                     if(listener)
-                        listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, "Expected \\u after surrogate character.");
+                        listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, PARSE_MSG_EXPECTED_SURROGATE_ESCAPE);
                 }
             }
             
-            tokValue.push_back(codepoint);
+            tokValue.push_back((TextChar)codepoint);
             return true;
         }
         default:
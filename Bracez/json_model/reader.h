@@ -22,6 +22,47 @@ namespace json
 #define PARSER_ERROR_DUPLICATE_MEMBER     5
 #define PARSER_ERROR_MALFORMED_NUMBER     6
 #define PARSER_ERROR_INVALID_MEMBER       7
+#define PARSER_ERROR_TOO_MANY_ERRORS      8
+
+// Errors are reported as a message id and a compact argument rather than a formatted string;
+// the text is only built by FormatParseError when an error is displayed.
+enum ParseErrorMessage
+{
+    PARSE_MSG_EXPECTED_HEX_DIGIT,
+    PARSE_MSG_UNRECOGNIZED_ESCAPE,          // arg: the escaped character
+    PARSE_MSG_EXPECTED_SURROGATE_ESCAPE,
+    PARSE_MSG_UNTERMINATED_STRING,
+    PARSE_MSG_UNKNOWN_TOKEN,                // arg: token length
+    PARSE_MSG_EXPECTED_EOS,
+    PARSE_MSG_UNEXPECTED_EOS,
+    PARSE_MSG_UNEXPECTED_TOKEN,             // arg: token length
+    PARSE_MSG_EXPECTED_TOKEN,               // arg: token length and expected type
+    PARSE_MSG_EXPECTED_MEMBER_NAME,
+    PARSE_MSG_EXPECTED_MEMBER_ASSIGN,
+    PARSE_MSG_EXPECTED_MEMBER_VALUE,
+    PARSE_MSG_DUPLICATE_MEMBER,             // arg: member name token length
+    PARSE_MSG_INVALID_MEMBER,               // arg: member name token length
+    PARSE_MSG_UNEXPECTED_EOF,
+    PARSE_MSG_EXPECTED_ARRAY_SEPARATOR,
+    PARSE_MSG_MALFORMED_NUMBER,
+    PARSE_MSG_MORE_ERRORS                   // arg: number of errors not reported
+};
+
+// Token lengths are kept in the low bits of an error argument; longer tokens are only
+// quoted up to a prefix anyway.
+#define PARSE_ERROR_ARG_LENGTH_BITS 20
+#define PARSE_ERROR_ARG_LENGTH_MASK ((1u << PARSE_ERROR_ARG_LENGTH_BITS) - 1)
+
+inline unsigned int MakeParseErrorArg(TextLength aTokenLength, unsigned int aExtra = 0)
+{
+    return (aExtra << PARSE_ERROR_ARG_LENGTH_BITS) |
+           (unsigned int)std::min<TextLength>(aTokenLength, PARSE_ERROR_ARG_LENGTH_MASK);
+}
+
+// Formats an error message. If aText is specified it points at the error coordinate in the
+// parsed text (up to aTextEnd), and is used to quote the offending token.
+std::string FormatParseError(int aMessage, unsigned int aArg,
+                             const TextChar *aText = NULL, const TextChar *aTextEnd = NULL);
 
 
 //////////////////////
@@ -29,35 +70,42 @@ struct ParseListener
 {
     virtual ~ParseListener() {}
     
-    virtual void EndOfLine(TextCoordinate aWhere) = 0;
-    virtual void Error(TextCoordinate aWhere, int aCode, const string &aText)=0;
+    virtual void Error(TextCoordinate aWhere, int aCode, ParseErrorMessage aMessage, unsigned int aArg = 0)=0;
 };
 
 class InputStream // would be cool if we could inherit from std::istream & override "get"
 {
 public:
-    InputStream(const wchar_t *aBuffer, TextLength aLength, ParseListener *aListener = NULL,
-                TextCoordinate aStartLocation = TextCoordinate());
+    // If aLineBreaks is specified, the location of each line break read is appended to it
+    InputStream(const TextChar *aBuffer, TextLength aLength,
+                TextCoordinate aStartLocation = TextCoordinate(),
+                SimpleMarkerList *aLineBreaks = NULL);
     
     // protect access to the input stream, so we can keep track of document/line offsets
-    inline wchar_t Get();
-    inline wchar_t Peek();
+    inline TextChar Get();
+    inline TextChar Peek();
     
-    const wchar_t *CurrentPtr() const;
+    const TextChar *CurrentPtr() const;
     
     bool EOS() const;
     
-    bool VerifyString(const std::wstring &sExpected);
+    bool VerifyString(const TextString &sExpected);
     const TextCoordinate GetLocation() const { return TextCoordinate(m_Location); }
     
     void seek(const unsigned long where);
     TextLength length() const { return m_Length; }
     
+    TextCoordinate GetLineStart() const { return TextCoordinate(m_LineStart); }
+    unsigned long GetNumLineBreaks() const { return m_NumLineBreaks; }
+    
 private:
-    const wchar_t* m_Buffer;
+    const TextChar* m_Buffer;
     std::atomic<unsigned long> m_Location;
     TextLength m_Length;
-    ParseListener *m_parseListener;
+    
+    unsigned long m_LineStart;
+    unsigned long m_NumLineBreaks;
+    SimpleMarkerList *m_LineBreaks;
 };
 
 struct Token
@@ -84,7 +132,7 @@ struct Token
         CHAR_CLASS_NUMERIC = 1,
     };
     
-    Token() : nType(TOKEN_UNKNOWN), valueBuff(NULL) {}
+    Token() : nType(TOKEN_UNKNOWN), orgTextStart(NULL), orgTextEnd(NULL), valueBuff(NULL) {}
     
     Token(const Token &other) {
         assignFrom(other);
@@ -113,9 +161,7 @@ struct Token
         locEnd = other.locEnd;
         
         if(other.valueBuff) {
-            valueBuff = wcsdup(other.valueBuff);
-            valueStart = valueBuff;
-            valueEnd = valueStart + (other.valueEnd-other.valueStart);
+            setOwnValue(other.valueStart, other.valueEnd-other.valueStart);
         } else {
             valueEnd = other.valueEnd;
             valueStart = other.valueStart;
@@ -137,11 +183,19 @@ struct Token
         valueStart = NULL;
     }
     
-    inline bool isValueEquals(const wchar_t *operand) const {
-        const wchar_t *s1 = valueStart;
-        const wchar_t *s2 = operand;
+    inline void setOwnValue(const TextChar *aValue, size_t aLen) {
+        valueBuff = (TextChar*)malloc(sizeof(TextChar)*(aLen ? aLen : 1));
+        memcpy(valueBuff, aValue, sizeof(TextChar)*aLen);
+        valueStart = valueBuff;
+        valueEnd = valueBuff + aLen;
+    }
+    
+    // operand is compared unit by unit, so it must be plain ASCII
+    inline bool isValueEquals(const char *operand) const {
+        const TextChar *s1 = valueStart;
+        const char *s2 = operand;
         while(*s2 && s1 < valueEnd) {
-            if(*s2 != *s1) {
+            if((TextChar)*s2 != *s1) {
                 return false;
             }
             
@@ -151,18 +205,19 @@ struct Token
         return !(*s2 || s1 < valueEnd);
     }
     
-    std::wstring value() const { assert(valueStart); return std::wstring(valueStart, valueEnd); }
-    std::wstring orgText() const { assert(orgTextStart); return std::wstring(orgTextStart, orgTextEnd); }
+    std::wstring value() const { assert(valueStart); return wstringFromText(valueStart, valueEnd); }
+    TextString orgText() const { assert(orgTextStart); return TextString(orgTextStart, orgTextEnd); }
+    TextLength orgTextLength() const { return orgTextStart ? orgTextEnd-orgTextStart : 0; }
     
     Type nType;
     
-    const wchar_t *orgTextStart;
-    const wchar_t *orgTextEnd;
+    const TextChar *orgTextStart;
+    const TextChar *orgTextEnd;
     
-    const wchar_t *valueStart;
-    const wchar_t *valueEnd;
+    const TextChar *valueStart;
+    const TextChar *valueEnd;
     
-    wchar_t *valueBuff;
+    TextChar *valueBuff;
     
     // for malformed file debugging
     TextCoordinate locBegin;
@@ -191,17 +246,15 @@ private:
     void MatchString();
     void MatchBareWordToken();
     void MatchNumber();
-    void updateLineCol(wchar_t forChar);
-    bool ProcessStringEscape(std::wstring &tokValue);
+    bool ProcessStringEscape(TextString &tokValue);
 
     bool skipWhitespace;
     bool tokenEaten;
     Token currentToken;
     bool isEos;
     
-    int currentCol;
-    int currentRow;
-    bool prevNewLine;
+    int startCol;
+    int startRow;
     
     InputStream &inputStream;
     ParseListener *listener;
@@ -242,6 +295,7 @@ public:
     
     
     // if you know what the document looks like, call one of these...
+    // (wstring overloads report the consumed length in characters, not UTF-16 units)
     static unsigned long Read(ObjectNode *& object, const std::wstring& istr);
     static unsigned long Read(ArrayNode *& array, const std::wstring& istr);
     static unsigned long Read(StringNode *& string, const std::wstring& istr);
@@ -251,6 +305,7 @@ public:
     
     // ...otherwise, if you don't know, call this & visit it
     static unsigned long Read(Node *& elementRoot, const std::wstring& istr, ParseListener *aParseListener=NULL, bool allowSuffix = false);
+    static unsigned long Read(Node *& elementRoot, const TextString& istr, ParseListener *aParseListener=NULL, bool allowSuffix = false);
     
     Reader(ParseListener *aParseListener);
     
@@ -259,6 +314,9 @@ private:
     template <typename ElementTypeT>
     static unsigned long Read_i(ElementTypeT& element, const std::wstring& istr, ParseListener *aListener=NULL, bool allowSuffix = false);
     
+    template <typename ElementTypeT>
+    static unsigned long Read_i(ElementTypeT& element, const TextString& istr, ParseListener *aListener=NULL, bool allowSuffix = false);
+    
 public:
     // parsing token sequence into element structure
     void Parse(Node *& element, TokenStream& tokenStream, TextCoordinate aBaseOfs=TextCoordinate(0));
@@ -275,7 +333,7 @@ public:
     inline const Token &MatchExpectedToken(Token::Type nExpected, TokenStream& tokenStream);
     inline bool ParseSeparatorOrTerminator(TokenStream& tokenStream, Token::Type terminator);
     void ReportExpectedToken(Token::Type nExpected, const Token& token);
-    inline bool AssertNonObjectMemberTerminatorWithError(TokenStream &tokenStream, const char *error);
+    inline bool AssertNonObjectMemberTerminatorWithError(TokenStream &tokenStream, ParseErrorMessage error);
 private:
     ParseListener *listener;
 };
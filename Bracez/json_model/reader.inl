@@ -10,14 +10,6 @@
 #include <set>
 #include <map>
 #include <sstream>
-#include <codecvt>
-
-// convert wstring to UTF-8 string
-static std::string wstring_to_utf8 (const std::wstring& str)
-{
-    std::wstring_convert< std::codecvt_utf8<wchar_t> > myconv;
-    return myconv.to_bytes(str);
-}
 
 namespace json
 {
@@ -27,20 +19,21 @@ namespace json
 // Reader::InputStream
 
 
-inline InputStream::InputStream(const wchar_t *aBuffer, TextLength aLength, ParseListener *aListener,
-                                TextCoordinate aStartLocation) :
-m_Buffer(aBuffer), m_Location(aStartLocation), m_parseListener(aListener), m_Length(aLength) {
+inline InputStream::InputStream(const TextChar *aBuffer, TextLength aLength,
+                                TextCoordinate aStartLocation, SimpleMarkerList *aLineBreaks) :
+m_Buffer(aBuffer), m_Location(aStartLocation), m_Length(aLength),
+m_LineStart(aStartLocation), m_NumLineBreaks(0), m_LineBreaks(aLineBreaks) {
     
 }
 
 
 
-inline wchar_t InputStream::Peek() {
+inline TextChar InputStream::Peek() {
     assert(!EOS());
     return *CurrentPtr();
 }
 
-inline const wchar_t *InputStream::CurrentPtr() const {
+inline const TextChar *InputStream::CurrentPtr() const {
     return m_Buffer + m_Location;
 }
 
@@ -52,26 +45,28 @@ inline void InputStream::seek(unsigned long where) {
     m_Location = where;
 }
 
-inline bool InputStream::VerifyString(const std::wstring &sExpected)
+inline bool InputStream::VerifyString(const TextString &sExpected)
 {
     unsigned long expectedLen = sExpected.length();
-    const wchar_t *expected = sExpected.c_str();
+    const TextChar *expected = sExpected.c_str();
     if(expectedLen > m_Length-m_Location) {
         return false;
     }
     
-    return !memcmp(expected, CurrentPtr(), sizeof(wchar_t)*expectedLen);
+    return !memcmp(expected, CurrentPtr(), sizeof(TextChar)*expectedLen);
 }
 
 
-inline wchar_t InputStream::Get()
+inline TextChar InputStream::Get()
 {
-    wchar_t c = *CurrentPtr();
+    TextChar c = *CurrentPtr();
     m_Location = m_Location + 1;
     if (c == L'\n') {
-        if(m_parseListener)
+        m_LineStart = m_Location;
+        m_NumLineBreaks++;
+        if(m_LineBreaks)
         {
-            m_parseListener->EndOfLine(TextCoordinate(m_Location-1));
+            m_LineBreaks->appendMarker(BaseMarker(TextCoordinate(m_LineStart-1)));
         }
     }
     
@@ -87,8 +82,8 @@ inputStream(aInputStream),
 tokenEaten(true),
 listener(aListener),
 skipWhitespace(aSkipWhitespace),
-currentRow(startRow),
-currentCol(startCol),
+startRow(startRow),
+startCol(startCol),
 isEos(false)
 {
     // Prepare lookup tables
@@ -143,11 +138,12 @@ inline bool TokenStream::EOS() const {
 }
 
 inline int TokenStream::Row() {
-    return currentRow;
+    return startRow + (int)inputStream.GetNumLineBreaks();
 }
 
 inline int TokenStream::Col() {
-    return currentCol;
+    int lCol = (int)(inputStream.GetLocation() - inputStream.GetLineStart());
+    return inputStream.GetNumLineBreaks() ? lCol : startCol + lCol;
 }
 
 inline void TokenStream::pumpTokenIfNeeded()
@@ -168,8 +164,8 @@ inline void TokenStream::pumpToken()
         currentToken.nType = Token::TOKEN_EOS;
     } else {
         // Get current token type (good guess...)
-        wchar_t sChar = inputStream.Peek();
-        currentToken.nType = (Token::Type)tokenTypeLookup[sChar];
+        TextChar sChar = inputStream.Peek();
+        currentToken.nType = sChar < 256 ? (Token::Type)tokenTypeLookup[sChar] : Token::TOKEN_UNKNOWN;
         
         switch (currentToken.nType)
         {
@@ -190,7 +186,6 @@ inline void TokenStream::pumpToken()
                 inputStream.Get();
                 currentToken.orgTextEnd = inputStream.CurrentPtr();
                 currentToken.assumeValueFromOrgText();
-                updateLineCol(sChar);
         }
     }
     
@@ -204,7 +199,7 @@ inline void TokenStream::EatWhiteSpace()
     if(skipWhitespace) {
         while (inputStream.EOS() == false &&
                ::isspace(inputStream.Peek()))
-            updateLineCol(inputStream.Get());
+            inputStream.Get();
     }
     
     if(inputStream.EOS()) {
@@ -217,7 +212,7 @@ inline void TokenStream::Match4Hex(unsigned int& integer) {
     for (int i = 0;
          (i < 4) && (inputStream.EOS() == false);
          ++i) {
-        wchar_t hex_char = inputStream.Peek();
+        TextChar hex_char = inputStream.Peek();
             
         integer = integer << 4;
         
@@ -225,13 +220,13 @@ inline void TokenStream::Match4Hex(unsigned int& integer) {
             integer |= hex_char - '0';
         } else
         if(hex_char >= L'a' && hex_char <= L'f') {
-            integer |= hex_char - 'a';
+            integer |= hex_char - 'a' + 10;
         } else
         if(hex_char >= L'A' && hex_char <= L'F') {
-            integer |=  hex_char - 'A';
+            integer |=  hex_char - 'A' + 10;
         } else {
             if(listener)
-                listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, "Expected a hex digit");
+                listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, PARSE_MSG_EXPECTED_HEX_DIGIT);
             return;
         }
         
@@ -241,7 +236,7 @@ inline void TokenStream::Match4Hex(unsigned int& integer) {
 
 inline void TokenStream::MatchString()
 {
-    std::wstring tokValue;
+    TextString tokValue;
         
     // Eat starting "\""
     currentToken.orgTextStart = inputStream.CurrentPtr();
@@ -254,9 +249,7 @@ inline void TokenStream::MatchString()
     while (!inputStream.EOS()  &&
            inputStream.Peek() != L'"')
     {
-        wchar_t c = inputStream.Get();
-        
-        updateLineCol(c);
+        TextChar c = inputStream.Get();
         
         // escape?
         if (c == L'\\' &&
@@ -264,13 +257,12 @@ inline void TokenStream::MatchString()
         {
             // Prepare 'ownbuff' if not ready
             if(tokValue.empty()) {
-                tokValue = std::wstring(currentToken.valueStart, inputStream.CurrentPtr()-1);
+                tokValue = TextString(currentToken.valueStart, inputStream.CurrentPtr()-1);
             }
             
             if(!ProcessStringEscape(tokValue)) {
-                std::string sMessage = "Unrecognized escape sequence found in string: \\" + wstring_to_utf8(wstring(&c, 1));
                 if(listener)
-                    listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, sMessage);
+                    listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_CHARACTER, PARSE_MSG_UNRECOGNIZED_ESCAPE, c);
             }
         }
         else {
@@ -284,9 +276,7 @@ inline void TokenStream::MatchString()
     if(tokValue.empty()) {
         currentToken.valueEnd = inputStream.CurrentPtr();
     } else {
-        currentToken.valueBuff = wcsdup(tokValue.c_str());
-        currentToken.valueStart = currentToken.valueBuff;
-        currentToken.valueEnd = currentToken.valueBuff + wcslen(currentToken.valueBuff);
+        currentToken.setOwnValue(tokValue.data(), tokValue.length());
     }
     
     if(!inputStream.EOS()) {
@@ -294,9 +284,8 @@ inline void TokenStream::MatchString()
         inputStream.Get();
     } else {
         currentToken.orgTextEnd++;        
-        std::string sMessage = "Unterminated string constant.";
         if(listener)
-            listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_EOS, sMessage);
+            listener->Error(inputStream.GetLocation(), PARSER_ERROR_UNEXPECTED_EOS, PARSE_MSG_UNTERMINATED_STRING);
     }
     
     // Store end of token
@@ -309,44 +298,47 @@ inline void TokenStream::MatchBareWordToken()
     currentToken.clearValue();
     
     currentToken.orgTextStart = inputStream.CurrentPtr();
-    wchar_t c;
-    wchar_t barewordBuffer[8] = {0};
+    TextChar c;
+    char barewordBuffer[8] = {0};
     int barewordLen = 0;
     while(!inputStream.EOS() &&
           !::isspace(c=inputStream.Peek()) &&
           c >= L'a' && c <= L'z' &&
-          barewordLen < sizeof(barewordBuffer)/sizeof(wchar_t))
+          barewordLen < sizeof(barewordBuffer)-1)
     {
-        updateLineCol(c);
         inputStream.Get();
         
-        barewordBuffer[barewordLen++] = c;
+        barewordBuffer[barewordLen++] = (char)c;
         
         // We want to break the bareword if it's recognized --
         // to support a scenario of "parse json with suffix"
-        if((barewordLen == 4 && (!wcscmp(barewordBuffer, L"true") || !wcscmp(barewordBuffer, L"null"))) ||
-           (barewordLen == 5 && (!wcscmp(barewordBuffer, L"false"))))
+        if((barewordLen == 4 && (!strcmp(barewordBuffer, "true") || !strcmp(barewordBuffer, "null"))) ||
+           (barewordLen == 5 && (!strcmp(barewordBuffer, "false"))))
         {
             break;
         }
     }
     
+    // Stray character (not a token start); consume it so that the stream always advances
+    if(!barewordLen && !inputStream.EOS()) {
+        inputStream.Get();
+    }
+    
     currentToken.orgTextEnd = inputStream.CurrentPtr();
     currentToken.assumeValueFromOrgText();
     
-    if(currentToken.isValueEquals(L"true") || currentToken.isValueEquals(L"false"))
+    if(currentToken.isValueEquals("true") || currentToken.isValueEquals("false"))
     {
         currentToken.nType = Token::TOKEN_BOOLEAN;
     } else
-    if(currentToken.isValueEquals(L"null"))
+    if(currentToken.isValueEquals("null"))
     {
         currentToken.nType = Token::TOKEN_NULL;
     } else
     {
-        
-        std::string sErrorMessage = "Unknown token in stream: " + wstring_to_utf8(currentToken.value());
         if(listener)
-            listener->Error(currentToken.locBegin, PARSER_ERROR_UNEXPECTED_CHARACTER, sErrorMessage);
+            listener->Error(currentToken.locBegin, PARSER_ERROR_UNEXPECTED_CHARACTER, PARSE_MSG_UNKNOWN_TOKEN,
+                            MakeParseErrorArg(currentToken.orgTextLength()));
     }
 }
 
@@ -365,8 +357,8 @@ inline void TokenStream::MatchNumber()
     
     while (inputStream.EOS() == false)
     {
-        char curChar = inputStream.Peek();
-        auto curCharClass = charClassLookup[inputStream.Peek()];
+        TextChar curChar = inputStream.Peek();
+        auto curCharClass = curChar < 256 ? charClassLookup[curChar] : Token::CHAR_CLASS_UNKNOWN;
         bool validChar = true;
         
         switch(state) {
@@ -403,7 +395,7 @@ inline void TokenStream::MatchNumber()
         }
         
         if(validChar) {
-            updateLineCol(inputStream.Get());
+            inputStream.Get();
         } else {
             break;
         }
@@ -413,19 +405,6 @@ inline void TokenStream::MatchNumber()
     currentToken.assumeValueFromOrgText();
 }
 
-inline void TokenStream::updateLineCol(wchar_t forChar) {
-    if(prevNewLine) {
-        currentCol = 0;
-        currentRow++;
-        prevNewLine = false;
-    } else {
-        currentCol++;
-        if(forChar == '\n') {
-            prevNewLine = true;
-        }
-    }
-}
-
 ///////////////////
 // Reader (finally)
 
@@ -440,17 +419,38 @@ inline unsigned long Reader::Read(NumberNode*& number, const std::wstring& istr)
 inline unsigned long Reader::Read(BooleanNode*& boolean, const std::wstring& istr) { return Read_i(boolean, istr); }
 inline unsigned long Reader::Read(NullNode*& null, const std::wstring& istr)       { return Read_i(null, istr); }
 inline unsigned long Reader::Read(Node*& unknown, const std::wstring& istr, ParseListener *aParseListener, bool allowSuffix)       { return Read_i(unknown, istr, aParseListener, allowSuffix); }
+inline unsigned long Reader::Read(Node*& unknown, const TextString& istr, ParseListener *aParseListener, bool allowSuffix)       { return Read_i(unknown, istr, aParseListener, allowSuffix); }
 
 
-template <typename ElementTypeT>   
+template <typename ElementTypeT>
 unsigned long Reader::Read_i(ElementTypeT& element,
                              const  std::wstring& istr,
                              ParseListener *aParseListener,
                              bool allowSuffix)
+{
+    TextString lText = textStringFromWstring(istr);
+    unsigned long lConsumedUnits = Read_i(element, lText, aParseListener, allowSuffix);
+    
+    // Map consumed UTF-16 units back to characters of the caller's string
+    unsigned long lConsumed = lConsumedUnits;
+    for(unsigned long i = 1; i < lConsumedUnits; i++) {
+        if(isLowSurrogate(lText[i]) && isHighSurrogate(lText[i-1])) {
+            lConsumed--;
+        }
+    }
+    
+    return lConsumed;
+}
+
+template <typename ElementTypeT>
+unsigned long Reader::Read_i(ElementTypeT& element,
+                             const TextString& istr,
+                             ParseListener *aParseListener,
+                             bool allowSuffix)
 {
     Reader reader(aParseListener);
     
-    InputStream inputStream(istr.c_str(), istr.size(), aParseListener);
+    InputStream inputStream(istr.c_str(), istr.size());
     TokenStream tokenStream(inputStream, aParseListener);
     reader.Parse(element, tokenStream, allowSuffix);
     
@@ -463,7 +463,7 @@ inline void Reader::Parse(T &element, TokenStream &tokenStream, bool allowSuffix
         
     if (!tokenStream.EOS() && !allowSuffix)
     {
-        listener->Error(tokenStream.getInputStream().GetLocation(), PARSER_ERROR_EXPECTED_EOS, "Expected End of token stream.");
+        listener->Error(tokenStream.getInputStream().GetLocation(), PARSER_ERROR_EXPECTED_EOS, PARSE_MSG_EXPECTED_EOS);
     }
 }
 
@@ -521,20 +521,20 @@ inline void Reader::Parse(Node*& element, TokenStream& tokenStream, TextCoordina
         }
                         
         case Token::TOKEN_EOS:
-            listener->Error(TextCoordinate(), PARSER_ERROR_UNEXPECTED_EOS, "Unexpected end of token stream");
+            listener->Error(TextCoordinate(), PARSER_ERROR_UNEXPECTED_EOS, PARSE_MSG_UNEXPECTED_EOS);
             break;
             
         default:
         {
-            std::string sMessage = "Unexpected token: " + wstring_to_utf8(token.value());
-            listener->Error(token.locBegin, PARSER_ERROR_UNEXPECTED_TOKEN, sMessage);
+            listener->Error(token.locBegin, PARSER_ERROR_UNEXPECTED_TOKEN, PARSE_MSG_UNEXPECTED_TOKEN,
+                            MakeParseErrorArg(token.orgTextLength()));
             tokenStream.Get();
         }
     }
 }
 
 
-inline bool Reader::AssertNonObjectMemberTerminatorWithError(TokenStream &tokenStream, const char *error) {
+inline bool Reader::AssertNonObjectMemberTerminatorWithError(TokenStream &tokenStream, ParseErrorMessage error) {
     
     const Token &tok = tokenStream.Peek();
     if(tok.nType & (Token::TOKEN_OBJECT_END | Token::TOKEN_NEXT_ELEMENT | Token::TOKEN_EOS)) {
@@ -564,14 +564,14 @@ inline void Reader::Parse(ObjectNode*& object, TokenStream& tokenStream, TextCoo
         bContinue = ParseSeparatorOrTerminator(tokenStream, Token::TOKEN_OBJECT_END))
     {
         if(!AssertNonObjectMemberTerminatorWithError(tokenStream,
-                                                     "Expected object member name"))
+                                                     PARSE_MSG_EXPECTED_MEMBER_NAME))
             continue;
         
         // first the member name. save the token in case we have to throw an exception
         Token tokenName = MatchExpectedToken(Token::TOKEN_STRING, tokenStream);
         
         if(!AssertNonObjectMemberTerminatorWithError(tokenStream,
-                                                     "Expected ':'"))
+                                                     PARSE_MSG_EXPECTED_MEMBER_ASSIGN))
             continue;
 
         
@@ -579,7 +579,7 @@ inline void Reader::Parse(ObjectNode*& object, TokenStream& tokenStream, TextCoo
         MatchExpectedToken(Token::TOKEN_MEMBER_ASSIGN, tokenStream);
         
         if(!AssertNonObjectMemberTerminatorWithError(tokenStream,
-                                                     "Expected object member value"))
+                                                     PARSE_MSG_EXPECTED_MEMBER_VALUE))
             continue;
 
         
@@ -598,18 +598,18 @@ inline void Reader::Parse(ObjectNode*& object, TokenStream& tokenStream, TextCoo
             catch (Exception&)
             {
                 // must be a duplicate name
-                std::string sMessage = "Duplicate object member: " + wstring_to_utf8(tokenName.value());
-                listener->Error(tokenName.locBegin, PARSER_ERROR_DUPLICATE_MEMBER, sMessage);
+                listener->Error(tokenName.locBegin, PARSER_ERROR_DUPLICATE_MEMBER, PARSE_MSG_DUPLICATE_MEMBER,
+                                MakeParseErrorArg(tokenName.orgTextLength()));
             }
         } else {
-            std::string sMessage = "Could not parse member value '" + wstring_to_utf8(tokenName.value()) + "'";
-            listener->Error(tokenName.locBegin, PARSER_ERROR_INVALID_MEMBER, sMessage);
+            listener->Error(tokenName.locBegin, PARSER_ERROR_INVALID_MEMBER, PARSE_MSG_INVALID_MEMBER,
+                            MakeParseErrorArg(tokenName.orgTextLength()));
         }
     }
     
     if(tokenStream.Peek().nType == Token::TOKEN_EOS)
     {
-        listener->Error(tokenStream.getInputStream().GetLocation(), PARSER_ERROR_UNEXPECTED_EOS, "Unexpected end of file");
+        listener->Error(tokenStream.getInputStream().GetLocation(), PARSER_ERROR_UNEXPECTED_EOS, PARSE_MSG_UNEXPECTED_EOF);
         object->textRange = TextRange(lBegin.relativeTo(aBaseOfs),
                                       tokenStream.getInputStream().GetLocation().relativeTo(aBaseOfs));
     } else
@@ -669,7 +669,7 @@ inline void Reader::Parse(ArrayNode*& array, TokenStream& tokenStream, TextCoord
     }
     
     if(tokenStream.Peek().nType == Token::TOKEN_EOS) {
-        listener->Error(TextCoordinate(0), PARSER_ERROR_UNEXPECTED_EOS, "Expecting \",\" or \"]\"");
+        listener->Error(TextCoordinate(0), PARSER_ERROR_UNEXPECTED_EOS, PARSE_MSG_EXPECTED_ARRAY_SEPARATOR);
         array->textRange = TextRange(lBegin.relativeTo(aBaseOfs), TextCoordinate::infinity);
     } else {
         TextCoordinate lEnd = MatchExpectedToken(Token::TOKEN_ARRAY_END, tokenStream).locEnd;
@@ -695,37 +695,38 @@ inline void Reader::Parse(NumberNode*& number, TokenStream& tokenStream, TextCoo
                         tok.locEnd.relativeTo(aBaseOfs));
     
 
-    wchar_t *lLastConverted;
+    const TextChar *lLastConverted;
     double dValue;
     
-    if(tok.valueEnd-tok.valueStart < MAX_FAST_NUM_LITERAL_LEN) {
-        const wchar_t *valueEnd;
-
-        char localToken[MAX_FAST_NUM_LITERAL_LEN+1];
-        char *tokOut;
-        
-        for(tokOut = localToken, valueEnd = tok.valueStart;
-            valueEnd != tok.valueEnd;
-            valueEnd++, tokOut++) {
-            if(*valueEnd > 127) {
-                break;
-            }
-            *tokOut = (char)(*valueEnd);
+    // Number tokens are ASCII; narrow to char for strtod (on the stack for typical literals)
+    char localToken[MAX_FAST_NUM_LITERAL_LEN+1];
+    std::string longToken;
+    char *tokBegin = localToken;
+    if(tok.valueEnd-tok.valueStart >= MAX_FAST_NUM_LITERAL_LEN) {
+        longToken.resize(tok.valueEnd-tok.valueStart+1);
+        tokBegin = &longToken[0];
+    }
+    
+    const TextChar *valueEnd;
+    char *tokOut;
+    for(tokOut = tokBegin, valueEnd = tok.valueStart;
+        valueEnd != tok.valueEnd;
+        valueEnd++, tokOut++) {
+        if(*valueEnd > 127) {
+            break;
         }
-        
-        *tokOut = 0;
-        
-        dValue = strtod(localToken, &tokOut);
-        lLastConverted = (wchar_t*)(tok.valueStart + (tokOut - localToken));
-    } else {
-        dValue = wcstod(tok.valueStart, &lLastConverted);
+        *tokOut = (char)(*valueEnd);
     }
     
+    *tokOut = 0;
+    
+    dValue = strtod(tokBegin, &tokOut);
+    lLastConverted = tok.valueStart + (tokOut - tokBegin);
+    
     // did we consume all characters in the token?
     if (lLastConverted != tok.valueEnd)
     {
-        std::string sMessage = std::string("Unexpected character in NUMBER token");
-        listener->Error(tok.locBegin, PARSER_ERROR_MALFORMED_NUMBER, sMessage);
+        listener->Error(tok.locBegin, PARSER_ERROR_MALFORMED_NUMBER, PARSE_MSG_MALFORMED_NUMBER);
     }
     
     number = new NumberNode(dValue);
@@ -736,7 +737,7 @@ inline void Reader::Parse(NumberNode*& number, TokenStream& tokenStream, TextCoo
 inline void Reader::Parse(BooleanNode*& boolean, TokenStream& tokenStream, TextCoordinate aBaseOfs)
 {
     const Token &tok = MatchExpectedToken(Token::TOKEN_BOOLEAN, tokenStream);
-    boolean = new BooleanNode(tok.isValueEquals(L"true"));
+    boolean = new BooleanNode(tok.isValueEquals("true"));
     TextRange lTokRange(tok.locBegin.relativeTo(aBaseOfs),
                         tok.locEnd.relativeTo(aBaseOfs));
     boolean->textRange = lTokRange;
@@ -755,22 +756,8 @@ inline void Reader::Parse(NullNode*& aNull, TokenStream& tokenStream, TextCoordi
 
 
 inline void Reader::ReportExpectedToken(Token::Type nExpected, const Token& token) {
-    
-    static std::map<Token::Type, const char*> lTypeNames = {
-        { Token::TOKEN_OBJECT_BEGIN, "'{'" },
-        { Token::TOKEN_OBJECT_END, "'}'" },
-        { Token::TOKEN_ARRAY_BEGIN, "'['" },
-        { Token::TOKEN_ARRAY_END, "']'" },
-        { Token::TOKEN_NEXT_ELEMENT, "','" },
-        { Token::TOKEN_MEMBER_ASSIGN, "':'" },
-        { Token::TOKEN_STRING, "string" },
-        { Token::TOKEN_NUMBER, "number" },
-        { Token::TOKEN_BOOLEAN, "'true' or 'false'" },
-        { Token::TOKEN_NULL, "'null'" }
-    };
-
-    std::string sMessage = "Unexpected token: " + wstring_to_utf8(token.value()) + "; expecting " + lTypeNames[nExpected];
-    listener->Error(token.locBegin, PARSER_ERROR_UNEXPECTED_TOKEN, sMessage);
+    listener->Error(token.locBegin, PARSER_ERROR_UNEXPECTED_TOKEN, PARSE_MSG_EXPECTED_TOKEN,
+                    MakeParseErrorArg(token.orgTextLength(), nExpected));
 }
 
 inline const Token &Reader::MatchExpectedToken(Token::Type nExpected, TokenStream& tokenStream)
@@ -783,8 +770,7 @@ inline const Token &Reader::MatchExpectedToken(Token::Type nExpected, TokenStrea
     {
         if (token.nType == Token::TOKEN_EOS)
         {
-            std::string sMessage = "Unexpected end of token stream";
-            listener->Error(TextCoordinate(), PARSER_ERROR_UNEXPECTED_EOS, "Unexpected end of token stream");
+            listener->Error(TextCoordinate(), PARSER_ERROR_UNEXPECTED_EOS, PARSE_MSG_UNEXPECTED_EOS);
             return lEmptyToken;
         }
         
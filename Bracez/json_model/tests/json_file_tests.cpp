@@ -0,0 +1,821 @@
+//
+//  json_file_tests.cpp
+//  Bracez
+//
+//  Created by Eldan Ben-Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "reader.h"
+#include "catch2/catch.hpp"
+#include <string>
+#include <random>
+#include <thread>
+
+using namespace json;
+
+static std::wstring debugJsonForDom(JsonFile* doc) {
+    std::unique_ptr<Node> debugDesc(doc->getDom()->createDebugRepresentation());
+    std::wstring debugDescJson;
+    debugDesc->calculateJsonTextRepresentation(debugDescJson);
+
+    return debugDescJson;
+}
+
+struct NodeRefreshCollector : public JsonFileChangeListener {
+    void notifyTextSpliced(JsonFile *aSender, TextCoordinate aOldOffset,
+                           TextLength aOldLength, TextLength aNewLength,
+                           TextCoordinate aOldLineStart, TextLength aOldLineLength,
+                           TextLength aNewLineLength) {}
+    
+    void notifyNodeChanged(JsonFile *aSender, const JsonPath &nodePath) {
+        refreshedPaths.push_back(nodePath);
+    }
+    
+    std::vector<JsonPath> refreshedPaths;
+};
+
+static TextString generateMultilineJson(int numElements) {
+    TextString ret = u"[\n";
+    for(int i=0; i<numElements; i++) {
+        TextString idx = textStringFromWstring(std::to_wstring(i));
+        ret += u"  { \"id\": " + idx + u", \"name\": \"element " + idx + u"\", \"tags\": [1, 2, 3] }";
+        ret += (i < numElements-1) ? u",\n" : u"\n";
+    }
+    ret += u"]\n";
+
+    return ret;
+}
+
+TEST_CASE("JSON file speculative parse: prefix is parsed, reconciliation completes model") {
+    TextString text = generateMultilineJson(100);
+
+    std::unique_ptr<JsonFile> fullyParsedDoc(new JsonFile());
+    fullyParsedDoc->setText(text);
+
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    auto task = doc->setTextWithSpeculativeParse(text, 200);
+    REQUIRE(task);
+    REQUIRE(doc->getText() == text);
+    REQUIRE(doc->numLines() == fullyParsedDoc->numLines());
+
+    // Region at beginning of the document is available...
+    ArrayNode *root = dynamic_cast<ArrayNode*>(doc->getDom()->getChildAt(0));
+    REQUIRE(root);
+    REQUIRE(root->getChildCount() > 0);
+    REQUIRE(root->getChildCount() < 100);
+    REQUIRE(!root->getTextRange().end.infinite());
+
+    JsonPath path;
+    REQUIRE(doc->findPathContaining(TextCoordinate(text.find(u"element 0")), path));
+    REQUIRE(path == JsonPath({0, 1}));
+
+    // ... and truncation artifacts aren't reported as errors
+    REQUIRE(doc->getErrors().size() == 0);
+
+    task->executeInBackground();
+    doc->applyReconciliationTask(task);
+
+    REQUIRE(debugJsonForDom(doc.get()) == debugJsonForDom(fullyParsedDoc.get()));
+}
+
+TEST_CASE("JSON file speculative parse: short text is fully parsed") {
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    auto task = doc->setTextWithSpeculativeParse(u"{ \"a\": [1, 2, }", 1024);
+
+    REQUIRE(!task);
+    REQUIRE(doc->getErrors().size() > 0);
+    REQUIRE(dynamic_cast<ObjectNode*>(doc->getDom()->getChildAt(0)));
+}
+
+TEST_CASE("JSON file line index") {
+    TextString text = u"{\n \"a\": 1,\n \"b\": [\n2]\n}";
+
+    std::unique_ptr<JsonFile> parsedDoc(new JsonFile());
+    parsedDoc->setText(text);
+
+    std::unique_ptr<JsonFile> splicedDoc(new JsonFile());
+    splicedDoc->spliceTextWithDirtySemanticModel(TextCoordinate(0), 0, text);
+
+    for(JsonFile *doc: { parsedDoc.get(), splicedDoc.get() }) {
+        REQUIRE(doc->numLines() == 5);
+
+        int row, col;
+        doc->getCoordinateRowCol(TextCoordinate(text.find(u'b')), row, col);
+        REQUIRE(row == 3);
+        REQUIRE(col == 3);
+
+        doc->getCoordinateRowCol(TextCoordinate(0), row, col);
+        REQUIRE(row == 1);
+        REQUIRE(col == 1);
+
+        REQUIRE(doc->getLineFirstCharacter(4) == TextCoordinate(text.find(u'2')));
+        REQUIRE(doc->getLineEnd(5) == TextCoordinate(text.length()));
+    }
+
+    SECTION("Lines after unparsed suffix are indexed") {
+        parsedDoc->setText(u"[1]\n]\n\n");
+        REQUIRE(parsedDoc->numLines() == 4);
+        REQUIRE(parsedDoc->getLineFirstCharacter(3) == TextCoordinate(6));
+    }
+}
+
+TEST_CASE("JSON file text is stored as UTF-16") {
+    TextString text = u"{\"\U0001F600\": \"\\ud83d\\ude00 é\", \"b\": 1}";
+
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->setText(text);
+    REQUIRE(doc->getErrors().size() == 0);
+
+    ObjectNode *root = dynamic_cast<ObjectNode*>(doc->getDom()->getChildAt(0));
+    REQUIRE(root);
+    REQUIRE(root->getMemberNameAt(0) == L"\U0001F600");
+
+    StringNode *value = dynamic_cast<StringNode*>(root->getChildAt(0));
+    REQUIRE(value);
+    REQUIRE(value->getValue() == L"\U0001F600 é");
+
+    // Coordinates count UTF-16 units
+    REQUIRE(root->getChildMemberAt(0)->nameRange == TextRange(TextCoordinate(1), TextCoordinate(5)));
+    REQUIRE(root->getChildAt(1)->getAbsTextRange().start == TextCoordinate(text.find(u'1')));
+}
+
+TEST_CASE("JSON file character offset index") {
+    TextString text = u"[\"a\U0001F600b\",\n\"\U0001F600\U0001F600\"]";
+
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->setText(text);
+
+    auto verifyIndex = [&doc]() {
+        const TextString &docText = doc->getText();
+        unsigned long charOffset = 0;
+        for(TextLength i=0; i<docText.length(); i++) {
+            if(isLowSurrogate(docText[i]) && i && isHighSurrogate(docText[i-1])) {
+                continue;
+            }
+            REQUIRE(doc->getCharacterOffset(TextCoordinate(i)) == charOffset);
+            REQUIRE(doc->getCoordinateForCharacterOffset(charOffset) == TextCoordinate(i));
+            charOffset++;
+        }
+        REQUIRE(doc->getCharacterOffset(TextCoordinate(docText.length())) == charOffset);
+    };
+
+    verifyIndex();
+
+    int row, col;
+    doc->getCoordinateRowCharacterCol(TextCoordinate(text.find(u'b')), row, col);
+    REQUIRE(row == 1);
+    REQUIRE(col == 5);
+
+    SECTION("Index is maintained by splices") {
+        doc->fastSpliceTextWithWorkLimit(TextCoordinate(1), 0, u"\"\U0001F600\", ", 1024);
+        verifyIndex();
+
+        // Remove a pair's leading unit and add it back
+        TextCoordinate pairStart = TextCoordinate(doc->getText().find(u"\U0001F600\U0001F600"));
+        doc->spliceTextWithDirtySemanticModel(pairStart, 1, u"");
+        verifyIndex();
+        doc->spliceTextWithDirtySemanticModel(pairStart, 0, TextString(1, (TextChar)0xD83D));
+        verifyIndex();
+        REQUIRE(doc->getCharacterOffset(TextCoordinate(doc->getText().length())) == 18);
+    }
+}
+
+TEST_CASE("JSON file concurrent child lookups") {
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    std::u16string text = u"[";
+    for(int i=0; i<1000; i++) {
+        text += (i ? u", " : u"") + std::u16string(1, u'0' + i % 10);
+    }
+    text += u"]";
+    doc->setText(text);
+
+    ArrayNode *root = dynamic_cast<ArrayNode*>(doc->getDom()->getChildAt(0));
+    REQUIRE(root);
+
+    // Lookups share the container's last found child; each thread walks in its own order
+    std::vector<int> numWrong(4);
+    std::vector<std::thread> threads;
+    for(int t=0; t<4; t++) {
+        threads.emplace_back([root, t, &numWrong]() {
+            for(int pass=0; pass<20; pass++) {
+                for(int i=0; i<root->getChildCount(); i++) {
+                    int idx = (t % 2) ? root->getChildCount() - 1 - i : (i * (t + 1)) % root->getChildCount();
+                    if(root->findChildContaining(root->getChildAt(idx)->getTextRange().start, false) != idx) {
+                        numWrong[t]++;
+                    }
+                }
+            }
+        });
+    }
+    for(std::thread &thread: threads) {
+        thread.join();
+    }
+
+    for(int wrong: numWrong) {
+        REQUIRE(wrong == 0);
+    }
+}
+
+TEST_CASE("JSON file snapshots") {
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->setText(u"{ \"a\": [1, 2], \"b\": \"x\" }");
+
+    std::shared_ptr<const JsonFileSnapshot> snapshot = doc->getSnapshot();
+    REQUIRE(snapshot->getVersion() == doc->getVersion());
+    REQUIRE(snapshot == doc->getSnapshot());
+    REQUIRE(&snapshot->getText() == &doc->getText());
+
+    SECTION("Snapshot is unaffected by later changes") {
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(12), 0, u", 3", 1024));
+        REQUIRE(doc->getVersion() != snapshot->getVersion());
+        REQUIRE(doc->getText() == u"{ \"a\": [1, 2, 3], \"b\": \"x\" }");
+        REQUIRE(snapshot->getText() == u"{ \"a\": [1, 2], \"b\": \"x\" }");
+
+        std::shared_ptr<const JsonFileSnapshot> newSnapshot = doc->getSnapshot();
+        REQUIRE(newSnapshot != snapshot);
+        REQUIRE(newSnapshot->getVersion() == doc->getVersion());
+        REQUIRE(!newSnapshot->isSemanticModelDirty());
+        REQUIRE(&newSnapshot->getText() == &doc->getText());
+    }
+
+    SECTION("Text isn't copied once snapshots are released") {
+        const TextString *text = &doc->getText();
+        snapshot.reset();
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(12), 0, u", 3", 1024));
+        REQUIRE(&doc->getText() == text);
+    }
+
+    SECTION("Dirty semantic model is flagged") {
+        auto task = doc->spliceTextWithDirtySemanticModel(TextCoordinate(0), 0, u" ");
+        REQUIRE(doc->getSnapshot()->isSemanticModelDirty());
+        REQUIRE(snapshot->getText()[0] == u'{');
+        REQUIRE(!doc->getSnapshot()->hasSameText(*snapshot));
+    }
+
+    SECTION("Parsed snapshot has the ranges of the file's DOM") {
+        std::unique_ptr<DocumentNode> dom = snapshot->parse();
+        REQUIRE(dom->getChildAt(0));
+        REQUIRE(!dom->getChildAt(0)->isLive());
+
+        ObjectNode *root = dynamic_cast<ObjectNode*>(dom->getChildAt(0));
+        REQUIRE(root);
+        ArrayNode *a = dynamic_cast<ArrayNode*>(root->getChildAt(0));
+        REQUIRE(a);
+        Node *two = a->getChildAt(1);
+        REQUIRE(dom->findNodeWithRange(two->getAbsTextRange()) == two);
+
+        Node *liveTwo = doc->findNodeWithRange(two->getAbsTextRange());
+        REQUIRE(liveTwo);
+        REQUIRE(liveTwo->isLive());
+        REQUIRE(liveTwo->getAbsTextRange() == two->getAbsTextRange());
+        ObjectNode *liveRoot = dynamic_cast<ObjectNode*>(doc->getDom()->getChildAt(0));
+        REQUIRE(doc->findNodeWithRange(root->getAbsTextRange()) == liveRoot);
+        REQUIRE(doc->findNodeWithRange(a->getAbsTextRange()) == liveRoot->getChildAt(0));
+        REQUIRE(!doc->findNodeWithRange(TextRange(TextCoordinate(1), TextCoordinate(3))));
+    }
+
+    SECTION("Snapshot text is lexed from a token start") {
+        std::vector<LexicalSpan> spans;
+        snapshot->getTokenSpans(TextCoordinate(0), TextCoordinate(snapshot->getText().length() + 10), spans);
+        REQUIRE(spans.size() > 0);
+        REQUIRE(spans.front().start == TextCoordinate(0));
+        REQUIRE(spans.front().tokenClass == ltcPunctuation);
+        REQUIRE(spans[1].tokenClass == ltcKey);
+    }
+
+    SECTION("Reconciling keeps the text of the dirty snapshot") {
+        auto task = doc->spliceTextWithDirtySemanticModel(TextCoordinate(0), 0, u" ");
+        std::shared_ptr<const JsonFileSnapshot> dirtySnapshot = doc->getSnapshot();
+        task->executeInBackground();
+        doc->applyReconciliationTask(task);
+
+        std::shared_ptr<const JsonFileSnapshot> reconciledSnapshot = doc->getSnapshot();
+        REQUIRE(reconciledSnapshot->getVersion() != dirtySnapshot->getVersion());
+        REQUIRE(!reconciledSnapshot->isSemanticModelDirty());
+        REQUIRE(reconciledSnapshot->hasSameText(*dirtySnapshot));
+    }
+}
+
+TEST_CASE("JSON file retired nodes") {
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->setText(u"[1, {\"a\": 2}, 3]");
+    REQUIRE(doc->numRetiredNodes() == 0);
+    
+    ArrayNode *root = dynamic_cast<ArrayNode*>(doc->getDom()->getChildAt(0));
+    REQUIRE(root);
+    const Node *member = root->getChildAt(1);
+    REQUIRE(member->isLive());
+    
+    SECTION("Replaced nodes outlive pins") {
+        NodeReclaimer::Pin pin = doc->pinNodes();
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(11), 0, u", \"b\": 4", 1024));
+        
+        // Old node is no longer live but still safe to look at
+        REQUIRE(doc->numRetiredNodes() > 0);
+        REQUIRE(!member->isLive());
+        REQUIRE(member->getNodeTypeId() == ntObject);
+        REQUIRE(dynamic_cast<const ObjectNode*>(member)->getChildCount() == 1);
+        
+        // Pins taken after the node was retired don't hold it
+        NodeReclaimer::Pin laterPin = doc->pinNodes();
+        pin.release();
+        REQUIRE(doc->numRetiredNodes() == 0);
+        
+        REQUIRE(root->isLive());
+        REQUIRE(root->getChildAt(1)->isLive());
+    }
+    
+    SECTION("Unpinned nodes are reclaimed right away") {
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(11), 0, u", \"b\": 4", 1024));
+        REQUIRE(doc->numRetiredNodes() == 0);
+    }
+    
+    SECTION("Whole DOM is retired on setText") {
+        NodeReclaimer::Pin pin = doc->pinNodes();
+        doc->setText(u"[]");
+        REQUIRE(!root->isLive());
+        REQUIRE(root->getChildCount() == 3);
+        
+        pin = NodeReclaimer::Pin();
+        REQUIRE(doc->numRetiredNodes() == 0);
+    }
+    
+    SECTION("Held nodes don't hold off deleting what's replaced") {
+        // Like UI proxies that are never looked at again
+        PinnedNodes replaced, kept;
+        replaced.assign(root->getChildAt(1));
+        kept.assign(root->getChildAt(0));
+        REQUIRE(doc->numPinnedNodeHolders() == 2);
+        
+        for(int i=0; i<3; i++) {
+            REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(11), 0, u", \"b\": 4", 1024));
+            REQUIRE(doc->numRetiredNodes() == 0);
+        }
+        
+        REQUIRE(!replaced.get());
+        REQUIRE(replaced.size() == 1);
+        REQUIRE(kept.get() == root->getChildAt(0));
+        
+        doc.reset();
+        REQUIRE(!kept.get());
+        REQUIRE(kept.empty());
+    }
+    
+    SECTION("Held nodes are dropped as soon as they're replaced") {
+        PinnedNodes replaced;
+        replaced.assign(root->getChildAt(1));
+        
+        doc->beginDeferNotifications();
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(11), 0, u", \"b\": 4", 1024));
+        REQUIRE(doc->numRetiredNodes() > 0);
+        REQUIRE(!replaced.get());
+        doc->endDeferNotifications();
+        
+        REQUIRE(doc->numRetiredNodes() == 0);
+        replaced.clear();
+        REQUIRE(doc->numPinnedNodeHolders() == 0);
+    }
+    
+    SECTION("Pinned nodes outlive their file") {
+        NodeReclaimer::Pin pin = doc->pinNodes();
+        doc.reset();
+        REQUIRE(!root->isLive());
+        REQUIRE(!member->isLive());
+        REQUIRE(root->getChildCount() == 3);
+    }
+}
+
+TEST_CASE("JSON file reconciliation keeps unchanged nodes") {
+    TextString text = u"{\"a\": [1, 2], \"b\": {\"c\": true}, \"d\": \"x\"}";
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->setText(text);
+    
+    ObjectNode *root = dynamic_cast<ObjectNode*>(doc->getDom()->getChildAt(0));
+    REQUIRE(root);
+    Node *a = root->getChildAt(0);
+    Node *b = root->getChildAt(1);
+    Node *d = root->getChildAt(2);
+    
+    NodeRefreshCollector collector;
+    doc->addListener(&collector);
+    NodeReclaimer::Pin pin = doc->pinNodes();
+    
+    auto reparse = [&doc](TextCoordinate start, TextLength len, const TextString &newText) {
+        auto task = doc->spliceTextWithDirtySemanticModel(start, len, newText);
+        task->executeInBackground();
+        doc->applyReconciliationTask(task);
+        
+        std::unique_ptr<JsonFile> parsedDoc(new JsonFile());
+        parsedDoc->setText(doc->getText());
+        REQUIRE(debugJsonForDom(doc.get()) == debugJsonForDom(parsedDoc.get()));
+    };
+    
+    SECTION("Changed value is the only node replaced") {
+        reparse(TextCoordinate(text.find(u'x')), 1, u"yz");
+        
+        REQUIRE(doc->getDom()->getChildAt(0) == root);
+        REQUIRE(root->getChildAt(0) == a);
+        REQUIRE(root->getChildAt(1) == b);
+        REQUIRE(root->getChildAt(2) != d);
+        REQUIRE(!d->isLive());
+        REQUIRE(collector.refreshedPaths == std::vector<JsonPath>({ JsonPath({2}) }));
+    }
+    
+    SECTION("Container whose children change is refreshed once") {
+        Node *firstElement = dynamic_cast<ArrayNode*>(a)->getChildAt(0);
+        reparse(TextCoordinate(0), 0, u"   ");
+        REQUIRE(collector.refreshedPaths.empty());
+        
+        reparse(TextCoordinate(doc->getText().find(u'[') + 1), 0, u"0, ");
+        
+        REQUIRE(root->getChildAt(0) == a);
+        REQUIRE(dynamic_cast<ArrayNode*>(a)->getChildCount() == 3);
+        REQUIRE(dynamic_cast<ArrayNode*>(a)->getChildAt(1) == firstElement);
+        REQUIRE(collector.refreshedPaths == std::vector<JsonPath>({ JsonPath({0}) }));
+    }
+    
+    SECTION("Members are matched by name") {
+        reparse(TextCoordinate(1), 0, u"\"z\": null, ");
+        
+        REQUIRE(root->getChildCount() == 4);
+        REQUIRE(root->getChildAt(1) == a);
+        REQUIRE(root->getChildAt(2) == b);
+        REQUIRE(root->getChildAt(3) == d);
+        REQUIRE(a->getParent() == root);
+        REQUIRE(collector.refreshedPaths == std::vector<JsonPath>({ JsonPath() }));
+    }
+    
+    SECTION("Root type change replaces root") {
+        reparse(TextCoordinate(0), text.length(), u"[1]");
+        
+        REQUIRE(doc->getDom()->getChildAt(0) != root);
+        REQUIRE(!root->isLive());
+        REQUIRE(collector.refreshedPaths == std::vector<JsonPath>({ JsonPath() }));
+    }
+    
+    doc->removeListener(&collector);
+}
+
+TEST_CASE("JSON file change sets") {
+    SECTION("Splices replay to the same text") {
+        std::minstd_rand random(7);
+        for(int iteration=0; iteration<200; iteration++) {
+            std::string original = "0123456789abcdefghijklmnopqrstuvwxyz";
+            std::string text = original;
+            JsonFileChangeSet changeSet;
+            char nextChar = 'A';
+            
+            for(int i=0; i<4; i++) {
+                TextLength start = random() % (text.length()+1);
+                TextLength len = random() % std::min<TextLength>(4, text.length()-start+1);
+                TextLength newLen = random() % 4;
+                text.replace(start, len, std::string(newLen, nextChar++));
+                changeSet.addSplice({ TextCoordinate(start), len, newLen, TextCoordinate(start), len, newLen });
+            }
+            
+            std::string replayed = original;
+            for(size_t i=0; i<changeSet.splices.size(); i++) {
+                const JsonFileChangeSet::TextSplice &splice = changeSet.splices[i];
+                REQUIRE(splice.lineOffsetStart == splice.offsetStart);
+                REQUIRE(splice.lineLen == splice.len);
+                REQUIRE(splice.lineNewLen == splice.newLen);
+                if(i) {
+                    const JsonFileChangeSet::TextSplice &prev = changeSet.splices[i-1];
+                    REQUIRE(prev.offsetStart + prev.newLen < splice.offsetStart);
+                }
+                replayed.replace(splice.offsetStart, splice.len, text.substr(splice.offsetStart, splice.newLen));
+            }
+            REQUIRE(replayed == text);
+        }
+    }
+    
+    SECTION("Refreshed nodes are coalesced with their ancestors") {
+        JsonFileChangeSet changeSet;
+        changeSet.addRefreshedNode({1, 2});
+        changeSet.addRefreshedNode({1, 2, 0});
+        changeSet.addRefreshedNode({3});
+        changeSet.addRefreshedNode({1});
+        REQUIRE(changeSet.refreshedNodes == std::vector<JsonPath>({ JsonPath({3}), JsonPath({1}) }));
+    }
+    
+    SECTION("Deferred changes are delivered once") {
+        struct ChangeSetCollector : public NodeRefreshCollector {
+            void notifyChangeSet(JsonFile *aSender, const JsonFileChangeSet &aChangeSet) {
+                changeSets.push_back(aChangeSet);
+            }
+            
+            std::vector<JsonFileChangeSet> changeSets;
+        } collector;
+        
+        std::unique_ptr<JsonFile> doc(new JsonFile());
+        doc->setText(u"[1, 2, [3, 4]]");
+        doc->addListener(&collector);
+        
+        doc->beginDeferNotifications();
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(8), 1, u"30", 1024));
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(10), 0, u"0", 1024));
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(TextCoordinate(1), 1, u"10", 1024));
+        doc->endDeferNotifications();
+        REQUIRE(doc->getText() == u"[10, 2, [300, 4]]");
+        
+        REQUIRE(collector.changeSets.size() == 1);
+        const JsonFileChangeSet &changeSet = collector.changeSets[0];
+        REQUIRE(changeSet.splices.size() == 2);
+        REQUIRE(changeSet.splices[0].offsetStart == TextCoordinate(2));
+        REQUIRE(changeSet.splices[0].newLen == 1);
+        REQUIRE(changeSet.splices[1].offsetStart == TextCoordinate(10));
+        REQUIRE(changeSet.splices[1].len == 0);
+        REQUIRE(changeSet.splices[1].newLen == 2);
+        
+        doc->removeListener(&collector);
+    }
+}
+
+TEST_CASE("JSON file batched edits") {
+    TextString text = generateMultilineJson(50);
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->setText(text);
+    
+    auto applyEditsToText = [](TextString text, const std::vector<Splice> &edits) {
+        for(auto iter = edits.rbegin(); iter != edits.rend(); iter++) {
+            text.replace(iter->start, iter->len, iter->newText);
+        }
+        return text;
+    };
+    
+    auto verifyMatchesParse = [&doc]() {
+        std::unique_ptr<JsonFile> parsedDoc(new JsonFile());
+        parsedDoc->setText(doc->getText());
+        REQUIRE(debugJsonForDom(doc.get()) == debugJsonForDom(parsedDoc.get()));
+        REQUIRE(doc->numLines() == parsedDoc->numLines());
+        REQUIRE(doc->getErrors().size() == parsedDoc->getErrors().size());
+        for(unsigned long line=1; line<=doc->numLines(); line++) {
+            REQUIRE(doc->getLineStart(line) == parsedDoc->getLineStart(line));
+        }
+    };
+    
+    struct ChangeSetCollector : public NodeRefreshCollector {
+        void notifyChangeSet(JsonFile *aSender, const JsonFileChangeSet &aChangeSet) {
+            changeSets.push_back(aChangeSet);
+        }
+        
+        std::vector<JsonFileChangeSet> changeSets;
+    } collector;
+    doc->addListener(&collector);
+    
+    SECTION("Values are replaced with a single local reparse") {
+        // Replace each "tags" array, and every id with a multiline object
+        std::vector<Splice> edits;
+        for(size_t pos = text.find(u"[1, 2, 3]"); pos != TextString::npos; pos = text.find(u"[1, 2, 3]", pos+1)) {
+            edits.push_back(Splice(TextCoordinate(pos), 9, u"[\"\U0001F600\"]"));
+        }
+        for(size_t pos = text.find(u"\"id\": "); pos != TextString::npos; pos = text.find(u"\"id\": ", pos+1)) {
+            size_t valueStart = pos + 6;
+            edits.push_back(Splice(TextCoordinate(valueStart), text.find(u',', valueStart) - valueStart, u"{\n\"x\": null\n}"));
+        }
+        std::sort(edits.begin(), edits.end(), [](const Splice &a, const Splice &b) { return a.start < b.start; });
+        
+        NodeReclaimer::Pin pin = doc->pinNodes();
+        ArrayNode *root = dynamic_cast<ArrayNode*>(doc->getDom()->getChildAt(0));
+        Node *firstName = dynamic_cast<ObjectNode*>(root->getChildAt(0))->getChildAt(1);
+        
+        REQUIRE(!doc->applyEdits(edits, 1024));
+        REQUIRE(doc->getText() == applyEditsToText(text, edits));
+        verifyMatchesParse();
+        
+        // Untouched nodes are kept
+        REQUIRE(doc->getDom()->getChildAt(0) == root);
+        REQUIRE(dynamic_cast<ObjectNode*>(root->getChildAt(0))->getChildAt(1) == firstName);
+        
+        REQUIRE(collector.changeSets.size() == 1);
+        const JsonFileChangeSet &changeSet = collector.changeSets[0];
+        REQUIRE(changeSet.splices.size() == edits.size());
+        REQUIRE(changeSet.refreshedNodes.size() == edits.size());
+        REQUIRE(changeSet.refreshedNodes[0] == JsonPath({0, 0}));
+        
+        // Splices replay to the new text
+        TextString replayed = text;
+        for(const JsonFileChangeSet::TextSplice &splice: changeSet.splices) {
+            replayed.replace(splice.offsetStart, splice.len, doc->getText().substr(splice.offsetStart, splice.newLen));
+        }
+        REQUIRE(replayed == doc->getText());
+    }
+    
+    SECTION("Edits that change structure grow the reparsed region") {
+        // Merge the first two elements into one; the array holding them is reparsed
+        size_t firstEnd = text.find(u"] }");
+        std::vector<Splice> edits = {
+            Splice(TextCoordinate(firstEnd), 3, u"], "),
+            Splice(TextCoordinate(text.find(u"  {", firstEnd)), 3, u""),
+            Splice(TextCoordinate(text.find(u"\"element 20\"")), 12, u"\"a\\nb\"")
+        };
+        
+        REQUIRE(!doc->applyEdits(edits, 64*1024));
+        verifyMatchesParse();
+        REQUIRE(dynamic_cast<ArrayNode*>(doc->getDom()->getChildAt(0))->getChildCount() == 49);
+    }
+    
+    SECTION("Edits that can't be reparsed locally leave the model dirty") {
+        std::vector<Splice> edits = {
+            Splice(TextCoordinate(0), 1, u"{"),
+            Splice(TextCoordinate(text.find(u"element 3\"")), 0, u"\n")
+        };
+        
+        auto task = doc->applyEdits(edits, 1024);
+        REQUIRE(task);
+        REQUIRE(doc->getText() == applyEditsToText(text, edits));
+        
+        task->executeInBackground();
+        doc->applyReconciliationTask(task);
+        verifyMatchesParse();
+    }
+    
+    SECTION("Edits past the root value leave the model dirty") {
+        std::vector<Splice> edits = {
+            Splice(TextCoordinate(text.find(u"element 3\"")), 0, u"x"),
+            Splice(TextCoordinate(text.length()), 0, u" {}")
+        };
+        
+        auto task = doc->applyEdits(edits, 64*1024);
+        REQUIRE(task);
+        
+        task->executeInBackground();
+        doc->applyReconciliationTask(task);
+        verifyMatchesParse();
+    }
+    
+    SECTION("Edits inside containers left open at the end of the text") {
+        doc->setText(u"[1, [2, 3");
+        std::vector<Splice> edits = {
+            Splice(TextCoordinate(5), 1, u"4"),
+            Splice(TextCoordinate(8), 1, u"5")
+        };
+        
+        auto task = doc->applyEdits(edits, 1024);
+        if(task) {
+            task->executeInBackground();
+            doc->applyReconciliationTask(task);
+        }
+        
+        REQUIRE(doc->getText() == u"[1, [4, 5");
+        const ContainerNode *inner = (const ContainerNode*)((const ContainerNode*)doc->getDom()->getChildAt(0))->getChildAt(1);
+        REQUIRE(inner->getAbsTextRange().end.infinite());
+        REQUIRE(((const NumberNode*)inner->getChildAt(1))->getValue() == 5);
+    }
+    
+    doc->removeListener(&collector);
+}
+
+TEST_CASE("JSON file error deltas") {
+    // Keeps a copy of the error list up to date from the deltas alone
+    struct ErrorMirror : public NodeRefreshCollector {
+        void notifyErrorsChanged(JsonFile *aSender, const MarkerListDelta &aDelta) {
+            REQUIRE(aDelta.index + aDelta.numRemoved + aDelta.numShifted == errors.size());
+            for(size_t i = aDelta.index + aDelta.numRemoved; i < errors.size(); i++) {
+                errors[i].adjustCoordinate(aDelta.shift);
+            }
+            errors.erase(errors.begin() + aDelta.index, errors.begin() + aDelta.index + aDelta.numRemoved);
+            for(size_t i = aDelta.index; i < aDelta.index + aDelta.numInserted; i++) {
+                errors.insert(errors.begin() + i, aSender->getErrors()[(int)i]);
+            }
+            lastDelta = aDelta;
+        }
+        
+        void verify(JsonFile *doc) {
+            REQUIRE(errors.size() == doc->getErrors().size());
+            for(size_t i=0; i<errors.size(); i++) {
+                REQUIRE(errors[i].getCoordinate() == doc->getErrors()[(int)i].getCoordinate());
+                REQUIRE(errors[i].getErrorText() == doc->getErrors()[(int)i].getErrorText());
+            }
+        }
+        
+        std::vector<ParseErrorMarker> errors;
+        MarkerListDelta lastDelta;
+    } mirror;
+    
+    // One error per element
+    TextString text = u"[";
+    for(int i=0; i<200; i++) {
+        text += i ? u", [x]" : u"[x]";
+    }
+    text += u"]";
+    
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->addListener(&mirror);
+    doc->setText(text);
+    mirror.verify(doc.get());
+    REQUIRE(doc->getErrors().size() == 200);
+    
+    SECTION("A local edit only replaces the errors it touches") {
+        TextCoordinate where(text.find(u"[x]", 500) + 1);
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(where, 1, u"1", 1024));
+        mirror.verify(doc.get());
+        REQUIRE(mirror.lastDelta.numRemoved == 1);
+        REQUIRE(mirror.lastDelta.numInserted == 0);
+        REQUIRE(mirror.lastDelta.shift == 0);
+        
+        REQUIRE(doc->fastSpliceTextWithWorkLimit(where, 1, u"[yy, 1]", 1024));
+        mirror.verify(doc.get());
+        REQUIRE(mirror.lastDelta.numRemoved == 0);
+        REQUIRE(mirror.lastDelta.numInserted == 1);
+        REQUIRE(mirror.lastDelta.shift == 6);
+    }
+    
+    SECTION("Deltas replay through random edits, batches and reparses") {
+        std::minstd_rand random(5);
+        const char16_t *pieces[] = { u"x", u"1", u"[", u"]", u", ", u"\"s\"", u"" };
+        for(int iteration=0; iteration<60; iteration++) {
+            TextString cur = doc->getText();
+            TextLength start = random() % (cur.length()+1);
+            TextLength len = random() % std::min<TextLength>(3, cur.length()-start+1);
+            const char16_t *piece = pieces[random() % 7];
+            
+            switch(iteration % 3) {
+                case 0:
+                    if(!doc->fastSpliceTextWithWorkLimit(TextCoordinate(start), len, piece, 1024)) {
+                        auto task = doc->spliceTextWithDirtySemanticModel(TextCoordinate(start), len, piece);
+                        mirror.verify(doc.get());
+                        task->executeInBackground();
+                        doc->applyReconciliationTask(task);
+                    }
+                    break;
+                    
+                case 1: {
+                    std::vector<Splice> edits = { Splice(TextCoordinate(start/2), 0, piece) };
+                    if(start/2 + 1 < start) {
+                        edits.push_back(Splice(TextCoordinate(start), len, u"x"));
+                    }
+                    auto task = doc->applyEdits(edits, 1024);
+                    if(task) {
+                        mirror.verify(doc.get());
+                        task->executeInBackground();
+                        doc->applyReconciliationTask(task);
+                    }
+                    break;
+                }
+                    
+                case 2:
+                    // Composed deltas
+                    doc->beginDeferNotifications();
+                    doc->fastSpliceTextWithWorkLimit(TextCoordinate(start), len, piece, 1024);
+                    doc->fastSpliceTextWithWorkLimit(TextCoordinate(start/3), 0, u"x", 1024);
+                    doc->endDeferNotifications();
+                    break;
+            }
+            
+            mirror.verify(doc.get());
+        }
+    }
+    
+    doc->removeListener(&mirror);
+}
+
+TEST_CASE("JSON file error cap") {
+    // One error per element
+    TextString text = u"[";
+    for(int i=0; i<50; i++) {
+        text += i ? u", [x]" : u"[x]";
+    }
+    text += u"]";
+    
+    std::unique_ptr<JsonFile> doc(new JsonFile());
+    doc->setMaxParseErrors(10);
+    
+    SECTION("Errors past the cap are summarized") {
+        doc->setText(text);
+        
+        REQUIRE(doc->getErrors().size() == 11);
+        const ParseErrorMarker &summary = doc->getErrors()[10];
+        REQUIRE(summary.getErrorCode() == PARSER_ERROR_TOO_MANY_ERRORS);
+        REQUIRE(summary.getErrorArg() == 40);
+        REQUIRE(summary.getCoordinate() == doc->getErrors()[9].getCoordinate() + 5);
+        REQUIRE(summary.getErrorText() == "40 more errors in range");
+    }
+    
+    SECTION("Stray characters don't stall the parser") {
+        doc->setText(u"[1, @#, 2]");
+        
+        REQUIRE(doc->getErrors().size() > 0);
+        REQUIRE(doc->getDom()->getChildAt(0)->getNodeTypeId() == ntArray);
+    }
+    
+    SECTION("Background parse is capped too") {
+        auto task = doc->spliceTextWithDirtySemanticModel(TextCoordinate(0), 0, text);
+        task->executeInBackground();
+        doc->applyReconciliationTask(task);
+        
+        REQUIRE(doc->getErrors().size() == 11);
+        REQUIRE(doc->getErrors()[10].getErrorArg() == 40);
+    }
+    
+    SECTION("Messages are formatted from the document text") {
+        doc->setText(u"[1, {\"a\": tru}, \"b\" 2]");
+        
+        REQUIRE(doc->getErrors().size() == 3);
+        REQUIRE(doc->getErrorText(doc->getErrors()[0]) == "Could not parse member value: \"a\"");
+        REQUIRE(doc->getErrorText(doc->getErrors()[1]) == "Unknown token in stream: tru");
+        REQUIRE(doc->getErrorText(doc->getErrors()[2]) == "Unexpected token: 2; expecting ','");
+        REQUIRE(doc->getErrors()[2].getErrorText() == "Unexpected token; expecting ','");
+    }
+}
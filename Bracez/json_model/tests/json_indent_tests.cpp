@@ -14,24 +14,34 @@
 #include <locale>
 #include "JsonIndentFormatter.hpp"
 
-static bool validateJsonValueInvariantAfterIndent(const std::wstring &aJson,
+static bool validateJsonValueInvariantAfterIndent(const TextString &aJson,
                                                   int aStartOffset = 0, size_t aLen = -1,
-                                                  std::wstring *aOutputText = NULL) {
+                                                  TextString *aOutputText = NULL) {
     if(aLen == -1) {
         aLen = aJson.length();
     }
     
     json::JsonFile jsonFile;
     jsonFile.setText(aJson);
-    JsonIndentFormatter indentFormatter(aJson, jsonFile, TextCoordinate(aStartOffset), TextLength(aLen), 3);
+    JsonIndentFormatter indentFormatter(jsonFile, TextCoordinate(aStartOffset), TextLength(aLen), 3);
     
-    std::wstring indented = indentFormatter.getIndented();
+    TextString indented = indentFormatter.getIndented();
     
-    std::wstring completeIndentedText = aJson.substr(0, aStartOffset) + indented + aJson.substr(aStartOffset+aLen);
+    TextString completeIndentedText = aJson.substr(0, aStartOffset) + indented + aJson.substr(aStartOffset+aLen);
     if(aOutputText) {
         *aOutputText = completeIndentedText;
     }
     
+    // Applying the whitespace splices should result in the same text
+    TextString splicedText = aJson;
+    const std::vector<json::Splice> &splices = indentFormatter.getIndentSplices();
+    for(auto splice = splices.rbegin(); splice != splices.rend(); splice++) {
+        splicedText.replace(splice->start.getAddress(), splice->len, splice->newText);
+    }
+    if(splicedText != completeIndentedText) {
+        return false;
+    }
+    
     json::JsonFile jsonIndentedFile;
     jsonIndentedFile.setText(completeIndentedText);
     
@@ -43,26 +53,46 @@ static bool validateJsonValueInvariantAfterIndent(const std::wstring &aJson,
 }
 
 TEST_CASE("JSON indent: oneliner") {
-    REQUIRE(validateJsonValueInvariantAfterIndent(L"{\"a\":{\"b\":23}}"));
+    REQUIRE(validateJsonValueInvariantAfterIndent(u"{\"a\":{\"b\":23}}"));
 }
 
 
 TEST_CASE("JSON indent: whitespace handling") {
-    std::wstring firstIndent;
-    validateJsonValueInvariantAfterIndent(L" \n   {\"a\":{\"b\":23}}  \n   \n  ", 0, -1, &firstIndent);
+    TextString firstIndent;
+    validateJsonValueInvariantAfterIndent(u" \n   {\"a\":{\"b\":23}}  \n   \n  ", 0, -1, &firstIndent);
 
-    REQUIRE(firstIndent[0] == L'{');
-    REQUIRE(firstIndent[firstIndent.length()-1] == L'\n');
+    REQUIRE(firstIndent[0] == u'{');
+    REQUIRE(firstIndent[firstIndent.length()-1] == u'\n');
 }
 
 TEST_CASE("JSON indent: indented is invariant") {
-    std::wstring firstIndent;
-    validateJsonValueInvariantAfterIndent(L"{\"a\":{\"b\":23}}", 0, -1, &firstIndent);
+    TextString firstIndent;
+    validateJsonValueInvariantAfterIndent(u"{\"a\":{\"b\":23}}", 0, -1, &firstIndent);
     
-    std::wstring secondIndent;
+    TextString secondIndent;
     validateJsonValueInvariantAfterIndent(firstIndent, 0, -1, &secondIndent);
     
     REQUIRE(firstIndent == secondIndent);
 }
 
 
+
+TEST_CASE("JSON indent: splices only touch whitespace that changes") {
+    json::JsonFile jsonFile;
+    jsonFile.setText(u"{\n   \"a\": [1,\n      2],\n  \"b\":3\n}");
+    
+    JsonIndentFormatter indentFormatter(jsonFile, TextCoordinate(0), jsonFile.getText().length(), 3);
+    const std::vector<json::Splice> &splices = indentFormatter.getIndentSplices();
+    
+    // Array elements are broken into lines and "b" is reindented; the rest is left alone
+    REQUIRE(splices.size() == 3);
+    REQUIRE(splices[0].start == TextCoordinate(jsonFile.getText().find(u"[1,") + 1));
+    REQUIRE(splices[0].len == 0);
+    REQUIRE(splices[0].newText == u"\n      ");
+    REQUIRE(splices[1].start == TextCoordinate(jsonFile.getText().find(u"2]") + 1));
+    REQUIRE(splices[1].len == 0);
+    REQUIRE(splices[1].newText == u"\n   ");
+    REQUIRE(splices[2].start == TextCoordinate(jsonFile.getText().find(u"\"b\"")));
+    REQUIRE(splices[2].len == 0);
+    REQUIRE(splices[2].newText == u" ");
+}
@@ -0,0 +1,197 @@
+//
+//  json_path_cache_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathResultCache.hpp"
+#include "catch2/catch.hpp"
+#include <string>
+#include <random>
+
+using namespace json;
+
+static std::string describeResult(const JsonPathExpressionNodeEvalResult &aResult) {
+    std::string lRet;
+    for(Node *lNode: aResult.nodeList) {
+        lRet += lNode ? std::to_string(lNode->getAbsTextRange().start.getAddress()) + " " : "null ";
+    }
+
+    return lRet;
+}
+
+static Node *queryNode(JsonFile &aFile, const std::wstring &aPath) {
+    return JsonPathExpression::compile(aPath).execute(aFile.getDom()->getChildAt(0)).nodeList.front();
+}
+
+static void spliceAt(JsonFile &aFile, const TextString &aFind, TextLength aLen, const TextString &aNewText) {
+    TextCoordinate lAt(aFile.getText().find(aFind));
+    REQUIRE(aFile.fastSpliceTextWithWorkLimit(lAt, aLen, aNewText, 1024));
+}
+
+TEST_CASE("JsonPath result cache") {
+    JsonFile file;
+    file.setText(u"{\"store\": {\"book\": [{\"title\": \"a\", \"price\": 8}, {\"title\": \"b\", \"price\": 12},\n"
+                 u" {\"title\": \"c\", \"price\": 30}], \"bicycle\": {\"color\": \"red\"}}, \"limit\": 10}");
+    Node *root = file.getDom()->getChildAt(0);
+
+    SECTION("Normalized form") {
+        auto normalized = [](const wchar_t *aPath) { return JsonPathExpression::compile(aPath).getNormalizedForm(); };
+
+        REQUIRE(normalized(L"$.store.book") == normalized(L"$[\"store\"][\"book\"]"));
+        REQUIRE(normalized(L"$.store.book") != normalized(L"$.store.bicycle"));
+        REQUIRE(normalized(L"$.store.book[0]") != normalized(L"$.store.book[1]"));
+        REQUIRE(normalized(L"$..book[?(@.price < 10)]") == normalized(L"$..book[?(@.price<10)]"));
+        REQUIRE(normalized(L"$..book[?(@.price < 10)]") != normalized(L"$..book[?(@.price < 11)]"));
+        REQUIRE(normalized(L"$..book[?(@.title == \"a\")]") != normalized(L"$..book[?(@.title == \"b\")]"));
+        REQUIRE(JsonPathExpression().getNormalizedForm().empty());
+    }
+
+    SECTION("Read scope") {
+        auto scopeOf = [&](const wchar_t *aPath) { return JsonPathExpression::compile(aPath).findReadScope(root); };
+
+        REQUIRE(scopeOf(L"$.store.book[?(@.price < 10)].title") == queryNode(file, L"$.store.book"));
+        REQUIRE(scopeOf(L"$.store.book[1].title") == queryNode(file, L"$.store.book[1].title"));
+        REQUIRE(scopeOf(L"$.store..color") == queryNode(file, L"$.store"));
+        REQUIRE(scopeOf(L"$..title") == root);
+        REQUIRE(scopeOf(L"$.store.book[?(@.price < $.limit)]") == root);
+        REQUIRE(scopeOf(L"$.store.book.^") == root);
+        REQUIRE(scopeOf(L"^.title") == root);
+        REQUIRE(scopeOf(L"$.missing.title") == root);
+    }
+
+    SECTION("Results are kept across unrelated edits") {
+        JsonPathResultCache cache(&file);
+        JsonPathExpression titles = JsonPathExpression::compile(L"$.store.book[*].title");
+        JsonPathExpression limit = JsonPathExpression::compile(L"$.limit");
+
+        REQUIRE(describeResult(cache.execute(titles)) == describeResult(titles.execute(root)));
+        REQUIRE(describeResult(cache.execute(JsonPathExpression::compile(L"$[\"store\"].book[*][\"title\"]"))) ==
+                describeResult(titles.execute(root)));
+        REQUIRE(cache.numMisses() == 1);
+        REQUIRE(cache.numHits() == 1);
+
+        spliceAt(file, u"red", 3, u"blue");
+        cache.execute(titles);
+        REQUIRE(cache.numHits() == 2);
+        cache.execute(limit);
+        REQUIRE(cache.numMisses() == 2);
+
+        spliceAt(file, u"\"b\"", 3, u"\"bb\"");
+        REQUIRE(describeResult(cache.execute(titles)) == describeResult(titles.execute(root)));
+        REQUIRE(cache.numMisses() == 3);
+        REQUIRE(((StringNode*)cache.execute(titles).nodeList[1])->getValue() == L"bb");
+        cache.execute(limit);
+        REQUIRE(cache.numHits() == 4);
+
+        // Whole DOM replaced
+        file.setText(file.getText());
+        root = file.getDom()->getChildAt(0);
+        REQUIRE(describeResult(cache.execute(titles)) == describeResult(titles.execute(root)));
+        REQUIRE(cache.numMisses() == 4);
+        REQUIRE(cache.execute(limit).nodeList.front() == ((ObjectNode*)root)->getChildAt(1));
+    }
+
+    SECTION("Keys") {
+        JsonPathResultCache cache(&file);
+        JsonPathExpression relative = JsonPathExpression::compile(L"^.title");
+        Node *firstBook = queryNode(file, L"$.store.book[0]");
+        Node *secondBook = queryNode(file, L"$.store.book[1]");
+
+        REQUIRE(cache.execute(relative, NULL, firstBook).nodeList.front() == queryNode(file, L"$.store.book[0].title"));
+        REQUIRE(cache.execute(relative, NULL, secondBook).nodeList.front() == queryNode(file, L"$.store.book[1].title"));
+        REQUIRE(cache.size() == 2);
+
+        // Cursor isn't part of the key of expressions that don't use it
+        cache.execute(JsonPathExpression::compile(L"$.limit"), NULL, firstBook);
+        cache.execute(JsonPathExpression::compile(L"$.limit"), NULL, secondBook);
+        REQUIRE(cache.size() == 3);
+
+        JsonPathExpressionOptions fuzzy;
+        fuzzy.fuzzy = true;
+        REQUIRE(cache.execute(JsonPathExpression::compile(L"$.store.b")).nodeList.empty());
+        REQUIRE(cache.execute(JsonPathExpression::compile(L"$.store.b"), &fuzzy).nodeList.size() == 2);
+        REQUIRE(cache.size() == 5);
+    }
+
+    SECTION("Least recently used entries are evicted") {
+        JsonPathResultCache cache(&file, 2);
+        JsonPathExpression first = JsonPathExpression::compile(L"$.store");
+        JsonPathExpression second = JsonPathExpression::compile(L"$.limit");
+        JsonPathExpression third = JsonPathExpression::compile(L"$..title");
+
+        cache.execute(first);
+        cache.execute(second);
+        cache.execute(first);
+        cache.execute(third);
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.numMisses() == 3);
+
+        cache.execute(first);
+        REQUIRE(cache.numHits() == 2);
+        cache.execute(second);
+        REQUIRE(cache.numMisses() == 4);
+    }
+
+    SECTION("Edits and reparses") {
+        JsonPathResultCache cache(&file, 4);
+        std::vector<JsonPathExpression> expressions = {
+            JsonPathExpression::compile(L"$.store.book[*].title"),
+            JsonPathExpression::compile(L"$.store.book[1]"),
+            JsonPathExpression::compile(L"$.store.bicycle.color"),
+            JsonPathExpression::compile(L"$..price"),
+            JsonPathExpression::compile(L"$.store.book[?(@.price < $.limit)]"),
+            JsonPathExpression::compile(L"$.limit")
+        };
+
+        const char16_t *pieces[] = { u"\"", u"\n", u"1", u"\"title\": ", u"{\"price\": 5}", u"\"s\"", u"[[1], []]", u"", u"}" };
+        std::minstd_rand rnd(17);
+        for(int i=0; i<300; i++) {
+            TextLength lLen = file.getText().length();
+            TextCoordinate lStart(rnd() % (lLen+1));
+            TextLength lDelLen = rnd() % std::min<TextLength>(6, lLen - lStart.getAddress() + 1);
+            TextString lPiece = pieces[rnd() % 9];
+
+            std::shared_ptr<JsonFileSemanticModelReconciliationTask> task;
+            switch(rnd() % 3) {
+                case 0:
+                    if(!file.fastSpliceTextWithWorkLimit(lStart, lDelLen, lPiece, 1024)) {
+                        task = file.spliceTextWithDirtySemanticModel(lStart, lDelLen, lPiece);
+                    }
+                    break;
+
+                case 1: {
+                    TextCoordinate lSecond = lStart + lDelLen + rnd() % (lLen - lStart.getAddress() - lDelLen + 1);
+                    task = file.applyEdits({ Splice(lStart, lDelLen, lPiece), Splice(lSecond, 0, u"{\"price\": 2}") }, 1024);
+                    break;
+                }
+
+                case 2:
+                    task = file.setTextWithSpeculativeParse(file.getText(), rnd() % (lLen+1));
+                    break;
+            }
+
+            if(task) {
+                task->executeInBackground();
+                file.applyReconciliationTask(task);
+            }
+
+            root = file.getDom()->getChildAt(0);
+            if(!root) {
+                continue;
+            }
+
+            INFO(i);
+            for(int j=0; j<3; j++) {
+                const JsonPathExpression &expression = expressions[rnd() % expressions.size()];
+                REQUIRE(describeResult(cache.execute(expression)) == describeResult(expression.execute(root)));
+            }
+        }
+
+        REQUIRE(cache.numHits() > 0);
+    }
+}
@@ -0,0 +1,111 @@
+//
+//  json_path_compile_cache_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathCompileCache.hpp"
+#include "catch2/catch.hpp"
+#include <string>
+#include <thread>
+
+using namespace json;
+
+TEST_CASE("JsonPath compile cache") {
+    JsonFile file;
+    file.setText(u"{\"store\": {\"book\": [{\"title\": \"a\", \"price\": 8}, {\"title\": \"b\", \"price\": 12}]}}");
+    Node *root = file.getDom()->getChildAt(0);
+
+    SECTION("Compiled expressions are shared") {
+        JsonPathCompileCache cache;
+        JsonPathExpression titles = cache.compile(L"$..title");
+        REQUIRE(titles.execute(root).nodeList.size() == 2);
+        REQUIRE(cache.compile(L"$..title").getNormalizedForm() == titles.getNormalizedForm());
+        REQUIRE(cache.compile(L"$..title").execute(root).nodeList == titles.execute(root).nodeList);
+        REQUIRE(cache.numMisses() == 1);
+        REQUIRE(cache.numHits() == 2);
+
+        // Same text, different type
+        REQUIRE(cache.compile(L"$..title", jsonPathExpression).execute(root).nodeList.size() == 2);
+        REQUIRE(cache.numMisses() == 2);
+        REQUIRE(cache.size() == 2);
+    }
+
+    SECTION("Errors are cached") {
+        JsonPathCompileCache cache;
+        size_t offset = 0;
+        for(int i=0; i<3; i++) {
+            try {
+                cache.compile(L"$.store[?(@.price <");
+                FAIL("Expected a parse error");
+            } catch(const parse_error &e) {
+                REQUIRE((offset == 0 || offset == e._offset_start));
+                offset = e._offset_start;
+            }
+        }
+
+        REQUIRE(offset > 0);
+        REQUIRE(cache.numMisses() == 1);
+        REQUIRE(cache.numHits() == 2);
+    }
+
+    SECTION("Least recently used entries are evicted") {
+        JsonPathCompileCache cache(2);
+        cache.compile(L"$.store");
+        cache.compile(L"$.store.book");
+        cache.compile(L"$.store");
+        cache.compile(L"$..price");
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.numMisses() == 3);
+
+        cache.compile(L"$.store");
+        REQUIRE(cache.numHits() == 2);
+        cache.compile(L"$.store.book");
+        REQUIRE(cache.numMisses() == 4);
+
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("Concurrent use") {
+        JsonPathCompileCache cache(8);
+        const wchar_t *expressions[] = { L"$..title", L"$.store.book[0]", L"$..book[?(@.price > 10)].title",
+                                         L"$.store.book[*].price", L"$..[", L"$.store..price", L"$.store.book[1:]",
+                                         L"$.store.book[?(@.title == \"a\")]", L"$..book.length(", L"$.*.*" };
+
+        std::vector<std::thread> threads;
+        std::vector<size_t> numResults(4);
+        for(size_t t=0; t<4; t++) {
+            threads.emplace_back([&, t]() {
+                for(int i=0; i<500; i++) {
+                    try {
+                        numResults[t] += cache.compile(expressions[(i + t) % 10]).execute(root).nodeList.size();
+                    } catch(const std::exception &) {
+                    }
+                }
+            });
+        }
+
+        for(std::thread &thread: threads) {
+            thread.join();
+        }
+
+        size_t expected = 0;
+        for(int i=0; i<500; i++) {
+            try {
+                expected += JsonPathExpression::compile(expressions[i % 10]).execute(root).nodeList.size();
+            } catch(const std::exception &) {
+            }
+        }
+
+        for(size_t t=0; t<4; t++) {
+            REQUIRE(numResults[t] == expected);
+        }
+        REQUIRE(cache.numHits() + cache.numMisses() == 2000);
+        REQUIRE(cache.size() <= 8);
+    }
+}
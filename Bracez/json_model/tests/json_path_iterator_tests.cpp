@@ -0,0 +1,250 @@
+//
+//  json_path_iterator_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathResultIterator.hpp"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <map>
+#include <string>
+
+using namespace json;
+
+// Counts its calls; filters calling it show how much of the document was evaluated
+class ProbeFunction : public JsonPathExpressionFunction {
+public:
+    virtual JsonPathExpressionNodeEvalResult invoke(const std::list<JsonPathExpressionNodeEvalResult> &args) {
+        numCalls++;
+        return JsonPathExpressionNodeEvalResult::booleanResult(true);
+    }
+
+    virtual int arity() { return 1; }
+
+    int numCalls = 0;
+};
+
+static JsonPathResultNodeList sorted(JsonPathResultNodeList aNodes) {
+    std::sort(aNodes.begin(), aNodes.end());
+    return aNodes;
+}
+
+static JsonPathResultNodeList iterated(JsonPathResultIterator &aIterator) {
+    JsonPathResultNodeList lRet;
+    while(Node *lNode = aIterator.next()) {
+        lRet.push_back(lNode);
+    }
+
+    return lRet;
+}
+
+static Node *firstAtOrAfterByScan(const JsonPathResultNodeList &aNodes, TextCoordinate aPosition) {
+    Node *lRet = NULL;
+    for(Node *lNode: aNodes) {
+        TextCoordinate lStart = lNode->getAbsTextRange().start;
+        if(lStart >= aPosition && (!lRet || lStart < lRet->getAbsTextRange().start)) {
+            lRet = lNode;
+        }
+    }
+
+    return lRet;
+}
+
+// Each result once, in document order
+static JsonPathResultNodeList inDocumentOrder(const JsonPathResultNodeList &aNodes) {
+    std::map<TextCoordinate, Node*> lByStart;
+    for(Node *lNode: aNodes) {
+        lByStart.emplace(lNode->getAbsTextRange().start, lNode);
+    }
+
+    JsonPathResultNodeList lRet;
+    for(const auto &lEntry: lByStart) {
+        lRet.push_back(lEntry.second);
+    }
+
+    return lRet;
+}
+
+TEST_CASE("JsonPath result iterator") {
+    JsonFile file;
+    file.setText(u"{\"store\": {\"book\": [{\"title\": \"a\", \"price\": 8, \"tags\": [1, 2]},\n"
+                 u"  {\"title\": \"b\", \"price\": 12, \"tags\": []}, {\"title\": \"c\", \"price\": 30,\n"
+                 u"  \"book\": [{\"title\": \"d\", \"price\": 4}]}], \"bicycle\": {\"color\": \"red\", \"price\": 19.95}},\n"
+                 u" \"limit\": 10, \"empty\": {}, \"list\": [[0, 1, 2], [3, 4, 5, 6], true, null]}");
+    REQUIRE(file.getErrors().size() == 0);
+    Node *root = file.getDom()->getChildAt(0);
+    Node *cursor = JsonPathExpression::compile(L"$.store.book[1]").execute(root).nodeList.front();
+
+    const wchar_t *paths[] = {
+        L"$", L"$.store", L"$.store.book[*].title", L"$..title", L"$..price", L"$.store.book[0]",
+        L"$.store.book[1:]", L"$.store.book[0:2].price", L"$.store.book[0,2]", L"$.list[1][2]",
+        L"$.store.*", L"$..*", L"$.list[*][*]", L"$..book[?(@.price < 10)].title",
+        L"$..book[?(@.price > 10)]..title", L"$.store.book[-1:]", L"$.list[1][-2:]",
+        L"$..tags[?(@ > 1)]", L"$..book..price", L"$.store..*", L"$.missing..title",
+        L"$..book[??(@.price > 5)].price", L"$.store.book[(1 + 1)].title", L"$..title.^",
+        L"$..book[?(@.price < $.limit)].title", L"^.title", L"^..price", L"$..*..*", L"$.store.b"
+    };
+
+    SECTION("Same results as execute") {
+        for(bool fuzzy: { false, true }) {
+            JsonPathExpressionOptions options;
+            options.fuzzy = fuzzy;
+            for(const wchar_t *path: paths) {
+                INFO(std::string(path, path + wcslen(path)) << (fuzzy ? " (fuzzy)" : ""));
+                JsonPathExpression expression = JsonPathExpression::compile(path);
+                JsonPathResultNodeList executed = expression.execute(root, &options, NULL, cursor).nodeList;
+
+                JsonPathResultIterator iterator(expression, root, &options, NULL, cursor);
+                REQUIRE(sorted(iterated(iterator)) == sorted(executed));
+                REQUIRE(iterator.next() == NULL);
+                REQUIRE(JsonPathResultIterator(expression, root, &options, NULL, cursor).count() == executed.size());
+            }
+        }
+    }
+
+    SECTION("Expressions that compute values") {
+        JsonPathExpression expression = JsonPathExpression::compile(L"$.limit + 1", jsonPathExpression);
+        JsonPathResultIterator iterator(expression, root);
+        Node *result = iterator.next();
+        REQUIRE(result);
+        REQUIRE(static_cast<NumberNode*>(result)->getValue() == 11);
+        REQUIRE(iterator.next() == NULL);
+    }
+
+    SECTION("Recursive matches in document order") {
+        JsonPathResultIterator iterator(JsonPathExpression::compile(L"$..title"), root);
+        JsonPathResultNodeList titles = iterated(iterator);
+        REQUIRE(titles.size() == 4);
+        REQUIRE(std::is_sorted(titles.begin(), titles.end(), [](Node *l, Node *r) {
+            return l->getAbsTextRange().start < r->getAbsTextRange().start;
+        }));
+    }
+
+    SECTION("Limits") {
+        JsonPathResultIterator iterator(JsonPathExpression::compile(L"$..price"), root);
+        JsonPathResultNodeList page;
+        REQUIRE(iterator.take(2, page) == 2);
+        REQUIRE(iterator.take(2, page) == 2);
+        REQUIRE(iterator.take(2, page) == 1);
+        REQUIRE(iterator.take(2, page) == 0);
+        REQUIRE(sorted(page) == sorted(JsonPathExpression::compile(L"$..price").execute(root).nodeList));
+
+        // Counting goes on from where taking stopped
+        JsonPathResultIterator counted(JsonPathExpression::compile(L"$..price"), root);
+        REQUIRE(counted.next());
+        REQUIRE(counted.count() == 4);
+        REQUIRE(counted.count() == 0);
+    }
+
+    SECTION("First at or after a position") {
+        for(const wchar_t *path: paths) {
+            INFO(std::string(path, path + wcslen(path)));
+            JsonPathExpression expression = JsonPathExpression::compile(path);
+            JsonPathResultNodeList executed = expression.execute(root, NULL, NULL, cursor).nodeList;
+            for(unsigned long position = 0; position <= file.getText().length(); position += 7) {
+                INFO(position);
+                JsonPathResultIterator iterator(expression, root, NULL, NULL, cursor);
+                REQUIRE(iterator.firstAtOrAfter(TextCoordinate(position)) == firstAtOrAfterByScan(executed, TextCoordinate(position)));
+            }
+        }
+    }
+
+    SECTION("Pages in document order") {
+        for(const wchar_t *path: paths) {
+            INFO(std::string(path, path + wcslen(path)));
+            JsonPathExpression expression = JsonPathExpression::compile(path);
+            JsonPathResultNodeList expected = inDocumentOrder(expression.execute(root, NULL, NULL, cursor).nodeList);
+
+            JsonPathResultNodeList paged;
+            TextCoordinate position(0);
+            while(true) {
+                JsonPathResultIterator iterator(expression, root, NULL, NULL, cursor);
+                JsonPathResultNodeList page;
+                size_t taken = iterator.takeAtOrAfter(position, 3, page);
+                REQUIRE(taken == page.size());
+                REQUIRE(taken <= 3);
+                if(!taken) {
+                    break;
+                }
+
+                paged.insert(paged.end(), page.begin(), page.end());
+                position = page.back()->getAbsTextRange().start + 1;
+            }
+
+            REQUIRE(paged == expected);
+        }
+    }
+
+    SECTION("Missing start node") {
+        REQUIRE_THROWS_AS(JsonPathResultIterator(JsonPathExpression::compile(L"^.title"), root), JsonPathEvalError);
+        REQUIRE_THROWS_AS(JsonPathResultIterator(JsonPathExpression(), root), JsonPathEvalError);
+    }
+}
+
+TEST_CASE("JsonPath result iterator laziness") {
+    TextString text = u"{\"items\": [";
+    for(int i=0; i<1000; i++) {
+        text += (i ? u", " : u"") + TextString(u"{\"name\": \"item") + textStringFromWstring(std::to_wstring(i)) +
+                u"\", \"v\": " + textStringFromWstring(std::to_wstring(i % 10)) + u"}";
+    }
+    text += u"]}";
+
+    JsonFile file;
+    file.setText(text);
+    Node *root = file.getDom()->getChildAt(0);
+
+    ProbeFunction probe;
+    JsonPathExpressionFunction::functions["probe"] = &probe;
+    JsonPathExpression expression = JsonPathExpression::compile(L"$.items[?(probe(@.v))].name");
+    JsonPathExpressionFunction::functions.erase("probe");
+
+    SECTION("Only what the results taken need is evaluated") {
+        JsonPathResultIterator iterator(expression, root);
+        REQUIRE(iterator.next()->toString() == L"item0");
+        REQUIRE(probe.numCalls == 1);
+
+        JsonPathResultNodeList page;
+        REQUIRE(iterator.take(10, page) == 10);
+        REQUIRE(probe.numCalls == 11);
+        REQUIRE(page.back()->toString() == L"item10");
+    }
+
+    SECTION("First at or after a position skips what's before it and after the hit") {
+        Node *item500 = JsonPathExpression::compile(L"$.items[500].name").execute(root).nodeList.front();
+
+        JsonPathResultIterator iterator(expression, root);
+        REQUIRE(iterator.firstAtOrAfter(item500->getAbsTextRange().start) == item500);
+        REQUIRE(probe.numCalls == 1);
+
+        // A recursive step with no member name index is walked, pruned to the window
+        JsonPathResultIterator recursive(JsonPathExpression::compile(L"$..name"), root);
+        REQUIRE(recursive.firstAtOrAfter(item500->getAbsTextRange().start - 1) == item500);
+    }
+
+    SECTION("A page skips what's before it and after its last result") {
+        Node *item500 = JsonPathExpression::compile(L"$.items[500].name").execute(root).nodeList.front();
+
+        JsonPathResultIterator iterator(expression, root);
+        JsonPathResultNodeList page;
+        REQUIRE(iterator.takeAtOrAfter(item500->getAbsTextRange().start, 10, page) == 10);
+        REQUIRE(page.front() == item500);
+        REQUIRE(page.back()->toString() == L"item509");
+        REQUIRE(probe.numCalls == 10);
+    }
+
+    SECTION("Recursive names from the member name index") {
+        file.setMemberNameIndexEnabled(true);
+        JsonPathResultIterator iterator(JsonPathExpression::compile(L"$..name"), root);
+        REQUIRE(iterator.next()->toString() == L"item0");
+        REQUIRE(iterator.count() == 999);
+
+        Node *item500 = JsonPathExpression::compile(L"$.items[500].name").execute(root).nodeList.front();
+        JsonPathResultIterator indexed(JsonPathExpression::compile(L"$..name"), root);
+        REQUIRE(indexed.firstAtOrAfter(item500->getAbsTextRange().start) == item500);
+    }
+}
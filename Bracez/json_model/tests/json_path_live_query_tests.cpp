@@ -0,0 +1,249 @@
+//
+//  json_path_live_query_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathLiveQuery.hpp"
+#include "catch2/catch.hpp"
+#include <string>
+#include <random>
+#include <set>
+
+using namespace json;
+
+static std::vector<Node*> queried(JsonFile &aFile, const JsonPathExpression &aExpression, Node *aCursor = NULL) {
+    std::vector<Node*> lRet;
+    Node *lRoot = aFile.getDom()->getChildAt(0);
+    if(!lRoot) {
+        return lRet;
+    }
+
+    for(Node *lNode: aExpression.execute(lRoot, NULL, NULL, aCursor).nodeList) {
+        if(lNode->getDocument() == aFile.getDom() && std::find(lRet.begin(), lRet.end(), lNode) == lRet.end()) {
+            lRet.push_back(lNode);
+        }
+    }
+
+    std::sort(lRet.begin(), lRet.end(), [](Node *l, Node *r) {
+        return l->getAbsTextRange().start < r->getAbsTextRange().start ||
+               (l->getAbsTextRange().start == r->getAbsTextRange().start && l->getAbsTextRange().end > r->getAbsTextRange().end);
+    });
+    return lRet;
+}
+
+// Results as a listener sees them by applying deltas
+struct DeltaMirror {
+    DeltaMirror(JsonPathLiveQuery &aQuery) {
+        std::vector<Node*> lResults = aQuery.getResults();
+        results.insert(lResults.begin(), lResults.end());
+        aQuery.setDeltaListener([this](const JsonPathLiveQuery::Delta &aDelta) {
+            numDeltas++;
+            lastDelta = aDelta;
+            for(Node *lNode: aDelta.removed) {
+                results.erase(lNode);
+            }
+            results.insert(aDelta.added.begin(), aDelta.added.end());
+        });
+    }
+
+    std::set<Node*> results;
+    JsonPathLiveQuery::Delta lastDelta;
+    int numDeltas = 0;
+};
+
+static std::string describeNodes(const std::vector<Node*> &aNodes) {
+    std::string lRet;
+    for(Node *lNode: aNodes) {
+        lRet += std::to_string(lNode->getAbsTextRange().start.getAddress()) + " ";
+    }
+
+    return lRet;
+}
+
+static void spliceAt(JsonFile &aFile, const TextString &aFind, TextLength aLen, const TextString &aNewText) {
+    TextCoordinate lAt(aFile.getText().find(aFind));
+    REQUIRE(aFile.fastSpliceTextWithWorkLimit(lAt, aLen, aNewText, 1024));
+}
+
+TEST_CASE("JsonPath live queries") {
+    JsonFile file;
+    TextString text = u"{\"items\": [\n";
+    for(int i=0; i<20; i++) {
+        TextString idx = textStringFromWstring(std::to_wstring(i));
+        text += u"  {\"name\": \"n" + idx + u"\", \"v\": " + textStringFromWstring(std::to_wstring(i % 4)) + u", \"sub\": {\"name\": \"s" + idx + u"\"}}";
+        text += i < 19 ? u",\n" : u"\n";
+    }
+    text += u"], \"name\": \"top\"}";
+    file.setText(text);
+
+    SECTION("Incremental expressions") {
+        REQUIRE(JsonPathLiveQuery(&file, JsonPathExpression::compile(L"$.items[*].name")).isIncremental());
+        REQUIRE(JsonPathLiveQuery(&file, JsonPathExpression::compile(L"$..name")).isIncremental());
+        REQUIRE(JsonPathLiveQuery(&file, JsonPathExpression::compile(L"$.items[?(@.v > 2)].sub")).isIncremental());
+        REQUIRE(!JsonPathLiveQuery(&file, JsonPathExpression::compile(L"$.items[?(@.v > $.items[0].v)]")).isIncremental());
+        REQUIRE(!JsonPathLiveQuery(&file, JsonPathExpression::compile(L"$..name.^")).isIncremental());
+        REQUIRE(!JsonPathLiveQuery(&file, JsonPathExpression::compile(L"^.name")).isIncremental());
+        REQUIRE(!JsonPathLiveQuery(&file, JsonPathExpression::compile(L"$.items[0].v + 1", jsonPathExpression)).isIncremental());
+    }
+
+    SECTION("Deltas of local edits") {
+        JsonPathExpression names = JsonPathExpression::compile(L"$.items[*].name");
+        JsonPathLiveQuery query(&file, names);
+        DeltaMirror mirror(query);
+        REQUIRE(query.size() == 20);
+        REQUIRE(describeNodes(query.getResults()) == describeNodes(queried(file, names)));
+
+        std::vector<Node*> all = query.getResults(), page;
+        query.getResults(18, 5, page);
+        REQUIRE(page == std::vector<Node*>(all.begin() + 18, all.end()));
+
+        // Unrelated edit
+        spliceAt(file, u"\"top\"", 5, u"\"other\"");
+        REQUIRE(mirror.numDeltas == 0);
+
+        spliceAt(file, u"\"n5\"", 4, u"\"five\"");
+        REQUIRE(mirror.numDeltas == 1);
+        REQUIRE(mirror.lastDelta.removed.size() == 1);
+        REQUIRE(mirror.lastDelta.added.size() == 1);
+        REQUIRE(((StringNode*)mirror.lastDelta.added[0])->getValue() == L"five");
+        REQUIRE(describeNodes(query.getResults()) == describeNodes(queried(file, names)));
+
+        // Member renamed
+        spliceAt(file, u"\"name\": \"n7\"", 6, u"\"nm\"");
+        REQUIRE(mirror.lastDelta.removed.size() == 1);
+        REQUIRE(mirror.lastDelta.added.empty());
+        REQUIRE(query.size() == 19);
+        std::vector<Node*> results = query.getResults();
+        REQUIRE(mirror.results == std::set<Node*>(results.begin(), results.end()));
+    }
+
+    SECTION("Filters read by the edit") {
+        JsonPathExpression subs = JsonPathExpression::compile(L"$.items[?(@.v > 2)].sub.name");
+        JsonPathLiveQuery query(&file, subs);
+        DeltaMirror mirror(query);
+        REQUIRE(query.size() == 5);
+
+        spliceAt(file, u"\"v\": 0", 6, u"\"v\": 7");
+        REQUIRE(mirror.lastDelta.removed.empty());
+        REQUIRE(mirror.lastDelta.added.size() == 1);
+        REQUIRE(((StringNode*)mirror.lastDelta.added[0])->getValue() == L"s0");
+
+        spliceAt(file, u"\"v\": 3", 6, u"\"v\": 1");
+        REQUIRE(mirror.lastDelta.removed.size() == 1);
+        REQUIRE(mirror.lastDelta.added.empty());
+        REQUIRE(describeNodes(query.getResults()) == describeNodes(queried(file, subs)));
+    }
+
+    SECTION("Wide arrays") {
+        JsonFile wide;
+        TextString wideText = u"{\"items\": [";
+        for(int i=0; i<5000; i++) {
+            wideText += (i ? u", {\"v\": " : u"{\"v\": ") + textStringFromWstring(std::to_wstring(i % 3)) + u"}";
+        }
+        wideText += u"]}";
+        wide.setText(wideText);
+
+        JsonPathExpression values = JsonPathExpression::compile(L"$.items[?(@.v == 1)].v");
+        JsonPathLiveQuery query(&wide, values);
+        DeltaMirror mirror(query);
+        REQUIRE(query.size() == 1667);
+
+        spliceAt(wide, u"{\"v\": 0}, {\"v\": 1}", 7, u"{\"v\": 1");
+        REQUIRE(mirror.lastDelta.removed.empty());
+        REQUIRE(mirror.lastDelta.added.size() == 1);
+        REQUIRE(query.size() == 1668);
+        REQUIRE(describeNodes(query.getResults()) == describeNodes(queried(wide, values)));
+    }
+
+    SECTION("Cursor") {
+        JsonPathExpression relative = JsonPathExpression::compile(L"^.name");
+        Node *second = JsonPathExpression::compile(L"$.items[2]").execute(file.getDom()->getChildAt(0)).nodeList.front();
+        Node *fourth = JsonPathExpression::compile(L"$.items[4]").execute(file.getDom()->getChildAt(0)).nodeList.front();
+
+        JsonPathLiveQuery query(&file, relative, JsonPathExpressionOptions(), second);
+        DeltaMirror mirror(query);
+        REQUIRE(describeNodes(query.getResults()) == describeNodes(queried(file, relative, second)));
+
+        query.setCursorNode(fourth);
+        REQUIRE(mirror.lastDelta.removed.size() == 1);
+        REQUIRE(mirror.lastDelta.added.size() == 1);
+        REQUIRE(describeNodes(query.getResults()) == describeNodes(queried(file, relative, fourth)));
+
+        // Cursor node is replaced by the edit and followed by its path
+        spliceAt(file, u"{\"name\": \"n4\"", 1, u"{\"x\": 1, ");
+        fourth = JsonPathExpression::compile(L"$.items[4]").execute(file.getDom()->getChildAt(0)).nodeList.front();
+        REQUIRE(describeNodes(query.getResults()) == describeNodes(queried(file, relative, fourth)));
+    }
+
+    SECTION("Edits and reparses") {
+        std::vector<JsonPathExpression> expressions = {
+            JsonPathExpression::compile(L"$.items[*].name"),
+            JsonPathExpression::compile(L"$..name"),
+            JsonPathExpression::compile(L"$.items[?(@.v > 1)].sub"),
+            JsonPathExpression::compile(L"$.items[??(@ == 2)]"),
+            JsonPathExpression::compile(L"$..sub..name"),
+            JsonPathExpression::compile(L"$..*"),
+            JsonPathExpression::compile(L"$.items[1:5].v"),
+            JsonPathExpression::compile(L"$.items[-3:].name"),
+            JsonPathExpression::compile(L"$.items[2,4,7].sub.name"),
+            JsonPathExpression::compile(L"$.items[?(@.v == 1)].*"),
+            JsonPathExpression::compile(L"$.items[(1 + 2)].sub"),
+            JsonPathExpression::compile(L"$.items[?(@.v > $.items[0].v)]"),
+            JsonPathExpression::compile(L"$..name.^")
+        };
+
+        std::vector<std::unique_ptr<JsonPathLiveQuery>> queries;
+        std::vector<std::unique_ptr<DeltaMirror>> mirrors;
+        for(const JsonPathExpression &expression: expressions) {
+            queries.emplace_back(new JsonPathLiveQuery(&file, expression));
+            mirrors.emplace_back(new DeltaMirror(*queries.back()));
+        }
+
+        const char16_t *pieces[] = { u"\"", u"\n", u"1", u"\"name\": ", u"{\"v\": 3, \"name\": 5}", u"\"s\"", u"[[1], []]", u"", u"}" };
+        std::minstd_rand rnd(23);
+        for(int i=0; i<300; i++) {
+            TextLength lLen = file.getText().length();
+            TextCoordinate lStart(rnd() % (lLen+1));
+            TextLength lDelLen = rnd() % std::min<TextLength>(6, lLen - lStart.getAddress() + 1);
+            TextString lPiece = pieces[rnd() % 9];
+
+            std::shared_ptr<JsonFileSemanticModelReconciliationTask> task;
+            switch(rnd() % 4) {
+                case 0:
+                case 1:
+                    if(!file.fastSpliceTextWithWorkLimit(lStart, lDelLen, lPiece, 1024)) {
+                        task = file.spliceTextWithDirtySemanticModel(lStart, lDelLen, lPiece);
+                    }
+                    break;
+
+                case 2: {
+                    TextCoordinate lSecond = lStart + lDelLen + rnd() % (lLen - lStart.getAddress() - lDelLen + 1);
+                    task = file.applyEdits({ Splice(lStart, lDelLen, lPiece), Splice(lSecond, 0, u"{\"name\": 2}") }, 1024);
+                    break;
+                }
+
+                case 3:
+                    task = file.setTextWithSpeculativeParse(file.getText(), rnd() % (lLen+1));
+                    break;
+            }
+
+            if(task) {
+                task->executeInBackground();
+                file.applyReconciliationTask(task);
+            }
+
+            INFO(i);
+            for(size_t j=0; j<expressions.size(); j++) {
+                INFO(j);
+                std::vector<Node*> expected = queried(file, expressions[j]);
+                REQUIRE(describeNodes(queries[j]->getResults()) == describeNodes(expected));
+                REQUIRE(mirrors[j]->results == std::set<Node*>(expected.begin(), expected.end()));
+            }
+        }
+    }
+}
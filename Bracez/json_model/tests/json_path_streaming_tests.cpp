@@ -0,0 +1,170 @@
+//
+//  json_path_streaming_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "reader.h"
+#include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathStreamingEvaluator.hpp"
+#include "catch2/catch.hpp"
+#include <string>
+#include <set>
+
+using namespace json;
+
+typedef std::set<std::pair<unsigned long, unsigned long>> RangeSet;
+
+static RangeSet streamed(const TextString &aText, const std::wstring &aPath, JsonPathStreamingEvaluator **aEvaluator = NULL) {
+    static std::unique_ptr<JsonPathStreamingEvaluator> lEvaluator;
+    lEvaluator.reset(new JsonPathStreamingEvaluator(JsonPathExpression::compile(aPath)));
+    if(aEvaluator) {
+        *aEvaluator = lEvaluator.get();
+    }
+
+    RangeSet lRet;
+    lEvaluator->evaluate(aText.c_str(), aText.length(), [&lRet](Node *aMatch) {
+        TextRange lRange = aMatch->getAbsTextRange();
+        REQUIRE(lRet.emplace(lRange.start.getAddress(), lRange.end.getAddress()).second);
+    });
+
+    return lRet;
+}
+
+static RangeSet streamedInChunks(const TextString &aText, const std::wstring &aPath, TextLength aChunkSize,
+                                 JsonPathStreamingEvaluator **aEvaluator = NULL) {
+    static std::unique_ptr<JsonPathStreamingEvaluator> lEvaluator;
+    lEvaluator.reset(new JsonPathStreamingEvaluator(JsonPathExpression::compile(aPath)));
+    if(aEvaluator) {
+        *aEvaluator = lEvaluator.get();
+    }
+
+    TextLength lRead = 0;
+    auto lReader = [&aText, &lRead](TextChar *aBuffer, TextLength aCapacity) {
+        TextLength lLen = std::min(aCapacity, aText.length() - lRead);
+        std::copy(aText.begin() + lRead, aText.begin() + lRead + lLen, aBuffer);
+        lRead += lLen;
+        return lLen;
+    };
+
+    RangeSet lRet;
+    lEvaluator->evaluate(lReader, [&lRet](Node *aMatch) {
+        TextRange lRange = aMatch->getAbsTextRange();
+        REQUIRE(lRet.emplace(lRange.start.getAddress(), lRange.end.getAddress()).second);
+    }, aChunkSize);
+
+    return lRet;
+}
+
+static RangeSet queried(JsonFile &aFile, const std::wstring &aPath) {
+    RangeSet lRet;
+    for(Node *lNode: JsonPathExpression::compile(aPath).execute(aFile.getDom()->getChildAt(0)).nodeList) {
+        TextRange lRange = lNode->getAbsTextRange();
+        lRet.emplace(lRange.start.getAddress(), lRange.end.getAddress());
+    }
+
+    return lRet;
+}
+
+TEST_CASE("Streaming JsonPath") {
+    TextString text = u"{\"store\": {\"book\": [{\"title\": \"a\", \"price\": 8, \"tags\": [1, 2]},\n"
+                      u"  {\"title\": \"b\", \"price\": 12, \"tags\": []}, {\"title\": \"c\\n\", \"price\": 30,\n"
+                      u"  \"book\": [{\"title\": \"d\", \"price\": 4}]}], \"bicycle\": {\"color\": \"red\", \"price\": 19.95}},\n"
+                      u" \"limit\": 10, \"empty\": {}, \"list\": [[0, 1, 2], [3, 4, 5, 6], true, null]}";
+    JsonFile file;
+    file.setText(text);
+    REQUIRE(file.getErrors().size() == 0);
+
+    SECTION("Streamable expressions") {
+        REQUIRE(JsonPathStreamingEvaluator::canStream(JsonPathExpression::compile(L"$..book[?(@.price < 10)].title")));
+        REQUIRE(JsonPathStreamingEvaluator::canStream(JsonPathExpression::compile(L"$.store.book[-1:]")));
+        REQUIRE(!JsonPathStreamingEvaluator::canStream(JsonPathExpression::compile(L"$..title.^")));
+        REQUIRE(!JsonPathStreamingEvaluator::canStream(JsonPathExpression::compile(L"^.title")));
+        REQUIRE(!JsonPathStreamingEvaluator::canStream(JsonPathExpression::compile(L"$..book[?(@.price < $.limit)]")));
+        REQUIRE_THROWS_AS(JsonPathStreamingEvaluator(JsonPathExpression::compile(L"$..title.^")), JsonPathEvalError);
+
+        // The root would be read in whole
+        REQUIRE(!JsonPathStreamingEvaluator::canStream(JsonPathExpression::compile(L"$")));
+        REQUIRE(!JsonPathStreamingEvaluator::canStream(JsonPathExpression::compile(L"$..*")));
+        REQUIRE_THROWS_AS(JsonPathStreamingEvaluator(JsonPathExpression::compile(L"$")), JsonPathEvalError);
+    }
+
+    SECTION("Same results as over the DOM") {
+        const wchar_t *paths[] = {
+            L"$.store", L"$.store.book[*].title", L"$..title", L"$..price", L"$.store.book[0]",
+            L"$.store.book[1:]", L"$.store.book[0:2].price", L"$.store.book[0,2]", L"$.list[1][2]",
+            L"$.store.*", L"$.list[*][*]", L"$..book[?(@.price < 10)].title",
+            L"$..book[?(@.price > 10)]..title", L"$.store.book[-1:]", L"$.list[1][-2:]",
+            L"$..tags[?(@ > 1)]", L"$..book..price", L"$.store..*", L"$.missing..title",
+            L"$..book[??(@.price > 5)].price", L"$.store.book[(1 + 1)].title"
+        };
+
+        for(const wchar_t *path: paths) {
+            INFO(std::string(path, path + wcslen(path)));
+            RangeSet expected = queried(file, path);
+            REQUIRE(streamed(text, path) == expected);
+            for(TextLength chunkSize: { 1, 3, 16, 1024 }) {
+                INFO(chunkSize);
+                REQUIRE(streamedInChunks(text, path, chunkSize) == expected);
+            }
+        }
+    }
+
+    SECTION("Fuzzy names") {
+        JsonPathExpressionOptions fuzzy;
+        fuzzy.fuzzy = true;
+        JsonPathStreamingEvaluator evaluator(JsonPathExpression::compile(L"$.store.b"), fuzzy);
+
+        int numMatches = 0;
+        evaluator.evaluate(text.c_str(), text.length(), [&numMatches](Node *aMatch) { numMatches++; });
+        REQUIRE(numMatches == 2);
+    }
+
+    SECTION("Only matches are read") {
+        TextString items = u"{\"meta\": {\"count\": 2000}, \"items\": [";
+        for(int i=0; i<2000; i++) {
+            TextString idx = textStringFromWstring(std::to_wstring(i));
+            items += (i ? u", " : u"") + TextString(u"{\"name\": \"item") + idx + u"\", \"v\": " +
+                     textStringFromWstring(std::to_wstring(i % 10)) + u", \"tags\": [\"x\", \"y\", {\"deep\": [1, 2, 3]}]}";
+        }
+        items += u"]}";
+
+        JsonPathStreamingEvaluator *evaluator = NULL;
+        REQUIRE(streamed(items, L"$.items[*].name", &evaluator).size() == 2000);
+        REQUIRE(evaluator->numMaterialized() == 2000);
+        REQUIRE(evaluator->maxMaterializedLength() < 16);
+
+        REQUIRE(streamed(items, L"$.items[?(@.v == 3)].name", &evaluator).size() == 200);
+        REQUIRE(evaluator->numMaterialized() == 2000);
+        REQUIRE(evaluator->maxMaterializedLength() < 100);
+
+        REQUIRE(streamed(items, L"$.meta.count", &evaluator).size() == 1);
+        REQUIRE(evaluator->numMaterialized() == 1);
+
+        // No match: nothing is read into a subtree
+        REQUIRE(streamed(items, L"$.items[5000]", &evaluator).empty());
+        REQUIRE(evaluator->numMaterialized() == 0);
+
+        // Read in chunks, only about a chunk of text is kept at a time
+        REQUIRE(streamedInChunks(items, L"$.items[?(@.v == 3)].name", 256, &evaluator).size() == 200);
+        REQUIRE(evaluator->maxBufferedLength() < 512);
+        REQUIRE(streamedInChunks(items, L"$.items[5000]", 256, &evaluator).empty());
+        REQUIRE(evaluator->maxBufferedLength() < 512);
+    }
+
+    SECTION("Malformed input") {
+        REQUIRE_THROWS_AS(streamed(u"{\"a\": [1, 2}", L"$.a"), JsonPathEvalError);
+        REQUIRE_THROWS_AS(streamed(u"{\"a\": [1, 2}", L"$.b"), JsonPathEvalError);
+        REQUIRE_THROWS_AS(streamed(u"{\"a\" 1}", L"$.b"), JsonPathEvalError);
+        REQUIRE_THROWS_AS(streamed(u"{\"a\": [1, 2", L"$.a[*]"), JsonPathEvalError);
+        REQUIRE_THROWS_AS(streamed(u"[1, 2 3]", L"$[0]"), JsonPathEvalError);
+        REQUIRE(streamed(u"{\"a\": {\"b\": 1}}", L"$.a.b").size() == 1);
+
+        REQUIRE_THROWS_AS(streamedInChunks(u"{\"a\": [1, 2}", L"$.a", 2), JsonPathEvalError);
+        REQUIRE_THROWS_AS(streamedInChunks(u"{\"a\": [1, 2", L"$.a[*]", 2), JsonPathEvalError);
+        REQUIRE_THROWS_AS(streamedInChunks(u"{\"a\": \"x", L"$.b", 2), JsonPathEvalError);
+    }
+}
@@ -10,6 +10,7 @@
 #include "JsonPathExpressionCompiler.hpp"
 
 #include <string>
+#include <atomic>
 
 #include "catch2/catch.hpp"
 
@@ -263,3 +264,126 @@ TEST_CASE_METHOD(BooksJsonPathTestFixture, "Subscript by expression", "[test]")
                "\"price\": 22.989999999999998437 } ]"));
     
 }
+
+TEST_CASE_METHOD(BooksJsonPathTestFixture, "Expression evaluation", "[test]") {
+    SECTION("Logical operators short-circuit") {
+        CHECK(jsonPathResult(doc, L"$..book[?(@.price > 0 || pow(@.category, 2))].title") == std::wstring(
+                L"[ \"Sayings of the Century\", \"Moby Dick\", \"The Lord of the Rings\" ]"));
+        CHECK(jsonPathResult(doc, L"$..book[?(@.price > 100 && pow(@.category, 2))].title") == std::wstring(L"[ ]"));
+    }
+
+    SECTION("Operator chains") {
+        CHECK(jsonPathResult(doc, L"$..book[?(@.price * 2 - 1 > 20)].title") == std::wstring(
+                L"[ \"The Lord of the Rings\" ]"));
+        CHECK(jsonPathResult(doc, L"$..book[?(@.category + \"!\" == \"reference!\")].title") == std::wstring(
+                L"[ \"Sayings of the Century\" ]"));
+        CHECK(jsonPathResult(doc, L"$..book[?(@.isbn && @.price < 10 || @.price > 20)].title") == std::wstring(
+                L"[ \"Moby Dick\", \"The Lord of the Rings\" ]"));
+    }
+
+    SECTION("Nested filters and member names") {
+        CHECK(jsonPathResult(doc, L"$.store[??(@.book[?(@.price > 20)])].bicycle.color") == std::wstring(
+                L"[ \"red\" ]"));
+        CHECK(jsonPathResult(doc, L"$.store.bicycle[?(@@ == \"color\")]") == std::wstring(
+                L"[ \"red\" ]"));
+        CHECK(jsonPathResult(doc, L"$.store.book[?(@@ > 0)].title") == std::wstring(
+                L"[ \"Moby Dick\", \"The Lord of the Rings\" ]"));
+    }
+
+    SECTION("Compiled expressions can be shared") {
+        JsonPathExpression expr = JsonPathExpression::compile(L"$..book[?(@.price < 9)].title");
+        JsonPathExpression copy = expr;
+        REQUIRE(expr.execute(doc).nodeList.size() == 2);
+        REQUIRE(copy.execute(doc).nodeList.size() == 2);
+        REQUIRE(!copy.isCursorDependent());
+        REQUIRE(JsonPathExpression::compile(L"^.title").isCursorDependent());
+    }
+
+    SECTION("Scalar results become nodes") {
+        auto scalarResult = [this](const wchar_t *expression) {
+            json::Node *book = JsonPathExpression::compile(L"$.store.book[2]").execute(doc).nodeList.front();
+            JsonPathExpressionNodeEvalResult result = JsonPathExpression::compile(expression, jsonPathExpression).execute(doc, NULL, book);
+
+            REQUIRE(!result.isScalar());
+            REQUIRE(result.nodeList.size() == 1);
+            std::wstring text;
+            result.nodeList.front()->calculateJsonTextRepresentation(text);
+            return text;
+        };
+
+        CHECK(scalarResult(L"@.price * 2 > 40") == L"true");
+        CHECK(scalarResult(L"@.price - 0.99") == L"22");
+        CHECK(scalarResult(L"@.category + \"/\" + @.price") == L"\"fiction/22.990000\"");
+        CHECK(scalarResult(L"@.isbn > 1") == L"false");
+        CHECK(scalarResult(L"@.missing > 1") == L"null");
+        CHECK(scalarResult(L"\"abc\"") == L"\"abc\"");
+        CHECK(scalarResult(L"length(\"abc\") + length(@.title)") == L"24");
+        CHECK(scalarResult(L"toarray(@.category) + 1") == L"[ \"fiction\", 1 ]");
+        CHECK(scalarResult(L"@.category in [\"fiction\", 1]") == L"true");
+    }
+}
+
+TEST_CASE("Parallel filters", "[test]") {
+    std::wstring docText = L"{\"items\": [";
+    for(int i=0; i<5000; i++) {
+        docText += (i ? L", " : L"") + std::wstring(L"{\"i\": ") + std::to_wstring(i) +
+                   L", \"tags\": [" + std::to_wstring(i % 7) + L", " + std::to_wstring(i % 5) + L"]}";
+    }
+    docText += L"]}";
+
+    json::Node *doc;
+    json::Reader::Read(doc, docText);
+
+    JsonPathExpressionOptions sequential;
+    JsonPathExpressionOptions parallel;
+    parallel.parallel = true;
+    parallel.parallelThreshold = 100;
+
+    auto describe = [doc](const wchar_t *path, JsonPathExpressionOptions &options) {
+        std::wstring ret;
+        for(json::Node *node: JsonPathExpression::compile(path).execute(doc, &options).nodeList) {
+            std::wstring nodeText;
+            node->calculateJsonTextRepresentation(nodeText);
+            ret += nodeText + L" ";
+        }
+        return ret;
+    };
+
+    SECTION("Results match sequential evaluation") {
+        const wchar_t *paths[] = {
+            L"$.items[?(@.i % 3 == 0 && @.tags[?(@ == 4)])].i",
+            L"$.items[??(@.i > 4900 || @.i < 10)]",
+            L"$..tags[?(@ > 5)]",
+            L"$.items[?(@.i % 1000 == 0)].tags[?(@ > 0)]"
+        };
+
+        for(const wchar_t *path: paths) {
+            INFO(std::string(path, path + wcslen(path)));
+            REQUIRE(describe(path, parallel) == describe(path, sequential));
+        }
+    }
+
+    SECTION("Partitions run through the executor") {
+        std::atomic<size_t> numPartitions(0);
+        parallel.parallelFor = [&numPartitions](size_t count, const std::function<void (size_t)> &body) {
+            numPartitions += count;
+            for(size_t idx=count; idx>0; idx--) {
+                body(idx-1);
+            }
+        };
+
+        REQUIRE(describe(L"$.items[?(@.i % 1000 == 0)].i", parallel) == L"0 1000 2000 3000 4000 ");
+        REQUIRE(numPartitions > 1);
+
+        numPartitions = 0;
+        describe(L"$.items[?(@.i < 2)]", sequential);
+        describe(L"$.items[0:20][?(@ < 2)]", parallel);
+        REQUIRE(numPartitions == 0);
+    }
+
+    SECTION("Errors propagate") {
+        REQUIRE_THROWS_AS(describe(L"$.items[?(@.tags[(@.i > 4000)])]", parallel), JsonPathEvalError);
+    }
+
+    delete doc;
+}
@@ -0,0 +1,281 @@
+//
+//  lexical_highlight_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "catch2/catch.hpp"
+#include <string>
+#include <random>
+
+using namespace json;
+
+static std::string describeSpans(JsonFile &aFile, TextCoordinate aStart, TextCoordinate aEnd) {
+    static const char *lClassNames[] = { "string", "key", "number", "literal", "punct" };
+
+    std::vector<LexicalSpan> lSpans;
+    aFile.getLexicalSpans(aStart, aEnd, lSpans);
+
+    std::string lRet;
+    for(const LexicalSpan &lSpan: lSpans) {
+        lRet += std::to_string(lSpan.start.getAddress()) + "+" + std::to_string(lSpan.length) + ":" +
+                lClassNames[lSpan.tokenClass] + " ";
+    }
+
+    return lRet;
+}
+
+TEST_CASE("Lexical highlighting") {
+    JsonFile file;
+
+    SECTION("Token classes") {
+        file.setText(u"{\"a\": [1, -2.5e3, true],\n \"b\" : null, \"c\": \"x\\\"y\"}");
+
+        REQUIRE(describeSpans(file, TextCoordinate(0), TextCoordinate(file.getText().length())) ==
+                "0+1:punct 1+3:key 4+1:punct 6+1:punct 7+1:number 8+1:punct 10+6:number 16+1:punct "
+                "18+4:literal 22+1:punct 23+1:punct 26+3:key 30+1:punct 32+4:literal 36+1:punct "
+                "38+3:key 41+1:punct 43+6:string 49+1:punct ");
+    }
+
+    SECTION("Range starts inside a multi-line string") {
+        file.setText(u"[\"abc\ndef\", 1,\n2]");
+
+        REQUIRE(describeSpans(file, TextCoordinate(8), TextCoordinate(13)) == "6+4:string 10+1:punct 12+1:number ");
+        REQUIRE(describeSpans(file, TextCoordinate(15), TextCoordinate(16)) == "15+1:number ");
+    }
+
+    SECTION("Checkpoints follow edits") {
+        const char16_t *pieces[] = { u"\"", u"\n", u"1", u"\"k\": ", u"\\", u"\"s\n\"", u"[true, null]", u"" };
+        TextString text = u"{\"a\": [1, 2, {\"b\": \"x\"}],\n \"c\": {\"d\": [true, false]},\n \"e\": \"multi\nline\",\n \"f\": [[1],\n[2],[3]]}";
+        file.setText(text);
+
+        std::minstd_rand rnd(5);
+        for(int i=0; i<300; i++) {
+            TextLength lLen = file.getText().length();
+            TextCoordinate lStart(rnd() % (lLen+1));
+            TextLength lDelLen = rnd() % std::min<TextLength>(4, lLen - lStart.getAddress() + 1);
+            TextString lPiece = pieces[rnd() % 8];
+
+            switch(rnd() % 3) {
+                case 0:
+                    if(!file.fastSpliceTextWithWorkLimit(lStart, lDelLen, lPiece, 1024)) {
+                        file.spliceTextWithDirtySemanticModel(lStart, lDelLen, lPiece);
+                    }
+                    break;
+
+                case 1: {
+                    auto task = file.applyEdits({ Splice(lStart, lDelLen, lPiece) }, 1024);
+                    if(task) {
+                        task->executeInBackground();
+                        file.applyReconciliationTask(task);
+                    }
+                    break;
+                }
+
+                case 2:
+                    // Model stays dirty till the next reparse, spans don't need it
+                    file.spliceTextWithDirtySemanticModel(lStart, lDelLen, lPiece);
+                    break;
+            }
+
+            JsonFile fresh;
+            fresh.setText(file.getText());
+
+            lLen = file.getText().length();
+            TextCoordinate lQueryStart(rnd() % (lLen+1));
+            TextCoordinate lQueryEnd = lQueryStart + rnd() % (lLen - lQueryStart.getAddress() + 1);
+            INFO(i);
+            REQUIRE(describeSpans(file, lQueryStart, lQueryEnd) == describeSpans(fresh, lQueryStart, lQueryEnd));
+        }
+    }
+}
+
+static std::string describeRuns(JsonFile &aFile, TextCoordinate aStart, TextCoordinate aEnd) {
+    static const char *lClassNames[] = { "string", "key", "number", "literal", "punct" };
+
+    std::string lRet;
+    auto lRuns = aFile.getSyntaxRuns().runsIntersecting(aStart, aEnd);
+    for(auto lIter = lRuns.first; lIter != lRuns.second; lIter++) {
+        lRet += std::to_string(lIter->getCoordinate().getAddress()) + "+" + std::to_string(lIter->getLength()) + ":" +
+                lClassNames[lIter->getTokenClass()] + " ";
+    }
+
+    return lRet;
+}
+
+static std::string describeRuns(JsonFile &aFile) {
+    return describeRuns(aFile, TextCoordinate(0), TextCoordinate(aFile.getText().length()));
+}
+
+static std::string describeFreshRuns(JsonFile &aFile) {
+    JsonFile lFresh;
+    lFresh.setText(aFile.getText());
+    return describeRuns(lFresh);
+}
+
+// Runs as the file's own DOM has them; local reparses of broken text may legitimately
+// differ from a fresh parse
+static void describeNodeRuns(const Node *aNode, TextLength aParentStart, TextLength aTextLen, TextLength &aLastEnd, std::string &aOut) {
+    static const char *lClassNames[] = { "literal", "number", "literal", "string" };
+
+    auto lAddRun = [&](TextLength aStart, TextLength aEnd, const char *aClass) {
+        aEnd = std::min(aEnd, aTextLen);
+        if(aStart < aEnd && aStart >= aLastEnd) {
+            aOut += std::to_string(aStart) + "+" + std::to_string(aEnd - aStart) + ":" + aClass + " ";
+            aLastEnd = aEnd;
+        }
+    };
+
+    TextLength lStart = aParentStart + aNode->getTextRange().start.getAddress();
+    if(const ObjectNode *lObject = dynamic_cast<const ObjectNode*>(aNode)) {
+        for(int i=0; i<lObject->getChildCount(); i++) {
+            const ObjectNode::Member *lMember = lObject->getChildMemberAt(i);
+            lAddRun(lStart + lMember->nameRange.start.getAddress(), lStart + lMember->nameRange.end.getAddress(), "key");
+            if(lMember->node) {
+                describeNodeRuns(lMember->node.get(), lStart, aTextLen, aLastEnd, aOut);
+            }
+        }
+    } else
+    if(const ArrayNode *lArray = dynamic_cast<const ArrayNode*>(aNode)) {
+        for(int i=0; i<lArray->getChildCount(); i++) {
+            if(lArray->getChildAt(i)) {
+                describeNodeRuns(lArray->getChildAt(i), lStart, aTextLen, aLastEnd, aOut);
+            }
+        }
+    } else {
+        TextLength lEnd = aNode->getTextRange().end.infinite() ? aTextLen : aParentStart + aNode->getTextRange().end.getAddress();
+        lAddRun(lStart, lEnd, lClassNames[aNode->getNodeTypeId()]);
+    }
+}
+
+static std::string describeModelRuns(JsonFile &aFile) {
+    std::string lRet;
+    TextLength lLastEnd = 0;
+    if(const Node *lRoot = aFile.getDom()->getChildAt(0)) {
+        describeNodeRuns(lRoot, 0, aFile.getText().length(), lLastEnd, lRet);
+    }
+
+    return lRet;
+}
+
+struct SyntaxRunsCollector : public JsonFileChangeListener {
+    void notifyTextSpliced(JsonFile *aSender, TextCoordinate aOldOffset,
+                           TextLength aOldLength, TextLength aNewLength,
+                           TextCoordinate aOldLineStart, TextLength aOldLineLength,
+                           TextLength aNewLineLength) {}
+    
+    void notifySyntaxRunsChanged(JsonFile *aSender, const MarkerListDelta &aDelta) {
+        deltas.push_back(aDelta);
+    }
+    
+    std::vector<MarkerListDelta> deltas;
+};
+
+TEST_CASE("Syntax run map") {
+    JsonFile file;
+    file.setText(u"{\"a\": [1, -2.5e3, true],\n \"b\" : null, \"c\": {\"d\": \"x\\\"y\"}}");
+
+    SECTION("Runs come from the DOM") {
+        REQUIRE(describeRuns(file) == describeModelRuns(file));
+        REQUIRE(describeRuns(file) ==
+                "1+3:key 7+1:number 10+6:number 18+4:literal 26+3:key 32+4:literal "
+                "38+3:key 44+3:key 49+6:string ");
+    }
+
+    SECTION("Range queries") {
+        REQUIRE(describeRuns(file, TextCoordinate(12), TextCoordinate(20)) == "10+6:number 18+4:literal ");
+        REQUIRE(describeRuns(file, TextCoordinate(16), TextCoordinate(18)) == "");
+        REQUIRE(describeRuns(file, TextCoordinate(0), TextCoordinate(2)) == "1+3:key ");
+
+        TextCoordinate lStart, lEnd;
+        const SyntaxRun *lRun = file.getSyntaxRuns().findRun(TextCoordinate(12), TextCoordinate(file.getText().length()), lStart, lEnd);
+        REQUIRE(lRun);
+        REQUIRE(lRun->getTokenClass() == ltcNumber);
+        REQUIRE(lStart == TextCoordinate(10));
+        REQUIRE(lEnd == TextCoordinate(16));
+
+        REQUIRE(!file.getSyntaxRuns().findRun(TextCoordinate(16), TextCoordinate(file.getText().length()), lStart, lEnd));
+        REQUIRE(lStart == TextCoordinate(16));
+        REQUIRE(lEnd == TextCoordinate(18));
+
+        REQUIRE(!file.getSyntaxRuns().findRun(TextCoordinate(56), TextCoordinate(file.getText().length()), lStart, lEnd));
+        REQUIRE(lStart == TextCoordinate(55));
+        REQUIRE(lEnd == TextCoordinate(57));
+    }
+
+    SECTION("Dirty splices drop the runs they touch") {
+        file.spliceTextWithDirtySemanticModel(TextCoordinate(16), 0, u"0");
+        REQUIRE(describeRuns(file, TextCoordinate(0), TextCoordinate(25)) == "1+3:key 7+1:number 19+4:literal ");
+    }
+
+    SECTION("Reparses report the runs they changed") {
+        SyntaxRunsCollector lCollector;
+        file.addListener(&lCollector);
+        
+        auto task = file.spliceTextWithDirtySemanticModel(TextCoordinate(16), 0, u"0");
+        std::string lBefore = describeRuns(file);
+        REQUIRE(task);
+        task->executeInBackground();
+        file.applyReconciliationTask(task);
+        file.removeListener(&lCollector);
+        
+        REQUIRE(lCollector.deltas.size() == 1);
+        TextCoordinate lStart, lEnd;
+        file.getSyntaxRuns().getChangedRange(lCollector.deltas[0], TextCoordinate(file.getText().length()), lStart, lEnd);
+        REQUIRE(lStart == TextCoordinate(8));
+        REQUIRE(lEnd == TextCoordinate(19));
+        
+        // Everything outside the changed range is what it was before the reparse
+        TextLength lLen = file.getText().length();
+        REQUIRE(describeRuns(file, TextCoordinate(0), lStart) + describeRuns(file, lEnd, TextCoordinate(lLen)) == lBefore);
+        REQUIRE(describeRuns(file, lStart, lEnd) == "10+7:number ");
+    }
+
+    SECTION("DOM edits") {
+        ObjectNode *root = (ObjectNode*)file.getDom()->getChildAt(0);
+        root->renameMemberAt(1, L"renamed");
+        REQUIRE(describeRuns(file) == describeFreshRuns(file));
+
+        ((ArrayNode*)root->getChildAt(0))->InsertMemberAt(1, new StringNode(L"str"), NULL);
+        REQUIRE(describeRuns(file) == describeFreshRuns(file));
+
+        Node *removed;
+        ((ArrayNode*)root->getChildAt(0))->detachChildAt(0, &removed);
+        delete removed;
+        REQUIRE(describeRuns(file) == describeFreshRuns(file));
+
+        root->insertMemberAt(1, L"k", new NumberNode(5), NULL);
+        REQUIRE(describeRuns(file) == describeFreshRuns(file));
+    }
+
+    SECTION("Runs follow edits and reparses") {
+        const char16_t *pieces[] = { u"\"", u"\n", u"1", u"\"k\": ", u"x", u"\"s\"", u"[true, null]", u"", u"{\"q\": 2}" };
+        std::minstd_rand rnd(7);
+        for(int i=0; i<300; i++) {
+            TextLength lLen = file.getText().length();
+            TextCoordinate lStart(rnd() % (lLen+1));
+            TextLength lDelLen = rnd() % std::min<TextLength>(4, lLen - lStart.getAddress() + 1);
+            TextString lPiece = pieces[rnd() % 9];
+
+            std::shared_ptr<JsonFileSemanticModelReconciliationTask> task;
+            if(rnd() % 2) {
+                if(!file.fastSpliceTextWithWorkLimit(lStart, lDelLen, lPiece, 1024)) {
+                    task = file.spliceTextWithDirtySemanticModel(lStart, lDelLen, lPiece);
+                }
+            } else {
+                TextCoordinate lSecond = lStart + lDelLen + rnd() % (lLen - lStart.getAddress() - lDelLen + 1);
+                task = file.applyEdits({ Splice(lStart, lDelLen, lPiece), Splice(lSecond, 0, u"2") }, 1024);
+            }
+
+            if(task) {
+                task->executeInBackground();
+                file.applyReconciliationTask(task);
+            }
+
+            INFO(i);
+            REQUIRE(describeRuns(file) == describeModelRuns(file));
+        }
+    }
+}
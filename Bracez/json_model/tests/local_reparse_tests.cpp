@@ -50,10 +50,10 @@ const T &getObjectMemberValue(ObjectNode* o, const std::wstring &memberName) {
 class JsonEditTestDescription {
 public:
     struct EditAction {
-        EditAction(int es, int edc, const std::wstring &ei) :
+        EditAction(int es, int edc, const TextString &ei) :
             editStart(es), editDeleteCount(edc), editInsert(ei) {}
         
-        void applyToString(std::wstring &str) const {
+        void applyToString(TextString &str) const {
             str = str.substr(0, editStart) +
                   editInsert +
                   str.substr(editStart+editDeleteCount);
@@ -68,7 +68,7 @@ public:
         
         int editStart;
         int editDeleteCount;
-        std::wstring editInsert;
+        TextString editInsert;
     };
     
     typedef vector<EditAction> Edits;
@@ -78,11 +78,11 @@ private:
     }
     
 public:
-    const std::wstring &getStartFile() const { return startFile; }
+    const TextString &getStartFile() const { return startFile; }
     const Edits &getEditActions() const { return editActions; }
 
-    std::wstring getEndFile() const {
-        std::wstring endFile = startFile;
+    TextString getEndFile() const {
+        TextString endFile = startFile;
         for_each(editActions.begin(), editActions.end(), [&endFile](const EditAction &a) {
             a.applyToString(endFile);
         });
@@ -90,17 +90,17 @@ public:
     }
     
 public:
-    static JsonEditTestDescription fromInlineEditDescription(const std::wstring &desc) {
-        int editStart = (int)(desc.find(L"<<<<"));
+    static JsonEditTestDescription fromInlineEditDescription(const TextString &desc) {
+        int editStart = (int)(desc.find(u"<<<<"));
         
-        int editDeleteStart = (int)desc.find(L"====");
+        int editDeleteStart = (int)desc.find(u"====");
         int editDeleteCount = (editDeleteStart - (editStart+4));
         
-        int editInsertEnd = (int)desc.find(L">>>>");
-        std::wstring editInsert = desc.substr(editDeleteStart+4, editInsertEnd-(editDeleteStart+4));
+        int editInsertEnd = (int)desc.find(u">>>>");
+        TextString editInsert = desc.substr(editDeleteStart+4, editInsertEnd-(editDeleteStart+4));
         
-        std::wstring preEdit = desc.substr(0, editStart);
-        std::wstring postEdit = desc.substr(editInsertEnd+4);
+        TextString preEdit = desc.substr(0, editStart);
+        TextString postEdit = desc.substr(editInsertEnd+4);
         
         JsonEditTestDescription ret;
         ret.startFile = preEdit +
@@ -116,7 +116,7 @@ public:
         JsonEditTestDescription ret;
         
         std::unique_ptr<ObjectNode> fileDesc = readJsonLineFromStream(recordingSessionStream);
-        ret.startFile = getObjectMemberValue<std::wstring>(fileDesc.get(), L"content");
+        ret.startFile = textStringFromWstring(getObjectMemberValue<std::wstring>(fileDesc.get(), L"content"));
             
         while(!recordingSessionStream.eof()) {
             std::unique_ptr<ObjectNode> fileDesc = readJsonLineFromStream(recordingSessionStream);
@@ -124,14 +124,14 @@ public:
             ret.editActions.push_back(EditAction(
                        getObjectMemberValue<double>(fileDesc.get(), L"start"),
                        getObjectMemberValue<double>(fileDesc.get(), L"len"),
-                                                 getObjectMemberValue<std::wstring>(fileDesc.get(), L"new_text")));            
+                                                 textStringFromWstring(getObjectMemberValue<std::wstring>(fileDesc.get(), L"new_text"))));            
         }
         
         return ret;
     }
     
 private:
-    std::wstring startFile;
+    TextString startFile;
     Edits editActions;
 };
 
@@ -156,7 +156,7 @@ static std::wstring debugJsonForDoc(JsonFile* doc) {
 
 TEST_CASE("JSON file local reparse text") {
     auto testedEdit = GENERATE(
-                               JsonEditTestDescription::fromInlineEditDescription(L"{ \"hello\": <<<<3====22>>>> }"),
+                               JsonEditTestDescription::fromInlineEditDescription(u"{ \"hello\": <<<<3====22>>>> }"),
                                
                                loadEditTestDescriptionFromFile( "json_model/tests/fixtures/edit_recording_test_local_reparse_1.txt"),
 
@@ -184,12 +184,12 @@ TEST_CASE("JSON file local reparse text") {
 TEST_CASE("JSON file local reparse: string unicode literal bug") {
     // Run edits
     std::unique_ptr<JsonFile> preEditDoc(new JsonFile());
-    preEditDoc->setText(L"{\"b\":\"\\\"\n}");
+    preEditDoc->setText(u"{\"b\":\"\\\"\n}");
     
     // There's an unterminated string here. We should have an error on it
     REQUIRE(preEditDoc->getErrors().size() == 1);
     
-    bool fastParseResult = preEditDoc->fastSpliceTextWithWorkLimit(TextCoordinate(7), 0, L"u", 1024);
+    bool fastParseResult = preEditDoc->fastSpliceTextWithWorkLimit(TextCoordinate(7), 0, u"u", 1024);
     REQUIRE(fastParseResult == false);
 }
     
@@ -197,12 +197,12 @@ TEST_CASE("JSON file local reparse: string unicode literal bug") {
 TEST_CASE("JSON file local reparse: EOS errors ") {
     // Run edits
     std::unique_ptr<JsonFile> preEditDoc(new JsonFile());
-    preEditDoc->setText(L"{\"d\":\"\\\"");
+    preEditDoc->setText(u"{\"d\":\"\\\"");
     
     // There's an unterminated string here. We should have an error on it
     REQUIRE(preEditDoc->getErrors().size() == 1);
     
-    bool fastParseResult = preEditDoc->fastSpliceTextWithWorkLimit(TextCoordinate(7), 0, L"n", 1024);
+    bool fastParseResult = preEditDoc->fastSpliceTextWithWorkLimit(TextCoordinate(7), 0, u"n", 1024);
     REQUIRE(fastParseResult == false);
 }
     
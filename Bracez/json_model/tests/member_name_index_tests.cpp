@@ -0,0 +1,165 @@
+//
+//  member_name_index_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "catch2/catch.hpp"
+#include <string>
+#include <random>
+
+using namespace json;
+
+static std::string describeNode(const Node *aNode) {
+    return aNode ? std::to_string(aNode->getAbsTextRange().start.getAddress()) + " " : "null ";
+}
+
+// `..name` the way JsonPath finds it without an index
+static std::string describeWalked(JsonFile &aFile, const std::wstring &aName) {
+    std::string lRet;
+    std::vector<Node*> lQueue(1, aFile.getDom()->getChildAt(0));
+    for(size_t i=0; i<lQueue.size(); i++) {
+        if(ObjectNode *lObject = dynamic_cast<ObjectNode*>(lQueue[i])) {
+            int lIdx = lObject->getIndexOfMemberWithName(aName);
+            if(lIdx != -1) {
+                lRet += describeNode(lObject->getChildAt(lIdx));
+            }
+        }
+
+        if(ContainerNode *lContainer = dynamic_cast<ContainerNode*>(lQueue[i])) {
+            for(int lChild=0; lChild<lContainer->getChildCount(); lChild++) {
+                lQueue.push_back(lContainer->getChildAt(lChild));
+            }
+        }
+    }
+
+    return lRet;
+}
+
+static std::string describeQueried(JsonFile &aFile, const std::wstring &aPath) {
+    std::string lRet;
+    if(!aFile.getDom()->getChildAt(0)) {
+        return lRet;
+    }
+
+    for(Node *lNode: JsonPathExpression::compile(aPath).execute(aFile.getDom()->getChildAt(0)).nodeList) {
+        lRet += describeNode(lNode);
+    }
+
+    return lRet;
+}
+
+static bool indexMatchesDom(JsonFile &aFile, const std::wstring &aName) {
+    return describeQueried(aFile, L"$.." + aName) == describeWalked(aFile, aName);
+}
+
+TEST_CASE("Member name index") {
+    JsonFile file;
+    file.setMemberNameIndexEnabled(true);
+    file.setText(u"{\"id\": 1, \"a\": [{\"id\": 2, \"b\": {\"id\": 3}}, {\"x\": {\"id\": 4}, \"id\": 5}],\n"
+                 u" \"c\": {\"id\": 6, \"id\": 7}, \"d\": [[{\"k\": {\"id\": 8}}]]}");
+
+    const MemberNameIndex *index = file.getMemberNameIndex();
+    REQUIRE(index);
+
+    SECTION("Lookups") {
+        Node *root = file.getDom()->getChildAt(0);
+        auto objects = index->objectsWithMember(root, L"id");
+        REQUIRE(objects.second - objects.first == 7);
+        REQUIRE(index->objectsWithMember(root, L"missing").first == index->objectsWithMember(root, L"missing").second);
+
+        ContainerNode *a = (ContainerNode*)((ObjectNode*)root)->getChildAt(1);
+        objects = index->objectsWithMember(a, L"id");
+        REQUIRE(objects.second - objects.first == 4);
+        REQUIRE(*objects.first == a->getChildAt(0));
+
+        // Breadth first, duplicate keys resolve to the first member
+        REQUIRE(describeQueried(file, L"$..id") == describeWalked(file, L"id"));
+        REQUIRE(describeQueried(file, L"$..id") == "7 84 23 66 38 56 117 ");
+        REQUIRE(describeQueried(file, L"$.a..id") == "23 66 38 56 ");
+        REQUIRE(describeQueried(file, L"$..b[?(@ > 2)]") == "38 ");
+        REQUIRE(describeQueried(file, L"$..missing") == "");
+    }
+
+    SECTION("Disabled index") {
+        file.setMemberNameIndexEnabled(false);
+        REQUIRE(!file.getMemberNameIndex());
+        REQUIRE(describeQueried(file, L"$..id") == "7 84 23 66 38 56 117 ");
+    }
+
+    SECTION("DOM edits") {
+        ObjectNode *root = (ObjectNode*)file.getDom()->getChildAt(0);
+        root->renameMemberAt(0, L"k");
+        REQUIRE(indexMatchesDom(file, L"id"));
+        REQUIRE(indexMatchesDom(file, L"k"));
+
+        ObjectNode *inserted = new ObjectNode();
+        inserted->domAddMemberNode(L"id", new NumberNode(9));
+        ((ArrayNode*)root->getChildAt(1))->InsertMemberAt(1, inserted, NULL);
+        REQUIRE(indexMatchesDom(file, L"id"));
+
+        Node *removed;
+        ((ArrayNode*)root->getChildAt(1))->detachChildAt(0, &removed);
+        REQUIRE(indexMatchesDom(file, L"id"));
+
+        // Moved elsewhere, as JsonCocoaNode does
+        root->insertMemberAt(2, L"moved", removed, NULL);
+        REQUIRE(indexMatchesDom(file, L"id"));
+        REQUIRE(indexMatchesDom(file, L"moved"));
+
+        root->removeChildAt(3);
+        REQUIRE(indexMatchesDom(file, L"id"));
+
+        size_t numObjects = index->numObjects();
+        file.setMemberNameIndexEnabled(false);
+        file.setMemberNameIndexEnabled(true);
+        REQUIRE(file.getMemberNameIndex()->numObjects() == numObjects);
+    }
+
+    SECTION("Edits and reparses") {
+        const char16_t *pieces[] = { u"\"", u"\n", u"1", u"\"id\": ", u"{\"k\": {\"id\": 0}}", u"\"s\"", u"[{\"id\": [1]}]", u"", u"}" };
+        std::minstd_rand rnd(11);
+        for(int i=0; i<300; i++) {
+            TextLength lLen = file.getText().length();
+            TextCoordinate lStart(rnd() % (lLen+1));
+            TextLength lDelLen = rnd() % std::min<TextLength>(6, lLen - lStart.getAddress() + 1);
+            TextString lPiece = pieces[rnd() % 9];
+
+            std::shared_ptr<JsonFileSemanticModelReconciliationTask> task;
+            switch(rnd() % 3) {
+                case 0:
+                    if(!file.fastSpliceTextWithWorkLimit(lStart, lDelLen, lPiece, 1024)) {
+                        task = file.spliceTextWithDirtySemanticModel(lStart, lDelLen, lPiece);
+                    }
+                    break;
+
+                case 1: {
+                    TextCoordinate lSecond = lStart + lDelLen + rnd() % (lLen - lStart.getAddress() - lDelLen + 1);
+                    task = file.applyEdits({ Splice(lStart, lDelLen, lPiece), Splice(lSecond, 0, u"{\"id\": 3}") }, 1024);
+                    break;
+                }
+
+                case 2:
+                    if(rnd() % 8 == 0) {
+                        file.setText(file.getText());
+                    } else {
+                        task = file.setTextWithSpeculativeParse(file.getText(), rnd() % (lLen+1));
+                    }
+                    break;
+            }
+
+            if(task) {
+                task->executeInBackground();
+                file.applyReconciliationTask(task);
+            }
+
+            INFO(i);
+            REQUIRE(indexMatchesDom(file, L"id"));
+            REQUIRE(indexMatchesDom(file, L"k"));
+        }
+    }
+}
@@ -0,0 +1,175 @@
+//
+//  path_summary_tests.cpp
+//  BracezTests
+//
+//  Created by Eldan Ben Haim on 19/10/2026.
+//
+
+#include "json_file.h"
+#include "PathSummary.hpp"
+#include "JsonPathExpressionNode.hpp"
+#include "JsonPathExpressionCompiler.hpp"
+#include "catch2/catch.hpp"
+#include <string>
+#include <random>
+#include <codecvt>
+#include <locale>
+
+using namespace json;
+
+static void describeEntry(const PathSummaryEntry *aEntry, std::wstring &aOut) {
+    aOut += aEntry->getPathString() + L" " + std::to_wstring(aEntry->getCount()) + L" [";
+    for(int lType=ntNull; lType<=ntArray; lType++) {
+        aOut += std::to_wstring(aEntry->getTypeCount((NodeTypeId)lType)) + L" ";
+    }
+    aOut += L"]";
+    if(aEntry->getTypeCount(ntArray)) {
+        aOut += L" " + std::to_wstring(aEntry->getMinArrayLength()) + L".." + std::to_wstring(aEntry->getMaxArrayLength()) +
+                L"/" + std::to_wstring(aEntry->getTotalArrayLength());
+    }
+    aOut += L"\n";
+
+    for(const auto &lMember: aEntry->getMembers()) {
+        describeEntry(lMember.second.get(), aOut);
+    }
+    if(aEntry->getElements()) {
+        describeEntry(aEntry->getElements(), aOut);
+    }
+}
+
+static std::string describeSummary(const PathSummary &aSummary) {
+    std::wstring lRet;
+    describeEntry(aSummary.getRoot(), lRet);
+    return std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t>().to_bytes(lRet);
+}
+
+// Compares the file's summary with one built from scratch for its current DOM
+static bool summaryMatchesDom(JsonFile &aFile) {
+    std::string lIncremental = describeSummary(*aFile.getPathSummary());
+    aFile.setPathSummaryEnabled(false);
+    aFile.setPathSummaryEnabled(true);
+    return lIncremental == describeSummary(*aFile.getPathSummary());
+}
+
+static std::string describeQueried(JsonFile &aFile, const std::wstring &aPath) {
+    std::string lRet;
+    if(!aFile.getDom()->getChildAt(0)) {
+        return lRet;
+    }
+
+    for(Node *lNode: JsonPathExpression::compile(aPath).execute(aFile.getDom()->getChildAt(0)).nodeList) {
+        lRet += lNode ? std::to_string(lNode->getAbsTextRange().start.getAddress()) + " " : "null ";
+    }
+
+    return lRet;
+}
+
+TEST_CASE("Path summary") {
+    JsonFile file;
+    file.setPathSummaryEnabled(true);
+    file.setText(u"{\"store\": {\"book\": [{\"title\": \"a\", \"price\": 8.95}, {\"title\": \"b\", \"isbn\": \"x\", \"price\": null},\n"
+                 u" {\"title\": \"c\", \"tags\": [1, 2, 3]}], \"bicycle\": {\"color\": \"red\", \"tags\": []}}, \"my key\": [[true]]}");
+
+    const PathSummary *summary = file.getPathSummary();
+    REQUIRE(summary);
+
+    SECTION("Paths and statistics") {
+        REQUIRE(describeSummary(*summary) ==
+                "$ 1 [0 0 0 0 1 0 ]\n"
+                "$[\"my key\"] 1 [0 0 0 0 0 1 ] 1..1/1\n"
+                "$[\"my key\"][*] 1 [0 0 0 0 0 1 ] 1..1/1\n"
+                "$[\"my key\"][*][*] 1 [0 0 1 0 0 0 ]\n"
+                "$.store 1 [0 0 0 0 1 0 ]\n"
+                "$.store.bicycle 1 [0 0 0 0 1 0 ]\n"
+                "$.store.bicycle.color 1 [0 0 0 1 0 0 ]\n"
+                "$.store.bicycle.tags 1 [0 0 0 0 0 1 ] 0..0/0\n"
+                "$.store.book 1 [0 0 0 0 0 1 ] 3..3/3\n"
+                "$.store.book[*] 3 [0 0 0 0 3 0 ]\n"
+                "$.store.book[*].isbn 1 [0 0 0 1 0 0 ]\n"
+                "$.store.book[*].price 2 [1 1 0 0 0 0 ]\n"
+                "$.store.book[*].tags 1 [0 0 0 0 0 1 ] 3..3/3\n"
+                "$.store.book[*].tags[*] 3 [0 3 0 0 0 0 ]\n"
+                "$.store.book[*].title 3 [0 0 0 3 0 0 ]\n");
+
+        REQUIRE(summary->numNodes() == 22);
+
+        Node *book = ((ObjectNode*)((ObjectNode*)file.getDom()->getChildAt(0))->getChildAt(0))->getChildAt(0);
+        const PathSummaryEntry *bookEntry = summary->findEntry(book);
+        REQUIRE(bookEntry == summary->getRoot()->getMember(L"store")->getMember(L"book"));
+        REQUIRE(bookEntry->getMeanArrayLength() == 3);
+        REQUIRE(bookEntry->mayContainMember(L"isbn"));
+        REQUIRE(!bookEntry->mayContainMember(L"color"));
+        REQUIRE(summary->findEntry(((ArrayNode*)book)->getChildAt(1)) == bookEntry->getElements());
+    }
+
+    SECTION("Recursive descent skips subtrees without the name") {
+        REQUIRE(describeQueried(file, L"$..title") == "30 61 106 ");
+        REQUIRE(describeQueried(file, L"$..tags") == "168 119 ");
+        REQUIRE(describeQueried(file, L"$.store..color") == "153 ");
+        REQUIRE(describeQueried(file, L"$..missing") == "");
+    }
+
+    SECTION("DOM edits") {
+        ObjectNode *root = (ObjectNode*)file.getDom()->getChildAt(0);
+        ObjectNode *store = (ObjectNode*)root->getChildAt(0);
+        store->renameMemberAt(1, L"bike");
+        REQUIRE(summaryMatchesDom(file));
+
+        ArrayNode *books = (ArrayNode*)store->getChildAt(0);
+        books->InsertMemberAt(0, new StringNode(L"str"), NULL);
+        REQUIRE(summaryMatchesDom(file));
+
+        Node *removed;
+        books->detachChildAt(3, &removed);
+        REQUIRE(summaryMatchesDom(file));
+
+        root->insertMemberAt(0, L"moved", removed, NULL);
+        REQUIRE(summaryMatchesDom(file));
+
+        root->removeChildAt(1);
+        REQUIRE(summaryMatchesDom(file));
+    }
+
+    SECTION("Edits and reparses") {
+        const char16_t *pieces[] = { u"\"", u"\n", u"1", u"\"title\": ", u"{\"k\": [{\"title\": 0}]}", u"\"s\"", u"[[1], []]", u"", u"}" };
+        std::minstd_rand rnd(13);
+        for(int i=0; i<300; i++) {
+            TextLength lLen = file.getText().length();
+            TextCoordinate lStart(rnd() % (lLen+1));
+            TextLength lDelLen = rnd() % std::min<TextLength>(6, lLen - lStart.getAddress() + 1);
+            TextString lPiece = pieces[rnd() % 9];
+
+            std::shared_ptr<JsonFileSemanticModelReconciliationTask> task;
+            switch(rnd() % 3) {
+                case 0:
+                    if(!file.fastSpliceTextWithWorkLimit(lStart, lDelLen, lPiece, 1024)) {
+                        task = file.spliceTextWithDirtySemanticModel(lStart, lDelLen, lPiece);
+                    }
+                    break;
+
+                case 1: {
+                    TextCoordinate lSecond = lStart + lDelLen + rnd() % (lLen - lStart.getAddress() - lDelLen + 1);
+                    task = file.applyEdits({ Splice(lStart, lDelLen, lPiece), Splice(lSecond, 0, u"[{\"tags\": [2]}]") }, 1024);
+                    break;
+                }
+
+                case 2:
+                    task = file.setTextWithSpeculativeParse(file.getText(), rnd() % (lLen+1));
+                    break;
+            }
+
+            if(task) {
+                task->executeInBackground();
+                file.applyReconciliationTask(task);
+            }
+
+            INFO(i);
+            std::string titles = describeQueried(file, L"$..title");
+            REQUIRE(summaryMatchesDom(file));
+
+            file.setPathSummaryEnabled(false);
+            REQUIRE(titles == describeQueried(file, L"$..title"));
+            file.setPathSummaryEnabled(true);
+        }
+    }
+}
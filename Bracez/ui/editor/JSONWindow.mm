@@ -413,19 +413,20 @@ static void onJqCompileError(void *ctxt, jv err) {
     ProjectionDefinition *jqProj = [[ProjectionDefinition alloc] init];
     jqProj.rowSelector = self->jsonPathSearchController.searchPath;
     
-    NSArray<ProjectionFieldDefinition*> *fields = [jqProj suggestFieldsBasedOnDocument:self.document];
-    for(ProjectionFieldDefinition* def in [fields subarrayWithRange:NSMakeRange(0, std::min((unsigned long)5, fields.count))]) {
-        [jqProj addProjection:def];
-    }
-    
-    ProjectionDefinitionEditor *editor = [[ProjectionDefinitionEditor alloc]
-                                          initWithDefinition:jqProj
-                                          previewDocument:self.document];
-    [self beginSheet:editor.window completionHandler:^(NSModalResponse returnCode) {
-        if(returnCode == NSModalResponseOK) {
-            self->guiModeControl.showProjectionView = YES;
-            [self setProjectionDefinition:editor.editedProjection];
+    [jqProj suggestFieldsBasedOnDocument:self.document completion:^(NSArray<ProjectionFieldDefinition*> *fields) {
+        for(ProjectionFieldDefinition* def in [fields subarrayWithRange:NSMakeRange(0, std::min((unsigned long)5, fields.count))]) {
+            [jqProj addProjection:def];
         }
+        
+        ProjectionDefinitionEditor *editor = [[ProjectionDefinitionEditor alloc]
+                                              initWithDefinition:jqProj
+                                              previewDocument:self.document];
+        [self beginSheet:editor.window completionHandler:^(NSModalResponse returnCode) {
+            if(returnCode == NSModalResponseOK) {
+                self->guiModeControl.showProjectionView = YES;
+                [self setProjectionDefinition:editor.editedProjection];
+            }
+        }];
     }];
 }
 
@@ -483,28 +484,15 @@ static void onJqCompileError(void *ctxt, jv err) {
 }
 
 -(void)autoSuggestProjection {
-    // First try to use one of the favorite projections
-    Node *node = self.document.jsonFile->getDom()->getChildAt(0);
-    Node *cursorNode = selectionController.currentSelectedNode.proxiedElement;
-    size_t maxNumRows = 0;
-    ProjectionDefinition *selectedDef = nil;
-    for(ProjectionDefinition *def in projectionDefinitionsHistory.favoritesList) {
-        JsonPathResultNodeList ret = [def compiledRowSelector].execute(node, NULL, NULL, cursorNode).nodeList;
-        size_t retSize = ret.size();
-        if(retSize > maxNumRows) {
-            maxNumRows = retSize;
-            selectedDef = def;
+    // One of the favorite projections if it matches the doc, or else one that's come up with
+    [ProjectionDefinition suggestProjectionForDocument:self.document
+                                         fromFavorites:projectionDefinitionsHistory.favoritesList
+                                            cursorNode:selectionController.currentSelectedNode.proxiedElement
+                                            completion:^(ProjectionDefinition *selectedDef) {
+        if(selectedDef) {
+            self->projectionTableController.projectionDefinition = selectedDef;
         }
-    }
-    
-    // If no favorite projection matches the doc, try to come up with one on your own
-    if(!selectedDef) {
-        selectedDef = [[ProjectionDefinition suggestPojectionsForDocument:self.document] firstObject];
-    }
-    
-    if(selectedDef) {
-        projectionTableController.projectionDefinition = selectedDef;
-    }
+    }];
 }
 
 -(void)editProjection {
@@ -12,7 +12,18 @@
 #import "JsonDocument.h"
 #import "stopwatch.h"
 #import "HistoryAndFavoritesControl.h"
+#import "NSString+WStringUtils.h"
 #include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathCompileCache.hpp"
+#include "JsonPathResultCache.hpp"
+#include "JsonPathLiveQuery.hpp"
+#include "JsonPathResultIterator.hpp"
+#include "JsonPathStreamingEvaluator.hpp"
+
+#define SEARCH_RESULTS_PAGE_SIZE 200
+
+// Documents at least this long are searched in the background, over a snapshot of their text
+#define STREAMED_SEARCH_MIN_LENGTH (4 * 1024 * 1024)
 
 enum JsonReplaceMode {
     replaceAll,
@@ -21,12 +32,72 @@ enum JsonReplaceMode {
 
 @interface JsonPathSearchController () {
     NSString *_searchPath;
+    BOOL _continuousSearch;
+
+    // Continuous search keeps its query standing; the query holds on to the document it
+    // listens to so it's released before it
+    JsonDocument *_liveQueryDocument;
+    std::unique_ptr<JsonPathLiveQuery> _liveQuery;
+
+    // Results are wrapped in markers a page at a time, in document order, the next page once
+    // the selection gets to the last result shown. They're taken from the live query's results,
+    // the streamed results, or paged out of the DOM. Live results follow the edits on their own;
+    // the others are searched for again once the document was edited past the version they're
+    // of, and the user is told why the list changed.
+    unsigned long _searchResultsVersion;
+    size_t _numShownResults;
+    BOOL _refreshedAfterEdit;
+
+    // Searches over the DOM are paged by position: each page is evaluated for the results that
+    // follow the last one shown
+    BOOL _paging;
+    JsonPathExpression _pagedExpression;
+    JsonPathExpressionOptions _pagedOptions;
+    json::PinnedNodes _pagedCursorNode;
+    TextCoordinate _nextPageStart;
+
+    // Large documents are searched by streaming a snapshot of their text on a background
+    // queue; the ranges of the results are taken once they're all in. A search's results are
+    // dropped if another search was started since. Results that come in while the DOM is
+    // still being reconciled with the text are held till it is.
+    BOOL _streamedSearch;
+    std::vector<json::TextRange> _streamedResults;
+    size_t _numTakenStreamedResults;
+    unsigned long _streamedSearchGeneration;
+    std::shared_ptr<const JsonFileSnapshot> _pendingStreamedSnapshot;
+    std::shared_ptr<std::vector<json::TextRange>> _pendingStreamedResults;
 }
 
 @end
 
 @implementation JsonPathSearchController
 
+-(void)awakeFromNib {
+    [super awakeFromNib];
+
+    // Pages taken in are appended without moving the selection
+    JSONPathResultsController.selectsInsertedObjects = NO;
+    [JSONPathResultsController addObserver:self forKeyPath:@"selectionIndexes" options:0 context:NULL];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(semanticModelUpdated:)
+                                                 name:JsonDocumentSemanticModelUpdatedNotification
+                                               object:document];
+}
+
+-(void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [JSONPathResultsController removeObserver:self forKeyPath:@"selectionIndexes"];
+}
+
+-(void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
+    if([keyPath isEqualTo:@"selectionIndexes"]) {
+        NSUInteger selectionIndex = JSONPathResultsController.selectionIndexes.lastIndex;
+        if(selectionIndex != NSNotFound && selectionIndex + 1 >= [JSONPathResultsController.arrangedObjects count]) {
+            [self showMoreSearchResults];
+        }
+    }
+}
+
 -(void)loadDefaults {
     BracezPreferences *prefs = [BracezPreferences sharedPreferences];
     JSONPathInput.font = prefs.editorFont;
@@ -73,7 +144,8 @@ enum JsonReplaceMode {
         if(!expression.length) {
             throw std::runtime_error("empty expression");
         }
-        return JsonPathExpression::compile(expression.UTF8String, expType);
+        // Every keystroke compiles the expression; invalid partial input fails from the cache
+        return JsonPathCompileCache::shared().compile(expression.cStringWstring, expType);
     } catch(const parse_error &e) {
         [self showErrorResult:[NSString stringWithFormat:@"Invalid JSON path syntax: %s; expected: %s",
                                e._what.c_str(), e._expecting.c_str()]
@@ -90,40 +162,294 @@ enum JsonReplaceMode {
     }
 }
 
--(JsonPathResultNodeList)refreshSearchResults {
+-(void)startLiveQuery:(const JsonPathExpression&)searchExpr
+           withOptions:(const JsonPathExpressionOptions&)opts
+            cursorNode:(Node*)cursorNode {
+    [self stopLiveQuery];
+
+    _liveQueryDocument = document;
+    _liveQuery.reset(new JsonPathLiveQuery(document.jsonFile, searchExpr, opts, cursorNode));
+
+    // Deltas are delivered while the document is still applying the change; the result list
+    // is updated once it's done
+    __weak JsonPathSearchController *weakSelf = self;
+    _liveQuery->setDeltaListener([weakSelf](const JsonPathLiveQuery::Delta &delta) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakSelf liveQueryResultsChanged];
+        });
+    });
+}
+
+-(void)stopLiveQuery {
+    _liveQuery.reset();
+    _liveQueryDocument = nil;
+}
+
+-(void)liveQueryResultsChanged {
+    if(_liveQuery) {
+        _searchResultsVersion = document.jsonFile->getVersion();
+        [self showSearchResultCount:_liveQuery->size()];
+        [self showSearchResults:_numShownResults];
+    }
+}
+
+-(void)startStreamedSearch:(const JsonPathExpression&)searchExpr
+               withOptions:(const JsonPathExpressionOptions&)opts {
+    std::shared_ptr<const JsonFileSnapshot> snapshot = document.jsonFile->getSnapshot();
+    unsigned long generation = ++_streamedSearchGeneration;
+    _streamedSearch = YES;
+    _searchResultsVersion = snapshot->getVersion();
+
+    JSONPathQueryStatus.textColor = [NSColor secondaryLabelColor];
+    JSONPathQueryStatus.font = [NSFont systemFontOfSize:[NSFont smallSystemFontSize]];
+    JSONPathQueryStatus.stringValue = @"Searching...";
+
+    // The block keeps its own copies of these
+    JsonPathExpression expr = searchExpr;
+    JsonPathExpressionOptions options = opts;
+    __weak JsonPathSearchController *weakSelf = self;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        auto results = std::make_shared<std::vector<json::TextRange>>();
+        std::string error;
+        try {
+            JsonPathStreamingEvaluator evaluator(expr, options);
+            const TextString &text = snapshot->getText();
+            evaluator.evaluate(text.data(), text.length(), [&results](Node *match) {
+                results->push_back(match->getAbsTextRange());
+            });
+        } catch(const std::exception &e) {
+            error = e.what();
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakSelf streamedSearch:generation ofSnapshot:snapshot finishedWithResults:results error:error];
+        });
+    });
+}
+
+-(void)streamedSearch:(unsigned long)generation
+           ofSnapshot:(std::shared_ptr<const JsonFileSnapshot>)snapshot
+  finishedWithResults:(std::shared_ptr<std::vector<json::TextRange>>)results
+                error:(const std::string&)error {
+    if(!_streamedSearch || generation != _streamedSearchGeneration) {
+        return;
+    }
+
+    if(!error.empty()) {
+        JSONPathQueryStatus.textColor = [NSColor redColor];
+        JSONPathQueryStatus.stringValue = [NSString stringWithUTF8String:error.c_str()];
+        return;
+    }
+
+    // Results are mapped to the nodes at their ranges, so the DOM must be that of the text
+    // searched. Text that was edited since is searched again; a DOM that's only behind the
+    // text is waited for.
+    if(!document.jsonFile->getSnapshot()->hasSameText(*snapshot)) {
+        [self refreshStaleSearchResults];
+        return;
+    }
+    if([document isSemanticModelDirty]) {
+        _pendingStreamedSnapshot = snapshot;
+        _pendingStreamedResults = results;
+        return;
+    }
+
+    [self showStreamedResults:results];
+}
+
+-(void)semanticModelUpdated:(NSNotification*)notification {
+    if(!_pendingStreamedResults || [document isSemanticModelDirty]) {
+        return;
+    }
+
+    std::shared_ptr<const JsonFileSnapshot> snapshot = std::move(_pendingStreamedSnapshot);
+    std::shared_ptr<std::vector<json::TextRange>> results = std::move(_pendingStreamedResults);
+    _pendingStreamedSnapshot.reset();
+    _pendingStreamedResults.reset();
+
+    if(!document.jsonFile->getSnapshot()->hasSameText(*snapshot)) {
+        [self refreshStaleSearchResults];
+        return;
+    }
+
+    [self showStreamedResults:results];
+}
+
+-(void)showStreamedResults:(std::shared_ptr<std::vector<json::TextRange>>)results {
+    std::sort(results->begin(), results->end(), [](const json::TextRange &l, const json::TextRange &r) {
+        return l.start < r.start;
+    });
+    _streamedResults = std::move(*results);
+    _numTakenStreamedResults = 0;
+    _searchResultsVersion = document.jsonFile->getVersion();
+
+    [self showSearchResultCount:_streamedResults.size()];
+    [self showSearchResults:0];
+}
+
+-(void)stopStreamedSearch {
+    _streamedSearch = NO;
+    _streamedResults.clear();
+    _numTakenStreamedResults = 0;
+    _pendingStreamedSnapshot.reset();
+    _pendingStreamedResults.reset();
+}
+
+-(void)showSearchResultCount:(size_t)numResults {
+    JSONPathQueryStatus.textColor = [NSColor labelColor];
+    JSONPathQueryStatus.font = [NSFont systemFontOfSize:[NSFont smallSystemFontSize]];
+    JSONPathQueryStatus.stringValue = _refreshedAfterEdit ?
+        [NSString stringWithFormat:@"%ld results (searched again, the document was edited)", numResults] :
+        [NSString stringWithFormat:@"%ld results", numResults];
+}
+
+// Markers for up to limit of the results not shown yet, in document order
+-(NSArray*)takeSearchResultMarkers:(size_t)limit {
+    JsonPathResultNodeList page;
+    if(_searchResultsVersion != document.jsonFile->getVersion()) {
+        // Nothing to take until the results are refreshed
+    } else if(_liveQuery) {
+        // The query keeps its results current, so they're taken from it as they're shown
+        _liveQuery->getResults(_numShownResults, limit, page);
+    } else if(_paging && (_pagedCursorNode.empty() || _pagedCursorNode.get())) {
+        try {
+            JsonPathResultIterator(_pagedExpression, document.rootNode.proxiedElement, &_pagedOptions, NULL, _pagedCursorNode.get())
+                .takeAtOrAfter(_nextPageStart, limit, page);
+        } catch(const std::exception &e) {
+            _paging = NO;
+        }
+        if(!page.empty()) {
+            _nextPageStart = page.back()->getAbsTextRange().start + 1;
+        }
+    } else if(_streamedSearch) {
+        JsonFile *file = document.jsonFile;
+        for(; page.size() < limit && _numTakenStreamedResults < _streamedResults.size(); _numTakenStreamedResults++) {
+            const json::TextRange &range = _streamedResults[_numTakenStreamedResults];
+            JsonPath path;
+            Node *node = file->findPathContaining(range.start, path) ? file->findNodeAtPath(path) : NULL;
+            if(node && node->getAbsTextRange() == range) {
+                page.push_back(node);
+            }
+        }
+    }
+    _numShownResults += page.size();
+
+    NSMutableArray *nodesArray = [NSMutableArray arrayWithCapacity:page.size()];
+    for(json::Node *node: page) {
+        if(!node->isLive()) {
+            continue;
+        }
+
+        JsonCocoaNode *nodeForResult = [JsonCocoaNode nodeForElement:node withName:@"Name"];
+        JsonMarker *markerForResult = [JsonMarker markerForNode:nodeForResult withParentDoc:document];
+        [nodesArray addObject:markerForResult];
+    }
+
+    return nodesArray;
+}
+
+// Replaces the results shown with the first numResults, at least a page
+-(void)showSearchResults:(size_t)numResults {
+    _numShownResults = 0;
+    _numTakenStreamedResults = 0;
+    _nextPageStart = TextCoordinate(0);
+    [JSONPathResultsController setContent:[self takeSearchResultMarkers:std::max(numResults, (size_t)SEARCH_RESULTS_PAGE_SIZE)]];
+}
+
+-(void)showMoreSearchResults {
+    if(_pendingStreamedResults) {
+        return;
+    }
+    if(!_liveQuery && _searchResultsVersion != document.jsonFile->getVersion()) {
+        [self refreshStaleSearchResults];
+        return;
+    }
+
+    NSArray *markers = [self takeSearchResultMarkers:SEARCH_RESULTS_PAGE_SIZE];
+    if(markers.count) {
+        [JSONPathResultsController addObjects:markers];
+    }
+}
+
+-(JsonPathExpressionOptions)searchOptions {
+    JsonPathExpressionOptions opts;
+    opts.fuzzy = self.fuzzySearch;
+    opts.parallel = true;
+    return opts;
+}
+
+-(void)refreshSearchResults {
     // TODO refresh on cursor change
-    JsonPathResultNodeList searchResultList;
-    
+    [self stopLiveQuery];
+    [self stopStreamedSearch];
+    _paging = NO;
+    _pagedCursorNode.clear();
     JsonPathExpression searchExpr =
         [self compileExpressionInEditor:JSONPathInput
                                  ofType:CompiledExpressionType::jsonPath];
     
-    JsonPathExpressionOptions opts;
-    opts.fuzzy = self.fuzzySearch;
+    JsonPathExpressionOptions opts = [self searchOptions];
+    
+    // Documents that get searched keep a member name index from then on, so `..name` doesn't
+    // walk the whole DOM on every keystroke
+    document.jsonFile->setMemberNameIndexEnabled(true);
     
+    // Continuous search keeps the results current as the document changes, evaluating only
+    // the parts of the document the edits touch. Otherwise the results are counted without
+    // being kept, and pulled a page at a time as they're shown
     Node *cursorNode = selectionController.currentSelectedNode.proxiedElement;
-    searchResultList = searchExpr.execute(document.rootNode.proxiedElement,
-                                          &opts, NULL, cursorNode).nodeList;
+    size_t numResults;
+    if(self.continuousSearch) {
+        [self startLiveQuery:searchExpr withOptions:opts cursorNode:cursorNode];
+        numResults = _liveQuery->size();
+    } else if(document.jsonFile->getText().length() >= STREAMED_SEARCH_MIN_LENGTH &&
+              JsonPathStreamingEvaluator::canStream(searchExpr)) {
+        [JSONPathResultsController setContent:@[]];
+        [self startStreamedSearch:searchExpr withOptions:opts];
+        return;
+    } else {
+        Node *root = document.rootNode.proxiedElement;
+        numResults = JsonPathResultIterator(searchExpr, root, &opts, NULL, cursorNode).count();
+        _paging = YES;
+        _pagedExpression = searchExpr;
+        _pagedOptions = opts;
+        _pagedCursorNode.assign(cursorNode);
+    }
+    _searchResultsVersion = document.jsonFile->getVersion();
 
-    JSONPathQueryStatus.textColor = [NSColor labelColor];
-    JSONPathQueryStatus.font = [NSFont systemFontOfSize:[NSFont smallSystemFontSize]];
-    JSONPathQueryStatus.stringValue = [NSString stringWithFormat:@"%ld results", searchResultList.size()];
-        
-    searchResultList.sort([](Node *l, Node *r) { return l->getAbsTextRange().start < r->getAbsTextRange().start; });
-    
-    NSMutableArray *nodesArray = [NSMutableArray arrayWithCapacity:searchResultList.size()];
-    std::for_each(searchResultList.begin(), searchResultList.end(),
-                  [nodesArray, self](json::Node* node) {
-        JsonCocoaNode *nodeForResult = [JsonCocoaNode nodeForElement:node withName:@"Name"];
-        JsonMarker *markerForResult = [JsonMarker markerForNode:nodeForResult withParentDoc:document];
-        [nodesArray addObject:markerForResult];
+    [self showSearchResultCount:numResults];
+    [self showSearchResults:0];
+}
+
+// All results of the search expression, in document order
+-(JsonPathResultNodeList)allSearchResults {
+    JsonPathExpression searchExpr =
+        [self compileExpressionInEditor:JSONPathInput
+                                 ofType:CompiledExpressionType::jsonPath];
+    JsonPathExpressionOptions opts = [self searchOptions];
+    Node *cursorNode = selectionController.currentSelectedNode.proxiedElement;
+
+    // Results are reused as long as the edits don't touch the part of the document the query reads
+    JsonPathResultNodeList searchResultList = document.jsonPathResultCache->execute(searchExpr, &opts, cursorNode).nodeList;
+    std::sort(searchResultList.begin(), searchResultList.end(), [](Node *l, Node *r) {
+        return l->getAbsTextRange().start < r->getAbsTextRange().start;
     });
-    
-    [JSONPathResultsController setContent:nodesArray];
-    
+
     return searchResultList;
 }
 
+// The first result starting at or after position; only as much of the document as it takes
+// to find it is evaluated
+-(Node*)searchResultAtOrAfter:(TextCoordinate)position {
+    JsonPathExpression searchExpr =
+        [self compileExpressionInEditor:JSONPathInput
+                                 ofType:CompiledExpressionType::jsonPath];
+    JsonPathExpressionOptions opts = [self searchOptions];
+    Node *cursorNode = selectionController.currentSelectedNode.proxiedElement;
+
+    return JsonPathResultIterator(searchExpr, document.rootNode.proxiedElement, &opts, NULL, cursorNode).firstAtOrAfter(position);
+}
+
 - (IBAction)executeJsonPath:(id)sender {
     if(!_searchPath.length) {
         return;
@@ -131,6 +457,17 @@ enum JsonReplaceMode {
     
     [JSONPathHistoryFavorites accumulateHistory];
     
+    _refreshedAfterEdit = NO;
+    try {
+        [self refreshSearchResults];
+    } catch(...) {
+        // refreshSearchResults already updated the error
+    }
+}
+
+// Results of a version the document was since edited past are searched for again
+-(void)refreshStaleSearchResults {
+    _refreshedAfterEdit = YES;
     try {
         [self refreshSearchResults];
     } catch(...) {
@@ -138,6 +475,17 @@ enum JsonReplaceMode {
     }
 }
 
+-(BOOL)continuousSearch {
+    return _continuousSearch;
+}
+
+-(void)setContinuousSearch:(BOOL)continuousSearch {
+    _continuousSearch = continuousSearch;
+    if(!continuousSearch) {
+        [self stopLiveQuery];
+    }
+}
+
 -(void)setSearchPath:(NSString*)searchPath {
     [self willChangeValueForKey:@"searchPath"];
     _searchPath = searchPath;
@@ -159,13 +507,15 @@ enum JsonReplaceMode {
 
 -(Node *)performReplacementWithMode:(JsonReplaceMode)replaceMode {
     
-    // Refresh and get current search results and replace expression
+    // Refresh search results (replacing one only looks for the node to replace, below)
+    // and get the replace expression.
     // If failed to reresh search result list no point in moving forward.
     // If failed to compile replacement expression -- no point in moving forward
-    JsonPathResultNodeList searchResultList;
     JsonPathExpression repExpr;
     try {
-        searchResultList = [self refreshSearchResults];
+        if(replaceMode == JsonReplaceMode::replaceAll) {
+            [self refreshSearchResults];
+        }
         repExpr =
             [self compileExpressionInEditor:replaceJSONPathExpressionInput
                                      ofType:CompiledExpressionType::jsonPathExpression];
@@ -178,6 +528,51 @@ enum JsonReplaceMode {
     TextCoordinate currentCoordinate((unsigned long) cocoaCurrentTextSelection.location);
     json::TextRange currentSelectedRange(currentCoordinate, currentCoordinate+cocoaCurrentTextSelection.length);
 
+    // Replacing one only looks for the first node to replace, and the one after it
+    if(replaceMode == JsonReplaceMode::replaceNext) {
+        Node *replacedNode = NULL;
+        Node *nextNode = NULL;
+        try {
+            replacedNode = [self searchResultAtOrAfter:currentCoordinate];
+            if(!replacedNode) {
+                return NULL;
+            }
+
+            // We need to make sure that the replaced node is selected
+            json::TextRange rangeToReplace = replacedNode->getAbsTextRange();
+            if(rangeToReplace != currentSelectedRange) {
+                [selectionController selectTextRange:NSMakeRange(rangeToReplace.start.getAddress(),
+                                                                 rangeToReplace.length())];
+                return NULL;
+            }
+
+            nextNode = [self searchResultAtOrAfter:rangeToReplace.end];
+        } catch(...) {
+            return NULL;
+        }
+
+        document.jsonFile->beginDeferNotifications();
+        Node *replacementResultNode = [self performReplacementForNode:replacedNode
+                                                       withExpression:repExpr];
+        document.jsonFile->endDeferNotifications();
+
+        if(nextNode) {
+            json::TextRange nextNodeRange = nextNode->getAbsTextRange();
+            NSRange cocoaRange = NSMakeRange(nextNodeRange.start.getAddress(),
+                                             nextNodeRange.length());
+            [selectionController selectTextRange:cocoaRange];
+        }
+
+        return replacementResultNode;
+    }
+
+    JsonPathResultNodeList searchResultList;
+    try {
+        searchResultList = [self allSearchResults];
+    } catch(...) {
+        return NULL;
+    }
+
     // First node to replace
     auto replaceNodeIter = find_if(searchResultList.begin(),
                                searchResultList.end(),
@@ -189,54 +584,36 @@ enum JsonReplaceMode {
         return NULL;
     }
 
-    // If replacing one --- we need to make sure that the
-    // replaced node is selected.
-    if(replaceMode == JsonReplaceMode::replaceNext) {
-        json::TextRange rangeToReplace = (*replaceNodeIter)->getAbsTextRange();
-        if(rangeToReplace != currentSelectedRange) {
-            [selectionController selectTextRange:NSMakeRange(rangeToReplace.start.getAddress(),
-                                                             rangeToReplace.length())];
-            return NULL;
-        }
-    }
-    
     // If replacing all, we need to clean nodes that
     // are contained within nodes previously listed;
     // otherwise, when we run the replace on the parent node,
     // we will hold a dangling references to the children (since they're
     // no deleted).
-    if(replaceMode == JsonReplaceMode::replaceAll) {
-        [self removeSuccessiveContainedNodesFromList:searchResultList startingFrom:replaceNodeIter];
-    }
+    [self removeSuccessiveContainedNodesFromList:searchResultList startingFrom:replaceNodeIter];
     
-    document.jsonFile->beginDeferNotifications();
-    Node *replacementResultNode = NULL;
-    do {
-        replacementResultNode = [self performReplacementForNode:*replaceNodeIter
-                                                 withExpression:repExpr];
-        replaceNodeIter++;
-    } while(replaceNodeIter != searchResultList.end() &&
-            replaceMode == JsonReplaceMode::replaceAll);
-    document.jsonFile->endDeferNotifications();
-            
-    if(replaceMode == JsonReplaceMode::replaceNext) {
-        if(replaceNodeIter != searchResultList.end()) {
-            json::TextRange nextNodeRange = (*replaceNodeIter)->getAbsTextRange();
-            NSRange cocoaRange = NSMakeRange(nextNodeRange.start.getAddress(),
-                                             nextNodeRange.length());
-            [selectionController selectTextRange:cocoaRange];
-        }
+    // Replacing all is done as a single batch of text edits: one pass over the text,
+    // one reparse and one change notification
+    std::vector<json::Splice> edits;
+    for(; replaceNodeIter != searchResultList.end(); replaceNodeIter++) {
+        std::unique_ptr<Node> replacementNode([self evaluateReplacementForNode:*replaceNodeIter
+                                                                 withExpression:repExpr]);
+        std::wstring replacementText;
+        replacementNode->calculateJsonTextRepresentation(replacementText);
+        
+        json::TextRange replacedRange = (*replaceNodeIter)->getAbsTextRange();
+        edits.push_back(json::Splice(replacedRange.start, replacedRange.length(),
+                                     textStringFromWstring(replacementText)));
     }
     
-    return replacementResultNode;
+    std::sort(edits.begin(), edits.end(), [](const json::Splice &aLeft, const json::Splice &aRight) {
+        return aLeft.start < aRight.start;
+    });
+    [document applyEdits:edits];
+    return NULL;
 }
 
 
--(Node*)performReplacementForNode:(Node*)replacedNode withExpression:(JsonPathExpression&)repExpr {
-    Node* replacementResultNode;
-    
-    int replacementIndex = replacedNode->getParent()->getIndexOfChild(replacedNode);
-    
+-(Node*)evaluateReplacementForNode:(Node*)replacedNode withExpression:(JsonPathExpression&)repExpr {
     JsonPathExpressionOptions opts;
     
     JsonPathExpressionNodeEvalResult replacementResult;
@@ -244,11 +621,16 @@ enum JsonReplaceMode {
     JsonPathResultNodeList &replacementResultNl = replacementResult.nodeList;
 
     if(replacementResultNl.size()) {
-        replacementResultNode = replacementResultNl.front()->clone();
+        return replacementResultNl.front()->clone();
     } else {
-        replacementResultNode = new NullNode();
+        return new NullNode();
     }
+}
+
+-(Node*)performReplacementForNode:(Node*)replacedNode withExpression:(JsonPathExpression&)repExpr {
+    int replacementIndex = replacedNode->getParent()->getIndexOfChild(replacedNode);
     
+    Node* replacementResultNode = [self evaluateReplacementForNode:replacedNode withExpression:repExpr];
     replacedNode->getParent()->setChildAt(replacementIndex, replacementResultNode);
     
     return replacementResultNode;
@@ -256,20 +638,23 @@ enum JsonReplaceMode {
 
 -(void)removeSuccessiveContainedNodesFromList:(JsonPathResultNodeList&)list
                                  startingFrom:(JsonPathResultNodeList::iterator)startIter {
-    auto nodeFilterIter = startIter;
-    while(nodeFilterIter != list.end()) {
-        json::TextRange curNodeRange = (*nodeFilterIter)->getAbsTextRange();
-        
-        auto nextFilterIter = nodeFilterIter; nextFilterIter++;
-        
-        while(nextFilterIter != list.end() &&
-              (*nextFilterIter)->getAbsTextRange().start < curNodeRange.end) {
-            list.erase(nextFilterIter);
-            nextFilterIter = nodeFilterIter; nextFilterIter++;
+    if(startIter == list.end()) {
+        return;
+    }
+    
+    // Compact the list in place; nothing up to startIter moves, so startIter stays valid
+    auto keptIter = startIter;
+    json::TextRange curNodeRange = (*keptIter)->getAbsTextRange();
+    for(auto nodeFilterIter = startIter + 1; nodeFilterIter != list.end(); nodeFilterIter++) {
+        if((*nodeFilterIter)->getAbsTextRange().start < curNodeRange.end) {
+            continue;
         }
-
-        nodeFilterIter++;
+        
+        *(++keptIter) = *nodeFilterIter;
+        curNodeRange = (*keptIter)->getAbsTextRange();
     }
+    
+    list.erase(keptIter + 1, list.end());
 }
 
 -(NSString*)searchPath {
@@ -53,7 +53,14 @@ NSString * const JsonNodePboardType=@"JsonNode";
     if(lNode && *lNode && lParentNode && *lParentNode)
     {
         [*lNode moveToNode:[item representedObject] atIndex:(int)index fromParent:*lParentNode];
-        json::TextRange updatedTextRange = (*lNode).proxiedElement->getAbsTextRange();
+        
+        // Nodes replaced since the drag started aren't moved
+        json::Node *lMovedElement = (*lNode).proxiedElement;
+        if(!lMovedElement) {
+            return NO;
+        }
+        
+        json::TextRange updatedTextRange = lMovedElement->getAbsTextRange();
         [window.document reindentStartingAt:updatedTextRange.start
                                        len:updatedTextRange.length()
                      suggestNewEndLocation:nil];
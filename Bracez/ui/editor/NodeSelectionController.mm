@@ -10,6 +10,7 @@
 #import "JsonCocoaNode.h"
 #import "NSIndexPathAdditions.h"
 #import "JsonMarker.h"
+#import "NSString+WStringUtils.h"
 
 #include <codecvt>
 #include <locale>
@@ -332,10 +333,14 @@
     JsonCocoaNode *lLastNode = nil;
     [self _nodeNamesForIndexPath:lQueryPath lastNodeInto:&lLastNode];
     if(lLastNode) {
-        int lChildCount = [lLastNode countOfChildren];
+        // Child names straight from the DOM, without proxies for all the children
+        const json::ContainerNode *lContainer = dynamic_cast<const json::ContainerNode*>(lLastNode.proxiedElement);
+        const json::ObjectNode *lObject = dynamic_cast<const json::ObjectNode*>(lContainer);
+        int lChildCount = lContainer ? lContainer->getChildCount() : 0;
         NSMutableArray *lRet = [NSMutableArray arrayWithCapacity:lChildCount];
         for(int idx=0; idx<lChildCount; idx++) {
-            NSString *proposal = [[lLastNode objectInChildrenAtIndex:idx] nodeName];
+            NSString *proposal = lObject ? [NSString stringWithWstring:lObject->getMemberNameAt(idx)] :
+                                           [NSString stringWithFormat:@"%d", idx];
             if(![lastPathComponent length] ||
                [proposal hasPrefix:lastPathComponent]) {
                 [lRet addObject:proposal];
@@ -747,7 +752,7 @@ static void adjustNavEntries(vector<TextCoordinate> &aNavEntries, TextCoordinate
     adjustNavEntries(forwardNavs, aOldOffset, aOldLength, aNewLength);
 }
 
--(void)notifyErrorsChanged:(json::JsonFile*)aSender
+-(void)notifyErrorsChanged:(json::JsonFile*)aSender delta:(const MarkerListDelta&)aDelta
 {
 }
 
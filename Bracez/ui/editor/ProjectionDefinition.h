@@ -34,12 +34,17 @@ typedef NS_ENUM(NSInteger, ProjectionFieldFormatterType) {
 @interface ProjectionDefinition : NSObject <NSCopying, NSSecureCoding>
 
 +(instancetype)newDefinition;
-+(NSArray<ProjectionDefinition*> *)suggestPojectionsForDocument:(JsonDocument*)document;
+// Suggestions are worked out in the background; completion is called on the main queue
++(void)suggestProjectionForDocument:(JsonDocument*)document
+                      fromFavorites:(NSArray<ProjectionDefinition*>*)favorites
+                         cursorNode:(json::Node * _Nullable)cursorNode
+                         completion:(void (^)(ProjectionDefinition * _Nullable suggestion))completion;
     
 -(void)addProjection:(ProjectionFieldDefinition*)definition;
 -(void)removeProjectionAtIndex:(NSUInteger)index;
 -(void)insertProjection:(ProjectionFieldDefinition*)definition atIndex:(NSUInteger)index;
--(NSArray<ProjectionFieldDefinition*> *)suggestFieldsBasedOnDocument:(JsonDocument*)document;
+-(void)suggestFieldsBasedOnDocument:(JsonDocument*)document
+                         completion:(void (^)(NSArray<ProjectionFieldDefinition*> *suggestions))completion;
 
 -(JsonPathExpression)compiledRowSelector;
 
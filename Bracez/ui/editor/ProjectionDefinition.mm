@@ -7,6 +7,8 @@
 
 #import "ProjectionDefinition.h"
 #include "JsonPathExpressionCompiler.hpp"
+#include "JsonPathCompileCache.hpp"
+#include "PathSummary.hpp"
 
 #import "NSString+WStringUtils.h"
 #import "JsonDocument.h"
@@ -17,7 +19,7 @@
 #include <iomanip>
 
 std::vector<std::wstring> suggestFields(const JsonPathResultNodeList &nodeList);
-std::vector<pair<std::wstring, size_t>> suggestRowSelectors(Node *parent, const std::wstring &basePath);
+std::vector<pair<std::wstring, size_t>> suggestRowSelectors(const json::PathSummary &summary);
 
 @implementation ProjectionFieldDefinition
 
@@ -74,6 +76,20 @@ std::vector<pair<std::wstring, size_t>> suggestRowSelectors(Node *parent, const
 @end
 
 
+// Suggested fields, with titles from the last step of their expressions
+static NSArray<ProjectionFieldDefinition*> *fieldDefinitionsForSuggestions(const std::vector<std::wstring> &suggestions) {
+    NSMutableArray<ProjectionFieldDefinition*> *ret = [NSMutableArray arrayWithCapacity:suggestions.size()];
+    for(auto it = suggestions.begin(); it != suggestions.end(); it++) {
+        ProjectionFieldDefinition *fieldDef = [[ProjectionFieldDefinition alloc] init];
+        fieldDef.expression = [NSString stringWithWstring:*it];
+        fieldDef.fieldTitle = [[fieldDef.expression componentsSeparatedByString:@"."] lastObject];
+        
+        [ret addObject:fieldDef];
+    }
+    
+    return ret;
+}
+
 @interface ProjectionDefinition () {
     NSMutableArray *_fieldDefinitions;
 }
@@ -116,58 +132,116 @@ std::vector<pair<std::wstring, size_t>> suggestRowSelectors(Node *parent, const
     [_fieldDefinitions removeObjectAtIndex:index];
 }
 
-+(NSArray<ProjectionDefinition*> *)suggestPojectionsForDocument:(JsonDocument*)document {
-    std::vector<pair<std::wstring, size_t>> rowSelectors =
-        suggestRowSelectors(document.jsonFile->getDom()->getChildAt(0), L"$");
-
-    if(rowSelectors.size()) {
-        NSMutableArray<ProjectionDefinition*> *defs = [NSMutableArray arrayWithCapacity:rowSelectors.size()];
-        for(auto iter = rowSelectors.begin(); iter != rowSelectors.end(); iter++) {
-            
-            ProjectionDefinition *suggestedDef = [[ProjectionDefinition alloc] init];
-            suggestedDef.rowSelector = [NSString stringWithWstring:iter->first];
-            
-            NSArray<ProjectionFieldDefinition*> *suggestedFields = [suggestedDef suggestFieldsBasedOnDocument:document];
-            for(ProjectionFieldDefinition *def in suggestedFields) {
-                [suggestedDef addProjection:def];
-                if(suggestedDef.fieldDefinitions.count >= 5) {
-                    break;
+// Suggestions are worked out on a DOM parsed from a snapshot of the document, in the
+// background, so they don't hold up editing. They're only text, so they're good even if the
+// document was edited by the time they're in.
++(void)suggestProjectionForDocument:(JsonDocument*)document
+                      fromFavorites:(NSArray<ProjectionDefinition*>*)favorites
+                         cursorNode:(json::Node*)cursorNode
+                         completion:(void (^)(ProjectionDefinition * _Nullable))completion {
+    NSMutableArray<ProjectionDefinition*> *candidates = [NSMutableArray arrayWithCapacity:favorites.count];
+    std::vector<JsonPathExpression> candidateRowSelectors;
+    for(ProjectionDefinition *def in favorites) {
+        try {
+            candidateRowSelectors.push_back([def compiledRowSelector]);
+            [candidates addObject:def];
+        } catch(const std::exception &e) {
+        }
+    }
+    
+    // The cursor is found in the parsed DOM by its range
+    bool hasCursor = cursorNode && cursorNode->isLive();
+    json::TextRange cursorRange = hasCursor ? cursorNode->getAbsTextRange() : json::TextRange();
+    
+    std::shared_ptr<const JsonFileSnapshot> snapshot = document.jsonFile->getSnapshot();
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        std::unique_ptr<json::DocumentNode> dom = snapshot->parse();
+        json::Node *root = dom->getChildAt(0);
+        json::Node *cursor = hasCursor ? dom->findNodeWithRange(cursorRange) : NULL;
+        
+        // First try to use the favorite projection with the most rows in the document
+        NSInteger selectedFavorite = -1;
+        size_t maxNumRows = 0;
+        for(size_t idx = 0; idx < candidateRowSelectors.size(); idx++) {
+            try {
+                size_t numRows = candidateRowSelectors[idx].execute(root, NULL, NULL, cursor).nodeList.size();
+                if(numRows > maxNumRows) {
+                    maxNumRows = numRows;
+                    selectedFavorite = idx;
                 }
+            } catch(const std::exception &e) {
             }
-                        
-            [defs addObject:suggestedDef];
         }
         
-        return defs;
-    } else {
-        return nil;
-    }
+        // If no favorite projection matches the doc, come up with one from the paths in it
+        std::wstring rowSelector;
+        std::vector<std::wstring> fields;
+        if(selectedFavorite < 0) {
+            json::PathSummary summary;
+            summary.refreshSubtree(dom.get());
+            std::vector<pair<std::wstring, size_t>> rowSelectors = suggestRowSelectors(summary);
+            if(rowSelectors.size()) {
+                rowSelector = rowSelectors.front().first;
+                try {
+                    fields = suggestFields(JsonPathCompileCache::shared().compile(rowSelector).execute(root).nodeList);
+                } catch(const std::exception &e) {
+                }
+            }
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if(selectedFavorite >= 0) {
+                completion(candidates[selectedFavorite]);
+            } else if(rowSelector.length()) {
+                ProjectionDefinition *suggestedDef = [[ProjectionDefinition alloc] init];
+                suggestedDef.rowSelector = [NSString stringWithWstring:rowSelector];
+                for(ProjectionFieldDefinition *def in fieldDefinitionsForSuggestions(fields)) {
+                    [suggestedDef addProjection:def];
+                    if(suggestedDef.fieldDefinitions.count >= 5) {
+                        break;
+                    }
+                }
+                
+                completion(suggestedDef);
+            } else {
+                completion(nil);
+            }
+        });
+    });
 }
 
 
--(NSArray<ProjectionFieldDefinition*> *)suggestFieldsBasedOnDocument:(JsonDocument*)document {
+-(void)suggestFieldsBasedOnDocument:(JsonDocument*)document
+                         completion:(void (^)(NSArray<ProjectionFieldDefinition*> *))completion {
+    JsonPathExpression rowSelector;
+    bool validRowSelector = false;
     if(self.rowSelector) {
-        JsonPathExpression rowSelector = [self compiledRowSelector];
-        auto rowsEvalResult = rowSelector.execute(document.jsonFile->getDom()->getChildAt(0));
-        std::vector<std::wstring> suggestions = suggestFields(rowsEvalResult.nodeList);
-        
-        NSMutableArray<ProjectionFieldDefinition*> *ret = [NSMutableArray arrayWithCapacity:suggestions.size()];
-        for(auto it = suggestions.begin(); it != suggestions.end(); it++) {
-            ProjectionFieldDefinition *fieldDef = [[ProjectionFieldDefinition alloc] init];
-            fieldDef.expression = [NSString stringWithWstring:*it];
-            fieldDef.fieldTitle = [[fieldDef.expression componentsSeparatedByString:@"."] lastObject];
-            
-            [ret addObject:fieldDef];
+        try {
+            rowSelector = [self compiledRowSelector];
+            validRowSelector = true;
+        } catch(const std::exception &e) {
         }
-        
-        return ret;
-    } else {
-        return nil;
     }
+    
+    std::shared_ptr<const JsonFileSnapshot> snapshot = document.jsonFile->getSnapshot();
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        std::vector<std::wstring> suggestions;
+        if(validRowSelector) {
+            try {
+                std::unique_ptr<json::DocumentNode> dom = snapshot->parse();
+                suggestions = suggestFields(rowSelector.execute(dom->getChildAt(0)).nodeList);
+            } catch(const std::exception &e) {
+            }
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(fieldDefinitionsForSuggestions(suggestions));
+        });
+    });
 }
 
 -(JsonPathExpression)compiledRowSelector {
-    return JsonPathExpression::compile(self.rowSelector.UTF8String);
+    return JsonPathCompileCache::shared().compile(self.rowSelector.cStringWstring);
 }
 
 -(NSArray<ProjectionFieldDefinition*> *)fieldDefinitions {
@@ -361,13 +435,22 @@ std::vector<std::wstring> suggestFields(const JsonPathResultNodeList &nodeList)
 }
 
 
-std::vector<pair<std::wstring, size_t>> suggestRowSelectors(Node *parent, const std::wstring &basePath) {
+static void walkSummaryEntries(const json::PathSummaryEntry *entry, int maxDepth, const std::function<void(const json::PathSummaryEntry *)> &callback) {
+    callback(entry);
+    if(maxDepth > 0) {
+        for(const auto &member: entry->getMembers()) {
+            walkSummaryEntries(member.second.get(), maxDepth-1, callback);
+        }
+    }
+}
+
+std::vector<pair<std::wstring, size_t>> suggestRowSelectors(const json::PathSummary &summary) {
     std::vector<pair<std::wstring, size_t>> scoredArrays;
     
-    walkPathsForNode(parent, L"$", 5, [&scoredArrays] (const std::wstring &path, const json::Node *node) {
-        const json::ArrayNode *array = dynamic_cast<const json::ArrayNode*>(node);
-        if(array) {
-            scoredArrays.push_back(make_pair(path + L"[*]", array->getChildCount()));
+    // Arrays reached through object members, by the number of elements at their path
+    walkSummaryEntries(summary.getRoot(), 5, [&scoredArrays] (const json::PathSummaryEntry *entry) {
+        if(entry->getTypeCount(json::ntArray)) {
+            scoredArrays.push_back(make_pair(entry->getPathString() + L"[*]", entry->getTotalArrayLength()));
         }
     });
     
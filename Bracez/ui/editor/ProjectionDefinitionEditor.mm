@@ -8,6 +8,7 @@
 #import "ProjectionDefinitionEditor.h"
 #import "ProjectionTableController.h"
 #import "JsonPathExpressionCompiler.hpp"
+#import "JsonPathCompileCache.hpp"
 #import "NSString+WStringUtils.h"
 #import "BracezPreferences.h"
 #import "SyntaxEditingField.h"
@@ -133,33 +134,38 @@
 }
 
 - (IBAction)suggestFields:(id)sender {
-    NSMenu *suggestionMenu = [[NSMenu alloc] initWithTitle:@"Field suggestions"];
-    for(ProjectionFieldDefinition *def in [_editedProjection suggestFieldsBasedOnDocument:_previewDocument]) {
-        NSMenuItem *suggestionItem = [[NSMenuItem alloc] initWithTitle:def.expression
-                                                                action:@selector(suggestedFieldSelected:)
-                                                         keyEquivalent:@""];
-        suggestionItem.representedObject = def;
-        suggestionItem.target = self;
-        [suggestionMenu addItem:suggestionItem];
-        
-        if(suggestionMenu.itemArray.count > 20) {
-            break;
+    // The menu pops up for the click once the suggestions are in
+    NSEvent *event = [NSApplication sharedApplication].currentEvent;
+    [_editedProjection suggestFieldsBasedOnDocument:_previewDocument completion:^(NSArray<ProjectionFieldDefinition*> *suggestions) {
+        NSMenu *suggestionMenu = [[NSMenu alloc] initWithTitle:@"Field suggestions"];
+        for(ProjectionFieldDefinition *def in suggestions) {
+            NSMenuItem *suggestionItem = [[NSMenuItem alloc] initWithTitle:def.expression
+                                                                    action:@selector(suggestedFieldSelected:)
+                                                             keyEquivalent:@""];
+            suggestionItem.representedObject = def;
+            suggestionItem.target = self;
+            [suggestionMenu addItem:suggestionItem];
+            
+            if(suggestionMenu.itemArray.count > 20) {
+                break;
+            }
         }
-    }
-    
-    if(!suggestionMenu.itemArray.count) {
-        NSMenuItem *placeholder = [[NSMenuItem alloc] initWithTitle:@"No suggestions"
-                                                             action:nil
-                                                      keyEquivalent:@""];
-        placeholder.enabled = NO;
-        [suggestionMenu addItem:placeholder];
-    }
         
-    [NSMenu popUpContextMenu:suggestionMenu
-                   withEvent:[NSApplication sharedApplication].currentEvent
-                     forView:sender];
+        if(!suggestionMenu.itemArray.count) {
+            NSMenuItem *placeholder = [[NSMenuItem alloc] initWithTitle:@"No suggestions"
+                                                                 action:nil
+                                                          keyEquivalent:@""];
+            placeholder.enabled = NO;
+            [suggestionMenu addItem:placeholder];
+        }
+            
+        [NSMenu popUpContextMenu:suggestionMenu
+                       withEvent:event
+                         forView:sender];
+    }];
 }
 
+
 - (void)syntaxEditingFieldChanged:(nonnull SyntaxEditingField *)sender {
     [self updatePreviewedProjection];
 }
@@ -168,7 +174,7 @@
     [sender clearErrorRanges];
     if(text.length) {
         try {
-            JsonPathExpression::compile([text cStringWstring]);
+            JsonPathCompileCache::shared().compile([text cStringWstring]);
         } catch(const parse_error &e) {
             [sender markErrorRange: NSMakeRange(
                                                std::min(e._offset_start, sender.textStorage.length-1),
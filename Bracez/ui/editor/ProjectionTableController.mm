@@ -7,6 +7,7 @@
 
 #import "ProjectionTableController.h"
 #import "JsonPathExpressionCompiler.hpp"
+#import "JsonPathCompileCache.hpp"
 #import "NSString+WStringUtils.h"
 #import "NodeSelectionController.h"
 
@@ -43,7 +44,7 @@
         self.sortDescriptorPrototype = [ProjectionColumnSortDescriptor forColumn:self ascending:NO];
 
         try {
-            columnExpression = JsonPathExpression::compile(projectionField.expression.cStringWstring);
+            columnExpression = JsonPathCompileCache::shared().compile(projectionField.expression.cStringWstring);
             _validDef = YES;
         } catch(const std::exception &err) {
             _validDef = NO;
@@ -53,8 +54,9 @@
     return self;
 }
 
+// Rows are either live, or of a DOM parsed in the background (see evaluateRows)
 -(Node*)resolveColumnInRow:(Node*)row {
-    if(_validDef) {
+    if(_validDef && row) {
         try {
             auto resultList = columnExpression.execute(row);
             if(resultList.nodeList.size()) {
@@ -73,7 +75,7 @@
 }
 
 -(NSString*)formatNodeToText:(Node*)node {
-    NSString *nodeValue = [JsonCocoaNode nodeForElement:node withName:@""].nodeValue;
+    NSString *nodeValue = [JsonCocoaNode valueOfElement:node];
 
     if(!nodeValue) {
         nodeValue = @"";
@@ -247,9 +249,23 @@
     
     JsonPathExpression dataSourceExpression;
     BOOL cursorDependent;
-    std::vector<Node*> rowNodes;
 
-    std::vector<Node*> displayedRowNodes;
+    // Rows are evaluated, filtered and sorted in the background, over a DOM parsed from a
+    // snapshot of the document's text, and come back as the ranges of the row nodes. They're
+    // taken as the file's nodes at those ranges once its DOM is of the same text. Evaluations
+    // run one at a time; a reload asked for while one runs has it run again once it's done.
+    // Changes to what the rows are (definition, filter, sort, cursor) start a new generation,
+    // and rows of an older one are dropped.
+    unsigned long rowsGeneration;
+    BOOL rowsEvaluating;
+    BOOL rowsReloadPending;
+    unsigned long pendingRowsGeneration;
+    std::shared_ptr<const JsonFileSnapshot> pendingRowsSnapshot;
+    std::shared_ptr<std::vector<json::TextRange>> pendingRows;
+
+    // Rows shown; those replaced by an edit show empty till the rows are reloaded
+    json::PinnedNodes displayedRowNodes;
+    BOOL reloadScheduled;
     
     BOOL _validDef;
 }
@@ -266,7 +282,7 @@
     _cursorNode = cursorNode;
     
     if(cursorDependent) {
-        [self reloadData];
+        [self rowsChanged];
     }
 }
 
@@ -285,8 +301,9 @@
 }
 
 -(void)setProjectedDocument:(JsonDocument *)projectedDocument {
+    displayedRowNodes.clear();
     jsonDocument = projectedDocument;
-    [self reloadData];
+    [self rowsChanged];
 }
 
 -(JsonDocument *)projectedDocument {
@@ -309,27 +326,181 @@
     }
     
     [self configureTableViewColumns];
-    [self reloadData];
+    [self rowsChanged];
 }
 
 -(ProjectionDefinition *)projectionDefinition {
     return definition;
 }
 
+-(void)rowsChanged {
+    rowsGeneration++;
+    [self reloadData];
+}
+
 -(void)reloadData {
-    rowNodes.clear();
+    reloadScheduled = NO;
+
+    if(rowsEvaluating) {
+        rowsReloadPending = YES;
+        return;
+    }
+    
+    // Rows that came in while the DOM was behind the text are taken once it's caught up
+    if(pendingRows) {
+        bool current = pendingRowsGeneration == rowsGeneration && jsonDocument &&
+                       jsonDocument.jsonFile->getSnapshot()->hasSameText(*pendingRowsSnapshot);
+        if(current && [jsonDocument isSemanticModelDirty]) {
+            return;
+        }
+        
+        std::shared_ptr<std::vector<json::TextRange>> rows = std::move(pendingRows);
+        pendingRowsSnapshot.reset();
+        pendingRows.reset();
+        if(current) {
+            [self takeRows:*rows];
+            return;
+        }
+    }
+    
+    [self evaluateRows];
+}
+
+// Filtered and sorted as they're to be shown
+static void filterAndSortRows(std::vector<Node*> &rows, NSArray<NSTableColumn*> *cols,
+                              NSString *filterText, NSArray<NSSortDescriptor*> *sortDescriptors) {
+    if(filterText.length) {
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [cols, filterText] (Node* node) {
+            for(ProjectionTableColumn *ptc in cols) {
+                if([ptc doesMatchFilter:filterText forRow:node]) {
+                    return false;
+                }
+            }
+            
+            return true;
+        }), rows.end());
+    }
+    
+    if(sortDescriptors.count) {
+        std::sort(rows.begin(),
+                  rows.end(), [sortDescriptors](Node *a, Node *b) {
+            for(ProjectionColumnSortDescriptor *d in sortDescriptors) {
+                NSComparisonResult r = [d compareNode:a toNode:b];
+                if(r < 0) {
+                    return true;
+                } else
+                if(r > 0) {
+                    return false;
+                }
+            }
+            
+            return false;
+        });
+    }
+}
 
-    if(_validDef && definition) {
-        JsonPathResultNodeList dataSourceList = self->dataSourceExpression.execute(jsonDocument.rootNode.proxiedElement, NULL, NULL, _cursorNode).nodeList;
-        rowNodes.reserve(dataSourceList.size());
-        std::copy(std::begin(dataSourceList), std::end(dataSourceList), std::back_inserter(rowNodes));
+-(void)evaluateRows {
+    rowsReloadPending = NO;
+    if(!_validDef || !definition || !jsonDocument) {
+        displayedRowNodes.clear();
+        [_tableView reloadData];
+        return;
     }
     
-    [self updateDisplayedRows];
+    // The block keeps its own copies of these; columns are only read by it
+    std::shared_ptr<const JsonFileSnapshot> snapshot = jsonDocument.jsonFile->getSnapshot();
+    JsonPathExpression expr = dataSourceExpression;
+    bool hasCursor = cursorDependent && _cursorNode && _cursorNode->isLive();
+    json::TextRange cursorRange = hasCursor ? _cursorNode->getAbsTextRange() : json::TextRange();
+    NSArray<NSTableColumn*> *cols = [self.tableView.tableColumns copy];
+    NSArray<NSSortDescriptor*> *sortDescriptors = [self.tableView.sortDescriptors copy];
+    NSString *filterText = [_filterText copy];
+    unsigned long generation = rowsGeneration;
+    
+    rowsEvaluating = YES;
+    __weak ProjectionTableController *weakSelf = self;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        auto rows = std::make_shared<std::vector<json::TextRange>>();
+        try {
+            std::unique_ptr<json::DocumentNode> dom = snapshot->parse();
+            json::Node *cursor = hasCursor ? dom->findNodeWithRange(cursorRange) : NULL;
+            
+            JsonPathExpressionOptions opts;
+            opts.parallel = true;
+            std::vector<Node*> rowNodes = expr.execute(dom->getChildAt(0), &opts, NULL, cursor).nodeList;
+            filterAndSortRows(rowNodes, cols, filterText, sortDescriptors);
+            
+            rows->reserve(rowNodes.size());
+            for(Node *node: rowNodes) {
+                rows->push_back(node->getAbsTextRange());
+            }
+        } catch(const std::exception &e) {
+            rows->clear();
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakSelf rowsEvaluated:rows ofSnapshot:snapshot generation:generation];
+        });
+    });
+}
+
+-(void)rowsEvaluated:(std::shared_ptr<std::vector<json::TextRange>>)rows
+          ofSnapshot:(std::shared_ptr<const JsonFileSnapshot>)snapshot
+          generation:(unsigned long)generation {
+    rowsEvaluating = NO;
     
+    // Rows are mapped to the nodes at their ranges, so the DOM must be that of the text
+    // evaluated. Text that was edited since is evaluated again; a DOM that's only behind the
+    // text is waited for, till the document's reconciled and the rows are reloaded.
+    if(rowsReloadPending || generation != rowsGeneration || !jsonDocument ||
+       !jsonDocument.jsonFile->getSnapshot()->hasSameText(*snapshot)) {
+        [self evaluateRows];
+        return;
+    }
+    if([jsonDocument isSemanticModelDirty]) {
+        pendingRowsGeneration = generation;
+        pendingRowsSnapshot = snapshot;
+        pendingRows = rows;
+        return;
+    }
+    
+    [self takeRows:*rows];
+}
+
+-(void)takeRows:(const std::vector<json::TextRange>&)rows {
+    JsonFile *file = jsonDocument.jsonFile;
+    std::vector<Node*> rowNodes;
+    rowNodes.reserve(rows.size());
+    for(const json::TextRange &range: rows) {
+        if(Node *node = file->findNodeWithRange(range)) {
+            rowNodes.push_back(node);
+        }
+    }
+    
+    displayedRowNodes.assign(file, std::move(rowNodes));
     [_tableView reloadData];
 }
 
+-(void)scheduleReloadData {
+    if(!reloadScheduled) {
+        reloadScheduled = YES;
+        __weak ProjectionTableController *weakSelf = self;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [weakSelf reloadData];
+        });
+    }
+}
+
+// The row's node, or NULL if it was replaced since the rows were taken
+-(Node*)liveRowNodeAt:(NSInteger)row {
+    Node *node = displayedRowNodes.at(row);
+    if(!node) {
+        [self scheduleReloadData];
+    }
+
+    return node;
+}
+
 -(NSInteger)numberOfRowsInTableView:(NSTableView *)tableView {
     return displayedRowNodes.size();
 }
@@ -337,7 +508,7 @@
 -(NSString*)csvRowForRow:(NSInteger)row {
     NSMutableArray *rowValues = [NSMutableArray array];
     for(ProjectionTableColumn *column in self.tableView.tableColumns) {
-        [rowValues addObject: [column displayTextForColumnInRow:displayedRowNodes[row]]];
+        [rowValues addObject: [column displayTextForColumnInRow:[self liveRowNodeAt:row]]];
     }
     
     return [rowValues componentsJoinedByString:@"\t"];
@@ -349,7 +520,7 @@
     ProjectionTableColumn* projectionCol = (ProjectionTableColumn*)tableColumn;
     NSTableCellView *viewForCol = [tableView makeViewWithIdentifier:@"projectionCell" owner:tableView];
 
-    viewForCol.textField.stringValue = [projectionCol displayTextForColumnInRow:displayedRowNodes[row]];
+    viewForCol.textField.stringValue = [projectionCol displayTextForColumnInRow:[self liveRowNodeAt:row]];
     
     return viewForCol;
 }
@@ -357,8 +528,8 @@
 -(void)tableViewSelectionDidChange:(NSNotification *)notification {
     if(self.delegate) {
         NSInteger selectedRow = [(NSTableView*)notification.object selectedRow];
-        if(selectedRow >= 0) {
-            Node *node = displayedRowNodes[selectedRow];
+        Node *node = selectedRow >= 0 ? [self liveRowNodeAt:selectedRow] : NULL;
+        if(node) {
             [self.delegate projectionTableController:self didSelectNode:node];
         }
     }
@@ -414,60 +585,24 @@
     }
 }
 
--(void)updateDisplayedRows {
-    NSArray<NSSortDescriptor*> *sortDescriptors = self.tableView.sortDescriptors;
-    NSArray<NSTableColumn*> *cols = self.tableView.tableColumns;
-    
-    if(!_filterText.length) {
-        displayedRowNodes = rowNodes;
-    } else {
-        displayedRowNodes.clear();
-        displayedRowNodes.reserve(rowNodes.size()/2);
-        
-        NSString *filterText = _filterText;
-        
-        std::copy_if(rowNodes.begin(), rowNodes.end(), inserter(displayedRowNodes, displayedRowNodes.end()), [cols, filterText] (Node* node) {
-            for(ProjectionTableColumn *ptc in cols) {
-                if([ptc doesMatchFilter:filterText forRow:node]) {
-                    return true;
-                }
-            }
-            
-            return false;
-        });
-    }
-    
-    if(sortDescriptors.count) {
-        std::sort(displayedRowNodes.begin(),
-                  displayedRowNodes.end(), [sortDescriptors](Node *a, Node *b) {
-            for(ProjectionColumnSortDescriptor *d in sortDescriptors) {
-                NSComparisonResult r = [d compareNode:a toNode:b];
-                if(r < 0) {
-                    return true;
-                } else
-                if(r > 0) {
-                    return false;
-                }
-            }
-            
-            return false;
-        });
-    }
-}
-
 -(void)tableView:(NSTableView *)tableView sortDescriptorsDidChange:(NSArray<NSSortDescriptor *> *)oldDescriptors {
-    [self updateDisplayedRows];
-    [tableView reloadData];
+    [self rowsChanged];
 }
 
 -(void)selectNode:(JsonCocoaNode*)node {
-    json::TextRange selectedNodeRange = node.proxiedElement->getAbsTextRange();
-    auto iter = std::find_if(displayedRowNodes.begin(), displayedRowNodes.end(), [selectedNodeRange](json::Node* node) {
-        return node->getAbsTextRange().contains(selectedNodeRange);
-    });
+    json::Node *selectedElement = node.proxiedElement;
+    if(!selectedElement) {
+        return;
+    }
+
+    json::TextRange selectedNodeRange = selectedElement->getAbsTextRange();
+    size_t rowIndex = 0;
+    while(rowIndex < displayedRowNodes.size() &&
+          !(displayedRowNodes.at(rowIndex) && displayedRowNodes.at(rowIndex)->getAbsTextRange().contains(selectedNodeRange))) {
+        rowIndex++;
+    }
     
-    if(iter != displayedRowNodes.end()) {
-        size_t rowIndex = iter - displayedRowNodes.begin();
+    if(rowIndex < displayedRowNodes.size()) {
         if(![self.tableView.selectedRowIndexes containsIndex:rowIndex]) {
             [self.tableView selectRowIndexes:[NSIndexSet indexSetWithIndex:rowIndex]
                         byExtendingSelection:NO];
@@ -478,8 +613,7 @@
 
 -(void)onSearchChange:(NSSearchField*)sender {
     _filterText = sender.stringValue;
-    [self updateDisplayedRows];
-    [self.tableView reloadData];
+    [self rowsChanged];
 }
 
 